@@ -0,0 +1,160 @@
+#include <chrono>
+#include <thread>
+
+#include <asio3/core/fmt.hpp>
+#include <asio3/http/http_server.hpp>
+
+#ifdef ASIO_STANDALONE
+namespace net = ::asio;
+#else
+namespace net = boost::asio;
+#endif
+
+// Sends many keep-alive requests over one connection to an arena server, and checks that the
+// arena stops allocating from the upstream after the warm up, that is, in the steady state
+// each request is served by the blocks which are retained from the previous requests.
+
+const std::size_t warmup_requests = 1000;
+const std::size_t total_requests  = 100000;
+
+http::arena::statistics warmup_stats;
+http::arena::statistics final_stats;
+
+net::awaitable<void> do_http_recv(net::http_arena_server& server, std::shared_ptr<net::http_arena_session> session)
+{
+	beast::flat_buffer buf;
+
+	auto token = net::bind_allocator(session->arena.get_allocator(), net::as_tuple(net::use_awaitable));
+
+	for (;;)
+	{
+		bool keep_alive = false;
+
+		{
+			http::arena_request req = session->make_request();
+			auto [e1, n1] = co_await http::async_read(session->socket, buf, req, token);
+			if (e1)
+				break;
+
+			http::web_response rep = session->make_response();
+			bool result = co_await server.router.route(req, rep);
+
+			auto [e2, n2] = co_await beast::async_write(
+				session->socket, http::advanced_message_generator_ref(rep), token);
+			if (e2)
+				break;
+
+			keep_alive = result && req.keep_alive();
+		}
+
+		session->arena.reset();
+
+		if (session->arena.get_statistics().resets == warmup_requests)
+			warmup_stats = session->arena.get_statistics();
+
+		if (!keep_alive)
+			break;
+	}
+
+	final_stats = session->arena.get_statistics();
+
+	session->close();
+}
+
+net::awaitable<void> start_server(net::http_arena_server& server, net::ip::tcp::acceptor& acceptor)
+{
+	auto [ec, client] = co_await acceptor.async_accept(net::as_tuple(net::use_awaitable));
+	if (ec)
+		co_return;
+
+	co_await do_http_recv(server, std::make_shared<net::http_arena_session>(std::move(client)));
+}
+
+net::awaitable<std::size_t> start_client(std::uint16_t port)
+{
+	auto executor = co_await net::this_coro::executor;
+
+	net::ip::tcp::socket sock(executor);
+	co_await sock.async_connect({ net::ip::make_address("127.0.0.1"), port }, net::use_awaitable);
+
+	beast::flat_buffer buf;
+	std::size_t failed = 0;
+
+	for (std::size_t i = 0; i < total_requests; ++i)
+	{
+		// the uri and the header have various lengths, so the requests have various sizes.
+		std::string target = (i % 3 == 2) ? "/hello" : fmt::format("/user/{}", i * 7919 % 100000);
+
+		http::request<http::string_body> req{ http::verb::get, target, 11 };
+		req.set(http::field::host, "127.0.0.1");
+		req.set(http::field::user_agent, std::string(16 + i % 64, 'a'));
+		req.keep_alive(i + 1 < total_requests);
+
+		co_await http::async_write(sock, req, net::use_awaitable);
+
+		http::response<http::string_body> rep;
+		co_await http::async_read(sock, buf, rep, net::use_awaitable);
+
+		if (rep.result() != http::status::ok)
+			++failed;
+	}
+
+	co_return failed;
+}
+
+int main()
+{
+	net::io_context server_ctx;
+	net::io_context client_ctx;
+
+	net::http_arena_server server(server_ctx.get_executor());
+
+	server.router.add("/user/:id", [](http::arena_request& req, http::web_response& rep,
+		http::route_params& params) -> net::awaitable<bool>
+	{
+		rep = http::make_text_response(std::allocator_arg, req.get_allocator(), params.get("id"));
+		co_return true;
+	});
+
+	server.router.add("/hello", [](http::arena_request& req, http::web_response& rep) -> net::awaitable<bool>
+	{
+		rep = http::make_text_response(std::allocator_arg, req.get_allocator(), "hello world");
+		co_return true;
+	}, http::enable_cache);
+
+	net::ip::tcp::acceptor acceptor(server_ctx, { net::ip::tcp::v4(), 0 });
+
+	std::uint16_t port = acceptor.local_endpoint().port();
+
+	net::co_spawn(server_ctx, start_server(server, acceptor), net::detached);
+
+	std::size_t failed = 0;
+
+	net::co_spawn(client_ctx, start_client(port), [&failed](std::exception_ptr ep, std::size_t n)
+	{
+		failed = ep ? total_requests : n;
+	});
+
+	auto t1 = std::chrono::steady_clock::now();
+
+	std::thread client_thread([&client_ctx]() { client_ctx.run(); });
+
+	server_ctx.run();
+	client_thread.join();
+
+	auto t2 = std::chrono::steady_clock::now();
+
+	double secs = std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count();
+
+	std::size_t steady_upstream = final_stats.upstream_allocations - warmup_stats.upstream_allocations;
+
+	fmt::print("requests: {}   failed: {}   {:.0f} requests/s\n", final_stats.resets, failed,
+		double(total_requests) / secs);
+	fmt::print("arena allocations per request: {:.1f}   capacity: {}\n",
+		double(final_stats.allocations) / double(final_stats.resets ? final_stats.resets : 1),
+		final_stats.capacity);
+	fmt::print("upstream allocations: {} in the warm up, {} in the steady state\n",
+		warmup_stats.upstream_allocations, steady_upstream);
+
+	return (failed == 0 && final_stats.resets == total_requests && steady_upstream == 0) ? 0 : 1;
+}
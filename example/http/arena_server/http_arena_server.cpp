@@ -0,0 +1,137 @@
+#include <asio3/core/fmt.hpp>
+#include <asio3/http/http_server.hpp>
+
+#ifdef ASIO_STANDALONE
+namespace net = ::asio;
+#else
+namespace net = boost::asio;
+#endif
+
+// The requests and responses of each connection are allocated from the arena of the session,
+// and the arena is reset after each response, so a keep-alive connection needn't allocate from
+// the heap in the steady state.
+
+net::awaitable<void> do_http_recv(net::http_arena_server& server, std::shared_ptr<net::http_arena_session> session)
+{
+	// This buffer is required to persist across reads
+	beast::flat_buffer buf;
+
+	// The async operations allocate their states from the arena too.
+	auto token = net::bind_allocator(session->arena.get_allocator(), net::as_tuple(net::use_awaitable));
+
+	for (;;)
+	{
+		bool keep_alive = false;
+
+		{
+			// Read a request
+			http::arena_request req = session->make_request();
+			auto [e1, n1] = co_await http::async_read(session->socket, buf, req, token);
+			if (e1)
+				break;
+
+			session->update_alive_time();
+
+			http::web_response rep = session->make_response();
+			bool result = co_await server.router.route(req, rep);
+
+			// Send the response, the response is written by reference, so it's destroyed
+			// at the end of this scope, before the arena is reset.
+			auto [e2, n2] = co_await beast::async_write(
+				session->socket, http::advanced_message_generator_ref(rep), token);
+			if (e2)
+				break;
+
+			keep_alive = result && req.keep_alive();
+		}
+
+		session->arena.reset();
+
+		if (!keep_alive)
+		{
+			// This means we should close the connection, usually because
+			// the response indicated the "Connection: close" semantic.
+			break;
+		}
+	}
+
+	http::arena::statistics stats = session->arena.get_statistics();
+
+	fmt::print("  requests: {} arena allocations: {} upstream allocations: {} capacity: {}\n",
+		stats.resets, stats.allocations, stats.upstream_allocations, stats.capacity);
+
+	session->close();
+}
+
+net::awaitable<void> client_join(net::http_arena_server& server, std::shared_ptr<net::http_arena_session> session)
+{
+	auto addr = session->get_remote_address();
+	auto port = session->get_remote_port();
+
+	fmt::print("+ client join: {} {}\n", addr, port);
+
+	co_await server.session_map.async_add(session);
+
+	co_await(do_http_recv(server, session) || net::watchdog(session->alive_time, net::http_idle_timeout));
+
+	co_await server.session_map.async_remove(session);
+
+	fmt::print("- client exit: {} {}\n", addr, port);
+}
+
+net::awaitable<void> start_server(net::http_arena_server& server, std::string listen_address, std::uint16_t listen_port)
+{
+	auto [ec, ep] = co_await server.async_listen(listen_address, listen_port);
+	if (ec)
+	{
+		fmt::print("listen failure: {}\n", ec.message());
+		co_return;
+	}
+
+	fmt::print("listen success: {} {}\n", server.get_listen_address(), server.get_listen_port());
+
+	while (!server.is_aborted())
+	{
+		auto [e1, client] = co_await server.acceptor.async_accept();
+		if (e1)
+		{
+			co_await net::delay(std::chrono::milliseconds(100));
+		}
+		else
+		{
+			net::co_spawn(server.get_executor(), client_join(server,
+				std::make_shared<net::http_arena_session>(std::move(client))), net::detached);
+		}
+	}
+}
+
+int main()
+{
+	net::io_context_thread ctx;
+
+	net::http_arena_server server(ctx.get_executor());
+
+	server.router.add("/user/:id", [](http::arena_request& req, http::web_response& rep,
+		http::route_params& params) -> net::awaitable<bool>
+	{
+		// the response uses the allocator of the request, which allocates from the arena.
+		rep = http::make_text_response(std::allocator_arg, req.get_allocator(), params.get("id"));
+		co_return true;
+	});
+
+	server.router.add("/hello", [](http::arena_request& req, http::web_response& rep) -> net::awaitable<bool>
+	{
+		rep = http::make_text_response(std::allocator_arg, req.get_allocator(), "hello world");
+		co_return true;
+	}, http::enable_cache);
+
+	net::co_spawn(ctx.get_executor(), start_server(server, "0.0.0.0", 8080), net::detached);
+
+	net::signal_set sigset(ctx.get_executor(), SIGINT);
+	sigset.async_wait([&server](net::error_code, int) mutable
+	{
+		server.async_stop([](auto) {});
+	});
+
+	ctx.join();
+}
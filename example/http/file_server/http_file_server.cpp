@@ -1,5 +1,6 @@
 #include <asio3/core/fmt.hpp>
 #include <asio3/http/http_server.hpp>
+#include <asio3/http/file_cache.hpp>
 #include <asio3/core/defer.hpp>
 #include <unordered_map>
 
@@ -108,6 +109,55 @@ auto response_404()
 	return http::make_error_page_response(http::status::not_found);
 }
 
+net::awaitable<bool> send_cached_file(http::file_cache& files, std::filesystem::path filepath,
+	http::web_request& req, http::web_response& rep, userdata data)
+{
+	auto entry = files.get(filepath);
+	if (!entry.has_value())
+	{
+		rep = response_404();
+		co_return true;
+	}
+
+	const http::file_cache::entry_ptr& file = entry.value();
+
+	if (file->is_not_modified(req))
+	{
+		rep = file->not_modified;
+		co_return true;
+	}
+
+	if (file->response)
+	{
+		rep = file->response;
+		co_return true;
+	}
+
+	// the large file is sent by sendfile from the cached descriptor.
+	net::error_code ec{};
+	net::stream_file stream = file->open(data.session->get_executor(), ec);
+	if (ec)
+	{
+		rep = http::make_error_page_response(http::status::internal_server_error);
+		co_return true;
+	}
+
+	http::response<http::string_body> res{ http::status::ok, req.version() };
+	res.set(http::field::server, BEAST_VERSION_STRING);
+	res.set(http::field::content_type, file->mimetype);
+	res.set(http::field::etag, file->etag);
+	res.set(http::field::last_modified, file->last_modified);
+	res.content_length(file->size);
+
+	auto [e2, n2] = co_await http::async_send_file(data.session->socket, stream, std::move(res));
+	if (e2)
+		co_return false;
+
+	data.need_response = false;
+
+	co_return true;
+}
+
 struct aop_auth
 {
 	net::awaitable<bool> before(http::web_request& req, http::web_response& rep)
@@ -133,47 +183,31 @@ int main()
 	root = root.parent_path().parent_path().append("example/wwwroot"); // /asio3/example/wwwroot
 	server.webroot = std::move(root);
 
-	server.router.add("/", [&server](http::web_request& req, http::web_response& rep, userdata data)
+	// the opened files and their metadata are cached, the small files are responsed from memory,
+	// and the conditional requests are answered by "304 Not Modified" without touching the disk.
+	http::file_cache& files = http::attach_file_cache(ctx.get_executor());
+
+	server.router.add("/", [&server, &files](http::web_request& req, http::web_response& rep, userdata data)
 		-> net::awaitable<bool>
 	{
 		auto [e1, n1] = co_await http::async_read(data.session->socket, data.buffer, data.parser);
 		if (e1)
 			co_return false;
 
-		std::filesystem::path filepath = server.webroot / "index.html";
-		auto [ec, file, content] = co_await net::async_read_file_content(filepath.string());
-		if (ec)
-		{
-			rep = response_404();
-			co_return true;
-		}
-
-		rep = http::make_html_response(std::move(content));
-		co_return true;
-	}, http::enable_cache, aop_auth{});
+		co_return co_await send_cached_file(files, server.webroot / "index.html", req, rep, data);
+	}, aop_auth{});
 
-	server.router.add("*", [&server](http::web_request& req, http::web_response& rep, userdata data)
+	server.router.add("*", [&server, &files](http::web_request& req, http::web_response& rep, userdata data)
 		-> net::awaitable<bool>
 	{
 		auto [e1, n1] = co_await http::async_read(data.session->socket, data.buffer, data.parser);
 		if (e1)
 			co_return false;
 
-		std::filesystem::path filepath = net::make_filepath(server.webroot, req.target());
-		auto [ec, file, content] = co_await net::async_read_file_content(filepath.string());
-		if (ec)
-		{
-			rep = response_404();
-			co_return true;
-		}
-
-		auto res = http::make_text_response(std::move(content));
-		res.set(http::field::content_type, http::extension_to_mimetype(filepath.extension().string()));
-		rep = std::move(res);
-		co_return true;
-	}, http::enable_cache);
+		co_return co_await send_cached_file(files, net::make_filepath(server.webroot, req.target()), req, rep, data);
+	});
 
-	server.router.add("/download/*", [&server, &sigs](http::web_request& req, http::web_response& rep, userdata data)
+	server.router.add("/download/*", [&server, &sigs, &files](http::web_request& req, http::web_response& rep, userdata data)
 		-> net::awaitable<bool>
 	{
 		auto [e1, n1] = co_await http::async_read(data.session->socket, data.buffer, data.parser);
@@ -189,20 +223,60 @@ int main()
 		std::filesystem::path filepath = net::make_filepath(
 			server.webroot, req.target().substr(std::strlen("/download")));
 
+		// the file is reopened from the cached descriptor, every download has its own offset.
+		auto entry = files.get(filepath);
+		if (!entry.has_value())
+		{
+			rep = http::make_error_page_response(http::status::internal_server_error);
+			co_return true;
+		}
+
 		net::error_code ec{};
-		net::stream_file file(data.session->get_executor());
-		file.open(filepath.string(), net::file_base::read_only, ec);
+		net::stream_file file = entry.value()->open(data.session->get_executor(), ec);
 		if (ec)
 		{
 			rep = http::make_error_page_response(http::status::internal_server_error);
 			co_return true;
 		}
 
+		std::uint64_t file_size = entry.value()->size;
+
 		http::response<http::string_body> res{ http::status::ok, req.version() };
 		res.set(http::field::server, BEAST_VERSION_STRING);
 		res.set(http::field::content_type, http::extension_to_mimetype(filepath.string()));
+		res.set(http::field::accept_ranges, "bytes");
 		//res.chunked(true);
-		res.content_length(file.size());
+
+		// only the single byte range is supported, the other ranges are responsed with the whole file.
+		auto range = http::parse_range(req[http::field::range], file_size);
+		if (range.has_value())
+		{
+			auto [first, last] = range.value();
+
+			// the async_send_file sends the content length bytes from the current position.
+			file.seek(std::int64_t(first), net::file_base::seek_set, ec);
+			if (ec)
+			{
+				rep = http::make_error_page_response(http::status::internal_server_error);
+				co_return true;
+			}
+
+			res.result(http::status::partial_content);
+			res.set(http::field::content_range, fmt::format("bytes {}-{}/{}", first, last, file_size));
+			res.content_length(last - first + 1);
+		}
+		else if (range.error() == http::status::range_not_satisfiable)
+		{
+			http::response<http::string_body> err = http::make_error_page_response(
+				http::status::range_not_satisfiable, std::string_view{}, "text/html", req.version());
+			err.set(http::field::content_range, fmt::format("bytes */{}", file_size));
+			rep = std::move(err);
+			co_return true;
+		}
+		else
+		{
+			res.content_length(file_size);
+		}
 
 		// used to interrupt the file operation, otherwise when close this application,
 		// it maybe wait for a long time until the file operation finished.
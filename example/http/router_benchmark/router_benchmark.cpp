@@ -0,0 +1,134 @@
+#include <chrono>
+#include <map>
+#include <random>
+#include <unordered_map>
+
+#include <asio3/core/fmt.hpp>
+#include <asio3/http/util.hpp>
+#include <asio3/http/route_tree.hpp>
+
+#ifdef ASIO_STANDALONE
+namespace net = ::asio;
+#else
+namespace net = boost::asio;
+#endif
+
+// the lookup algorithm of the router before the route tree was used, the method char
+// is prepended to the uri, then the strictly map and the wildcard map are searched.
+struct legacy_router
+{
+	void insert(std::string uri, int value)
+	{
+		uri.insert(0, "1");
+
+		if (uri.back() == '*')
+			wildcard_routers[std::move(uri)] = value;
+		else
+			strictly_routers[std::move(uri)] = value;
+	}
+
+	int* find(std::string_view path)
+	{
+		std::string uri;
+		uri.reserve(1 + path.size());
+		uri += "1";
+		uri += path;
+
+		if (auto it = strictly_routers.find(uri); it != strictly_routers.end())
+			return std::addressof(it->second);
+
+		for (auto it = wildcard_routers.rbegin(); it != wildcard_routers.rend(); ++it)
+		{
+			auto& k = it->first;
+			if (uri.front() == k.front() && uri.size() >= (k.size() - 2)
+				&& uri[k.size() - 3] == k[k.size() - 3] && http::url_match(k, uri))
+			{
+				return std::addressof(it->second);
+			}
+		}
+
+		return nullptr;
+	}
+
+	std::unordered_map<std::string, int> strictly_routers;
+	std::map<std::string, int>           wildcard_routers;
+};
+
+template<class F>
+double measure(std::size_t loops, F&& f)
+{
+	auto t1 = std::chrono::steady_clock::now();
+
+	for (std::size_t i = 0; i < loops; ++i)
+	{
+		f(i);
+	}
+
+	auto t2 = std::chrono::steady_clock::now();
+
+	return double(std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count()) / double(loops);
+}
+
+void run(std::size_t route_count)
+{
+	legacy_router legacy;
+	http::basic_route_tree<int> tree;
+
+	std::vector<std::string> paths;
+
+	// 80% static routes, 10% wildcard routes, 10% routes whose last segment is a param.
+	for (std::size_t i = 0; i < route_count; ++i)
+	{
+		std::string base = fmt::format("/api/v1/module{}/resource{}", i % 37, i);
+
+		if (i % 10 == 8)
+		{
+			legacy.insert(base + "/*", int(i));
+			tree.insert(base + "/*", int(i));
+			paths.emplace_back(base + "/some/file.txt");
+		}
+		else if (i % 10 == 9)
+		{
+			// the legacy router has no param, so a wildcard is used to emulate it.
+			legacy.insert(base + "/*", int(i));
+			tree.insert(base + "/:id", int(i));
+			paths.emplace_back(base + "/12345");
+		}
+		else
+		{
+			legacy.insert(base, int(i));
+			tree.insert(base, int(i));
+			paths.emplace_back(base);
+		}
+	}
+
+	std::shuffle(paths.begin(), paths.end(), std::mt19937{ 1234 });
+
+	const std::size_t loops = 1000000;
+
+	std::size_t hits1 = 0, hits2 = 0;
+
+	double t1 = measure(loops, [&](std::size_t i)
+	{
+		hits1 += legacy.find(paths[i % paths.size()]) != nullptr;
+	});
+
+	http::route_params params;
+
+	double t2 = measure(loops, [&](std::size_t i)
+	{
+		params.reset();
+		hits2 += tree.find(paths[i % paths.size()], params) != nullptr;
+	});
+
+	fmt::print("routes: {:>5}   legacy: {:>9.1f} ns/op   route_tree: {:>7.1f} ns/op   hits: {}/{}\n",
+		route_count, t1, t2, hits1, hits2);
+}
+
+int main()
+{
+	for (std::size_t n : { 10, 100, 1000 })
+	{
+		run(n);
+	}
+}
@@ -127,6 +127,13 @@ int main()
 		co_return true;
 	}, aop_auth{});
 
+	server.router.add("/user/:id", [](http::web_request& req, http::web_response& rep,
+		http::route_params& params) -> net::awaitable<bool>
+	{
+		rep = http::make_text_response(params.get("id"));
+		co_return true;
+	});
+
 	server.router.add("*", [&server](http::web_request& req, http::web_response& rep) -> net::awaitable<bool>
 	{
 		auto res = http::make_file_response(server.webroot, req.target());
@@ -90,7 +90,7 @@ net::awaitable<void> do_http_recv(net::httpws_server& server, std::shared_ptr<ne
 		bool result = co_await server.router.route(req, rep);
 
 		// Support websocket
-		if (websocket::is_upgrade(req) && rep.get_response_header().result() == http::status::switching_protocols)
+		if (websocket::is_upgrade(req) && rep.result() == http::status::switching_protocols)
 		{
 			net::co_spawn(server.get_executor(), websocket_client_join(server,
 				std::make_shared<net::ws_session>(std::move(session->socket)), std::move(req)), net::detached);
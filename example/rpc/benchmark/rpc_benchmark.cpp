@@ -0,0 +1,239 @@
+#include <asio3/core/fmt.hpp>
+#include <asio3/core/match_condition.hpp>
+#include <asio3/rpc/rpc_server.hpp>
+#include <asio3/rpc/rpc_client.hpp>
+
+#include <future>
+
+#ifdef ASIO_STANDALONE
+namespace net = ::asio;
+#else
+namespace net = boost::asio;
+#endif
+
+// Compare the throughput of the receive loop of the rpc server example, which executes one
+// request at a time, with the rpc::async_serve, which executes the requests concurrently.
+// usage: rpc_benchmark [concurrent_calls] [seconds]
+
+net::awaitable<std::string> echo(std::string a)
+{
+	co_return a;
+}
+
+net::awaitable<std::string> slow(std::string a)
+{
+	co_await net::delay(std::chrono::milliseconds(5));
+	co_return a;
+}
+
+// the receive loop of the rpc server example.
+net::awaitable<void> serial_recv(net::rpc_server& server, std::shared_ptr<net::rpc_session> session)
+{
+	std::string strbuf;
+	rpc::serializer& sr = session->serializer;
+	rpc::deserializer& dr = session->deserializer;
+
+	for (;;)
+	{
+		auto [e1, n1] = co_await net::async_read_until(
+			session->get_stream(), net::dynamic_buffer(strbuf), net::length_payload_match_condition{});
+		if (e1 || n1 == 0)
+			break;
+
+		std::string_view data = net::length_payload_match_condition::get_payload(strbuf.data(), n1);
+
+		rpc::header head{};
+		try
+		{
+			dr.reset(data);
+			dr >> head;
+		}
+		catch (const cereal::exception&)
+		{
+			break;
+		}
+
+		if (!head.is_request())
+			break;
+
+		auto [e2, resp] = co_await server.invoker.invoke(sr, dr, std::move(head), data);
+
+		if (!resp.empty())
+		{
+			std::string len = net::length_payload_match_condition::generate_length(net::buffer(resp));
+			std::array<net::const_buffer, 2> buffers
+			{
+				net::buffer(len),
+				net::buffer(resp),
+			};
+			co_await session->async_send(buffers);
+		}
+
+		if (e2)
+			break;
+
+		strbuf.erase(0, n1);
+	}
+
+	session->close();
+}
+
+net::awaitable<void> pipelined_recv(net::rpc_server& server, std::shared_ptr<net::rpc_session> session)
+{
+	co_await rpc::async_serve(*session, server.invoker);
+
+	session->close();
+}
+
+net::awaitable<void> client_join(net::rpc_server& server, std::shared_ptr<net::rpc_session> session, bool pipelined)
+{
+	co_await server.session_map.async_add(session);
+
+	if (pipelined)
+		co_await pipelined_recv(server, session);
+	else
+		co_await serial_recv(server, session);
+
+	co_await server.session_map.async_remove(session);
+}
+
+net::awaitable<void> start_server(net::rpc_server& server, bool pipelined, std::uint16_t port)
+{
+	auto [ec, ep] = co_await server.async_listen("127.0.0.1", port);
+	if (ec)
+	{
+		fmt::print("listen failure: {}\n", ec.message());
+		co_return;
+	}
+
+	while (!server.is_aborted())
+	{
+		auto [e1, client] = co_await server.acceptor.async_accept();
+		if (e1)
+			break;
+
+		net::co_spawn(server.get_executor(), client_join(server,
+			std::make_shared<net::rpc_session>(std::move(client)), pipelined), net::detached);
+	}
+}
+
+net::awaitable<std::size_t> run_client(
+	std::uint16_t port, std::size_t concurrency, bool with_slow, std::chrono::seconds duration)
+{
+	auto ex = co_await net::this_coro::executor;
+
+	net::rpc_client client(ex);
+
+	auto [ec, ep] = co_await client.async_connect("127.0.0.1", port);
+	if (ec)
+	{
+		fmt::print("connect failure: {}\n", ec.message());
+		co_return 0;
+	}
+
+	net::timer serving(ex, std::chrono::steady_clock::time_point::max());
+
+	bool served = false;
+
+	// the serving holds the reference of the client, so wait for it before the client is destroyed.
+	net::co_spawn(ex, rpc::async_serve(client, client.invoker), [&serving, &served](auto...) mutable
+	{
+		served = true;
+		serving.cancel();
+	});
+
+	std::size_t calls = 0, running = concurrency;
+
+	auto deadline = std::chrono::steady_clock::now() + duration;
+
+	net::timer done(ex, std::chrono::steady_clock::time_point::max());
+
+	for (std::size_t i = 0; i < concurrency; ++i)
+	{
+		// the first caller calls the slow function if required.
+		std::string method = (with_slow && i == 0) ? "slow" : "echo";
+
+		net::co_spawn(ex, [&, method]() mutable -> net::awaitable<void>
+		{
+			std::string msg(128, 'A');
+
+			while (std::chrono::steady_clock::now() < deadline)
+			{
+				auto [e1, s1] = co_await client.async_call<std::string>(method, msg);
+				if (e1)
+					break;
+
+				++calls;
+			}
+
+			if (--running == 0)
+				done.cancel();
+		}, net::detached);
+	}
+
+	co_await done.async_wait(net::use_nothrow_awaitable);
+
+	client.close();
+
+	if (!served)
+		co_await serving.async_wait(net::use_nothrow_awaitable);
+
+	co_return calls;
+}
+
+std::size_t benchmark(bool pipelined, bool with_slow, std::size_t concurrency, std::chrono::seconds duration)
+{
+	static std::uint16_t port = 18038;
+
+	++port;
+
+	net::io_context_thread server_ctx;
+	net::io_context_thread client_ctx;
+
+	net::rpc_server server(server_ctx.get_executor());
+
+	server.invoker.bind("echo", echo);
+	server.invoker.bind("slow", slow);
+
+	net::co_spawn(server_ctx.get_executor(), start_server(server, pipelined, port), net::detached);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	std::size_t calls = net::co_spawn(client_ctx.get_executor(),
+		run_client(port, concurrency, with_slow, duration), net::use_future).get();
+
+	std::promise<void> stopped;
+
+	net::post(server_ctx.get_executor(), [&]() mutable
+	{
+		server.async_stop([&](auto) { stopped.set_value(); });
+	});
+
+	stopped.get_future().wait();
+
+	server_ctx.join();
+	client_ctx.join();
+
+	return calls;
+}
+
+int main(int argc, char* argv[])
+{
+	std::size_t concurrency = argc > 1 ? std::stoul(argv[1]) : 64;
+
+	std::chrono::seconds duration(argc > 2 ? std::stoul(argv[2]) : 3);
+
+	for (bool with_slow : { false, true })
+	{
+		for (bool pipelined : { false, true })
+		{
+			std::size_t calls = benchmark(pipelined, with_slow, concurrency, duration);
+
+			fmt::print("{:<10} {:<14} concurrency {:<5} {:>12.1f} calls/s\n",
+				pipelined ? "pipelined" : "serial",
+				with_slow ? "echo + slow" : "echo",
+				concurrency,
+				double(calls) / double(duration.count()));
+		}
+	}
+}
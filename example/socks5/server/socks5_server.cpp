@@ -1,5 +1,6 @@
 #include <asio3/core/fmt.hpp>
 #include <asio3/proxy/socks5_server.hpp>
+#include <asio3/tcp/relay.hpp>
 
 #ifdef ASIO_STANDALONE
 namespace net = ::asio;
@@ -8,25 +9,6 @@ namespace net = boost::asio;
 #endif
 using time_point = std::chrono::steady_clock::time_point;
 
-net::awaitable<void> tcp_transfer(
-	std::shared_ptr<net::socks5_session> conn, net::tcp_socket& from, net::tcp_socket& to)
-{
-	std::array<char, 1024> data;
-
-	for (;;)
-	{
-		conn->update_alive_time();
-
-		auto [e1, n1] = co_await net::async_read_some(from, net::buffer(data));
-		if (e1)
-			break;
-
-		auto [e2, n2] = co_await net::async_write(to, net::buffer(data, n1));
-		if (e2)
-			break;
-	}
-}
-
 net::awaitable<void> udp_transfer(
 	std::shared_ptr<net::socks5_session> conn, net::tcp_socket& front, net::udp_socket& bound)
 {
@@ -143,8 +125,8 @@ net::awaitable<void> proxy(std::shared_ptr<net::socks5_session> conn)
 		net::tcp_socket& front_client = conn->socket;
 		net::tcp_socket& back_client = *conn->get_backend_tcp_socket();
 		co_await(
-			tcp_transfer(conn, front_client, back_client) ||
-			tcp_transfer(conn, back_client, front_client) ||
+			net::async_relay(front_client, back_client, net::relay_option{
+				.transfer_callback = [conn](std::size_t) { conn->update_alive_time(); } }) ||
 			net::watchdog(conn->alive_time, net::proxy_idle_timeout));
 		front_client.close(ec);
 		back_client.close(ec);
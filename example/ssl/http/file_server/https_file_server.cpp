@@ -219,11 +219,44 @@ int main()
 			co_return true;
 		}
 
+		std::uint64_t file_size = file.size();
+
 		http::response<http::string_body> res{ http::status::ok, req.version() };
 		res.set(http::field::server, BEAST_VERSION_STRING);
 		res.set(http::field::content_type, http::extension_to_mimetype(filepath.string()));
+		res.set(http::field::accept_ranges, "bytes");
 		//res.chunked(true);
-		res.content_length(file.size());
+
+		// only the single byte range is supported, the other ranges are responsed with the whole file.
+		auto range = http::parse_range(req[http::field::range], file_size);
+		if (range.has_value())
+		{
+			auto [first, last] = range.value();
+
+			// the async_send_file sends the content length bytes from the current position.
+			file.seek(std::int64_t(first), net::file_base::seek_set, ec);
+			if (ec)
+			{
+				rep = http::make_error_page_response(http::status::internal_server_error);
+				co_return true;
+			}
+
+			res.result(http::status::partial_content);
+			res.set(http::field::content_range, fmt::format("bytes {}-{}/{}", first, last, file_size));
+			res.content_length(last - first + 1);
+		}
+		else if (range.error() == http::status::range_not_satisfiable)
+		{
+			http::response<http::string_body> err = http::make_error_page_response(
+				http::status::range_not_satisfiable, std::string_view{}, "text/html", req.version());
+			err.set(http::field::content_range, fmt::format("bytes */{}", file_size));
+			rep = std::move(err);
+			co_return true;
+		}
+		else
+		{
+			res.content_length(file_size);
+		}
 
 		// used to interrupt the file operation, otherwise when close this application,
 		// it maybe wait for a long time until the file operation finished.
@@ -96,7 +96,7 @@ net::awaitable<void> do_http_recv(net::httpwss_server& server, std::shared_ptr<n
 		bool result = co_await server.router.route(req, rep);
 
 		// Support websocket
-		if (websocket::is_upgrade(req) && rep.get_response_header().result() == http::status::switching_protocols)
+		if (websocket::is_upgrade(req) && rep.result() == http::status::switching_protocols)
 		{
 			net::co_spawn(server.get_executor(), websocket_client_join(server,
 				std::make_shared<net::flex_wss_session>(std::move(session)), std::move(req)), net::detached);
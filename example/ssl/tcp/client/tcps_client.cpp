@@ -76,6 +76,8 @@ int main()
 
 	net::ssl::context sslctx(net::ssl::context::sslv23);
 	net::load_cert_from_string(sslctx, net::ssl::verify_peer, ca_crt, client_crt, client_key, "123456");
+	// cache the sessions, so the reconnection can resume the last session.
+	net::ssl_session_cache::attach(sslctx, std::make_shared<net::ssl_session_cache>());
 	net::tcps_client client(ctx.get_executor(), std::move(sslctx));
 
 	net::co_spawn(ctx.get_executor(), connect(client), net::detached);
@@ -88,6 +88,8 @@ int main()
 	net::ssl::context sslctx(net::ssl::context::sslv23);
 	net::load_cert_from_string(sslctx, net::ssl::verify_peer | net::ssl::verify_fail_if_no_peer_cert,
 		ca_crt, server_crt, server_key, "123456", dh);
+	// issue the session tickets, so the clients can resume the sessions when reconnecting.
+	net::ssl_ticket_keys::attach(sslctx, std::make_shared<net::ssl_ticket_keys>());
 	net::tcps_server server(ctx.get_executor(), std::move(sslctx));
 
 	net::co_spawn(ctx.get_executor(), start_server(server, "0.0.0.0", 8002), net::detached);
@@ -0,0 +1,103 @@
+#include <asio3/core/fmt.hpp>
+#include <asio3/tcp/tcp_multi_server.hpp>
+
+#ifdef ASIO_STANDALONE
+namespace net = ::asio;
+#else
+namespace net = boost::asio;
+#endif
+
+net::awaitable<void> do_recv(std::shared_ptr<net::tcp_session> session)
+{
+	std::string strbuf;
+
+	for (;;)
+	{
+		auto [e1, n1] = co_await net::async_read_until(session->socket, net::dynamic_buffer(strbuf), '\n');
+		if (e1)
+			break;
+
+		session->update_alive_time();
+
+		auto data = net::buffer(strbuf.data(), n1);
+
+		auto [e2, n2] = co_await net::async_send(session->socket, data);
+		if (e2)
+			break;
+
+		strbuf.erase(0, n1);
+	}
+
+	session->close();
+}
+
+net::awaitable<void> client_join(net::tcp_multi_server& server, std::shared_ptr<net::tcp_session> session)
+{
+	co_await server.session_map.async_add(session);
+
+	session->socket.set_option(net::ip::tcp::no_delay(true));
+	session->socket.set_option(net::socket_base::keep_alive(true));
+
+	co_await(do_recv(session) || net::watchdog(session->alive_time, net::tcp_idle_timeout));
+
+	co_await server.session_map.async_remove(session);
+}
+
+net::awaitable<void> accept_loop(net::tcp_multi_server& server, std::size_t index)
+{
+	while (!server.is_aborted())
+	{
+		auto [e1, client] = co_await server.async_accept(index);
+		if (e1)
+		{
+			co_await net::delay(std::chrono::milliseconds(100));
+		}
+		else
+		{
+			// the session runs in the reactor which the socket is bound to.
+			auto ex = client.get_executor();
+
+			net::co_spawn(ex, client_join(server,
+				std::make_shared<net::tcp_session>(std::move(client))), net::detached);
+		}
+	}
+}
+
+net::awaitable<void> start_server(net::tcp_multi_server& server,
+	std::string listen_address, std::uint16_t listen_port)
+{
+	auto [ec, ep] = co_await server.async_listen(listen_address, listen_port);
+	if (ec)
+	{
+		fmt::print("listen failure: {}\n", ec.message());
+		co_return;
+	}
+
+	fmt::print("listen success: {} {}\n", server.get_listen_address(), server.get_listen_port());
+
+	for (std::size_t i = 0; i < server.reactor_count(); ++i)
+	{
+		if (server.is_listening(i))
+			net::co_spawn(server.get_executor(i), accept_loop(server, i), net::detached);
+	}
+}
+
+int main()
+{
+	std::vector<net::io_context_thread> reactors((std::max)(std::thread::hardware_concurrency(), 1u));
+
+	net::tcp_multi_server server(reactors);
+
+	net::co_spawn(server.get_executor(), start_server(server, "0.0.0.0", 8028), net::detached);
+
+	net::signal_set sigset(server.get_executor(), SIGINT);
+	sigset.async_wait([&server](net::error_code, int) mutable
+	{
+		server.async_stop([](auto) {});
+	});
+
+	for (net::io_context_thread& reactor : reactors)
+	{
+		reactor.join();
+	}
+}
@@ -0,0 +1,229 @@
+#include <asio3/core/fmt.hpp>
+#include <asio3/core/work_stealing_pool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#ifdef ASIO_STANDALONE
+namespace net = ::asio;
+#else
+namespace net = boost::asio;
+#endif
+
+// Compare the asio3 thread_pool, which is replaced by the work_stealing_pool, with the
+// work_stealing_pool, which gives each thread its own deque. The asio::thread_pool is measured
+// too as a reference. The thread count is doubled from 1 up to the max_threads.
+// usage: thread_pool_benchmark [tasks] [max_threads]
+
+// the thread_pool of <asio3/core/thread_pool.hpp>, it has the same name as the asio::thread_pool,
+// so it can't be included together with asio, the post path is copied here, every post creates a
+// packaged_task and a future, and all the threads share one locked queue.
+class legacy_thread_pool
+{
+public:
+	explicit legacy_thread_pool(std::size_t thread_count)
+	{
+		for (std::size_t i = 0; i < thread_count; ++i)
+		{
+			this->workers_.emplace_back([this]() mutable
+			{
+				for (;;)
+				{
+					std::packaged_task<void()> task;
+
+					{
+						std::unique_lock<std::mutex> lock(this->mtx_);
+						this->cv_.wait(lock, [this] { return (this->stop_ || !this->tasks_.empty()); });
+
+						if (this->stop_ && this->tasks_.empty())
+							return;
+
+						task = std::move(this->tasks_.front());
+						this->tasks_.pop();
+					}
+
+					task();
+				}
+			});
+		}
+	}
+
+	~legacy_thread_pool()
+	{
+		{
+			std::unique_lock<std::mutex> lock(this->mtx_);
+			this->stop_ = true;
+		}
+
+		this->cv_.notify_all();
+
+		for (std::thread& worker : this->workers_)
+		{
+			worker.join();
+		}
+	}
+
+	template<class Fun>
+	auto post(Fun&& fun) -> std::future<std::invoke_result_t<Fun>>
+	{
+		std::packaged_task<std::invoke_result_t<Fun>()> task(std::forward<Fun>(fun));
+
+		std::future<std::invoke_result_t<Fun>> future = task.get_future();
+
+		{
+			std::unique_lock<std::mutex> lock(this->mtx_);
+			this->tasks_.emplace(std::move(task));
+		}
+
+		this->cv_.notify_one();
+
+		return future;
+	}
+
+protected:
+	std::vector<std::thread> workers_;
+	std::queue<std::packaged_task<void()>> tasks_;
+	std::mutex mtx_;
+	std::condition_variable cv_;
+	bool stop_ = false;
+};
+
+template<typename Pool>
+inline void post_to(Pool& pool, auto&& f)
+{
+	if constexpr (std::same_as<Pool, legacy_thread_pool>)
+		pool.post(std::forward<decltype(f)>(f));
+	else
+		net::post(pool.get_executor(), std::forward<decltype(f)>(f));
+}
+
+// the tasks are posted from one thread outside of the pool.
+template<typename Pool>
+double bench_post(Pool& pool, std::size_t tasks)
+{
+	std::atomic<std::size_t> done{ 0 };
+	std::promise<void> finished;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (std::size_t i = 0; i < tasks; ++i)
+	{
+		post_to(pool, [&done, &finished, tasks]() mutable
+		{
+			if (done.fetch_add(1, std::memory_order_relaxed) + 1 == tasks)
+				finished.set_value();
+		});
+	}
+
+	finished.get_future().wait();
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// each task posts two child tasks until the depth is reached, so most of the tasks are
+// posted from the threads of the pool itself, like the divide and conquer algorithms.
+template<typename Pool>
+struct fan_out
+{
+	Pool& pool;
+	std::atomic<std::size_t>& done;
+	std::promise<void>& finished;
+	std::size_t total;
+
+	void operator()(std::size_t depth) const
+	{
+		if (depth > 0)
+		{
+			post_to(pool, [*this, depth]() { (*this)(depth - 1); });
+			post_to(pool, [*this, depth]() { (*this)(depth - 1); });
+		}
+
+		if (done.fetch_add(1, std::memory_order_relaxed) + 1 == total)
+			finished.set_value();
+	}
+};
+
+template<typename Pool>
+double bench_fan_out(Pool& pool, std::size_t tasks)
+{
+	std::size_t depth = 0;
+	while ((std::size_t(2) << (depth + 1)) - 1 <= tasks)
+		++depth;
+
+	std::size_t total = (std::size_t(2) << depth) - 1;
+
+	std::atomic<std::size_t> done{ 0 };
+	std::promise<void> finished;
+
+	auto start = std::chrono::steady_clock::now();
+
+	post_to(pool, [f = fan_out<Pool>{ pool, done, finished, total }, depth]()
+	{
+		f(depth);
+	});
+
+	finished.get_future().wait();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return seconds * double(tasks) / double(total);
+}
+
+// the whole batch is submitted at once.
+double bench_bulk(net::work_stealing_pool& pool, std::size_t tasks)
+{
+	std::atomic<std::size_t> done{ 0 };
+	std::promise<void> finished;
+
+	auto start = std::chrono::steady_clock::now();
+
+	pool.post_bulk(tasks, [&done, &finished, tasks](std::size_t) mutable
+	{
+		if (done.fetch_add(1, std::memory_order_relaxed) + 1 == tasks)
+			finished.set_value();
+	});
+
+	finished.get_future().wait();
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void print(const char* pool, const char* mode, std::size_t threads, std::size_t tasks, double seconds)
+{
+	fmt::print("{:<20} {:<8} threads {:<4} {:>12.1f} ktasks/s\n",
+		pool, mode, threads, double(tasks) / seconds / 1000.0);
+}
+
+int main(int argc, char* argv[])
+{
+	std::size_t tasks = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+	std::size_t max_threads = argc > 2 ? std::stoul(argv[2]) : 64;
+
+	for (std::size_t threads = 1; threads <= max_threads; threads *= 2)
+	{
+		{
+			legacy_thread_pool pool(threads);
+			print("asio3 thread_pool", "post", threads, tasks, bench_post(pool, tasks));
+			print("asio3 thread_pool", "fan-out", threads, tasks, bench_fan_out(pool, tasks));
+		}
+		{
+			net::thread_pool pool(threads);
+			print("asio::thread_pool", "post", threads, tasks, bench_post(pool, tasks));
+			print("asio::thread_pool", "fan-out", threads, tasks, bench_fan_out(pool, tasks));
+			pool.join();
+		}
+		{
+			net::work_stealing_pool pool(threads);
+			print("work_stealing_pool", "post", threads, tasks, bench_post(pool, tasks));
+			print("work_stealing_pool", "fan-out", threads, tasks, bench_fan_out(pool, tasks));
+			print("work_stealing_pool", "bulk", threads, tasks, bench_bulk(pool, tasks));
+		}
+	}
+}
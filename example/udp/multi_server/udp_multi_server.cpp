@@ -0,0 +1,92 @@
+#include <asio3/core/fmt.hpp>
+#include <asio3/udp/udp_multi_server.hpp>
+
+#ifdef ASIO_STANDALONE
+namespace net = ::asio;
+#else
+namespace net = boost::asio;
+#endif
+
+net::awaitable<void> client_join(net::udp_multi_server& server,
+	std::size_t index, std::shared_ptr<net::udp_session> session)
+{
+	co_await net::watchdog(session->watchdog_timer, session->alive_time, net::udp_idle_timeout);
+	co_await session->async_disconnect();
+
+	co_await server.get_session_map(index).async_remove(session);
+}
+
+net::awaitable<void> recv_loop(net::udp_multi_server& server, std::size_t index)
+{
+	// the sessions of this reactor are only in its own session map.
+	auto& session_map = server.get_session_map(index);
+
+	net::datagram_batch batch(64, 1024);
+
+	while (!server.is_aborted())
+	{
+		auto [e1, n1] = co_await server.async_receive_batch(index, batch);
+		if (e1)
+			break;
+
+		for (std::size_t i = 0; i < batch.size(); ++i)
+		{
+			std::string_view data = batch[i].data;
+			net::ip::udp::endpoint remote_endpoint = batch[i].endpoint;
+
+			auto [session] = co_await session_map.async_find(remote_endpoint);
+			if (!session)
+			{
+				session = net::udp_session::create(server.get_socket(index), remote_endpoint);
+				co_await session_map.async_add(session);
+				net::co_spawn(server.get_executor(index), client_join(server, index, session), net::detached);
+			}
+
+			session->update_alive_time();
+
+			fmt::print("{} {} {} {}\n", index,
+				session->get_remote_address(), session->get_remote_port(), data);
+
+			co_await session->async_send(std::string(data));
+		}
+	}
+}
+
+net::awaitable<void> start_server(net::udp_multi_server& server,
+	std::string listen_address, std::uint16_t listen_port)
+{
+	auto [ec, ep] = co_await server.async_open(listen_address, listen_port);
+	if (ec)
+	{
+		fmt::print("listen failure: {}\n", ec.message());
+		co_return;
+	}
+
+	fmt::print("listen success: {} {}\n", server.get_listen_address(), server.get_listen_port());
+
+	for (std::size_t i = 0; i < server.reactor_count(); ++i)
+	{
+		if (server.is_listening(i))
+			net::co_spawn(server.get_executor(i), recv_loop(server, i), net::detached);
+	}
+}
+
+int main()
+{
+	std::vector<net::io_context_thread> reactors((std::max)(std::thread::hardware_concurrency(), 1u));
+
+	net::udp_multi_server server(reactors);
+
+	net::co_spawn(server.get_executor(), start_server(server, "0.0.0.0", 8035), net::detached);
+
+	net::signal_set sigset(server.get_executor(), SIGINT);
+	sigset.async_wait([&server](net::error_code, int) mutable
+	{
+		server.async_stop([](auto) {});
+	});
+
+	for (net::io_context_thread& reactor : reactors)
+	{
+		reactor.join();
+	}
+}
@@ -238,6 +238,23 @@ struct impl_base<true>
         o = pmd_opts_;
     }
 
+    bool
+    get_negotiated_option_pmd(permessage_deflate& o) const
+    {
+        o = pmd_opts_;
+        if(! pmd_)
+            return false;
+        o.server_max_window_bits =
+            pmd_config_.server_max_window_bits;
+        o.client_max_window_bits =
+            pmd_config_.client_max_window_bits;
+        o.server_no_context_takeover =
+            pmd_config_.server_no_context_takeover;
+        o.client_no_context_takeover =
+            pmd_config_.client_no_context_takeover;
+        return true;
+    }
+
 
     void
     build_request_pmd(http::request<http::empty_body>& req)
@@ -433,6 +450,15 @@ struct impl_base<false>
         o.server_enable = false;
     }
 
+    bool
+    get_negotiated_option_pmd(permessage_deflate& o) const
+    {
+        o = {};
+        o.client_enable = false;
+        o.server_enable = false;
+        return false;
+    }
+
     void
     build_request_pmd(
         http::request<http::empty_body>&)
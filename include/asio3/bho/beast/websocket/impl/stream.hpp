@@ -200,6 +200,14 @@ get_option(permessage_deflate& o)
     impl_->get_option_pmd(o);
 }
 
+template<class NextLayer, bool deflateSupported>
+bool
+stream<NextLayer, deflateSupported>::
+get_negotiated_option(permessage_deflate& o) const
+{
+    return impl_->get_negotiated_option_pmd(o);
+}
+
 template<class NextLayer, bool deflateSupported>
 void
 stream<NextLayer, deflateSupported>::
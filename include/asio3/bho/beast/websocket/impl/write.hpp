@@ -897,6 +897,172 @@ async_write(
             bs);
 }
 
+//------------------------------------------------------------------------------
+
+/*
+    This composed operation writes the buffers of pre-encoded
+    frames to the next layer as is, while holding the write lock.
+*/
+template<class NextLayer, bool deflateSupported>
+template<class Handler, class Buffers>
+class stream<NextLayer, deflateSupported>::write_frame_op
+    : public beast::async_base<
+        Handler, beast::executor_type<stream>>
+    , public asio::coroutine
+{
+    std::weak_ptr<impl_type> wp_;
+    Buffers bs_;
+    std::size_t bytes_transferred_ = 0;
+
+public:
+    static constexpr int id = 6; // for soft_mutex
+
+    template<class Handler_>
+    write_frame_op(
+        Handler_&& h,
+        std::shared_ptr<impl_type> const& sp,
+        Buffers const& bs)
+        : beast::async_base<Handler,
+            beast::executor_type<stream>>(
+                std::forward<Handler_>(h),
+                    sp->stream().get_executor())
+        , wp_(sp)
+        , bs_(bs)
+    {
+        (*this)({}, 0, false);
+    }
+
+    void operator()(
+        error_code ec = {},
+        std::size_t bytes_transferred = 0,
+        bool cont = true)
+    {
+        auto sp = wp_.lock();
+        if(! sp)
+        {
+            BHO_BEAST_ASSIGN_EC(ec, net::error::operation_aborted);
+            return this->complete(cont, ec, bytes_transferred_);
+        }
+        auto& impl = *sp;
+        ASIO_CORO_REENTER(*this)
+        {
+            // Acquire the write lock
+            if(! impl.wr_block.try_lock(this))
+            {
+                ASIO_CORO_YIELD
+                {
+                    ASIO_HANDLER_LOCATION((
+                        __FILE__, __LINE__,
+                        "websocket::async_write_frame"));
+                    this->set_allowed_cancellation(net::cancellation_type::all);
+                    impl.op_wr.emplace(std::move(*this),
+                                       net::cancellation_type::all);
+                }
+                if (ec)
+                    return this->complete(cont, ec, bytes_transferred_);
+
+                this->set_allowed_cancellation(net::cancellation_type::terminal);
+                impl.wr_block.lock(this);
+                ASIO_CORO_YIELD
+                {
+                    ASIO_HANDLER_LOCATION((
+                        __FILE__, __LINE__,
+                        "websocket::async_write_frame"));
+
+                    const auto ex = this->get_immediate_executor();
+                    net::dispatch(ex, std::move(*this));
+                }
+                assert(impl.wr_block.is_locked(this));
+            }
+            if(impl.check_stop_now(ec))
+                goto upcall;
+
+            // The frames sent by a client must be masked with
+            // a fresh key, and a data frame can't be sent in
+            // the middle of a fragmented message.
+            if(impl.role == role_type::client || impl.wr_cont)
+            {
+                BHO_BEAST_ASSIGN_EC(ec, net::error::operation_not_supported);
+                goto upcall;
+            }
+
+            // Send the frames
+            ASIO_CORO_YIELD
+            {
+                ASIO_HANDLER_LOCATION((
+                    __FILE__, __LINE__,
+                    "websocket::async_write_frame"));
+
+                net::async_write(impl.stream(), bs_,
+                    beast::detail::bind_continuation(std::move(*this)));
+            }
+            bytes_transferred_ += bytes_transferred;
+            if(impl.check_stop_now(ec))
+                goto upcall;
+
+        upcall:
+            impl.wr_block.unlock(this);
+            impl.op_close.maybe_invoke()
+                || impl.op_idle_ping.maybe_invoke()
+                || impl.op_rd.maybe_invoke()
+                || impl.op_ping.maybe_invoke();
+            this->complete(cont, ec, bytes_transferred_);
+        }
+    }
+};
+
+template<class NextLayer, bool deflateSupported>
+struct stream<NextLayer, deflateSupported>::
+    run_write_frame_op
+{
+    template<
+        class WriteHandler,
+        class ConstBufferSequence>
+    void
+    operator()(
+        WriteHandler&& h,
+        std::shared_ptr<impl_type> const& sp,
+        ConstBufferSequence const& b)
+    {
+        // If you get an error on the following line it means
+        // that your handler does not meet the documented type
+        // requirements for the handler.
+
+        static_assert(
+            beast::detail::is_invocable<WriteHandler,
+                void(error_code, std::size_t)>::value,
+            "WriteHandler type requirements not met");
+
+        write_frame_op<
+            typename std::decay<WriteHandler>::type,
+            ConstBufferSequence>(
+                std::forward<WriteHandler>(h),
+                sp,
+                b);
+    }
+};
+
+template<class NextLayer, bool deflateSupported>
+template<class ConstBufferSequence, BHO_BEAST_ASYNC_TPARAM2 WriteHandler>
+BHO_BEAST_ASYNC_RESULT2(WriteHandler)
+stream<NextLayer, deflateSupported>::
+async_write_frame(
+    ConstBufferSequence const& bs, WriteHandler&& handler)
+{
+    static_assert(is_async_stream<next_layer_type>::value,
+        "AsyncStream type requirements not met");
+    static_assert(net::is_const_buffer_sequence<
+        ConstBufferSequence>::value,
+            "ConstBufferSequence type requirements not met");
+    return net::async_initiate<
+        WriteHandler,
+        void(error_code, std::size_t)>(
+            run_write_frame_op{},
+            handler,
+            impl_,
+            bs);
+}
+
 } // websocket
 } // beast
 } // bho
@@ -405,6 +405,18 @@ public:
     void
     get_option(permessage_deflate& o);
 
+    /** Get the negotiated permessage-deflate extension parameters.
+
+        @param o Set to the permessage-deflate extension options, with
+        the window bits and the context takeover parameters replaced
+        by the values which were negotiated with the peer.
+
+        @return `true` if the permessage-deflate extension is in use
+        on this connection.
+    */
+    bool
+    get_negotiated_option(permessage_deflate& o) const;
+
     /** Set the automatic fragmentation option.
 
         Determines if outgoing message payloads are broken up into
@@ -2783,6 +2795,62 @@ public:
             net::default_completion_token_t<
                 executor_type>{});
 
+    /** Write pre-encoded frames asynchronously.
+
+        This function is used to asynchronously write one or more
+        complete WebSocket messages which were already framed, for
+        example a message which is encoded once and sent to many
+        streams.
+
+        The buffers are written to the next layer as is, while the
+        write lock is held, so they are never interleaved with the
+        control frames sent by this stream. The caller is responsible
+        for the frames being valid for this stream: they must be
+        unmasked, and the reserved bits must only be set as permitted
+        by the negotiated extensions (see @ref get_negotiated_option).
+        The frames do not change the state of the permessage-deflate
+        compressor of this stream, so compressed frames may only be
+        sent if `server_no_context_takeover` was negotiated.
+
+        The program must ensure that no other calls to @ref write,
+        @ref write_some, @ref async_write, or @ref async_write_some
+        are performed until this operation completes.
+
+        @param buffers The buffers containing the encoded frames.
+        The implementation will make copies of this object
+        as needed, but ownership of the underlying memory is not
+        transferred. The caller is responsible for ensuring that
+        the memory locations pointed to by buffers remains valid
+        until the completion handler is called.
+
+        @param handler The completion handler to invoke when the operation
+        completes. The implementation takes ownership of the handler by
+        performing a decay-copy. The equivalent function signature of
+        the handler must be:
+        @code
+        void handler(
+            error_code const& ec,           // Result of operation
+            std::size_t bytes_transferred   // Number of bytes sent from the
+                                            // buffers.
+        );
+        @endcode
+        The operation fails with `net::error::operation_not_supported`
+        in the client role, because the frames sent by a client must be
+        masked with a fresh key, or when a fragmented message is being
+        written.
+    */
+    template<
+        class ConstBufferSequence,
+        BHO_BEAST_ASYNC_TPARAM2 WriteHandler =
+            net::default_completion_token_t<
+                executor_type>>
+    BHO_BEAST_ASYNC_RESULT2(WriteHandler)
+    async_write_frame(
+        ConstBufferSequence const& buffers,
+        WriteHandler&& handler =
+            net::default_completion_token_t<
+                executor_type>{});
+
 private:
     template<class, class>  class accept_op;
     template<class>         class close_op;
@@ -2794,6 +2862,7 @@ private:
     template<class>         class response_op;
     template<class, class>  class write_some_op;
     template<class, class>  class write_op;
+    template<class, class>  class write_frame_op;
 
     struct run_accept_op;
     struct run_close_op;
@@ -2805,6 +2874,7 @@ private:
     struct run_response_op;
     struct run_write_some_op;
     struct run_write_op;
+    struct run_write_frame_op;
 
     static void default_decorate_req(request_type&) {}
     static void default_decorate_res(response_type&) {}
@@ -199,6 +199,80 @@ namespace boost::asio
 		}
 	};
 
+	template<typename SessionT>
+	struct basic_session_map<SessionT>::async_broadcast_op
+	{
+		auto operator()(auto state, auto self_ref, auto&& data, auto&& pred) -> void
+		{
+			using msg_type = std::remove_cvref_t<decltype(data)>;
+			using result_channel_type = experimental::channel<void(error_code, std::size_t, value_type)>;
+
+			auto& self = self_ref.get();
+
+			// the msg is shared by all the sends, so it's only copied once.
+			auto msg = std::make_shared<const msg_type>(std::forward_like<decltype(data)>(data));
+			auto fun = std::forward_like<decltype(pred)>(pred);
+
+			co_await asio::dispatch(asio::use_deferred_executor(self));
+
+			std::vector<value_type> conns;
+
+			{
+				if (!self.lock.try_send())
+				{
+					co_await self.lock.async_send(asio::use_deferred_executor(self.lock));
+				}
+
+				[[maybe_unused]] asio::defer_unlock defered_unlock{ self.lock };
+
+				conns.reserve(self.map.size());
+
+				for (auto& [key, conn] : self.map)
+				{
+					if (fun(conn))
+						conns.emplace_back(conn);
+				}
+			}
+
+			std::size_t total{ 0 };
+			error_code ec{};
+			failures_type failures;
+
+			if (conns.empty())
+				co_return{ ec, total, std::move(failures) };
+
+			// the channel is captured by the send handlers, and the send handlers maybe called
+			// after this operation is destroyed, so it must be a shared_ptr.
+			auto ch = std::make_shared<result_channel_type>(self.get_executor(), conns.size());
+
+			for (value_type& conn : conns)
+			{
+				conn->async_send(asio::to_buffer(*msg), asio::bind_executor(ch->get_executor(),
+				[conn, msg, ch](const error_code& e, std::size_t n) mutable
+				{
+					ch->try_send(e, n, std::move(conn));
+				}));
+			}
+
+			for (std::size_t i = 0; i < conns.size(); ++i)
+			{
+				auto [e1, n1, conn] = co_await ch->async_receive(asio::use_deferred_executor(*ch));
+
+				total += n1;
+
+				if (e1)
+				{
+					if (!ec)
+						ec = e1;
+
+					failures.emplace_back(std::move(conn), e1);
+				}
+			}
+
+			co_return{ ec, total, std::move(failures) };
+		}
+	};
+
 	template<typename SessionT>
 	struct basic_session_map<SessionT>::async_for_each_op
 	{
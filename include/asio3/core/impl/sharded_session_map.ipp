@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+	template<typename SessionT>
+	struct basic_sharded_session_map<SessionT>::async_disconnect_all_op
+	{
+		auto operator()(auto state, auto self_ref, auto&& pred) -> void
+		{
+			using result_channel_type = experimental::channel<void(error_code)>;
+
+			auto& self = self_ref.get();
+			auto fun = std::forward_like<decltype(pred)>(pred);
+
+			// remove the sessions one by one, so the index of the keys is updated too.
+			std::vector<value_type> conns = self.snapshot(fun);
+
+			std::erase_if(conns, [&self](value_type& conn) { return !self.remove(conn); });
+
+			if (conns.empty())
+				co_return 0;
+
+			auto ch = std::make_shared<result_channel_type>(self.get_executor(), conns.size());
+
+			for (value_type& conn : conns)
+			{
+				conn->async_disconnect(asio::bind_executor(ch->get_executor(),
+				[conn, ch](auto...) mutable
+				{
+					ch->try_send(error_code{});
+				}));
+			}
+
+			for (std::size_t i = 0; i < conns.size(); ++i)
+			{
+				co_await ch->async_receive(asio::use_deferred_executor(*ch));
+			}
+
+			co_return conns.size();
+		}
+	};
+
+	template<typename SessionT>
+	struct basic_sharded_session_map<SessionT>::async_broadcast_op
+	{
+		auto operator()(auto state, auto self_ref, auto&& data, auto&& pred) -> void
+		{
+			using msg_type = std::remove_cvref_t<decltype(data)>;
+			using result_channel_type = experimental::channel<void(error_code, std::size_t, value_type)>;
+
+			auto& self = self_ref.get();
+
+			// the msg is shared by all the sends, so it's only copied once.
+			auto msg = std::make_shared<const msg_type>(std::forward_like<decltype(data)>(data));
+			auto fun = std::forward_like<decltype(pred)>(pred);
+
+			std::vector<value_type> conns = self.snapshot(fun);
+
+			std::size_t total{ 0 };
+			error_code ec{};
+			failures_type failures;
+
+			if (conns.empty())
+				co_return{ ec, total, std::move(failures) };
+
+			auto ch = std::make_shared<result_channel_type>(self.get_executor(), conns.size());
+
+			for (value_type& conn : conns)
+			{
+				conn->async_send(asio::to_buffer(*msg), asio::bind_executor(ch->get_executor(),
+				[conn, msg, ch](const error_code& e, std::size_t n) mutable
+				{
+					ch->try_send(e, n, std::move(conn));
+				}));
+			}
+
+			for (std::size_t i = 0; i < conns.size(); ++i)
+			{
+				auto [e1, n1, conn] = co_await ch->async_receive(asio::use_deferred_executor(*ch));
+
+				total += n1;
+
+				if (e1)
+				{
+					if (!ec)
+						ec = e1;
+
+					failures.emplace_back(std::move(conn), e1);
+				}
+			}
+
+			co_return{ ec, total, std::move(failures) };
+		}
+	};
+
+	template<typename SessionT>
+	struct basic_sharded_session_map<SessionT>::async_for_each_op
+	{
+		template<class Function>
+		static asio::awaitable<void> visit(shard& s, Function& fn)
+		{
+			using fun_ret_type = std::invoke_result_t<Function&, value_type&>;
+
+			std::vector<value_type> conns;
+
+			{
+				asio::shared_locker guard(s.mtx);
+
+				conns.reserve(s.map.size());
+
+				for (auto& [key, conn] : s.map)
+				{
+					conns.emplace_back(conn);
+				}
+			}
+
+			for (value_type& conn : conns)
+			{
+				if constexpr (asio::is_template_instance_of<asio::awaitable, fun_ret_type>)
+				{
+					co_await fn(conn);
+				}
+				else
+				{
+					fn(conn);
+				}
+			}
+		}
+
+		template<class Function>
+		auto operator()(auto state, auto self_ref, Function&& func) -> void
+		{
+			auto& self = self_ref.get();
+
+			auto fn = std::forward<Function>(func);
+
+			// the visitors reference the fn which is owned by this operation.
+			state.reset_cancellation_state(asio::disable_cancellation());
+
+			auto ch = std::make_shared<experimental::channel<void(error_code, std::exception_ptr)>>(
+				self.get_executor(), self.shards.size());
+
+			for (auto& s : self.shards)
+			{
+				asio::co_spawn(s->executor, visit(*s, fn), asio::bind_executor(ch->get_executor(),
+				[ch](std::exception_ptr ep) mutable
+				{
+					ch->try_send(error_code{}, std::move(ep));
+				}));
+			}
+
+			std::exception_ptr first;
+
+			// wait for all the shards even if some one failed, because they reference the fn.
+			for (std::size_t i = 0; i < self.shards.size(); ++i)
+			{
+				auto [e1, ep] = co_await ch->async_receive(asio::use_deferred_executor(*ch));
+
+				if (ep && !first)
+					first = std::move(ep);
+			}
+
+			if (first)
+				std::rethrow_exception(first);
+
+			co_return error_code{};
+		}
+	};
+}
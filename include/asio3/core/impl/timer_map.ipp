@@ -61,7 +61,7 @@ namespace boost::asio
 			}
 
 			// the asio::timer's constructor may be throw some exception.
-			value_type timer_ptr = asio::create_timer(
+			value_type timer_ptr = asio::create_timer<TimerObject>(
 				self.get_executor(), first_delay, interval, repeat_times,
 				std::move(callback),
 				[&self, handle]() mutable
@@ -191,42 +191,51 @@ struct length_payload_match_condition
 			});
 	}
 
-	[[nodiscard]] inline static std::string generate_length(asio::const_buffer buffer)
+	/// the max bytes of the length head.
+	static constexpr std::size_t max_length_size = 1 + sizeof(std::uint64_t);
+
+	/**
+	 * @brief Write the length head of the payload into the head buffer, return the bytes of the head.
+	 * @param head - The buffer which size must be at least max_length_size.
+	 */
+	inline static std::size_t generate_length(std::size_t payload_size, char* head) noexcept
 	{
-		std::string head;
-
-		if (buffer.size() < std::size_t(254))
+		if (payload_size < std::size_t(254))
 		{
-			head.resize(1);
-			head[0] = static_cast<std::string::value_type>(buffer.size());
+			head[0] = static_cast<char>(payload_size);
+			return 1;
 		}
-		else if (buffer.size() <= (std::numeric_limits<std::uint16_t>::max)())
+		else if (payload_size <= (std::numeric_limits<std::uint16_t>::max)())
 		{
-			head.resize(3);
-			head[0] = static_cast<std::string::value_type>(254);
-			std::uint16_t size = static_cast<std::uint16_t>(buffer.size());
+			head[0] = static_cast<char>(254);
+			std::uint16_t size = static_cast<std::uint16_t>(payload_size);
 			// use little endian
 			if constexpr (std::endian::native == std::endian::big)
 			{
 				size = ::std::byteswap(size);
 			}
 			std::memcpy(&head[1], reinterpret_cast<const void*>(&size), sizeof(std::uint16_t));
+			return 1 + sizeof(std::uint16_t);
 		}
 		else
 		{
-			assert(buffer.size() > (std::numeric_limits<std::uint16_t>::max)());
-			head.resize(9);
-			head[0] = static_cast<std::uint8_t>(255);
-			std::uint64_t size = buffer.size();
+			head[0] = static_cast<char>(255);
+			std::uint64_t size = payload_size;
 			// use little endian
 			if constexpr (std::endian::native == std::endian::big)
 			{
 				size = ::std::byteswap(size);
 			}
 			std::memcpy(&head[1], reinterpret_cast<const void*>(&size), sizeof(std::uint64_t));
+			return 1 + sizeof(std::uint64_t);
 		}
+	}
+
+	[[nodiscard]] inline static std::string generate_length(asio::const_buffer buffer)
+	{
+		char head[max_length_size];
 
-		return head;
+		return std::string(head, generate_length(buffer.size(), head));
 	}
 };
 
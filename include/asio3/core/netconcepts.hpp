@@ -56,4 +56,11 @@ namespace boost::asio
 	concept convertible_to_buffer_sequence_adapter =
 		convertible_to_const_buffer_sequence_adapter<U> ||
 		convertible_to_mutable_buffer_sequence_adapter<U>;
+
+	/**
+	 * @brief The message which is encoded once and sent to many streams as is, like the
+	 * ws_prepared_message, it isn't a buffer sequence, so it is passed through to_buffer unchanged.
+	 */
+	template<typename T, typename U = std::remove_cvref_t<T>>
+	concept is_prepared_message = requires { typename U::prepared_message_tag; };
 }
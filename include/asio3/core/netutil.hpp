@@ -55,6 +55,9 @@ namespace boost::asio
 	constexpr ::std::chrono::milliseconds  udp_connect_timeout    = ::std::chrono::milliseconds(30 * 1000);
 	constexpr ::std::chrono::milliseconds http_connect_timeout    = ::std::chrono::milliseconds(30 * 1000);
 
+	// RFC 8305 section 5, the delay between two connection attempts of the happy eyeballs connect.
+	constexpr ::std::chrono::milliseconds  tcp_connection_attempt_delay = ::std::chrono::milliseconds(250);
+
 	constexpr ::std::chrono::milliseconds  tcp_disconnect_timeout = ::std::chrono::milliseconds(30 * 1000);
 	constexpr ::std::chrono::milliseconds  udp_disconnect_timeout = ::std::chrono::milliseconds(30 * 1000);
 	constexpr ::std::chrono::milliseconds http_disconnect_timeout = ::std::chrono::milliseconds(3  * 1000);
@@ -84,6 +87,10 @@ namespace boost::asio
 	constexpr ::std::size_t  tcp_frame_size = 1480;
 	constexpr ::std::size_t  udp_frame_size = 548; // LAN:1472 WAN:548
 	constexpr ::std::size_t http_frame_size = 1480;
+
+#if defined(SO_REUSEPORT)
+	using reuse_port = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
 }
 
 #ifdef ASIO_STANDALONE
@@ -166,7 +173,11 @@ namespace boost::asio
 
 	[[nodiscard]] auto to_buffer(auto&& data)
 	{
-		if constexpr (convertible_to_buffer_sequence_adapter<::std::remove_cvref_t<decltype(data)>>)
+		if constexpr (is_prepared_message<::std::remove_cvref_t<decltype(data)>>)
+		{
+			return ::std::forward_like<decltype(data)>(data);
+		}
+		else if constexpr (convertible_to_buffer_sequence_adapter<::std::remove_cvref_t<decltype(data)>>)
 		{
 			return ::std::forward_like<decltype(data)>(data);
 		}
@@ -13,6 +13,7 @@
 #include <asio3/core/asio.hpp>
 #include <asio3/core/netutil.hpp>
 #include <asio3/core/strutil.hpp>
+#include <asio3/core/resolve_cache.hpp>
 
 #ifdef ASIO_STANDALONE
 namespace asio
@@ -32,6 +33,14 @@ namespace boost::asio
 
 		co_await asio::dispatch(asio::use_awaitable_executor(resolver));
 
+		using protocol_type = typename std::remove_cvref_t<AsyncResolver>::protocol_type;
+
+		// use the dns cache if it is attached to the execution context of the resolver.
+		if (auto* cache = asio::find_resolve_cache<protocol_type>(resolver.get_executor()))
+		{
+			co_return co_await cache->resolve(resolver.get_executor(), addr, port, results, resolve_flags);
+		}
+
 		auto [e1, eps] = co_await resolver.async_resolve(
 			addr_sv, port_sv, resolve_flags, asio::use_awaitable_executor(resolver));
 
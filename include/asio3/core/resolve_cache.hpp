@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <asio3/core/asio.hpp>
+
+#ifdef ASIO_STANDALONE
+	#include <asio/experimental/concurrent_channel.hpp>
+#else
+	#include <boost/asio/experimental/concurrent_channel.hpp>
+#endif
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+	struct resolve_cache_option
+	{
+		/// how long a successful result is kept, the getaddrinfo doesn't report the dns ttl.
+		std::chrono::steady_clock::duration positive_ttl = std::chrono::seconds(60);
+
+		/// how long a failed result is kept, avoid hammering the resolver with bad names.
+		std::chrono::steady_clock::duration negative_ttl = std::chrono::seconds(5);
+
+		/// a successful result which is older than this is refreshed in the background
+		/// when it is used, the cached result is returned without waiting the refresh.
+		std::chrono::steady_clock::duration refresh_ahead = std::chrono::seconds(45);
+
+		/// when the entries exceed this count, the expired entries are removed, and then
+		/// the whole cache is cleared if it is still full.
+		std::size_t max_entries = 4096;
+	};
+
+	/**
+	 * @brief A dns cache service which is attached to a execution context. When the service
+	 * exists in the context of the resolver, asio::resolve and asio::async_resolve use it
+	 * transparently. The concurrent lookups of the same name are coalesced into one
+	 * getaddrinfo call.
+	 * @code
+	 *    asio::attach_resolve_cache(ctx.get_executor());
+	 * @endcode
+	 */
+	template<typename InternetProtocol>
+	class basic_resolve_cache
+		: public asio::detail::execution_context_service_base<basic_resolve_cache<InternetProtocol>>
+	{
+	public:
+		using protocol_type = InternetProtocol;
+		using resolver_type = typename InternetProtocol::resolver;
+		using results_type  = typename resolver_type::results_type;
+		using clock_type    = std::chrono::steady_clock;
+
+	protected:
+		using waiter_type = asio::experimental::concurrent_channel<void(asio::error_code, results_type)>;
+
+		struct entry
+		{
+			asio::error_code                          ec{};
+			results_type                              results{};
+			clock_type::time_point                    expiry{};
+			clock_type::time_point                    refresh{};
+			bool                                      valid = false;
+			bool                                      pending = false;
+			std::vector<std::shared_ptr<waiter_type>> waiters;
+		};
+
+	public:
+		explicit basic_resolve_cache(asio::execution_context& ctx)
+			: asio::detail::execution_context_service_base<basic_resolve_cache<InternetProtocol>>(ctx)
+		{
+		}
+
+		~basic_resolve_cache()
+		{
+		}
+
+		void shutdown() override
+		{
+			std::lock_guard g{ mtx_ };
+			entries_.clear();
+		}
+
+		/**
+		 * @brief Resolve the host and service, the result is got from the cache if possible.
+		 * @param ex - The executor which is used to do the getaddrinfo.
+		 */
+		asio::awaitable<asio::error_code> resolve(
+			const auto& ex, const std::string& host, const std::string& service,
+			results_type& results, asio::ip::resolver_base::flags resolve_flags)
+		{
+			std::string key = make_key(host, service, resolve_flags);
+
+			std::shared_ptr<waiter_type> waiter;
+
+			bool refresh = false;
+
+			bool leader = false;
+
+			auto now = clock_type::now();
+
+			{
+				std::lock_guard g{ mtx_ };
+
+				entry& e = entries_[key];
+
+				if (e.valid && now < e.expiry)
+				{
+					results = e.results;
+
+					if (!e.ec && !e.pending && now >= e.refresh)
+					{
+						e.pending = true;
+						refresh = true;
+					}
+					else
+					{
+						co_return e.ec;
+					}
+				}
+				else
+				{
+					leader = !e.pending;
+
+					e.pending = true;
+
+					// the caller which starts the lookup waits for the result like the others,
+					// so when it's cancelled, only itself gets the operation_aborted.
+					waiter = std::make_shared<waiter_type>(ex, 1);
+					e.waiters.emplace_back(waiter);
+				}
+			}
+
+			if (refresh || leader)
+			{
+				asio::co_spawn(ex, lookup(ex, key, host, service, resolve_flags), asio::detached);
+			}
+
+			if (refresh)
+			{
+				co_return asio::error_code{};
+			}
+
+			auto [e1, eps] = co_await waiter->async_receive(asio::use_nothrow_awaitable);
+			results = std::move(eps);
+			co_return e1;
+		}
+
+		/**
+		 * @brief Remove all the cached results of the host.
+		 */
+		inline void erase(std::string_view host)
+		{
+			std::lock_guard g{ mtx_ };
+			std::erase_if(entries_, [host](const auto& pair)
+			{
+				return !pair.second.pending && std::string_view(pair.first).substr(0, pair.first.find('\0')) == host;
+			});
+		}
+
+		/**
+		 * @brief Remove all the cached results, the pending lookups are not affected.
+		 */
+		inline void clear()
+		{
+			std::lock_guard g{ mtx_ };
+			std::erase_if(entries_, [](const auto& pair) { return !pair.second.pending; });
+		}
+
+		/**
+		 * @brief Get the count of the cached names.
+		 */
+		inline std::size_t size()
+		{
+			std::lock_guard g{ mtx_ };
+			return entries_.size();
+		}
+
+		inline void set_option(resolve_cache_option opt)
+		{
+			std::lock_guard g{ mtx_ };
+			option_ = std::move(opt);
+		}
+
+		inline resolve_cache_option get_option()
+		{
+			std::lock_guard g{ mtx_ };
+			return option_;
+		}
+
+	protected:
+		static std::string make_key(
+			const std::string& host, const std::string& service, asio::ip::resolver_base::flags resolve_flags)
+		{
+			std::string key;
+			key.reserve(host.size() + service.size() + 8);
+			key += host;
+			key += '\0';
+			key += service;
+			key += '\0';
+			key += std::to_string(static_cast<int>(resolve_flags));
+			return key;
+		}
+
+		asio::awaitable<std::tuple<asio::error_code, results_type>> lookup(
+			auto ex, std::string key, std::string host, std::string service,
+			asio::ip::resolver_base::flags resolve_flags)
+		{
+			resolver_type resolver(ex);
+
+			auto [ec, eps] = co_await resolver.async_resolve(
+				host, service, resolve_flags, asio::use_nothrow_awaitable);
+
+			std::vector<std::shared_ptr<waiter_type>> waiters;
+
+			{
+				std::lock_guard g{ mtx_ };
+
+				auto now = clock_type::now();
+
+				entry& e = entries_[key];
+
+				e.pending = false;
+
+				waiters = std::move(e.waiters);
+
+				// the lookup was cancelled by the shutdown of the context, don't cache it.
+				if (ec == asio::error::operation_aborted)
+				{
+					if (!e.valid)
+						entries_.erase(key);
+				}
+				// a failed background refresh keeps the old result until it expired.
+				else if (!ec || !e.valid || e.ec || now >= e.expiry)
+				{
+					e.ec = ec;
+					e.results = eps;
+					e.valid = true;
+					e.expiry = now + (ec ? option_.negative_ttl : option_.positive_ttl);
+					e.refresh = now + option_.refresh_ahead;
+				}
+
+				if (entries_.size() > option_.max_entries)
+					purge(now);
+			}
+
+			for (std::shared_ptr<waiter_type>& waiter : waiters)
+			{
+				waiter->try_send(ec, eps);
+			}
+
+			co_return std::tuple{ ec, std::move(eps) };
+		}
+
+		void purge(clock_type::time_point now)
+		{
+			std::erase_if(entries_, [now](const auto& pair)
+			{
+				return !pair.second.pending && now >= pair.second.expiry;
+			});
+
+			if (entries_.size() > option_.max_entries)
+			{
+				std::erase_if(entries_, [](const auto& pair) { return !pair.second.pending; });
+			}
+		}
+
+	protected:
+		std::mutex                             mtx_;
+
+		resolve_cache_option                   option_;
+
+		std::unordered_map<std::string, entry> entries_;
+	};
+
+	using tcp_resolve_cache = basic_resolve_cache<asio::ip::tcp>;
+	using udp_resolve_cache = basic_resolve_cache<asio::ip::udp>;
+
+	/**
+	 * @brief Attach the tcp and udp dns cache to the execution context of the executor.
+	 * All the resolvers which use this execution context will use the cache after that.
+	 * @param executor - The executor or the execution context.
+	 */
+	inline void attach_resolve_cache(auto&& executor, resolve_cache_option opt = {})
+	{
+		asio::execution_context* ctx = nullptr;
+
+		if constexpr (std::derived_from<std::remove_cvref_t<decltype(executor)>, asio::execution_context>)
+			ctx = std::addressof(executor);
+		else
+			ctx = std::addressof(asio::query(executor, asio::execution::context_as<asio::execution_context&>));
+
+		asio::use_service<tcp_resolve_cache>(*ctx).set_option(opt);
+		asio::use_service<udp_resolve_cache>(*ctx).set_option(std::move(opt));
+	}
+
+	/**
+	 * @brief Get the dns cache which is attached to the execution context of the executor.
+	 * @return Returns nullptr if the cache is not attached.
+	 */
+	template<typename InternetProtocol>
+	inline basic_resolve_cache<InternetProtocol>* find_resolve_cache(const auto& executor)
+	{
+		asio::execution_context& ctx = asio::query(
+			executor, asio::execution::context_as<asio::execution_context&>);
+
+		if (!asio::has_service<basic_resolve_cache<InternetProtocol>>(ctx))
+			return nullptr;
+
+		return std::addressof(asio::use_service<basic_resolve_cache<InternetProtocol>>(ctx));
+	}
+}
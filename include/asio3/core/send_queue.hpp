@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include <asio3/core/asio.hpp>
+#include <asio3/core/netconcepts.hpp>
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+	/**
+	 * @brief A write-coalescing send queue for stream sockets.
+	 * All the messages which are queued while a write is in progress will be sent
+	 * by the next write with one scatter/gather call, every sender is completed
+	 * with the byte count of its own message. Every writer only sends one batch,
+	 * then the sender of the next queued message becomes the writer.
+	 * This class is not thread safety, it must be accessed in the executor thread
+	 * of the stream which it is attached to.
+	 */
+	class send_queue
+	{
+	public:
+		using notify_type = experimental::channel<void(error_code, std::size_t)>;
+
+		struct entry
+		{
+			// used when the message is a single buffer, this is the most case.
+			asio::const_buffer              buffer;
+
+			// used when the message is a buffer sequence which has multi buffers.
+			std::vector<asio::const_buffer> buffers;
+
+			std::size_t                     size = 0;
+
+			notify_type*                    notify = nullptr;
+		};
+
+		send_queue() = default;
+
+		send_queue(send_queue&&) noexcept = default;
+		send_queue& operator=(send_queue&&) noexcept = default;
+
+		/**
+		 * @brief Append the message to the queue.
+		 * The memory of the message must be valid until the notify is triggered.
+		 */
+		inline void push(const auto& data, notify_type* notify)
+		{
+			entry& e = entries.emplace_back();
+
+			if constexpr (std::is_convertible_v<decltype(data), asio::const_buffer>)
+			{
+				e.buffer = asio::const_buffer(data);
+			}
+			else
+			{
+				e.buffers.assign(asio::buffer_sequence_begin(data), asio::buffer_sequence_end(data));
+			}
+
+			e.size = asio::buffer_size(data);
+			e.notify = notify;
+
+			queued_bytes += e.size;
+		}
+
+		/**
+		 * @brief Check whether the message should wait for free space before pushing.
+		 * The first message is always accepted even if it's larger than the high water mark.
+		 */
+		[[nodiscard]] inline bool is_full(std::size_t size) const noexcept
+		{
+			if (!space_waiters.empty())
+				return true;
+
+			return !entries.empty() && queued_bytes + size > high_water_mark;
+		}
+
+		/**
+		 * @brief Move all the queued messages into the batch, and collect their buffers.
+		 */
+		inline void take(std::deque<entry>& batch, std::vector<asio::const_buffer>& gather)
+		{
+			batch.clear();
+			gather.clear();
+
+			batch.swap(entries);
+
+			for (entry& e : batch)
+			{
+				if (e.buffers.empty())
+					gather.emplace_back(e.buffer);
+				else
+					gather.insert(gather.end(), e.buffers.begin(), e.buffers.end());
+			}
+		}
+
+		/**
+		 * @brief Notify every sender in the batch with the byte count of its own message.
+		 */
+		inline void complete(std::deque<entry>& batch, const error_code& ec, std::size_t bytes_sent)
+		{
+			for (entry& e : batch)
+			{
+				std::size_t n = (std::min)(e.size, bytes_sent);
+
+				bytes_sent -= n;
+				queued_bytes -= e.size;
+
+				e.notify->try_send(ec, n);
+			}
+
+			batch.clear();
+
+			// if the socket is broken, all the queued messages will never be sent.
+			if (ec)
+			{
+				for (entry& e : entries)
+				{
+					e.notify->try_send(ec, 0);
+				}
+
+				entries.clear();
+
+				queued_bytes = 0;
+			}
+
+			while (!space_waiters.empty() && (ec || queued_bytes < high_water_mark))
+			{
+				notify_type* notify = space_waiters.front();
+
+				space_waiters.pop_front();
+
+				notify->try_send(ec, 0);
+			}
+		}
+
+		/**
+		 * @brief Hand the queue over to the sender of the first queued message after the writer
+		 * sent its batch, the chosen sender will write the next batch.
+		 */
+		inline void handoff()
+		{
+			if (entries.empty())
+			{
+				writing = false;
+				return;
+			}
+
+			next_writer = entries.front().notify;
+
+			next_writer->try_send(error_code{}, 0);
+		}
+
+	public:
+		/// Whether to use the send queue or not, default is false.
+		bool        enabled = false;
+
+		/// When the queued bytes exceed this value, the senders will wait until
+		/// the queue is drained below it.
+		std::size_t high_water_mark = 4 * 1024 * 1024;
+
+		/// The queued messages that are waiting for writing.
+		std::deque<entry> entries;
+
+		/// The senders that are waiting for free space.
+		std::deque<notify_type*> space_waiters;
+
+		/// The total bytes of the queued messages.
+		std::size_t queued_bytes = 0;
+
+		/// Whether there is a sender is draining the queue now.
+		bool        writing = false;
+
+		/// The sender which is chosen to write the next batch.
+		notify_type* next_writer = nullptr;
+	};
+}
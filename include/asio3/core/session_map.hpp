@@ -32,6 +32,7 @@ namespace boost::asio
 		using map_type   = std::unordered_map<key_type, value_type>;
 		using lock_type  = as_tuple_t<use_awaitable_t<>>::as_default_on_t<experimental::channel<void()>>;
 		using executor_type = typename lock_type::executor_type;
+		using failures_type = std::vector<std::pair<value_type, error_code>>;
 
 		struct async_add_op;
 		struct async_find_or_add_op;
@@ -39,6 +40,7 @@ namespace boost::asio
 		struct async_find_op;
 		struct async_disconnect_all_op;
 		struct async_send_all_op;
+		struct async_broadcast_op;
 		struct async_for_each_op;
 
 	public:
@@ -189,6 +191,51 @@ namespace boost::asio
 				std::forward_like<decltype(pred)>(pred));
 		}
 
+		/**
+		 * @brief send data to all the sessions in the map concurrently.
+		 * The data is wrapped into a shared immutable buffer once, and all the sends are started
+		 * at the same time without holding the map lock while the io is in flight, so the total
+		 * time is bounded by the slowest session.
+		 * @param data - 
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, std::size_t sent_bytes,
+		 *        std::vector<std::pair<std::shared_ptr<session_type>, asio::error_code>> failures);
+		 *    the ec is the error of the first failed session, failures contains all the failed sessions.
+		 */
+		template<typename BroadcastToken = asio::default_token_type<lock_type>>
+		inline auto async_broadcast(
+			auto&& data,
+			BroadcastToken&& token = asio::default_token_type<lock_type>())
+		{
+			return asio::async_initiate<BroadcastToken, void(error_code, std::size_t, failures_type)>(
+				asio::experimental::co_composed<void(error_code, std::size_t, failures_type)>(
+					async_broadcast_op{}, lock),
+				token, std::ref(*this),
+				detail::data_persist(std::forward_like<decltype(data)>(data)),
+				[](auto&) { return true; });
+		}
+
+		/**
+		 * @brief send data to the selected sessions in the map concurrently.
+		 * @param data - 
+		 * @param pred - [](auto& conn){ return true; }
+		 */
+		template<typename BroadcastToken = asio::default_token_type<lock_type>>
+		inline auto async_broadcast_selected(
+			auto&& data,
+			auto&& pred,
+			BroadcastToken&& token = asio::default_token_type<lock_type>())
+		{
+			return asio::async_initiate<BroadcastToken, void(error_code, std::size_t, failures_type)>(
+				asio::experimental::co_composed<void(error_code, std::size_t, failures_type)>(
+					async_broadcast_op{}, lock),
+				token, std::ref(*this),
+				detail::data_persist(std::forward_like<decltype(data)>(data)),
+				std::forward_like<decltype(pred)>(pred));
+		}
+
 		/**
 		 * @brief call user custom callback function for every session
 		 * the custom callback function is like this :
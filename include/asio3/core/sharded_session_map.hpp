@@ -0,0 +1,619 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <bit>
+
+#include <asio3/core/asio.hpp>
+#include <asio3/core/with_lock.hpp>
+#include <asio3/core/netutil.hpp>
+#include <asio3/core/function_traits.hpp>
+#include <asio3/core/data_persist.hpp>
+#include <asio3/core/shared_mutex.hpp>
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+	/**
+	 * @brief A session map which partitions the keys across several shards, each shard
+	 * is guarded by its own shared mutex, so it can be accessed from any thread directly
+	 * without dispatching to a single executor.
+	 * The interface is same as the basic_session_map, so it can be used by the servers
+	 * as a drop-in replacement, and the synchronous functions can be used additionally.
+	 * If the map is created by a group of executors, every executor has its own shard and
+	 * the sessions are stored in the shard of their executor, so the sessions of a reactor
+	 * are only contended by the threads which touch the same reactor, and the shard of a key
+	 * is recorded in the index of the shard which the key is hashed to.
+	 */
+	template<typename SessionT>
+	class basic_sharded_session_map
+	{
+	public:
+		using session_type  = SessionT;
+		using key_type      = typename session_type::key_type;
+		using value_type    = std::shared_ptr<session_type>;
+		using map_type      = std::unordered_map<key_type, value_type>;
+		using executor_type = asio::any_io_executor;
+		using token_type    = as_tuple_t<use_awaitable_t<>>;
+		using failures_type = std::vector<std::pair<value_type, error_code>>;
+
+		struct alignas(64) shard
+		{
+			explicit shard(const executor_type& ex) : executor(ex)
+			{
+			}
+
+			// used to visit the sessions of this shard when call async_for_each.
+			executor_type        executor;
+
+			asio::shared_mutexer mtx;
+
+			map_type             map ASIO3_GUARDED_BY(mtx);
+
+			// only used when the sessions are stored by executor, the keys which are hashed to
+			// this shard and the shards which the sessions are stored in. the index_mtx is always
+			// locked before the mtx.
+			asio::shared_mutexer index_mtx;
+
+			std::unordered_map<key_type, shard*> index ASIO3_GUARDED_BY(index_mtx);
+		};
+
+		struct async_disconnect_all_op;
+		struct async_broadcast_op;
+		struct async_for_each_op;
+
+	public:
+		/**
+		 * @brief constructor, all the shards use the same executor.
+		 * @param shard_count - the shard count, it will be rounded up to the power of 2.
+		 */
+		template<class Executor>
+		explicit basic_sharded_session_map(const Executor& ex,
+			std::size_t shard_count = asio::default_concurrency()) : executor(ex)
+		{
+			shard_count = std::bit_ceil((std::max)(shard_count, std::size_t(1)));
+
+			shards.reserve(shard_count);
+
+			for (std::size_t i = 0; i < shard_count; ++i)
+			{
+				shards.emplace_back(std::make_unique<shard>(executor));
+			}
+		}
+
+		/**
+		 * @brief constructor, one shard per executor, the session is stored in the shard of the
+		 * executor which it runs on, and the async_for_each visits the shards in parallel.
+		 */
+		template<class Executor>
+		explicit basic_sharded_session_map(const std::vector<Executor>& executors)
+			: executor(executors.at(0)), by_executor(true)
+		{
+			shards.reserve(executors.size());
+
+			for (const Executor& ex : executors)
+			{
+				shards.emplace_back(std::make_unique<shard>(ex));
+			}
+		}
+
+		basic_sharded_session_map(basic_sharded_session_map&&) noexcept = default;
+		basic_sharded_session_map& operator=(basic_sharded_session_map&&) noexcept = default;
+
+		~basic_sharded_session_map()
+		{
+		}
+
+		/**
+		 * @brief Get the shard which the key belongs to.
+		 */
+		[[nodiscard]] inline shard& shard_of(const key_type& key) noexcept
+		{
+			// the key of the tcp session is the address of the session object, the low bits of
+			// it are always zero, so mix the bits by the fibonacci hashing before use it.
+			std::uint64_t h = static_cast<std::uint64_t>(std::hash<key_type>{}(key));
+
+			h = (h ^ (h >> 32)) * 0x9E3779B97F4A7C15ull;
+
+			return *shards[static_cast<std::size_t>(h >> 32) % shards.size()];
+		}
+
+		/**
+		 * @brief Get the shard which the session belongs to.
+		 */
+		[[nodiscard]] inline shard& shard_of(const value_type& conn) noexcept
+		{
+			if (by_executor)
+			{
+				auto ex = conn->get_executor();
+
+				for (auto& s : shards)
+				{
+					if (s->executor == ex)
+						return *s;
+				}
+			}
+
+			return shard_of(conn->hash_key());
+		}
+
+		/**
+		 * @brief add session, this function is thread safety.
+		 */
+		inline bool add(value_type conn)
+		{
+			key_type key = conn->hash_key();
+
+			if (by_executor)
+			{
+				shard& h = shard_of(key);
+
+				asio::unique_locker index_guard(h.index_mtx);
+
+				if (h.index.contains(key))
+					return false;
+
+				return emplace_unlocked(h, key, std::move(conn)).second;
+			}
+
+			shard& s = shard_of(key);
+
+			asio::unique_locker guard(s.mtx);
+
+			return s.map.emplace(std::move(key), std::move(conn)).second;
+		}
+
+		/**
+		 * @brief find the session, if it's not exists, add a new session, this function is thread safety.
+		 */
+		inline std::pair<value_type, bool> find_or_add(const key_type& key, auto&& create_func)
+		{
+			// the index of the key is locked while the session is created, so the same key is
+			// never added to two shards.
+			if (by_executor)
+			{
+				if (value_type conn = find(key))
+					return { std::move(conn), false };
+
+				shard& h = shard_of(key);
+
+				asio::unique_locker index_guard(h.index_mtx);
+
+				if (auto it = h.index.find(key); it != h.index.end())
+				{
+					asio::shared_locker guard(it->second->mtx);
+
+					return { it->second->map.at(key), false };
+				}
+
+				return emplace_unlocked(h, key, create_func());
+			}
+
+			shard& s = shard_of(key);
+
+			{
+				asio::shared_locker guard(s.mtx);
+
+				if (auto it = s.map.find(key); it != s.map.end())
+					return { it->second, false };
+			}
+
+			asio::unique_locker guard(s.mtx);
+
+			// double check, another thread maybe added it already.
+			auto it = s.map.find(key);
+			if (it != s.map.end())
+				return { it->second, false };
+
+			it = s.map.emplace(key, create_func()).first;
+
+			return { it->second, true };
+		}
+
+		/**
+		 * @brief remove session by the key, this function is thread safety.
+		 */
+		inline bool remove(const key_type& key)
+		{
+			if (by_executor)
+			{
+				shard& h = shard_of(key);
+
+				asio::unique_locker index_guard(h.index_mtx);
+
+				auto it = h.index.find(key);
+				if (it == h.index.end())
+					return false;
+
+				{
+					asio::unique_locker guard(it->second->mtx);
+
+					it->second->map.erase(key);
+				}
+
+				h.index.erase(it);
+
+				return true;
+			}
+
+			shard& s = shard_of(key);
+
+			asio::unique_locker guard(s.mtx);
+
+			return s.map.erase(key) > 0;
+		}
+
+		/**
+		 * @brief remove the specified session, this function is thread safety.
+		 */
+		inline bool remove(const value_type& conn)
+		{
+			return remove(conn->hash_key());
+		}
+
+		/**
+		 * @brief find session by the key, this function is thread safety.
+		 */
+		[[nodiscard]] inline value_type find(const key_type& key)
+		{
+			if (by_executor)
+			{
+				shard& h = shard_of(key);
+
+				asio::shared_locker index_guard(h.index_mtx);
+
+				auto it = h.index.find(key);
+				if (it == h.index.end())
+					return nullptr;
+
+				asio::shared_locker guard(it->second->mtx);
+
+				return it->second->map.at(key);
+			}
+
+			shard& s = shard_of(key);
+
+			asio::shared_locker guard(s.mtx);
+
+			auto it = s.map.find(key);
+
+			return it == s.map.end() ? nullptr : it->second;
+		}
+
+		/**
+		 * @brief Get the selected sessions, the shards are locked one by one.
+		 * @param pred - [](auto& conn){ return true; }
+		 */
+		[[nodiscard]] inline std::vector<value_type> snapshot(auto&& pred)
+		{
+			std::vector<value_type> conns;
+
+			for (auto& s : shards)
+			{
+				asio::shared_locker guard(s->mtx);
+
+				for (auto& [key, conn] : s->map)
+				{
+					if (pred(conn))
+						conns.emplace_back(conn);
+				}
+			}
+
+			return conns;
+		}
+
+		/**
+		 * @brief Get all the sessions, the shards are locked one by one.
+		 */
+		[[nodiscard]] inline std::vector<value_type> snapshot()
+		{
+			return snapshot([](auto&) { return true; });
+		}
+
+		/**
+		 * @brief add session
+		 */
+		template<typename AddToken = token_type>
+		inline auto async_add(
+			value_type conn,
+			AddToken&& token = token_type())
+		{
+			return asio::async_initiate<AddToken, void(bool)>(
+				[](auto handler, auto self_ref, value_type conn) mutable
+				{
+					auto& self = self_ref.get();
+					self.complete_immediately(std::move(handler), self.add(std::move(conn)));
+				}, token, std::ref(*this), std::move(conn));
+		}
+
+		/**
+		 * @brief find the session, if it's not exists, add a new session
+		 */
+		template<typename AddToken = token_type>
+		inline auto async_find_or_add(
+			key_type key,
+			auto&& create_func,
+			AddToken&& token = token_type())
+		{
+			return asio::async_initiate<AddToken, void(value_type, bool)>(
+				[](auto handler, auto self_ref, key_type key, auto&& create_func) mutable
+				{
+					auto& self = self_ref.get();
+					auto [conn, inserted] = self.find_or_add(key, create_func);
+					self.complete_immediately(std::move(handler), std::move(conn), inserted);
+				}, token, std::ref(*this), std::move(key),
+				std::forward_like<decltype(create_func)>(create_func));
+		}
+
+		/**
+		 * @brief remove session by the key
+		 */
+		template<typename RemoveToken = token_type>
+		inline auto async_remove(
+			key_type key,
+			RemoveToken&& token = token_type())
+		{
+			return asio::async_initiate<RemoveToken, void(bool)>(
+				[](auto handler, auto self_ref, key_type key) mutable
+				{
+					auto& self = self_ref.get();
+					self.complete_immediately(std::move(handler), self.remove(key));
+				}, token, std::ref(*this), std::move(key));
+		}
+
+		/**
+		 * @brief remove the specified session
+		 */
+		template<typename RemoveToken = token_type>
+		inline auto async_remove(
+			std::shared_ptr<session_type>& conn,
+			RemoveToken&& token = token_type())
+		{
+			return asio::async_initiate<RemoveToken, void(bool)>(
+				[](auto handler, auto self_ref, value_type conn) mutable
+				{
+					auto& self = self_ref.get();
+					self.complete_immediately(std::move(handler), self.remove(conn));
+				}, token, std::ref(*this), conn);
+		}
+
+		/**
+		 * @brief find session by the key
+		 */
+		template<typename FindToken = token_type>
+		inline auto async_find(
+			key_type key,
+			FindToken&& token = token_type())
+		{
+			return asio::async_initiate<FindToken, void(value_type)>(
+				[](auto handler, auto self_ref, key_type key) mutable
+				{
+					auto& self = self_ref.get();
+					self.complete_immediately(std::move(handler), self.find(key));
+				}, token, std::ref(*this), std::move(key));
+		}
+
+		/**
+		 * @brief disconnect all the sessions in the map.
+		 */
+		template<typename DisconnectToken = token_type>
+		inline auto async_disconnect_all(
+			DisconnectToken&& token = token_type())
+		{
+			return asio::async_initiate<DisconnectToken, void(std::size_t)>(
+				asio::experimental::co_composed<void(std::size_t)>(
+					async_disconnect_all_op{}, executor),
+				token, std::ref(*this), [](auto&) { return true; });
+		}
+
+		/**
+		 * @brief disconnect the selected sessions in the map.
+		 */
+		template<typename DisconnectToken = token_type>
+		inline auto async_disconnect_selected(
+			auto&& pred,
+			DisconnectToken&& token = token_type())
+		{
+			return asio::async_initiate<DisconnectToken, void(std::size_t)>(
+				asio::experimental::co_composed<void(std::size_t)>(
+					async_disconnect_all_op{}, executor),
+				token, std::ref(*this), std::forward_like<decltype(pred)>(pred));
+		}
+
+		/**
+		 * @brief send data to all the sessions in the map concurrently.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, std::size_t sent_bytes,
+		 *        std::vector<std::pair<std::shared_ptr<session_type>, asio::error_code>> failures);
+		 */
+		template<typename BroadcastToken = token_type>
+		inline auto async_broadcast(
+			auto&& data,
+			BroadcastToken&& token = token_type())
+		{
+			return asio::async_initiate<BroadcastToken, void(error_code, std::size_t, failures_type)>(
+				asio::experimental::co_composed<void(error_code, std::size_t, failures_type)>(
+					async_broadcast_op{}, executor),
+				token, std::ref(*this),
+				detail::data_persist(std::forward_like<decltype(data)>(data)),
+				[](auto&) { return true; });
+		}
+
+		/**
+		 * @brief send data to the selected sessions in the map concurrently.
+		 * @param pred - [](auto& conn){ return true; }
+		 */
+		template<typename BroadcastToken = token_type>
+		inline auto async_broadcast_selected(
+			auto&& data,
+			auto&& pred,
+			BroadcastToken&& token = token_type())
+		{
+			return asio::async_initiate<BroadcastToken, void(error_code, std::size_t, failures_type)>(
+				asio::experimental::co_composed<void(error_code, std::size_t, failures_type)>(
+					async_broadcast_op{}, executor),
+				token, std::ref(*this),
+				detail::data_persist(std::forward_like<decltype(data)>(data)),
+				std::forward_like<decltype(pred)>(pred));
+		}
+
+		/**
+		 * @brief send data to all the sessions in the map, same as async_broadcast but the
+		 * failures is not reported.
+		 */
+		template<typename SendToken = token_type>
+		inline auto async_send_all(
+			auto&& data,
+			SendToken&& token = token_type())
+		{
+			return this->async_send_selected(std::forward_like<decltype(data)>(data),
+				[](auto&) { return true; }, std::forward<SendToken>(token));
+		}
+
+		/**
+		 * @brief send data to the selected sessions in the map.
+		 * @param pred - [](auto& conn){ return true; }
+		 */
+		template<typename SendToken = token_type>
+		inline auto async_send_selected(
+			auto&& data,
+			auto&& pred,
+			SendToken&& token = token_type())
+		{
+			return this->async_broadcast_selected(
+				std::forward_like<decltype(data)>(data),
+				std::forward_like<decltype(pred)>(pred),
+				asio::deferred([](error_code ec, std::size_t n, failures_type) mutable
+				{
+					return asio::deferred.values(std::move(ec), n);
+				}))(std::forward<SendToken>(token));
+		}
+
+		/**
+		 * @brief call user custom callback function for every session, the shards are
+		 * visited in parallel on their own executors, so the callback function maybe called
+		 * in multi threads at the same time.
+		 * the custom callback function is like this :
+		 * [](std::shared_ptr<tcp_session>& conn){}
+		 * if the callback function throws, the shard stops visiting its remaining sessions,
+		 * the other shards are still visited, and the first exception is rethrown after that.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec);
+		 */
+		template<
+			typename Function,
+			typename ForEachToken = token_type>
+		inline auto async_for_each(
+			Function&& func,
+			ForEachToken&& token = token_type())
+		{
+			return asio::async_initiate<ForEachToken, void(asio::error_code)>(
+				asio::experimental::co_composed<void(asio::error_code)>(
+					async_for_each_op{}, executor),
+				token, std::ref(*this), std::forward<Function>(func));
+		}
+
+		/**
+		 * @brief get session count
+		 */
+		[[nodiscard]] inline std::size_t size() noexcept
+		{
+			std::size_t total = 0;
+
+			for (auto& s : shards)
+			{
+				asio::shared_locker guard(s->mtx);
+
+				total += s->map.size();
+			}
+
+			return total;
+		}
+
+		/**
+		 * @brief get session count
+		 */
+		[[nodiscard]] inline std::size_t count() noexcept
+		{
+			return this->size();
+		}
+
+		/**
+		 * @brief Checks if the session container has no elements
+		 */
+		[[nodiscard]] inline bool empty() noexcept
+		{
+			return this->size() == 0;
+		}
+
+		/**
+		 * @brief Get the executor associated with the object.
+		 */
+		inline const auto& get_executor(this auto&& self) noexcept
+		{
+			return self.executor;
+		}
+
+	protected:
+		/**
+		 * @brief Store the session in the shard of its executor and record it in the index,
+		 * the index_mtx of the h must be locked by the caller.
+		 */
+		inline std::pair<value_type, bool> emplace_unlocked(shard& h, const key_type& key, value_type conn)
+		{
+			shard& s = shard_of(conn);
+
+			{
+				asio::unique_locker guard(s.mtx);
+
+				s.map.emplace(key, conn);
+			}
+
+			h.index.emplace(key, std::addressof(s));
+
+			return { std::move(conn), true };
+		}
+
+		/**
+		 * @brief Complete the handler without an extra async operation.
+		 * The handler is dispatched to its associated immediate executor, which is the
+		 * executor of this map with blocking.never by default, so the handler is never
+		 * called inside the initiating function.
+		 */
+		template<typename Handler, typename... Args>
+		inline void complete_immediately(Handler&& handler, Args&&... args)
+		{
+			auto ex = asio::get_associated_immediate_executor(handler, executor);
+
+			asio::dispatch(ex, asio::append(std::forward<Handler>(handler), std::forward<Args>(args)...));
+		}
+
+	public:
+		executor_type executor;
+
+		std::vector<std::unique_ptr<shard>> shards;
+
+		/// whether the sessions are stored in the shard of their executor or not.
+		bool          by_executor = false;
+	};
+
+	template<typename SessionT>
+	using sharded_session_map = basic_sharded_session_map<SessionT>;
+}
+
+#include <asio3/core/impl/sharded_session_map.ipp>
@@ -16,6 +16,7 @@
 #include <asio3/core/netutil.hpp>
 #include <asio3/core/defer.hpp>
 #include <asio3/core/with_lock.hpp>
+#include <asio3/core/timer_wheel.hpp>
 
 #ifdef ASIO_STANDALONE
 namespace asio
@@ -173,11 +174,12 @@ namespace boost::asio::detail
 
 	struct call_func_when_timeout
 	{
-		::std::shared_ptr<asio::timer> timer_ptr;
+		// the timeouts are coarse-grained, so they share the timer wheel of the executor.
+		::std::shared_ptr<asio::wheel_timer> timer_ptr;
 
 		call_func_when_timeout(auto&& executor, asio::timer::duration timeout_value, auto&& func)
 		{
-			timer_ptr = ::std::make_shared<asio::timer>(executor);
+			timer_ptr = ::std::make_shared<asio::wheel_timer>(executor);
 			timer_ptr->expires_after(timeout_value);
 			timer_ptr->async_wait(
 			[p = timer_ptr, f = ::std::forward_like<decltype(func)>(func)]
@@ -202,16 +204,16 @@ namespace boost::asio::detail
 
 	struct timer_callback_helper
 	{
-		template<class F>
-		requires (::std::invocable<::std::decay_t<F>, ::std::shared_ptr<asio::timer>&>)
-		static inline asio::awaitable<bool> call(F& f, ::std::shared_ptr<asio::timer>& timer_ptr)
+		template<class F, class Timer>
+		requires (::std::invocable<::std::decay_t<F>, ::std::shared_ptr<Timer>&>)
+		static inline asio::awaitable<bool> call(F& f, ::std::shared_ptr<Timer>& timer_ptr)
 		{
 			co_return co_await f(timer_ptr);
 		}
 
-		template<class F>
-		requires (!::std::invocable<::std::decay_t<F>, ::std::shared_ptr<asio::timer>&>)
-		static inline asio::awaitable<bool> call(F& f, ::std::shared_ptr<asio::timer>&)
+		template<class F, class Timer>
+		requires (!::std::invocable<::std::decay_t<F>, ::std::shared_ptr<Timer>&>)
+		static inline asio::awaitable<bool> call(F& f, ::std::shared_ptr<Timer>&)
 		{
 			co_return co_await f();
 		}
@@ -219,16 +221,16 @@ namespace boost::asio::detail
 
 	struct timer_exit_notify_helper
 	{
-		template<class F>
-		requires (::std::invocable<::std::decay_t<F>, ::std::shared_ptr<asio::timer>&>)
-		static inline void call(F& f, ::std::shared_ptr<asio::timer>& timer_ptr)
+		template<class F, class Timer>
+		requires (::std::invocable<::std::decay_t<F>, ::std::shared_ptr<Timer>&>)
+		static inline void call(F& f, ::std::shared_ptr<Timer>& timer_ptr)
 		{
 			f(timer_ptr);
 		}
 
-		template<class F>
-		requires (!::std::invocable<::std::decay_t<F>, ::std::shared_ptr<asio::timer>&>)
-		static inline void call(F& f, ::std::shared_ptr<asio::timer>&)
+		template<class F, class Timer>
+		requires (!::std::invocable<::std::decay_t<F>, ::std::shared_ptr<Timer>&>)
+		static inline void call(F& f, ::std::shared_ptr<Timer>&)
 		{
 			f();
 		}
@@ -348,6 +350,35 @@ namespace boost::asio
 		co_return asio::error::timed_out;
 	}
 
+	/**
+	 * @brief Asynchronously wait until the idle timeout, the timer is driven by the shared
+	 * timer wheel, and the idle duration is measured by the coarse clock.
+	 * @param duration - The deadline.
+	 */
+	template<typename = void>
+	asio::awaitable<error_code> watchdog(
+		asio::wheel_timer& watchdog_timer,
+		::std::chrono::system_clock::time_point& alive_time,
+		::std::chrono::system_clock::duration idle_timeout)
+	{
+		auto idled_duration = asio::coarse_clock::now() - alive_time;
+
+		while (idled_duration < idle_timeout)
+		{
+			watchdog_timer.expires_after(idle_timeout - idled_duration);
+
+			auto [ec] = co_await watchdog_timer.async_wait(asio::use_awaitable_executor(watchdog_timer));
+			if (ec)
+				co_return ec;
+			if (watchdog_timer.canceled())
+				co_return asio::error::operation_aborted;
+
+			idled_duration = asio::coarse_clock::now() - alive_time;
+		}
+
+		co_return asio::error::timed_out;
+	}
+
 	/**
 	 * @brief Asynchronously wait until the idle timeout.
 	 * @param duration - The deadline. 
@@ -357,7 +388,7 @@ namespace boost::asio
 		::std::chrono::system_clock::time_point& alive_time,
 		::std::chrono::system_clock::duration idle_timeout)
 	{
-		asio::timer watchdog_timer(co_await asio::this_coro::executor);
+		asio::wheel_timer watchdog_timer(co_await asio::this_coro::executor);
 
 		co_return co_await watchdog(watchdog_timer, alive_time, idle_timeout);
 	}
@@ -482,21 +513,22 @@ namespace boost::asio
 
 	/**
 	 * @brief create a timer.
+	 * @tparam Timer - The asio::timer or the asio::wheel_timer.
 	 */
-	::std::shared_ptr<asio::timer> create_timer(const auto& executor,
+	template<typename Timer = asio::timer>
+	::std::shared_ptr<Timer> create_timer(const auto& executor,
 		asio::timer::duration first_delay, asio::timer::duration interval,
 		::std::integral auto repeat_times, auto&& callback, auto&& exit_notify)
 	{
-		::std::shared_ptr<asio::timer> t = ::std::make_shared<asio::timer>(executor);
+		::std::shared_ptr<Timer> t = ::std::make_shared<Timer>(executor);
+
+		t->expires_after((::std::max)(first_delay, asio::timer::duration::zero()));
 
 		asio::co_spawn(executor,
-		[t, first_delay, interval, repeat_times, f = ::std::forward_like<decltype(callback)>(callback),
+		[t, interval, repeat_times, f = ::std::forward_like<decltype(callback)>(callback),
 			e = ::std::forward_like<decltype(exit_notify)>(exit_notify)]
 		() mutable -> asio::awaitable<asio::error_code>
 		{
-			if (first_delay > asio::timer::duration::zero())
-				co_await asio::delay(first_delay);
-
 			::std::defer notify_when_destroy = [t, e = ::std::move(e)]() mutable
 			{
 				detail::timer_exit_notify_helper::call(e, t);
@@ -415,6 +415,12 @@ namespace boost::asio
 	using timer_map = basic_timer_map<
 		timer_handle, asio::timer,
 		detail::timer_handle_hash, detail::timer_handle_equal>;
+
+	/// the timers are driven by the shared timer wheel, it's suitable for a large number
+	/// of the coarse-grained timers.
+	using wheel_timer_map = basic_timer_map<
+		timer_handle, asio::wheel_timer,
+		detail::timer_handle_hash, detail::timer_handle_equal>;
 }
 
 #include <asio3/core/impl/timer_map.ipp>
@@ -0,0 +1,746 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <asio3/core/asio.hpp>
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+	/**
+	 * @brief A system clock which returns the time cached by the running timer wheels, it's
+	 * used to update the alive time of the sessions on every read without a clock call.
+	 * The cached time is refreshed on every tick of the timer wheels, when no timer wheel is
+	 * running, the real system time is returned.
+	 */
+	struct coarse_clock
+	{
+		using rep        = ::std::chrono::system_clock::rep;
+		using period     = ::std::chrono::system_clock::period;
+		using duration   = ::std::chrono::system_clock::duration;
+		using time_point = ::std::chrono::system_clock::time_point;
+
+		static constexpr bool is_steady = false;
+
+		static inline time_point now() noexcept
+		{
+			if (running.load(::std::memory_order_acquire) > 0)
+				return time_point(duration(cached.load(::std::memory_order_relaxed)));
+
+			return ::std::chrono::system_clock::now();
+		}
+
+		static inline void refresh() noexcept
+		{
+			cached.store(::std::chrono::system_clock::now().time_since_epoch().count(), ::std::memory_order_relaxed);
+		}
+
+		/// the count of the timer wheels which are refreshing the cached time.
+		static inline ::std::atomic<::std::size_t> running{ 0 };
+
+		static inline ::std::atomic<rep>           cached{ 0 };
+	};
+}
+
+#ifdef ASIO_STANDALONE
+namespace asio::detail
+#else
+namespace boost::asio::detail
+#endif
+{
+	struct wheel_node
+	{
+		wheel_node*                                       prev = nullptr;
+		wheel_node*                                       next = nullptr;
+		wheel_node**                                      slot = nullptr;
+
+		/// the expiry of the steady clock, it can be moved later without the lock of the wheel.
+		::std::atomic<::std::chrono::steady_clock::rep>   expiry{ 0 };
+
+		asio::any_io_executor                             executor;
+
+		asio::any_completion_handler<void(asio::error_code)> handler;
+	};
+}
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+	/**
+	 * @brief A hierarchical timing wheel which is shared by all the wheel timers of a execution
+	 * context, it's used for the coarse-grained deadlines, such as the idle timeout, handshake
+	 * timeout, and so on. The waiting timers are linked into the slots intrusively, so adding
+	 * and removing a timer is O(1), and moving the deadline of a waiting timer later is only
+	 * an atomic store, the timer is refiled lazily when its old slot is reached.
+	 * All the timers are driven by one steady timer, which only runs while there are waiting
+	 * timers. The deadline is rounded up to the tick.
+	 * This class is thread safety.
+	 */
+	class timer_wheel : public asio::detail::execution_context_service_base<timer_wheel>
+	{
+	public:
+		using clock_type = ::std::chrono::steady_clock;
+		using duration   = clock_type::duration;
+		using time_point = clock_type::time_point;
+		using node_type  = asio::detail::wheel_node;
+
+	protected:
+		// the first level has 256 slots of one tick, and the upper levels have 64 slots of
+		// 2^8, 2^14, 2^20 ticks, so the wheel can hold 2^26 ticks, about 38 days with the
+		// default tick, the longer deadlines are refiled when the top level is cascaded.
+		static constexpr unsigned      root_bits   = 8;
+		static constexpr unsigned      level_bits  = 6;
+		static constexpr std::size_t   root_size   = std::size_t(1) << root_bits;
+		static constexpr std::size_t   level_size  = std::size_t(1) << level_bits;
+		static constexpr std::size_t   level_count = 3;
+		static constexpr std::uint64_t max_ticks   = std::uint64_t(1) << (root_bits + level_bits * level_count);
+
+		struct expired
+		{
+			asio::any_io_executor                                executor;
+			asio::any_completion_handler<void(asio::error_code)> handler;
+		};
+
+	public:
+		explicit timer_wheel(asio::execution_context& ctx)
+			: asio::detail::execution_context_service_base<timer_wheel>(ctx)
+		{
+		}
+
+		~timer_wheel()
+		{
+		}
+
+		void shutdown() override
+		{
+			std::vector<expired> handlers;
+
+			{
+				std::lock_guard g{ mtx_ };
+
+				collect(handlers);
+
+				if (running_)
+				{
+					running_ = false;
+					running_flag_.store(false, std::memory_order_release);
+					coarse_clock::running.fetch_sub(1, std::memory_order_relaxed);
+				}
+
+				// the timer must be destroyed before its service.
+				timer_.reset();
+			}
+
+			// the handlers are destroyed without the lock, they may destroy the wheel timers.
+			handlers.clear();
+		}
+
+		/**
+		 * @brief Set the tick of the wheel, it only takes effect when there are no waiting timers.
+		 * @return Returns false if there are waiting timers.
+		 */
+		inline bool set_tick(duration tick)
+		{
+			std::lock_guard g{ mtx_ };
+
+			if (size_ > 0 || running_ || tick <= duration::zero())
+				return false;
+
+			tick_ = tick;
+			start_ = clock_type::now();
+			base_ = 0;
+
+			return true;
+		}
+
+		/**
+		 * @brief Get the tick of the wheel.
+		 */
+		inline duration tick()
+		{
+			std::lock_guard g{ mtx_ };
+			return tick_;
+		}
+
+		/**
+		 * @brief Get the count of the waiting timers.
+		 */
+		inline std::size_t size()
+		{
+			std::lock_guard g{ mtx_ };
+			return size_;
+		}
+
+		/**
+		 * @brief Get the steady time which is cached on the last tick, when the wheel is not
+		 * running, the real time is returned.
+		 */
+		inline time_point now() const noexcept
+		{
+			if (running_flag_.load(std::memory_order_acquire))
+				return time_point(duration(now_.load(std::memory_order_relaxed)));
+
+			return clock_type::now();
+		}
+
+		/**
+		 * @brief Link the node into the wheel, the handler is posted to the executor of the
+		 * node when the expiry is reached. If the node is already waiting, the old handler
+		 * is posted with the operation_aborted.
+		 */
+		inline void add(node_type& n, asio::any_completion_handler<void(asio::error_code)> handler)
+		{
+			expired e;
+
+			{
+				std::lock_guard g{ mtx_ };
+
+				if (n.slot)
+				{
+					unlink(n);
+
+					--size_;
+
+					e.executor = n.executor;
+					e.handler = std::move(n.handler);
+				}
+
+				if (size_ == 0 && !running_)
+					base_ = now_tick() + 1;
+
+				n.handler = std::move(handler);
+
+				file(n);
+
+				++size_;
+
+				if (!running_)
+					start(n.executor);
+			}
+
+			if (e.handler)
+				complete(e, asio::error::operation_aborted);
+		}
+
+		/**
+		 * @brief Remove the node from the wheel, and post the handler with the error.
+		 * @return Returns the count of the removed nodes.
+		 */
+		inline std::size_t remove(node_type& n, asio::error_code ec = asio::error::operation_aborted)
+		{
+			expired e;
+
+			{
+				std::lock_guard g{ mtx_ };
+
+				if (!n.slot)
+					return 0;
+
+				unlink(n);
+
+				--size_;
+
+				e.executor = n.executor;
+				e.handler = std::move(n.handler);
+			}
+
+			complete(e, ec);
+
+			return 1;
+		}
+
+		/**
+		 * @brief Move the expiry of the node, if the node is waiting and the expiry is moved
+		 * earlier, the node is refiled, otherwise the node is refiled lazily.
+		 */
+		inline void update(node_type& n, time_point expiry)
+		{
+			auto rep = expiry.time_since_epoch().count();
+
+			if (rep >= n.expiry.load(std::memory_order_relaxed))
+			{
+				n.expiry.store(rep, std::memory_order_relaxed);
+				return;
+			}
+
+			std::lock_guard g{ mtx_ };
+
+			n.expiry.store(rep, std::memory_order_relaxed);
+
+			if (n.slot)
+			{
+				unlink(n);
+				file(n);
+			}
+		}
+
+	protected:
+		inline std::uint64_t now_tick() const noexcept
+		{
+			return static_cast<std::uint64_t>((clock_type::now() - start_) / tick_);
+		}
+
+		inline std::uint64_t to_tick(const node_type& n) const noexcept
+		{
+			duration d = time_point(duration(n.expiry.load(std::memory_order_relaxed))) - start_;
+
+			if (d <= duration::zero())
+				return 0;
+
+			return static_cast<std::uint64_t>((d + tick_ - duration(1)) / tick_);
+		}
+
+		inline void link(node_type*& slot, node_type& n) noexcept
+		{
+			n.prev = nullptr;
+			n.next = slot;
+			n.slot = std::addressof(slot);
+
+			if (slot)
+				slot->prev = std::addressof(n);
+
+			slot = std::addressof(n);
+		}
+
+		inline void unlink(node_type& n) noexcept
+		{
+			if (n.prev)
+				n.prev->next = n.next;
+			else
+				*n.slot = n.next;
+
+			if (n.next)
+				n.next->prev = n.prev;
+
+			n.prev = nullptr;
+			n.next = nullptr;
+			n.slot = nullptr;
+		}
+
+		inline void file(node_type& n) noexcept
+		{
+			std::uint64_t expiry = (std::max)(to_tick(n), base_);
+			std::uint64_t delta = expiry - base_;
+
+			if (delta < root_size)
+			{
+				link(root_[expiry & (root_size - 1)], n);
+				return;
+			}
+
+			if (delta >= max_ticks)
+				expiry = base_ + max_ticks - 1;
+
+			for (std::size_t i = 0; i < level_count; ++i)
+			{
+				unsigned shift = root_bits + level_bits * static_cast<unsigned>(i);
+
+				if (delta < (std::uint64_t(1) << (shift + level_bits)) || i + 1 == level_count)
+				{
+					link(levels_[i][(expiry >> shift) & (level_size - 1)], n);
+					return;
+				}
+			}
+		}
+
+		/**
+		 * @brief Refile all the nodes of the slot to the lower levels.
+		 * @return Returns the index of the slot.
+		 */
+		inline std::size_t cascade(std::size_t level)
+		{
+			unsigned shift = root_bits + level_bits * static_cast<unsigned>(level);
+
+			std::size_t index = static_cast<std::size_t>((base_ >> shift) & (level_size - 1));
+
+			node_type* n = levels_[level][index];
+
+			levels_[level][index] = nullptr;
+
+			while (n)
+			{
+				node_type* next = n->next;
+				n->slot = nullptr;
+				file(*n);
+				n = next;
+			}
+
+			return index;
+		}
+
+		inline void advance(std::uint64_t target, std::vector<expired>& handlers)
+		{
+			while (base_ <= target)
+			{
+				if (size_ == 0)
+				{
+					base_ = target + 1;
+					break;
+				}
+
+				std::size_t index = static_cast<std::size_t>(base_ & (root_size - 1));
+
+				if (index == 0)
+				{
+					for (std::size_t i = 0; i < level_count && cascade(i) == 0; ++i);
+				}
+
+				node_type* n = root_[index];
+
+				root_[index] = nullptr;
+
+				++base_;
+
+				while (n)
+				{
+					node_type* next = n->next;
+
+					n->slot = nullptr;
+
+					// the expiry was moved later after the node was filed.
+					if (to_tick(*n) >= base_)
+					{
+						file(*n);
+					}
+					else
+					{
+						--size_;
+
+						handlers.emplace_back(n->executor, std::move(n->handler));
+					}
+
+					n = next;
+				}
+			}
+		}
+
+		inline void collect(std::vector<expired>& handlers)
+		{
+			auto collect_slot = [this, &handlers](node_type*& slot) mutable
+			{
+				while (slot)
+				{
+					node_type& n = *slot;
+					unlink(n);
+					handlers.emplace_back(n.executor, std::move(n.handler));
+				}
+			};
+
+			for (node_type*& slot : root_)
+				collect_slot(slot);
+
+			for (auto& level : levels_)
+				for (node_type*& slot : level)
+					collect_slot(slot);
+
+			size_ = 0;
+		}
+
+		inline void start(const asio::any_io_executor& ex)
+		{
+			if (!timer_)
+				timer_.emplace(ex);
+
+			// the cached time must be valid before it's published to the other threads,
+			// otherwise they may read the epoch.
+			refresh();
+
+			running_ = true;
+			running_flag_.store(true, std::memory_order_release);
+			coarse_clock::running.fetch_add(1, std::memory_order_release);
+
+			arm();
+		}
+
+		inline void arm()
+		{
+			timer_->expires_at(start_ + tick_ * static_cast<duration::rep>(base_));
+			timer_->async_wait([this](const asio::error_code& ec) mutable
+			{
+				if (ec == asio::error::operation_aborted)
+					return;
+
+				on_tick();
+			});
+		}
+
+		inline void refresh() noexcept
+		{
+			now_.store(clock_type::now().time_since_epoch().count(), std::memory_order_relaxed);
+			coarse_clock::refresh();
+		}
+
+		inline void on_tick()
+		{
+			std::vector<expired> handlers;
+
+			{
+				std::lock_guard g{ mtx_ };
+
+				if (!running_)
+					return;
+
+				refresh();
+
+				advance(now_tick(), handlers);
+
+				if (size_ > 0)
+				{
+					arm();
+				}
+				else
+				{
+					running_ = false;
+					running_flag_.store(false, std::memory_order_release);
+					coarse_clock::running.fetch_sub(1, std::memory_order_relaxed);
+				}
+			}
+
+			for (expired& e : handlers)
+			{
+				complete(e, asio::error_code{});
+			}
+		}
+
+		static inline void complete(expired& e, asio::error_code ec)
+		{
+			asio::post(e.executor, asio::append(std::move(e.handler), ec));
+		}
+
+	protected:
+		std::mutex                                                    mtx_;
+
+		duration                                                      tick_ = std::chrono::milliseconds(50);
+
+		time_point                                                    start_ = clock_type::now();
+
+		/// the next tick which is not processed yet.
+		std::uint64_t                                                 base_ = 0;
+
+		std::size_t                                                   size_ = 0;
+
+		bool                                                          running_ = false;
+
+		std::atomic<bool>                                             running_flag_{ false };
+
+		std::atomic<duration::rep>                                    now_{ 0 };
+
+		std::array<node_type*, root_size>                             root_{};
+
+		std::array<std::array<node_type*, level_size>, level_count>  levels_{};
+
+		std::optional<asio::steady_timer>                             timer_;
+	};
+
+	/**
+	 * @brief Get the timer wheel of the execution context of the executor.
+	 * @param executor - The executor or the execution context.
+	 */
+	inline timer_wheel& use_timer_wheel(auto&& executor)
+	{
+		if constexpr (std::derived_from<std::remove_cvref_t<decltype(executor)>, asio::execution_context>)
+			return asio::use_service<timer_wheel>(executor);
+		else
+			return asio::use_service<timer_wheel>(
+				asio::query(executor, asio::execution::context_as<asio::execution_context&>));
+	}
+
+	/**
+	 * @brief A timer which is driven by the shared timer wheel of the execution context.
+	 * Unlike the asio::steady_timer, moving the expiry doesn't cancel the waiting operation,
+	 * the waiting operation is completed at the new expiry instead, so the deadline can be
+	 * pushed back on every read cheaply. The expiry is rounded up to the tick of the wheel.
+	 */
+	template<typename Executor = any_io_executor>
+	class basic_wheel_timer
+	{
+	public:
+		using executor_type = Executor;
+		using clock_type    = timer_wheel::clock_type;
+		using duration      = timer_wheel::duration;
+		using time_point    = timer_wheel::time_point;
+
+		/// Rebinds the timer type to another executor.
+		template<typename Executor1>
+		struct rebind_executor
+		{
+			/// The timer type when rebound to the specified executor.
+			using other = basic_wheel_timer<Executor1>;
+		};
+
+	protected:
+		struct cancel_handler
+		{
+			basic_wheel_timer* self;
+
+			void operator()(asio::cancellation_type_t type)
+			{
+				if (type != asio::cancellation_type::none)
+					self->wheel_->remove(self->node_);
+			}
+		};
+
+		struct initiate_async_wait
+		{
+			basic_wheel_timer* self;
+
+			using executor_type = Executor;
+
+			inline const executor_type& get_executor() const noexcept
+			{
+				return self->executor_;
+			}
+
+			template<typename Handler>
+			void operator()(Handler&& handler)
+			{
+				asio::any_completion_handler<void(asio::error_code)> h(std::forward<Handler>(handler));
+
+				// the any_completion_handler installs its own cancellation state into the slot
+				// of the handler, so the cancel handler must be installed into the inner slot.
+				if (auto slot = h.get_cancellation_slot(); slot.is_connected())
+					slot.template emplace<cancel_handler>(self);
+
+				// only one waiting operation is supported, the old one is aborted.
+				self->wheel_->add(self->node_, std::move(h));
+			}
+		};
+
+	public:
+		explicit basic_wheel_timer(const executor_type& ex)
+			: executor_(ex)
+			, wheel_(std::addressof(asio::use_timer_wheel(ex)))
+		{
+			node_.executor = executor_;
+		}
+
+		template<typename ExecutionContext>
+		requires std::derived_from<ExecutionContext, asio::execution_context>
+		explicit basic_wheel_timer(ExecutionContext& ctx)
+			: executor_(ctx.get_executor())
+			, wheel_(std::addressof(asio::use_timer_wheel(ctx)))
+		{
+			node_.executor = executor_;
+		}
+
+		basic_wheel_timer(const executor_type& ex, duration expiry_time) : basic_wheel_timer(ex)
+		{
+			expires_after(expiry_time);
+		}
+
+		basic_wheel_timer(basic_wheel_timer&&) = delete;
+		basic_wheel_timer& operator=(basic_wheel_timer&&) = delete;
+
+		~basic_wheel_timer()
+		{
+			wheel_->remove(node_);
+		}
+
+		/**
+		 * @brief Set the expiry at an absolute time.
+		 */
+		inline void expires_at(time_point expiry_time)
+		{
+			wheel_->update(node_, expiry_time);
+		}
+
+		/**
+		 * @brief Set the expiry relative to the cached time of the wheel.
+		 */
+		inline void expires_after(duration expiry_time)
+		{
+			wheel_->update(node_, wheel_->now() + expiry_time);
+		}
+
+		/**
+		 * @brief Get the expiry.
+		 */
+		inline time_point expiry() const noexcept
+		{
+			return time_point(duration(node_.expiry.load(std::memory_order_relaxed)));
+		}
+
+		/**
+		 * @brief Start an asynchronous wait on the timer.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec);
+		 */
+		template<typename WaitToken = asio::default_token_type<basic_wheel_timer>>
+		inline auto async_wait(WaitToken&& token = asio::default_token_type<basic_wheel_timer>())
+		{
+			return asio::async_initiate<WaitToken, void(asio::error_code)>(
+				initiate_async_wait{ this }, token);
+		}
+
+		/**
+		 * @brief Cancel the waiting operation, the handler is invoked with the operation_aborted.
+		 * @return The number of asynchronous operations that were cancelled.
+		 */
+		inline std::size_t cancel()
+		{
+			canceled_.test_and_set();
+			return wheel_->remove(node_);
+		}
+
+		inline bool canceled() const noexcept
+		{
+			return canceled_.test();
+		}
+
+		inline void clear() noexcept
+		{
+			canceled_.clear();
+		}
+
+		/**
+		 * @brief Get the executor.
+		 */
+		inline const executor_type& get_executor() noexcept
+		{
+			return executor_;
+		}
+
+		/**
+		 * @brief Get the timer wheel.
+		 */
+		inline timer_wheel& get_wheel() noexcept
+		{
+			return *wheel_;
+		}
+
+	protected:
+		executor_type           executor_;
+
+		timer_wheel*            wheel_ = nullptr;
+
+		asio::detail::wheel_node node_;
+
+		std::atomic_flag        canceled_{};
+	};
+
+	using wheel_timer = as_tuple_t<use_awaitable_t<>>::as_default_on_t<asio::basic_wheel_timer<>>;
+}
@@ -0,0 +1,857 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * the deque is referenced from :
+ * Correct and Efficient Work-Stealing for Weak Memory Models, N.M. Le, A. Pop, A. Cohen, F.Z. Nardelli
+ */
+
+#pragma once
+
+#include <cassert>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <asio3/core/asio.hpp>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifdef ASIO_STANDALONE
+namespace asio::detail
+#else
+namespace boost::asio::detail
+#endif
+{
+	/**
+	 * @brief The task of the work stealing pool, the function is moved out and the task is
+	 * freed before the function is called.
+	 */
+	struct pool_task
+	{
+		pool_task* next = nullptr;
+
+		void(*complete)(pool_task* task, bool invoke) = nullptr;
+	};
+
+	template<typename Function>
+	struct pool_task_impl : pool_task
+	{
+		explicit pool_task_impl(Function&& f) : func(std::move(f))
+		{
+			this->complete = &pool_task_impl::do_complete;
+		}
+
+		static void do_complete(pool_task* task, bool invoke)
+		{
+			pool_task_impl* p = static_cast<pool_task_impl*>(task);
+
+			Function f(std::move(p->func));
+
+			delete p;
+
+			if (invoke)
+				f();
+		}
+
+		Function func;
+	};
+
+	template<typename Function>
+	inline pool_task* make_pool_task(Function&& f)
+	{
+		return new pool_task_impl<std::decay_t<Function>>(std::decay_t<Function>(std::forward<Function>(f)));
+	}
+
+	/**
+	 * @brief A Chase-Lev deque, the owner thread pushes and pops at the bottom, the other
+	 * threads steal from the top. The buffer is grown when it's full, the old buffers are
+	 * kept until the deque is destroyed, because the thieves may still read them.
+	 */
+	class chase_lev_deque
+	{
+	protected:
+		struct buffer
+		{
+			explicit buffer(std::int64_t capacity)
+				: mask(capacity - 1)
+				, slots(std::make_unique<std::atomic<pool_task*>[]>(static_cast<std::size_t>(capacity)))
+			{
+			}
+
+			inline pool_task* get(std::int64_t i) const noexcept
+			{
+				return slots[static_cast<std::size_t>(i & mask)].load(std::memory_order_relaxed);
+			}
+
+			inline void put(std::int64_t i, pool_task* task) noexcept
+			{
+				slots[static_cast<std::size_t>(i & mask)].store(task, std::memory_order_relaxed);
+			}
+
+			std::int64_t                              mask;
+
+			std::unique_ptr<std::atomic<pool_task*>[]> slots;
+		};
+
+	public:
+		explicit chase_lev_deque(std::int64_t capacity = 1024)
+		{
+			std::int64_t n = 1;
+			while (n < capacity)
+				n <<= 1;
+
+			buffers_.emplace_back(std::make_unique<buffer>(n));
+			buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Push a task at the bottom, only the owner thread can call it.
+		 */
+		inline void push(pool_task* task)
+		{
+			std::int64_t b = bottom_.load(std::memory_order_relaxed);
+			std::int64_t t = top_.load(std::memory_order_acquire);
+
+			buffer* a = buffer_.load(std::memory_order_relaxed);
+
+			if (b - t > a->mask)
+				a = grow(a, t, b);
+
+			a->put(b, task);
+
+			bottom_.store(b + 1, std::memory_order_release);
+		}
+
+		/**
+		 * @brief Pop a task from the bottom, only the owner thread can call it.
+		 */
+		inline pool_task* pop() noexcept
+		{
+			std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+
+			buffer* a = buffer_.load(std::memory_order_relaxed);
+
+			bottom_.store(b, std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			std::int64_t t = top_.load(std::memory_order_relaxed);
+
+			if (t > b)
+			{
+				bottom_.store(b + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			pool_task* task = a->get(b);
+
+			if (t == b)
+			{
+				// the last task, race with the thieves.
+				if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					task = nullptr;
+
+				bottom_.store(b + 1, std::memory_order_relaxed);
+			}
+
+			return task;
+		}
+
+		/**
+		 * @brief Steal a task from the top, any thread can call it.
+		 * @return Returns nullptr if the deque is empty or the stealing is failed.
+		 */
+		inline pool_task* steal() noexcept
+		{
+			std::int64_t t = top_.load(std::memory_order_acquire);
+
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			std::int64_t b = bottom_.load(std::memory_order_acquire);
+
+			if (t >= b)
+				return nullptr;
+
+			buffer* a = buffer_.load(std::memory_order_acquire);
+
+			pool_task* task = a->get(t);
+
+			if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return nullptr;
+
+			return task;
+		}
+
+		[[nodiscard]] inline bool empty() const noexcept
+		{
+			return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+		}
+
+	protected:
+		inline buffer* grow(buffer* a, std::int64_t t, std::int64_t b)
+		{
+			buffers_.emplace_back(std::make_unique<buffer>((a->mask + 1) * 2));
+
+			buffer* n = buffers_.back().get();
+
+			for (std::int64_t i = t; i < b; ++i)
+				n->put(i, a->get(i));
+
+			buffer_.store(n, std::memory_order_release);
+
+			return n;
+		}
+
+	protected:
+		alignas(64) std::atomic<std::int64_t> top_{ 0 };
+
+		alignas(64) std::atomic<std::int64_t> bottom_{ 0 };
+
+		std::atomic<buffer*>                  buffer_{ nullptr };
+
+		std::vector<std::unique_ptr<buffer>>  buffers_;
+	};
+
+	/**
+	 * @brief Get the cpus of every numa node, an empty vector is returned if it's unknown.
+	 */
+	inline std::vector<std::vector<unsigned>> get_numa_nodes()
+	{
+		std::vector<std::vector<unsigned>> nodes;
+
+	#if defined(__linux__)
+		for (unsigned node = 0;; ++node)
+		{
+			std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+			if (!file)
+				break;
+
+			std::string list;
+			std::getline(file, list);
+
+			std::vector<unsigned> cpus;
+
+			// the format is like : 0-3,8-11
+			for (std::size_t pos = 0; pos < list.size();)
+			{
+				std::size_t end = list.find(',', pos);
+				if (end == std::string::npos)
+					end = list.size();
+
+				std::string range = list.substr(pos, end - pos);
+
+				std::size_t dash = range.find('-');
+
+				try
+				{
+					unsigned first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+					unsigned last = dash == std::string::npos ? first : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+
+					for (unsigned cpu = first; cpu <= last; ++cpu)
+						cpus.emplace_back(cpu);
+				}
+				catch (const std::exception&)
+				{
+				}
+
+				pos = end + 1;
+			}
+
+			if (!cpus.empty())
+				nodes.emplace_back(std::move(cpus));
+		}
+	#endif
+
+		return nodes;
+	}
+
+	inline void bind_this_thread_to_cpu([[maybe_unused]] unsigned cpu) noexcept
+	{
+	#if defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+	#elif defined(ASIO_WINDOWS) || defined(BOOST_ASIO_WINDOWS)
+		if (cpu < sizeof(DWORD_PTR) * 8)
+			::SetThreadAffinityMask(::GetCurrentThread(), DWORD_PTR(1) << cpu);
+	#endif
+	}
+}
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+	struct work_stealing_option
+	{
+		/// the count of the worker threads.
+		std::size_t thread_count = (std::max)(std::thread::hardware_concurrency(), 1u);
+
+		/// bind every worker thread to one cpu.
+		bool        pin_threads = false;
+
+		/// spread the worker threads over the numa nodes, and the idle workers steal the tasks
+		/// of the workers in the same node first. it implies pin_threads.
+		bool        numa_aware = false;
+
+		/// how many times an idle worker looks for tasks before it sleeps.
+		std::size_t spin_count = 64;
+	};
+
+	/**
+	 * @brief A thread pool which every worker has its own task deque, the tasks posted in a
+	 * worker thread are pushed into the deque of this worker without any lock, the tasks
+	 * posted in other threads are pushed into a lock free injection list, and the idle
+	 * workers steal the tasks of the busy workers.
+	 * The executor of the pool is an asio executor, so the cpu heavy functions can be
+	 * offloaded from the io threads :
+	 * @code
+	 *    auto [e, result] = co_await pool.async_call([]() { return heavy(); });
+	 * @endcode
+	 * The pending tasks are still executed when the pool is stopping.
+	 * This class is thread safety.
+	 */
+	class work_stealing_pool : public asio::execution_context
+	{
+	protected:
+		struct worker
+		{
+			detail::chase_lev_deque deque;
+
+			std::vector<std::size_t> victims;
+
+			std::uint64_t            seed = 0;
+
+			std::thread              thread;
+		};
+
+		struct thread_state
+		{
+			work_stealing_pool* pool = nullptr;
+
+			worker*             self = nullptr;
+		};
+
+		static inline thread_state& this_thread_state() noexcept
+		{
+			static thread_local thread_state state{};
+			return state;
+		}
+
+	public:
+		class executor_type
+		{
+		public:
+			explicit executor_type(work_stealing_pool& pool) noexcept : pool_(std::addressof(pool))
+			{
+			}
+
+			inline work_stealing_pool& query(asio::execution::context_t) const noexcept
+			{
+				return *pool_;
+			}
+
+			static constexpr asio::execution::blocking_t query(asio::execution::blocking_t) noexcept
+			{
+				return asio::execution::blocking.never;
+			}
+
+			static constexpr asio::execution::relationship_t query(asio::execution::relationship_t) noexcept
+			{
+				return asio::execution::relationship.fork;
+			}
+
+			static constexpr asio::execution::outstanding_work_t query(asio::execution::outstanding_work_t) noexcept
+			{
+				return asio::execution::outstanding_work.untracked;
+			}
+
+			inline executor_type require(asio::execution::blocking_t::never_t) const noexcept
+			{
+				return *this;
+			}
+
+			template<typename Function>
+			inline void execute(Function&& f) const
+			{
+				pool_->post(std::forward<Function>(f));
+			}
+
+			[[nodiscard]] inline bool running_in_this_thread() const noexcept
+			{
+				return pool_->running_in_threads();
+			}
+
+			inline work_stealing_pool& context() const noexcept
+			{
+				return *pool_;
+			}
+
+			friend inline bool operator==(const executor_type& a, const executor_type& b) noexcept
+			{
+				return a.pool_ == b.pool_;
+			}
+
+			friend inline bool operator!=(const executor_type& a, const executor_type& b) noexcept
+			{
+				return a.pool_ != b.pool_;
+			}
+
+		protected:
+			work_stealing_pool* pool_;
+		};
+
+	public:
+		/**
+		 * @brief constructor
+		 */
+		explicit work_stealing_pool(std::size_t thread_count = std::thread::hardware_concurrency())
+			: work_stealing_pool(work_stealing_option{ .thread_count = thread_count })
+		{
+		}
+
+		/**
+		 * @brief constructor
+		 */
+		explicit work_stealing_pool(work_stealing_option opt) : option_(std::move(opt))
+		{
+			option_.thread_count = (std::max)(option_.thread_count, std::size_t(1));
+
+			std::size_t count = option_.thread_count;
+
+			std::vector<unsigned> cpus(count);
+			std::vector<std::size_t> nodes(count, 0);
+
+			std::vector<std::vector<unsigned>> numa_nodes;
+			if (option_.numa_aware)
+				numa_nodes = detail::get_numa_nodes();
+
+			if (numa_nodes.empty())
+			{
+				numa_nodes.emplace_back();
+				for (unsigned i = 0; i < (std::max)(std::thread::hardware_concurrency(), 1u); ++i)
+					numa_nodes.back().emplace_back(i);
+			}
+
+			// the workers are spread over the nodes in turn.
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				std::vector<unsigned>& node_cpus = numa_nodes[i % numa_nodes.size()];
+
+				nodes[i] = i % numa_nodes.size();
+				cpus[i] = node_cpus[(i / numa_nodes.size()) % node_cpus.size()];
+			}
+
+			workers_.reserve(count);
+
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				workers_.emplace_back(std::make_unique<worker>());
+
+				worker& w = *workers_.back();
+
+				w.seed = 0x9E3779B97F4A7C15ull * (i + 1);
+
+				// the workers in the same node are the first victims.
+				for (std::size_t j = 1; j < count; ++j)
+				{
+					std::size_t k = (i + j) % count;
+					if (nodes[k] == nodes[i])
+						w.victims.emplace_back(k);
+				}
+				for (std::size_t j = 1; j < count; ++j)
+				{
+					std::size_t k = (i + j) % count;
+					if (nodes[k] != nodes[i])
+						w.victims.emplace_back(k);
+				}
+			}
+
+			// all the workers must be created before any thread is started, the threads may
+			// steal from each other at once.
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				workers_[i]->thread = std::thread([this, i, cpu = cpus[i]]() mutable
+				{
+					if (option_.pin_threads || option_.numa_aware)
+						detail::bind_this_thread_to_cpu(cpu);
+
+					run(*workers_[i]);
+				});
+			}
+		}
+
+		/**
+		 * @brief destructor
+		 */
+		~work_stealing_pool()
+		{
+			this->stop();
+
+			this->shutdown();
+			this->destroy();
+
+			// the tasks which are posted after the pool is stopped.
+			for (detail::pool_task* task = injection_.exchange(nullptr); task;)
+			{
+				detail::pool_task* next = task->next;
+				task->complete(task, false);
+				task = next;
+			}
+		}
+
+		/**
+		 * @brief Get the executor of the pool.
+		 */
+		inline executor_type get_executor() noexcept
+		{
+			return executor_type(*this);
+		}
+
+		/**
+		 * @brief post a function object into the pool, then return immediately, the function
+		 * object will never be executed inside this function. Instead, it will be executed
+		 * asynchronously in the pool. No future is created for the function.
+		 * @param f - The function object, signature : void()
+		 */
+		template<typename Function>
+		inline void post(Function&& f)
+		{
+			push(detail::make_pool_task(std::forward<Function>(f)), 1);
+		}
+
+		/**
+		 * @brief post all the function objects of the range into the pool at once.
+		 * @param first, last - The range of the function objects, signature : void()
+		 */
+		template<std::input_iterator Iterator>
+		inline void post_bulk(Iterator first, Iterator last)
+		{
+			detail::pool_task* head = nullptr;
+			detail::pool_task* tail = nullptr;
+
+			std::size_t count = 0;
+
+			for (; first != last; ++first, ++count)
+			{
+				detail::pool_task* task = detail::make_pool_task(*first);
+
+				task->next = head;
+				head = task;
+
+				if (!tail)
+					tail = task;
+			}
+
+			if (head)
+				push_list(head, tail, count);
+		}
+
+		/**
+		 * @brief post the function object into the pool for count times at once.
+		 * @param f - The function object, signature : void(std::size_t index)
+		 */
+		template<typename Function>
+		requires std::invocable<Function&, std::size_t>
+		inline void post_bulk(std::size_t count, Function&& f)
+		{
+			detail::pool_task* head = nullptr;
+			detail::pool_task* tail = nullptr;
+
+			for (std::size_t i = count; i > 0; --i)
+			{
+				detail::pool_task* task = detail::make_pool_task([f, i]() mutable { f(i - 1); });
+
+				task->next = head;
+				head = task;
+
+				if (!tail)
+					tail = task;
+			}
+
+			if (head)
+				push_list(head, tail, count);
+		}
+
+		/**
+		 * @brief Execute the function in the pool, and complete with the result in the
+		 * executor of the completion handler.
+		 * @param f - The function object, signature : R()
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(std::exception_ptr ep, R result);
+		 */
+		template<typename Function, typename CallToken = asio::default_completion_token_t<executor_type>>
+		inline auto async_call(Function&& f, CallToken&& token = asio::default_completion_token_t<executor_type>())
+		{
+			using result_type = std::invoke_result_t<std::decay_t<Function>&>;
+
+			return asio::co_spawn(get_executor(),
+				[f = std::forward<Function>(f)]() mutable -> asio::awaitable<result_type>
+				{
+					co_return f();
+				}, std::forward<CallToken>(token));
+		}
+
+		/**
+		 * @brief Stop the pool and block until all the tasks are executed.
+		 * It can't be called in the threads of the pool.
+		 */
+		void stop()
+		{
+			assert(!running_in_threads());
+
+			stopped_.store(true, std::memory_order_seq_cst);
+
+			epoch_.fetch_add(1, std::memory_order_seq_cst);
+			epoch_.notify_all();
+
+			for (std::unique_ptr<worker>& w : workers_)
+			{
+				if (w->thread.joinable())
+					w->thread.join();
+			}
+		}
+
+		/**
+		 * @brief get thread count of the pool
+		 */
+		[[nodiscard]] inline std::size_t thread_count() const noexcept
+		{
+			return this->workers_.size();
+		}
+
+		/**
+		 * @brief Determine whether current code is running in the pool's threads.
+		 */
+		[[nodiscard]] inline bool running_in_threads() const noexcept
+		{
+			return this_thread_state().pool == this;
+		}
+
+		/**
+		 * @brief Get the option of the pool.
+		 */
+		[[nodiscard]] inline const work_stealing_option& get_option() const noexcept
+		{
+			return option_;
+		}
+
+	protected:
+		inline void push(detail::pool_task* task, std::size_t count)
+		{
+			thread_state& state = this_thread_state();
+
+			if (state.pool == this)
+				state.self->deque.push(task);
+			else
+				push_injection(task, task);
+
+			wake(count);
+		}
+
+		inline void push_list(detail::pool_task* head, detail::pool_task* tail, std::size_t count)
+		{
+			thread_state& state = this_thread_state();
+
+			if (state.pool == this)
+			{
+				for (detail::pool_task* task = head; task;)
+				{
+					detail::pool_task* next = task->next;
+					state.self->deque.push(task);
+					task = next;
+				}
+			}
+			else
+			{
+				push_injection(head, tail);
+			}
+
+			wake(count);
+		}
+
+		inline void push_injection(detail::pool_task* head, detail::pool_task* tail) noexcept
+		{
+			tail->next = injection_.load(std::memory_order_relaxed);
+
+			while (!injection_.compare_exchange_weak(tail->next, head,
+				std::memory_order_release, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		inline void wake(std::size_t count) noexcept
+		{
+			// pairs with the fence of the sleeping worker, either the worker sees the task,
+			// or this thread sees the worker.
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			if (sleepers_.load(std::memory_order_relaxed) == 0)
+				return;
+
+			epoch_.fetch_add(1, std::memory_order_seq_cst);
+
+			if (count == 1)
+				epoch_.notify_one();
+			else
+				epoch_.notify_all();
+		}
+
+		inline bool has_task() const noexcept
+		{
+			if (injection_.load(std::memory_order_relaxed))
+				return true;
+
+			for (const std::unique_ptr<worker>& w : workers_)
+			{
+				if (!w->deque.empty())
+					return true;
+			}
+
+			return false;
+		}
+
+		inline detail::pool_task* find_task(worker& self) noexcept
+		{
+			if (detail::pool_task* task = self.deque.pop())
+				return task;
+
+			// take all the injected tasks at once, run one of them, and move the others into the
+			// own deque, so they can be stolen by the other workers.
+			if (injection_.load(std::memory_order_relaxed))
+			{
+				detail::pool_task* list = injection_.exchange(nullptr, std::memory_order_acquire);
+
+				if (list)
+				{
+					detail::pool_task* first = list;
+
+					for (detail::pool_task* task = list->next; task;)
+					{
+						detail::pool_task* next = task->next;
+						self.deque.push(task);
+						task = next;
+					}
+
+					return first;
+				}
+			}
+
+			if (self.victims.empty())
+				return nullptr;
+
+			// start from a random victim of the same priority.
+			self.seed ^= self.seed << 13;
+			self.seed ^= self.seed >> 7;
+			self.seed ^= self.seed << 17;
+
+			std::size_t n = self.victims.size();
+			std::size_t offset = static_cast<std::size_t>(self.seed % n);
+
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				std::size_t index = self.victims[(offset + i) % n];
+
+				if (detail::pool_task* task = workers_[index]->deque.steal())
+					return task;
+			}
+
+			return nullptr;
+		}
+
+		void run(worker& self)
+		{
+			thread_state& state = this_thread_state();
+
+			state.pool = this;
+			state.self = std::addressof(self);
+
+			std::size_t spins = 0;
+
+			for (;;)
+			{
+				if (detail::pool_task* task = find_task(self))
+				{
+					spins = 0;
+
+					task->complete(task, true);
+
+					continue;
+				}
+
+				if (++spins < option_.spin_count)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				spins = 0;
+
+				std::uint32_t epoch = epoch_.load(std::memory_order_seq_cst);
+
+				sleepers_.fetch_add(1, std::memory_order_seq_cst);
+
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				if (has_task())
+				{
+					sleepers_.fetch_sub(1, std::memory_order_relaxed);
+					continue;
+				}
+
+				if (stopped_.load(std::memory_order_seq_cst))
+				{
+					sleepers_.fetch_sub(1, std::memory_order_relaxed);
+					break;
+				}
+
+				epoch_.wait(epoch, std::memory_order_seq_cst);
+
+				sleepers_.fetch_sub(1, std::memory_order_relaxed);
+			}
+
+			state.pool = nullptr;
+			state.self = nullptr;
+		}
+
+	private:
+		/// no copy construct function
+		work_stealing_pool(const work_stealing_pool&) = delete;
+
+		/// no operator equal function
+		work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+	protected:
+		work_stealing_option                 option_;
+
+		std::vector<std::unique_ptr<worker>> workers_;
+
+		/// the tasks which are posted by the threads out of the pool.
+		alignas(64) std::atomic<detail::pool_task*> injection_{ nullptr };
+
+		alignas(64) std::atomic<std::uint32_t> epoch_{ 0 };
+
+		std::atomic<std::size_t>             sleepers_{ 0 };
+
+		std::atomic<bool>                    stopped_{ false };
+	};
+}
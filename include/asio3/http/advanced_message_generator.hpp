@@ -24,6 +24,9 @@
 #include <boost/beast/http/string_body.hpp>
 #endif
 #include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
 
 #ifdef ASIO3_HEADER_ONLY
 namespace bho
@@ -34,6 +37,53 @@ namespace boost
 namespace beast {
 namespace http {
 
+/** A response which was serialized already.
+
+    The serialized data can be shared by many @ref http::advanced_message_generator,
+    such as the responses which are stored in the cache, so the response is only
+    serialized once and every write sends the ready-made buffer.
+*/
+struct serialized_response
+{
+    /// The header of the response.
+    http::response_header<> header;
+
+    /// The serialized header and body.
+    std::string data;
+
+    /// The bytes of the serialized header at the beginning of the data.
+    std::size_t header_size = 0;
+
+    /// The result of `m.keep_alive()` on the message which was serialized.
+    bool keep_alive = true;
+};
+
+namespace detail {
+
+// The impl of the generator may be allocated from a memory resource, so the deleter
+// remembers where it came from.
+struct generator_impl_deleter
+{
+    std::pmr::memory_resource* mr = nullptr;
+    std::size_t size = 0;
+    std::size_t align = 0;
+
+    template<class T>
+    void operator()(T* p) const noexcept
+    {
+        if (!mr)
+        {
+            delete p;
+            return;
+        }
+        void* q = dynamic_cast<void*>(p);
+        p->~T();
+        mr->deallocate(q, size, align);
+    }
+};
+
+} // detail
+
 /** Type-erased buffers generator for @ref http::message
    
     Implements the BuffersGenerator concept for any concrete instance of the
@@ -70,6 +120,38 @@ public:
     template <bool isRequest, class Body, class Fields>
     advanced_message_generator(http::message<isRequest, Body, Fields>&&);
 
+    template<typename = void>
+    advanced_message_generator(std::shared_ptr<const serialized_response>);
+
+    /** Construct an empty generator whose messages are allocated from the memory resource.
+
+        The messages which are assigned to this generator later are stored in memory
+        allocated from `mr`, such as a per-connection @ref http::arena, so a response
+        needn't allocate from the heap. The memory resource must outlive the generator.
+    */
+    template<typename = void>
+    explicit advanced_message_generator(std::pmr::memory_resource* mr);
+
+    advanced_message_generator(advanced_message_generator&& o) noexcept = default;
+
+    /// Take the message of `o`, the memory resource of this generator is kept.
+    advanced_message_generator&
+    operator=(advanced_message_generator&& o) noexcept
+    {
+        impl_ = std::move(o.impl_);
+        return *this;
+    }
+
+    /// Take the message, it's allocated from the memory resource of this generator if any.
+    template <bool isRequest, class Body, class Fields>
+    advanced_message_generator&
+    operator=(http::message<isRequest, Body, Fields>&&);
+
+    /// Use the serialized response, it's allocated from the memory resource of this generator if any.
+    template<typename = void>
+    advanced_message_generator&
+    operator=(std::shared_ptr<const serialized_response>);
+
     /// `BuffersGenerator`
     bool is_done() const {
         return impl_->is_done();
@@ -96,9 +178,19 @@ public:
         return impl_->keep_alive();
     }
 
-    /// Returns the message header reference of the underlying message
+    /// Returns the status of the underlying response, `status::unknown` for a request.
+    http::status
+    result() const noexcept
+    {
+        return impl_->result();
+    }
+
+    /// Returns the message header reference of the underlying message. If it's a serialized
+    /// response, a copy of the header is returned, the changes of the copy are not applied.
+    /// Throws std::logic_error if the message uses the fields with another allocator, like
+    /// the messages of the @ref http::arena, use `result()` and `keep_alive()` to read them.
     http::response_header<>&
-    get_response_header() noexcept
+    get_response_header()
     {
         return impl_->get_response_header();
     }
@@ -116,17 +208,65 @@ private:
         virtual const_buffers_type prepare(error_code& ec) = 0;
         virtual void consume(std::size_t n) = 0;
         virtual bool keep_alive() const noexcept = 0;
-        virtual http::response_header<>& get_response_header() noexcept = 0;
+        virtual http::status result() const noexcept = 0;
+        virtual http::response_header<>& get_response_header() = 0;
         virtual std::expected<http::response<http::string_body>, error_code> to_string_body_response() = 0;
     };
 
-    std::unique_ptr<impl_base> impl_;
+    template<class Impl, class... Args>
+    void emplace(Args&&... args);
+
+    std::unique_ptr<impl_base, detail::generator_impl_deleter> impl_;
+
+    std::pmr::memory_resource* resource_ = nullptr;
 
     template <bool isRequest, class Body, class Fields>
     struct generator_impl;
 
     template <bool isRequest, class Body, class Fields>
     struct ref_generator_impl;
+
+    struct shared_generator_impl;
+};
+
+/** A BuffersGenerator which refers to a @ref http::advanced_message_generator.
+
+    The write operation which takes the ownership of a generator may be destroyed after
+    its completion handler returns, so a generator whose message is allocated from a
+    per-connection @ref http::arena is written through this reference instead, then
+    the owner knows when the generator is destroyed and the arena can be reset.
+*/
+class advanced_message_generator_ref
+{
+public:
+    using const_buffers_type = advanced_message_generator::const_buffers_type;
+
+    explicit advanced_message_generator_ref(advanced_message_generator& g) noexcept
+        : g_(std::addressof(g))
+    {
+    }
+
+    /// `BuffersGenerator`
+    bool is_done() const {
+        return g_->is_done();
+    }
+
+    /// `BuffersGenerator`
+    const_buffers_type
+    prepare(error_code& ec)
+    {
+        return g_->prepare(ec);
+    }
+
+    /// `BuffersGenerator`
+    void
+    consume(std::size_t n)
+    {
+        g_->consume(n);
+    }
+
+private:
+    advanced_message_generator* g_;
 };
 
 } // namespace http
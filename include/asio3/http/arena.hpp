@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <asio3/core/beast.hpp>
+
+#ifdef ASIO3_HEADER_ONLY
+namespace bho::beast::http
+#else
+namespace boost::beast::http
+#endif
+{
+	template<typename T>
+	class arena_allocator;
+
+	/**
+	 * @brief The monotonic memory arena of a connection, the fields, the body and the response
+	 * generator of a request allocate from it, and the whole memory is rewinded by reset() after
+	 * the response was sent, so a keep-alive connection needn't call malloc for every request.
+	 * The blocks which were used by a request are merged into one block when the arena is reset,
+	 * so the arena doesn't allocate from the upstream anymore once it's large enough.
+	 * The arena isn't thread safe, it's supposed to be used by the only one connection.
+	 */
+	class arena : public std::pmr::memory_resource
+	{
+	public:
+		struct statistics
+		{
+			/// the count of the allocations served by the arena.
+			std::size_t allocations          = 0;
+
+			/// the bytes of the allocations served by the arena.
+			std::size_t allocated_bytes      = 0;
+
+			/// the count of the blocks allocated from the upstream, it stops growing when the
+			/// connection reaches the steady state.
+			std::size_t upstream_allocations = 0;
+
+			/// the count of the reset() calls.
+			std::size_t resets               = 0;
+
+			/// the bytes of the blocks which are owned by the arena currently.
+			std::size_t capacity             = 0;
+		};
+
+		/**
+		 * @brief constructor
+		 * @param initial_size - the size of the first block, it's allocated at the first use.
+		 * @param max_retained_size - if the capacity exceeds this value when the arena is reset,
+		 *   for example after a large upload, all the blocks are released to the upstream, and
+		 *   the next use allocates a block of the initial size again.
+		 * @param upstream - the memory resource which the blocks are allocated from.
+		 */
+		explicit arena(
+			std::size_t initial_size = 4096,
+			std::size_t max_retained_size = 1024 * 1024,
+			std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+			: initial_size_(initial_size)
+			, max_retained_size_(max_retained_size)
+			, upstream_(upstream)
+		{
+		}
+
+		arena(arena&& o) noexcept
+			: initial_size_(o.initial_size_)
+			, max_retained_size_(o.max_retained_size_)
+			, upstream_(o.upstream_)
+			, head_(std::exchange(o.head_, nullptr))
+			, current_(std::exchange(o.current_, nullptr))
+			, ptr_(std::exchange(o.ptr_, nullptr))
+			, end_(std::exchange(o.end_, nullptr))
+			, stats_(std::exchange(o.stats_, statistics{}))
+		{
+		}
+
+		arena& operator=(arena&& o) noexcept
+		{
+			if (this != std::addressof(o))
+			{
+				release();
+
+				initial_size_      = o.initial_size_;
+				max_retained_size_ = o.max_retained_size_;
+				upstream_          = o.upstream_;
+				head_              = std::exchange(o.head_, nullptr);
+				current_           = std::exchange(o.current_, nullptr);
+				ptr_               = std::exchange(o.ptr_, nullptr);
+				end_               = std::exchange(o.end_, nullptr);
+				stats_             = std::exchange(o.stats_, statistics{});
+			}
+			return *this;
+		}
+
+		arena(const arena&) = delete;
+		arena& operator=(const arena&) = delete;
+
+		/**
+		 * @brief destructor
+		 */
+		~arena()
+		{
+			release();
+		}
+
+		/**
+		 * @brief Rewind the arena, all the memory allocated from the arena is invalid after this,
+		 * so it must be called after the request and the response were destroyed.
+		 */
+		inline void reset()
+		{
+			++stats_.resets;
+
+			if (!head_)
+				return;
+
+			// the request needed more than one block, merge them into one block, so the same
+			// request can be served by the only one block next time.
+			if (head_->next && stats_.capacity <= max_retained_size_)
+			{
+				std::size_t size = stats_.capacity;
+				release();
+				allocate_block(size, nullptr);
+			}
+			else if (stats_.capacity > max_retained_size_)
+			{
+				release();
+			}
+
+			current_ = head_;
+			if (current_)
+			{
+				ptr_ = current_->data();
+				end_ = current_->data() + current_->size;
+			}
+		}
+
+		/**
+		 * @brief Free all the blocks to the upstream.
+		 */
+		inline void release() noexcept
+		{
+			for (block* b = head_; b;)
+			{
+				block* next = b->next;
+				upstream_->deallocate(b, sizeof(block) + b->size, alignof(std::max_align_t));
+				b = next;
+			}
+
+			head_ = current_ = nullptr;
+			ptr_ = end_ = nullptr;
+			stats_.capacity = 0;
+		}
+
+		/**
+		 * @brief Get the allocator which allocates from this arena.
+		 */
+		template<typename T = std::byte>
+		[[nodiscard]] inline auto get_allocator() noexcept
+		{
+			return arena_allocator<T>(this);
+		}
+
+		[[nodiscard]] inline statistics get_statistics() const noexcept
+		{
+			return stats_;
+		}
+
+	protected:
+		struct alignas(std::max_align_t) block
+		{
+			block*      next;
+			std::size_t size;
+
+			inline std::byte* data() noexcept
+			{
+				return reinterpret_cast<std::byte*>(this + 1);
+			}
+		};
+
+		inline block* allocate_block(std::size_t size, block* prev)
+		{
+			void* p = upstream_->allocate(sizeof(block) + size, alignof(std::max_align_t));
+
+			block* b = ::new (p) block{ nullptr, size };
+
+			if (prev)
+				prev->next = b;
+			else
+				head_ = b;
+
+			++stats_.upstream_allocations;
+			stats_.capacity += size;
+
+			return b;
+		}
+
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override
+		{
+			++stats_.allocations;
+			stats_.allocated_bytes += bytes;
+
+			for (;;)
+			{
+				if (ptr_)
+				{
+					std::uintptr_t p = (reinterpret_cast<std::uintptr_t>(ptr_) + alignment - 1) &
+						~(std::uintptr_t(alignment) - 1);
+
+					if (p + bytes <= reinterpret_cast<std::uintptr_t>(end_))
+					{
+						ptr_ = reinterpret_cast<std::byte*>(p + bytes);
+						return reinterpret_cast<void*>(p);
+					}
+				}
+
+				// use the next block which was kept by the reset, or allocate a new one.
+				block* next = current_ ? current_->next : head_;
+				if (!next || next->size < bytes + alignment)
+				{
+					std::size_t size = current_ ? current_->size * 2 : initial_size_;
+					if (size < bytes + alignment)
+						size = bytes + alignment;
+
+					block* prev = current_;
+					while (prev && prev->next)
+						prev = prev->next;
+
+					next = allocate_block(size, prev);
+				}
+
+				current_ = next;
+				ptr_ = current_->data();
+				end_ = current_->data() + current_->size;
+			}
+		}
+
+		void do_deallocate(void*, std::size_t, std::size_t) override
+		{
+			// the memory is reclaimed by reset() as a whole.
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return this == std::addressof(other);
+		}
+
+	protected:
+		std::size_t                 initial_size_;
+
+		std::size_t                 max_retained_size_;
+
+		std::pmr::memory_resource*  upstream_;
+
+		block*                      head_    = nullptr;
+
+		block*                      current_ = nullptr;
+
+		std::byte*                  ptr_     = nullptr;
+
+		std::byte*                  end_     = nullptr;
+
+		statistics                  stats_;
+	};
+
+	/**
+	 * @brief The allocator which allocates from a memory resource, such as the arena.
+	 * It's like the std::pmr::polymorphic_allocator, but it's assignable and propagated by the
+	 * containers, which is required by the http::basic_fields.
+	 */
+	template<typename T>
+	class arena_allocator
+	{
+	public:
+		using value_type = T;
+
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap            = std::true_type;
+		using is_always_equal                        = std::false_type;
+
+		arena_allocator() noexcept : resource_(std::pmr::get_default_resource())
+		{
+		}
+
+		arena_allocator(std::pmr::memory_resource* r) noexcept : resource_(r)
+		{
+		}
+
+		template<typename U>
+		arena_allocator(const arena_allocator<U>& o) noexcept : resource_(o.resource())
+		{
+		}
+
+		arena_allocator(const arena_allocator&) noexcept = default;
+		arena_allocator& operator=(const arena_allocator&) noexcept = default;
+
+		[[nodiscard]] inline T* allocate(std::size_t n)
+		{
+			return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+		}
+
+		inline void deallocate(T* p, std::size_t n) noexcept
+		{
+			resource_->deallocate(p, n * sizeof(T), alignof(T));
+		}
+
+		[[nodiscard]] inline std::pmr::memory_resource* resource() const noexcept
+		{
+			return resource_;
+		}
+
+		template<typename U>
+		friend inline bool operator==(const arena_allocator& a, const arena_allocator<U>& b) noexcept
+		{
+			return a.resource() == b.resource() || *a.resource() == *b.resource();
+		}
+
+	protected:
+		std::pmr::memory_resource* resource_;
+	};
+
+	using arena_fields      = http::basic_fields<arena_allocator<char>>;
+
+	using arena_string_body = http::basic_string_body<char, std::char_traits<char>, arena_allocator<char>>;
+
+	using arena_request     = http::request<arena_string_body, arena_fields>;
+
+	using arena_response    = http::response<arena_string_body, arena_fields>;
+
+	/**
+	 * @brief Create a request whose fields and body allocate from the arena.
+	 */
+	[[nodiscard]] inline arena_request make_arena_request(http::arena& a)
+	{
+		return arena_request{
+			std::piecewise_construct,
+			std::make_tuple(a.get_allocator<char>()),
+			std::make_tuple(a.get_allocator<char>()) };
+	}
+
+	/**
+	 * @brief Create a response whose fields and body allocate from the arena.
+	 */
+	[[nodiscard]] inline arena_response make_arena_response(
+		http::arena& a, http::status result = http::status::ok, unsigned version = 11)
+	{
+		arena_response rep{
+			std::piecewise_construct,
+			std::make_tuple(a.get_allocator<char>()),
+			std::make_tuple(a.get_allocator<char>()) };
+
+		rep.result(result);
+		rep.version(version);
+
+		return rep;
+	}
+}
@@ -20,12 +20,18 @@
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <list>
+#include <vector>
+#include <optional>
+#include <bit>
+#include <charconv>
 #include <type_traits>
 #include <shared_mutex>
 
 #include <asio3/core/function_traits.hpp>
 #include <asio3/core/netutil.hpp>
 #include <asio3/core/null_shared_mutex.hpp>
+#include <asio3/core/strutil.hpp>
 
 #include <asio3/core/beast.hpp>
 #include <asio3/http/core.hpp>
@@ -57,36 +63,170 @@ namespace boost::beast::http
 		}
 	}
 
+	/**
+	 * @brief Serialize the response into the serialized_response, the header and the body
+	 * are stored in one buffer, so it can be written by one call without serializing again.
+	 */
+	template<class Body, class Fields>
+	inline bool serialize_response(http::response<Body, Fields>& msg, http::serialized_response& e)
+	{
+		static_cast<http::response_header<>&>(e.header) = msg.base();
+
+		e.keep_alive = msg.keep_alive();
+
+		http::response_serializer<Body, Fields> sr{ msg };
+
+		// split the header from the body, otherwise they are returned in one buffer sequence,
+		// and the header size can't be known.
+		sr.split(true);
+
+		error_code ec{};
+
+		while (!sr.is_done())
+		{
+			sr.next(ec, [&sr, &e](error_code& ec, const auto& buffers) mutable
+			{
+				ec = {};
+
+				std::size_t n = 0;
+
+				for (auto it = asio::buffer_sequence_begin(buffers); it != asio::buffer_sequence_end(buffers); ++it)
+				{
+					asio::const_buffer b = *it;
+					e.data.append(static_cast<const char*>(b.data()), b.size());
+					n += b.size();
+				}
+
+				if (!sr.is_header_done())
+					e.header_size += n;
+
+				sr.consume(n);
+			});
+
+			if (ec)
+				return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * @brief A sharded response cache with CLOCK eviction, per-entry ttl and a memory budget.
+	 * The responses are stored pre-serialized, a hit can be written directly without
+	 * serializing the message again. The read path only takes a shared lock of one shard,
+	 * and the evicted entries stay valid while they are still referenced by the readers.
+	 */
 	template<class MessageT, class MutexT>
 	class basic_cache
 	{
-	protected:
-		struct cache_node
+	public:
+		struct entry : public http::serialized_response
 		{
-			std::chrono::steady_clock::time_point alive;
+			/// the request fields which are listed in the "Vary" of the response, and their values.
+			std::vector<std::pair<std::string, std::string>> vary;
+
+			std::chrono::steady_clock::time_point             expiry;
 
-			MessageT msg;
+			/// the bytes charged to the memory budget.
+			std::size_t                                       cost = 0;
 
-			cache_node(std::chrono::steady_clock::time_point t, MessageT m)
-				: alive(t), msg(std::move(m))
+			[[nodiscard]] inline bool is_expired(std::chrono::steady_clock::time_point now) const noexcept
 			{
+				return now >= expiry;
 			}
 
-			inline void update_alive_time() noexcept
+			/**
+			 * @brief Check whether the request selects this variant of the response.
+			 */
+			template<class Fields>
+			[[nodiscard]] inline bool match(const http::header<true, Fields>& req) const noexcept
 			{
-				alive = std::chrono::steady_clock::now();
+				for (auto& [name, value] : vary)
+				{
+					if (req[name] != value)
+						return false;
+				}
+				return true;
+			}
+
+			/**
+			 * @brief Check whether the "If-None-Match" of the request matches the "ETag" of the response.
+			 */
+			template<class Fields>
+			[[nodiscard]] inline bool is_not_modified(const http::header<true, Fields>& req) const noexcept
+			{
+				std::string_view etag = header[http::field::etag];
+				if (etag.empty())
+					return false;
+
+				std::string_view inm = req[http::field::if_none_match];
+				if (inm.empty())
+					return false;
+
+				return inm == "*" || inm.find(etag) != std::string_view::npos;
 			}
 		};
 
-	public:
 		using message_type = MessageT;
 		using mutex_type = MutexT;
+		using entry_type = entry;
+		using entry_ptr = std::shared_ptr<const entry>;
+		using clock_type = std::chrono::steady_clock;
 
+		struct statistics
+		{
+			std::size_t hits        = 0;
+			std::size_t misses      = 0;
+			std::size_t insertions  = 0;
+			std::size_t evictions   = 0;
+			std::size_t expirations = 0;
+		};
+
+	protected:
+		struct node
+		{
+			std::string                         key;
+
+			std::vector<std::shared_ptr<entry>> variants;
+
+			std::size_t                         cost = 0;
+
+			// the CLOCK reference bit, it's set by the readers under the shared lock.
+			mutable std::atomic<bool>           referenced{ false };
+		};
+
+		using list_type = std::list<node>;
+
+		struct alignas(64) shard
+		{
+			mutable MutexT                                                mtx;
+
+			list_type                                                     ring;
+
+			// the CLOCK hand, points to the next candidate for eviction.
+			typename list_type::iterator                                  hand = ring.end();
+
+			// the key is a view of node::key, so the lookup needn't construct a std::string.
+			std::unordered_map<std::string_view, typename list_type::iterator> map;
+
+			std::size_t                                                   bytes = 0;
+		};
+
+	public:
 		/**
 		 * @brief constructor
+		 * @param shard_count - the shard count, it will be rounded up to the power of 2.
 		 */
-		basic_cache()
+		explicit basic_cache(std::size_t shard_count = 16)
 		{
+			shard_count = std::bit_ceil((std::max)(shard_count, std::size_t(1)));
+
+			shards_.reserve(shard_count);
+
+			for (std::size_t i = 0; i < shard_count; ++i)
+			{
+				shards_.emplace_back(std::make_unique<shard>());
+			}
 		}
 
 		/**
@@ -95,21 +235,124 @@ namespace boost::beast::http
 		~basic_cache() = default;
 
 		/**
-		 * @brief Add a element into the cache.
+		 * @brief Add the response into the cache, the response is serialized when adding.
+		 * The response is not cached if its "Cache-Control" has "no-store" or "private",
+		 * or its "Vary" is "*". The "max-age" of the "Cache-Control" overrides the default ttl.
+		 * @return Returns the cached entry, or nullptr if the response can't be cached.
 		 */
-		template<class StringT>
-		inline cache_node* add(StringT&& url, MessageT msg)
+		template<class Fields, class Body, class ResFields>
+		inline entry_ptr add(std::string_view url,
+			const http::header<true, Fields>& req, http::response<Body, ResFields>& msg)
 		{
-			std::unique_lock guard(this->cache_mutex_);
+			std::string_view cache_control = msg[http::field::cache_control];
 
-			if (this->cache_map_.size() >= cache_max_count_)
+			if (asio::ifind(cache_control, "no-store") != std::string_view::npos ||
+				asio::ifind(cache_control, "private") != std::string_view::npos)
 				return nullptr;
 
-			// can't use insert_or_assign, it maybe cause the msg was changed in multithread, and 
-			// other thread are using the msg at this time.
-			return std::addressof(this->cache_map_.emplace(
-				asio::to_string(std::forward<StringT>(url)),
-				cache_node{ std::chrono::steady_clock::now(), std::move(msg) }).first->second);
+			std::shared_ptr<entry> e = std::make_shared<entry>();
+
+			for (std::string_view name : asio::split(msg[http::field::vary], ","))
+			{
+				asio::trim_both(name);
+
+				if (name.empty())
+					continue;
+
+				if (name == "*")
+					return nullptr;
+
+				e->vary.emplace_back(name, req[name]);
+			}
+
+			if (!serialize(msg, *e))
+				return nullptr;
+
+			e->expiry = clock_type::now() + get_max_age(cache_control).value_or(ttl_);
+			e->cost = sizeof(entry) + e->data.size() + url.size();
+
+			for (auto& [name, value] : e->vary)
+			{
+				e->cost += name.size() + value.size();
+			}
+
+			return this->insert(url, std::move(e));
+		}
+
+		/**
+		 * @brief Add the response into the cache without the "Vary" check.
+		 */
+		template<class Body, class ResFields>
+		inline entry_ptr add(std::string_view url, http::response<Body, ResFields>& msg)
+		{
+			return this->add(url, http::request_header<>{}, msg);
+		}
+
+		/**
+		 * @brief Finds the cached response which matchs the url and the request.
+		 * @return Returns nullptr if not found or the response is expired.
+		 */
+		template<class Fields>
+		inline entry_ptr find(std::string_view url, const http::header<true, Fields>& req)
+		{
+			shard& s = this->shard_of(url);
+
+			std::shared_lock guard(s.mtx);
+
+			auto it = s.map.find(url);
+			if (it == s.map.end())
+			{
+				misses_.fetch_add(1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			const node& n = *(it->second);
+
+			for (const std::shared_ptr<entry>& e : n.variants)
+			{
+				if (!e->match(req))
+					continue;
+
+				// the expired entry is removed by the next insertion or shrink_to_fit.
+				if (e->is_expired(clock_type::now()))
+					break;
+
+				n.referenced.store(true, std::memory_order_relaxed);
+
+				hits_.fetch_add(1, std::memory_order_relaxed);
+
+				return e;
+			}
+
+			misses_.fetch_add(1, std::memory_order_relaxed);
+
+			return nullptr;
+		}
+
+		/**
+		 * @brief Finds the cached response which matchs the url, the "Vary" is ignored.
+		 */
+		inline entry_ptr find(std::string_view url)
+		{
+			return this->find(url, http::request_header<>{});
+		}
+
+		/**
+		 * @brief Removes all the variants of the url.
+		 */
+		inline bool erase(std::string_view url)
+		{
+			shard& s = this->shard_of(url);
+
+			std::unique_lock guard(s.mtx);
+
+			auto it = s.map.find(url);
+			if (it == s.map.end())
+				return false;
+
+			this->remove(s, it->second);
+
+			return true;
 		}
 
 		/**
@@ -117,65 +360,112 @@ namespace boost::beast::http
 		 */
 		inline bool empty() const noexcept
 		{
-			std::shared_lock guard(this->cache_mutex_);
-
-			return this->cache_map_.empty();
+			return this->get_count() == 0;
 		}
 
 		/**
-		 * @brief Checks if the cache is full.
+		 * @brief Checks if the cache reachs the memory budget or the max count.
 		 */
 		inline bool full() const noexcept
 		{
-			std::shared_lock guard(this->cache_mutex_);
+			return this->get_bytes() >= max_bytes_ || this->get_count() >= max_count_;
+		}
 
-			return this->cache_map_.size() >= cache_max_count_;
+		/**
+		 * @brief Set the memory budget in bytes of all the cached responses.
+		 */
+		inline void set_max_bytes(std::size_t bytes) noexcept
+		{
+			this->max_bytes_ = bytes;
 		}
 
 		/**
-		 * @brief Finds the cache with key equivalent to url.
+		 * @brief Get the memory budget in bytes.
 		 */
-		template<class StringT>
-		inline cache_node* find(const StringT& url)
+		inline std::size_t get_max_bytes() const noexcept
 		{
-			std::shared_lock guard(this->cache_mutex_);
+			return this->max_bytes_;
+		}
 
-			if (this->cache_map_.empty())
-				return nullptr;
+		/**
+		 * @brief Get the bytes which are charged by the cached responses.
+		 */
+		inline std::size_t get_bytes() const noexcept
+		{
+			std::size_t bytes = 0;
 
-			// If rehashing occurs due to the insertion, all iterators are invalidated.
-			// Otherwise iterators are not affected. References are not invalidated. 
-			std::string str = asio::to_string(url);
-			if (auto it = this->cache_map_.find(str); it != this->cache_map_.end())
-				return std::addressof(it->second);
+			for (const std::unique_ptr<shard>& s : shards_)
+			{
+				std::shared_lock guard(s->mtx);
 
-			return nullptr;
+				bytes += s->bytes;
+			}
+
+			return bytes;
 		}
 
 		/**
-		 * @brief Set the max number of elements in the container.
+		 * @brief Set the max number of urls in the container.
 		 */
 		inline void set_max_count(std::size_t count) noexcept
 		{
-			this->cache_max_count_ = count;
+			this->max_count_ = count;
 		}
 
 		/**
-		 * @brief Get the max number of elements in the container.
+		 * @brief Get the max number of urls in the container.
 		 */
 		inline std::size_t get_max_count() const noexcept
 		{
-			return this->cache_max_count_;
+			return this->max_count_;
 		}
 
 		/**
-		 * @brief Get the current number of elements in the container.
+		 * @brief Get the current number of urls in the container.
 		 */
 		inline std::size_t get_count() const noexcept
 		{
-			std::shared_lock guard(this->cache_mutex_);
+			std::size_t count = 0;
 
-			return this->cache_map_.size();
+			for (const std::unique_ptr<shard>& s : shards_)
+			{
+				std::shared_lock guard(s->mtx);
+
+				count += s->map.size();
+			}
+
+			return count;
+		}
+
+		/**
+		 * @brief Set the default time to live of the cached responses.
+		 */
+		template<class Rep, class Period>
+		inline void set_ttl(std::chrono::duration<Rep, Period> duration) noexcept
+		{
+			this->ttl_ = std::chrono::duration_cast<clock_type::duration>(duration);
+		}
+
+		/**
+		 * @brief Get the default time to live of the cached responses.
+		 */
+		inline clock_type::duration get_ttl() const noexcept
+		{
+			return this->ttl_;
+		}
+
+		/**
+		 * @brief Get the hit/miss/insertion/eviction/expiration counters.
+		 */
+		inline statistics get_statistics() const noexcept
+		{
+			statistics r;
+			r.hits        = hits_       .load(std::memory_order_relaxed);
+			r.misses      = misses_     .load(std::memory_order_relaxed);
+			r.insertions  = insertions_ .load(std::memory_order_relaxed);
+			r.evictions   = evictions_  .load(std::memory_order_relaxed);
+			r.expirations = expirations_.load(std::memory_order_relaxed);
+			return r;
 		}
 
 		/**
@@ -183,42 +473,218 @@ namespace boost::beast::http
 		 */
 		inline void shrink_to_fit()
 		{
-			std::unique_lock guard(this->cache_mutex_);
+			auto now = clock_type::now();
 
-			if (this->cache_map_.size() < cache_max_count_)
-				return;
+			for (std::unique_ptr<shard>& s : shards_)
+			{
+				std::unique_lock guard(s->mtx);
 
-			std::multimap<std::chrono::steady_clock::duration::rep, const std::string*> mms;
-			for (auto& [url, node] : this->cache_map_)
+				for (auto it = s->ring.begin(); it != s->ring.end();)
+				{
+					auto next = std::next(it);
+
+					this->remove_expired(*s, it, now);
+
+					it = next;
+				}
+			}
+		}
+
+		/**
+		 * @brief Erases all elements from the container.
+		 */
+		inline void clear() noexcept
+		{
+			for (std::unique_ptr<shard>& s : shards_)
 			{
-				mms.emplace(node.alive.time_since_epoch().count(), std::addressof(url));
+				std::unique_lock guard(s->mtx);
+
+				s->map.clear();
+				s->ring.clear();
+				s->hand = s->ring.end();
+				s->bytes = 0;
 			}
+		}
+
+	protected:
+		inline shard& shard_of(std::string_view url) noexcept
+		{
+			return *shards_[std::hash<std::string_view>{}(url) & (shards_.size() - 1)];
+		}
+
+		static std::optional<clock_type::duration> get_max_age(std::string_view cache_control)
+		{
+			std::size_t pos = asio::ifind(cache_control, "max-age=");
+			if (pos == std::string_view::npos)
+				return std::nullopt;
+
+			std::string_view v = cache_control.substr(pos + 8);
 
-			std::size_t i = 0, n = mms.size() / 3;
-			for (auto& [t, purl] : mms)
+			std::size_t seconds = 0;
+			auto [p, ec] = std::from_chars(v.data(), v.data() + v.size(), seconds);
+			if (ec != std::errc{})
+				return std::nullopt;
+
+			return std::chrono::seconds(seconds);
+		}
+
+		template<class Body, class ResFields>
+		static bool serialize(http::response<Body, ResFields>& msg, entry& e)
+		{
+			return http::serialize_response(msg, e);
+		}
+
+		inline entry_ptr insert(std::string_view url, std::shared_ptr<entry> e)
+		{
+			shard& s = this->shard_of(url);
+
+			std::size_t budget = (std::max)(max_bytes_ / shards_.size(), std::size_t(1));
+			std::size_t count = (std::max)(max_count_ / shards_.size(), std::size_t(1));
+
+			if (e->cost > budget)
+				return nullptr;
+
+			std::unique_lock guard(s.mtx);
+
+			auto it = s.map.find(url);
+
+			if (it == s.map.end())
 			{
-				asio::ignore_unused(t);
-				if (++i > n)
-					break;
-				this->cache_map_.erase(*purl);
+				this->evict(s, budget - e->cost, count - 1);
+
+				// insert the new node before the hand, so it will be checked at last.
+				auto pos = s.ring.emplace(s.hand);
+				pos->key = url;
+
+				if (s.hand == s.ring.end())
+					s.hand = s.ring.begin();
+
+				it = s.map.emplace(pos->key, pos).first;
 			}
+			else
+			{
+				node& n = *(it->second);
+
+				// replace the variant which is selected by the same request fields.
+				for (auto v = n.variants.begin(); v != n.variants.end(); ++v)
+				{
+					if ((*v)->vary == e->vary)
+					{
+						n.cost -= (*v)->cost;
+						s.bytes -= (*v)->cost;
+						n.variants.erase(v);
+						break;
+					}
+				}
+
+				// the node which is being updated is pinned, otherwise it maybe removed by the
+				// evict when its last variant was replaced or all its variants were expired.
+				this->evict(s, (std::max)(budget, e->cost) - e->cost, count, std::addressof(n));
+			}
+
+			node& n = *(it->second);
+
+			n.cost += e->cost;
+			s.bytes += e->cost;
+
+			n.variants.emplace_back(e);
+
+			insertions_.fetch_add(1, std::memory_order_relaxed);
+
+			return e;
 		}
 
 		/**
-		 * @brief Erases all elements from the container.
+		 * @brief Run the CLOCK until the shard's bytes and count are not greater than the limits.
+		 * @param pinned - the node which is skipped by the CLOCK.
 		 */
-		inline void clear() noexcept
+		inline void evict(shard& s, std::size_t max_bytes, std::size_t max_count, const node* pinned = nullptr)
 		{
-			std::unique_lock guard(this->cache_mutex_);
-			this->cache_map_.clear();
+			auto now = clock_type::now();
+
+			// the referenced node gets a second chance, so two loops are enough to evict one node.
+			std::size_t steps = 2 * s.ring.size() + 1;
+
+			while ((s.bytes > max_bytes || s.map.size() > max_count) && !s.ring.empty() && steps-- > 0)
+			{
+				if (s.hand == s.ring.end())
+					s.hand = s.ring.begin();
+
+				auto it = s.hand;
+
+				if (std::addressof(*it) == pinned)
+				{
+					++s.hand;
+					continue;
+				}
+
+				if (this->remove_expired(s, it, now))
+					continue;
+
+				if (it->referenced.exchange(false, std::memory_order_relaxed))
+				{
+					++s.hand;
+					continue;
+				}
+
+				evictions_.fetch_add(it->variants.size(), std::memory_order_relaxed);
+
+				this->remove(s, it);
+			}
+		}
+
+		inline bool remove_expired(shard& s, typename list_type::iterator it, clock_type::time_point now)
+		{
+			node& n = *it;
+
+			for (auto v = n.variants.begin(); v != n.variants.end();)
+			{
+				if ((*v)->is_expired(now))
+				{
+					n.cost -= (*v)->cost;
+					s.bytes -= (*v)->cost;
+					v = n.variants.erase(v);
+
+					expirations_.fetch_add(1, std::memory_order_relaxed);
+				}
+				else
+				{
+					++v;
+				}
+			}
+
+			if (!n.variants.empty())
+				return false;
+
+			this->remove(s, it);
+
+			return true;
+		}
+
+		inline void remove(shard& s, typename list_type::iterator it)
+		{
+			if (s.hand == it)
+				++s.hand;
+
+			s.bytes -= it->cost;
+			s.map.erase(it->key);
+			s.ring.erase(it);
 		}
 
 	protected:
-		mutable MutexT                              cache_mutex_;
+		std::vector<std::unique_ptr<shard>> shards_;
+
+		std::size_t                         max_bytes_ = 64 * 1024 * 1024;
+
+		std::size_t                         max_count_ = 0xffff;
 
-		std::unordered_map<std::string, cache_node> cache_map_;
+		clock_type::duration                ttl_ = std::chrono::minutes(10);
 
-		std::size_t                                 cache_max_count_ = 0xffff;
+		std::atomic<std::size_t>            hits_{ 0 };
+		std::atomic<std::size_t>            misses_{ 0 };
+		std::atomic<std::size_t>            insertions_{ 0 };
+		std::atomic<std::size_t>            evictions_{ 0 };
+		std::atomic<std::size_t>            expirations_{ 0 };
 	};
 
 	using cache = basic_cache<http::response<http::string_body>, asio::null_shared_mutex>;
@@ -0,0 +1,702 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <asio3/core/detail/push_options.hpp>
+
+#include <deque>
+#include <optional>
+#include <unordered_map>
+
+#include <asio3/core/asio.hpp>
+#include <asio3/core/beast.hpp>
+#include <asio3/core/netutil.hpp>
+#include <asio3/core/resolve.hpp>
+#include <asio3/core/strutil.hpp>
+#include <asio3/core/timer.hpp>
+
+#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+#include <asio3/core/root_certificates.hpp>
+#include <asio3/tcp/sslutil.hpp>
+#endif
+
+#include <asio3/http/url.hpp>
+
+#include <asio3/proxy/handshake.hpp>
+
+#ifdef ASIO3_HEADER_ONLY
+namespace bho::beast::http
+#else
+namespace boost::beast::http
+#endif
+{
+	/**
+	 * @brief A client connection which is used by the http requests, it can be kept alive
+	 * in the client_pool and reused by the next request to the same scheme/host/port/proxy.
+	 */
+	struct client_connection
+	{
+		explicit client_connection(const auto& ex) : sock(ex)
+		{
+		}
+
+		~client_connection()
+		{
+			close();
+		}
+
+		/**
+		 * @brief Check whether the connection is connected or not.
+		 */
+		[[nodiscard]] inline bool is_open() const noexcept
+		{
+			return sock.is_open();
+		}
+
+		/**
+		 * @brief Check whether the connection has been used by other requests before.
+		 */
+		[[nodiscard]] inline bool is_reused() const noexcept
+		{
+			return requests > 1;
+		}
+
+		/**
+		 * @brief Check whether the connection is a ssl connection.
+		 */
+		[[nodiscard]] inline bool is_ssl() const noexcept
+		{
+		#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+			return stream != nullptr;
+		#else
+			return false;
+		#endif
+		}
+
+		inline void close() noexcept
+		{
+			asio::error_code ec{};
+			sock.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+			sock.close(ec);
+			asio::reset_lock(sock);
+		}
+
+		/// the pool key of this connection.
+		std::string                                                  key;
+
+		asio::ip::tcp::socket                                        sock;
+
+	#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+		/// the ssl context must be alive as long as the stream, so it's owned by the connection.
+		std::shared_ptr<asio::ssl::context>                          sslctx;
+
+		std::unique_ptr<asio::ssl::stream<asio::ip::tcp::socket&>>   stream;
+	#endif
+
+		/// the bytes which were read from the socket but not consumed by the previous response.
+		beast::flat_buffer                                           buffer;
+
+		/// the time when the connection was put back into the pool.
+		std::chrono::steady_clock::time_point                        idle_time{};
+
+		/// the count of the requests which were sent on this connection.
+		std::size_t                                                  requests = 0;
+	};
+
+	using client_connection_ptr = std::shared_ptr<client_connection>;
+
+	struct client_pool_option
+	{
+		/// the max connections to the same scheme/host/port/proxy, include the idle connections.
+		std::size_t max_per_host = 8;
+
+		/// the idle connections which were not used for this time will be closed.
+		std::chrono::steady_clock::duration idle_timeout = std::chrono::seconds(60);
+	};
+
+	/**
+	 * @brief Check whether the error is caused by the server closed a idle keep-alive connection.
+	 * An idempotent request which failed with these errors on a reused connection can be sent again.
+	 */
+	inline bool is_stale_connection_error(const asio::error_code& ec) noexcept
+	{
+		return ec == asio::error::eof
+			|| ec == asio::error::connection_reset
+			|| ec == asio::error::connection_aborted
+			|| ec == asio::error::broken_pipe
+			|| ec == asio::error::bad_descriptor
+			|| ec == http::error::end_of_stream;
+	}
+
+	/**
+	 * @brief Check whether the request method is idempotent, see RFC 9110 9.2.2.
+	 * Only the idempotent requests are sent again automatically, because the server may have
+	 * processed the request before it closed the connection.
+	 */
+	inline bool is_idempotent(http::verb method) noexcept
+	{
+		switch (method)
+		{
+		case http::verb::get:
+		case http::verb::head:
+		case http::verb::put:
+		case http::verb::delete_:
+		case http::verb::options:
+		case http::verb::trace:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+	/**
+	 * @brief Get the ssl context which is used by the connection of the request.
+	 * The pooled connection may outlive the request, so it must own the ssl context, the
+	 * context which is passed by the reference can't be used with the pool.
+	 * @return Returns nullptr if the default ssl context should be used.
+	 */
+	template<class Option>
+	inline std::shared_ptr<asio::ssl::context> get_ssl_context(const Option& opt, asio::error_code& ec)
+	{
+		ec.clear();
+
+		if (opt.shared_sslctx)
+			return opt.shared_sslctx;
+
+		if (!opt.sslctx.has_value())
+			return nullptr;
+
+		if (opt.pool.has_value())
+		{
+			ec = asio::error::invalid_argument;
+			return nullptr;
+		}
+
+		// the connection is owned by the request, so the context of the caller outlives it.
+		return std::shared_ptr<asio::ssl::context>(
+			std::shared_ptr<asio::ssl::context>{}, std::addressof(opt.sslctx.value().get()));
+	}
+#endif
+}
+
+#ifdef ASIO3_HEADER_ONLY
+namespace bho::beast::http::detail
+#else
+namespace boost::beast::http::detail
+#endif
+{
+	/**
+	 * @brief Make the function which closes the connection when the request is timed out.
+	 * The connection is closed in the executor of its socket, and it's not closed if it
+	 * was already acquired by the next request at that time.
+	 */
+	/**
+	 * @brief Get the deadline which is the timeout after now, it's saturated to the max.
+	 */
+	inline std::chrono::steady_clock::time_point make_deadline(std::chrono::steady_clock::duration timeout) noexcept
+	{
+		auto now = std::chrono::steady_clock::now();
+
+		if (timeout >= std::chrono::steady_clock::time_point::max() - now)
+			return std::chrono::steady_clock::time_point::max();
+
+		return now + timeout;
+	}
+
+	/**
+	 * @brief Get the time which is left before the deadline, it's zero if the deadline passed.
+	 */
+	inline std::chrono::steady_clock::duration remaining_time(std::chrono::steady_clock::time_point deadline) noexcept
+	{
+		if (deadline == std::chrono::steady_clock::time_point::max())
+			return std::chrono::steady_clock::duration::max();
+
+		return (std::max)(deadline - std::chrono::steady_clock::now(), std::chrono::steady_clock::duration::zero());
+	}
+
+	inline auto make_timeout_closer(const client_connection_ptr& conn)
+	{
+		return [conn, requests = conn->requests]() mutable
+		{
+			asio::post(conn->sock.get_executor(), [conn = std::move(conn), requests]() mutable
+			{
+				if (conn->requests == requests)
+					conn->close();
+			});
+		};
+	}
+
+	struct async_client_connect_op
+	{
+		auto operator()(
+			auto state, auto conn_ref,
+			std::string host, std::string port, bool is_ssl,
+			std::optional<socks5::option> socks5_option,
+			std::chrono::steady_clock::duration connect_timeout,
+			std::chrono::steady_clock::duration attempt_delay) -> void
+		{
+			client_connection& conn = conn_ref.get();
+
+			co_await asio::dispatch(asio::use_deferred_executor(conn.sock));
+
+			state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+			asio::ip::tcp::resolver resolver(conn.sock.get_executor());
+
+			std::string addr = host;
+			std::string serv = port;
+
+			if (socks5_option.has_value())
+			{
+				socks5::option& s5opt = socks5_option.value();
+				addr = s5opt.proxy_address;
+				serv = std::to_string(s5opt.proxy_port);
+			}
+
+			// A successful resolve operation is guaranteed to pass a non-empty range to the handler.
+			auto [e1, eps] = co_await asio::async_resolve(
+				resolver, std::move(addr), std::move(serv),
+				asio::ip::resolver_base::flags(), asio::use_deferred_executor(resolver));
+			if (e1)
+				co_return e1;
+
+			if (!!state.cancelled())
+				co_return asio::error::operation_aborted;
+
+			auto [e2, ep] = co_await asio::async_race_connect(
+				conn.sock, eps, connect_timeout, attempt_delay,
+				asio::default_tcp_socket_option_setter{}, asio::use_deferred_executor(conn.sock));
+			if (e2)
+				co_return e2;
+
+			if (!!state.cancelled())
+				co_return asio::error::operation_aborted;
+
+			if (socks5_option.has_value())
+			{
+				socks5::option& s5opt = socks5_option.value();
+
+				if (s5opt.method.empty())
+					s5opt.method.emplace_back(socks5::auth_method::anonymous);
+				if (s5opt.dest_address.empty())
+					s5opt.dest_address = host;
+				if (s5opt.dest_port == 0)
+					s5opt.dest_port = static_cast<std::uint16_t>(std::stoul(port));
+				if (std::to_underlying(s5opt.cmd) == 0)
+					s5opt.cmd = socks5::command::connect;
+
+				auto [e3] = co_await socks5::async_handshake(
+					conn.sock, s5opt, asio::use_deferred_executor(conn.sock));
+				if (e3)
+					co_return e3;
+			}
+
+			if (is_ssl)
+			{
+			#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+				if (!conn.sslctx)
+				{
+					conn.sslctx = std::make_shared<asio::ssl::context>(asio::ssl::context::tlsv12_client);
+					asio::load_root_certificates(*conn.sslctx);
+					asio::ssl_session_cache::attach(*conn.sslctx, asio::default_ssl_session_cache());
+				}
+
+				conn.stream = std::make_unique<asio::ssl::stream<asio::ip::tcp::socket&>>(
+					conn.sock, *conn.sslctx);
+
+				// Set SNI Hostname (many hosts need this to handshake successfully)
+				// https://github.com/djarek/certify
+				SSL_set_tlsext_host_name(conn.stream->native_handle(), host.data());
+
+				auto [e4] = co_await asio::async_handshake(*conn.stream,
+					asio::ssl::stream_base::handshake_type::client, asio::use_deferred_executor(conn.sock));
+				if (e4)
+					co_return e4;
+			#else
+				co_return asio::error::operation_not_supported;
+			#endif
+			}
+
+			co_return error_code{};
+		}
+	};
+}
+
+#ifdef ASIO3_HEADER_ONLY
+namespace bho::beast::http
+#else
+namespace boost::beast::http
+#endif
+{
+	/**
+	 * @brief Asynchronously resolve, connect, socks5 handshake and ssl handshake the connection.
+	 * @param conn - The connection, its sslctx will be used for the ssl handshake if it's not empty.
+	 * @param host - The server host, it's also used as the SNI hostname.
+	 * @param port - The server port.
+	 * @param is_ssl - Whether to perform the ssl handshake.
+	 * @param socks5_option - The socks5 proxy option.
+	 * @param token - The completion handler to invoke when the operation completes.
+	 *	  The equivalent function signature of the handler must be:
+	 *    @code
+	 *    void handler(const asio::error_code& ec);
+	 */
+	template<typename ConnectToken = asio::default_token_type<asio::tcp_socket>>
+	inline auto async_connect(
+		client_connection& conn,
+		std::string host, std::string port, bool is_ssl,
+		std::optional<socks5::option> socks5_option,
+		ConnectToken&& token = asio::default_token_type<asio::tcp_socket>())
+	{
+		return asio::async_initiate<ConnectToken, void(asio::error_code)>(
+			asio::experimental::co_composed<void(asio::error_code)>(
+				detail::async_client_connect_op{}, conn.sock),
+			token,
+			std::ref(conn),
+			std::move(host), std::move(port), is_ssl,
+			std::move(socks5_option),
+			asio::http_connect_timeout,
+			asio::tcp_connection_attempt_delay);
+	}
+
+	/**
+	 * @brief Asynchronously resolve, connect, socks5 handshake and ssl handshake the connection.
+	 * @param conn - The connection, its sslctx will be used for the ssl handshake if it's not empty.
+	 * @param host - The server host, it's also used as the SNI hostname.
+	 * @param port - The server port.
+	 * @param is_ssl - Whether to perform the ssl handshake.
+	 * @param socks5_option - The socks5 proxy option.
+	 * @param connect_timeout - The timeout of the tcp connect.
+	 * @param attempt_delay - The delay between the connection attempts, see RFC 8305.
+	 * @param token - The completion handler to invoke when the operation completes.
+	 *	  The equivalent function signature of the handler must be:
+	 *    @code
+	 *    void handler(const asio::error_code& ec);
+	 */
+	template<typename ConnectToken = asio::default_token_type<asio::tcp_socket>>
+	inline auto async_connect(
+		client_connection& conn,
+		std::string host, std::string port, bool is_ssl,
+		std::optional<socks5::option> socks5_option,
+		std::chrono::steady_clock::duration connect_timeout,
+		std::chrono::steady_clock::duration attempt_delay,
+		ConnectToken&& token = asio::default_token_type<asio::tcp_socket>())
+	{
+		return asio::async_initiate<ConnectToken, void(asio::error_code)>(
+			asio::experimental::co_composed<void(asio::error_code)>(
+				detail::async_client_connect_op{}, conn.sock),
+			token,
+			std::ref(conn),
+			std::move(host), std::move(port), is_ssl,
+			std::move(socks5_option),
+			connect_timeout,
+			attempt_delay);
+	}
+
+	/**
+	 * @brief A pool of the keep-alive client connections, the connections are keyed by
+	 * scheme/host/port/proxy. All the connections of the pool run in the pool's executor.
+	 */
+	class client_pool
+	{
+	protected:
+		using waiter_type = asio::experimental::channel<void(asio::error_code)>;
+
+		struct host_entry
+		{
+			// the idle connections, the back is the most recently used one.
+			std::deque<client_connection_ptr>        idle;
+
+			// the count of the connections which are idle or in use.
+			std::size_t                              count = 0;
+
+			// the requests which are waiting for a free connection.
+			std::deque<std::shared_ptr<waiter_type>> waiters;
+		};
+
+	public:
+		using executor_type = asio::any_io_executor;
+
+		explicit client_pool(const auto& ex, client_pool_option opt = {}) : executor(ex), option(std::move(opt))
+		{
+		}
+
+		~client_pool()
+		{
+		}
+
+		/**
+		 * @brief Make the pool key for the url, the proxy and the ssl context.
+		 * @param sslctx - The identity of the ssl context, the connections which were created by
+		 *   a ssl context are only reused by the requests with the same ssl context.
+		 */
+		static std::string make_key(const http::url& url, const std::optional<socks5::option>& socks5_option,
+			const void* sslctx = nullptr)
+		{
+			std::string key;
+
+			key += asio::to_lower(std::string(url.get_schema()));
+			key += "://";
+			key += url.get_host();
+			key += ":";
+			key += url.get_port();
+
+			if (socks5_option.has_value())
+			{
+				key += "|socks5://";
+				key += socks5_option->proxy_address;
+				key += ":";
+				key += std::to_string(socks5_option->proxy_port);
+				key += "|";
+				key += socks5_option->username;
+			}
+
+			if (sslctx)
+			{
+				key += "|sslctx=";
+				key += std::to_string(reinterpret_cast<std::uintptr_t>(sslctx));
+			}
+
+			return key;
+		}
+
+		/**
+		 * @brief Asynchronously get a connection for the key.
+		 * If there is a idle connection, it will be returned, otherwise a new unconnected
+		 * connection is returned, the caller should connect it by http::async_connect.
+		 * If the connections of the key reached the max_per_host, wait until one is released.
+		 * The connection must be returned by the release function.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, http::client_connection_ptr conn);
+		 */
+		template<typename AcquireToken = asio::default_token_type<asio::tcp_socket>>
+		inline auto async_acquire(
+			std::string key,
+			AcquireToken&& token = asio::default_token_type<asio::tcp_socket>())
+		{
+			return this->async_acquire(std::move(key),
+				std::chrono::steady_clock::duration::max(), std::forward<AcquireToken>(token));
+		}
+
+		/**
+		 * @brief Asynchronously get a connection for the key, same as above, but the waiting
+		 * for a free connection fails with timed_out after the timeout.
+		 */
+		template<typename AcquireToken = asio::default_token_type<asio::tcp_socket>>
+		inline auto async_acquire(
+			std::string key,
+			std::chrono::steady_clock::duration timeout,
+			AcquireToken&& token = asio::default_token_type<asio::tcp_socket>())
+		{
+			return asio::async_initiate<AcquireToken, void(asio::error_code, client_connection_ptr)>(
+				asio::experimental::co_composed<void(asio::error_code, client_connection_ptr)>(
+					[](auto state, std::reference_wrapper<client_pool> pool_ref, std::string key,
+						std::chrono::steady_clock::duration timeout) -> void
+					{
+						client_pool& pool = pool_ref.get();
+
+						co_await asio::dispatch(asio::use_deferred_executor(pool.executor));
+
+						state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+						if (timeout <= std::chrono::steady_clock::duration::zero())
+							co_return{ asio::error::timed_out, nullptr };
+
+						// the timer and the waiters all run in the pool's executor.
+						std::optional<asio::detail::call_func_when_timeout> wt;
+
+						auto timed_out = std::make_shared<bool>(false);
+
+						std::shared_ptr<waiter_type> waiter;
+
+						if (timeout != std::chrono::steady_clock::duration::max())
+						{
+							wt.emplace(pool.executor, timeout, [&waiter, timed_out]() mutable
+							{
+								*timed_out = true;
+
+								if (waiter)
+									waiter->cancel();
+							});
+						}
+
+						for (;;)
+						{
+							host_entry& host = pool.hosts[key];
+
+							pool.purge(host, std::chrono::steady_clock::now());
+
+							if (!host.idle.empty())
+							{
+								client_connection_ptr conn = std::move(host.idle.back());
+								host.idle.pop_back();
+								conn->requests++;
+								co_return{ asio::error_code{}, std::move(conn) };
+							}
+
+							if (host.count < (std::max)(pool.option.max_per_host, std::size_t(1)))
+							{
+								host.count++;
+								client_connection_ptr conn = std::make_shared<client_connection>(pool.executor);
+								conn->key = key;
+								conn->requests++;
+								co_return{ asio::error_code{}, std::move(conn) };
+							}
+
+							if (*timed_out)
+								co_return{ asio::error::timed_out, nullptr };
+
+							waiter = std::make_shared<waiter_type>(pool.executor, 1);
+
+							host.waiters.emplace_back(waiter);
+
+							auto [e1] = co_await waiter->async_receive(asio::use_deferred_executor(pool.executor));
+							if (e1)
+							{
+								// the waiter may be notified by the release after the receive was
+								// cancelled, pass the notification to the next waiter, otherwise
+								// it's lost, and the next waiter waits for another release.
+								bool notified = false;
+								waiter->try_receive([&notified](auto&&...) mutable { notified = true; });
+
+								// the host entry may be erased by the purge after the waiter was
+								// notified, so it's not created again here.
+								if (auto it = pool.hosts.find(key); it != pool.hosts.end())
+								{
+									std::erase(it->second.waiters, waiter);
+
+									if (notified)
+										pool.notify(it->second);
+								}
+
+								co_return{ *timed_out ? asio::error::timed_out : e1, nullptr };
+							}
+						}
+					}, executor), token, std::ref(*this), std::move(key), timeout);
+		}
+
+		/**
+		 * @brief Return the connection to the pool.
+		 * @param conn - The connection which was got by async_acquire.
+		 * @param reusable - If true and the connection is still open, it will be kept alive
+		 *                   for the next request, otherwise it will be closed.
+		 */
+		inline void release(client_connection_ptr conn, bool reusable)
+		{
+			if (!conn)
+				return;
+
+			asio::dispatch(executor, [this, conn = std::move(conn), reusable]() mutable
+			{
+				host_entry& host = hosts[conn->key];
+
+				if (reusable && conn->is_open())
+				{
+					conn->idle_time = std::chrono::steady_clock::now();
+					host.idle.emplace_back(std::move(conn));
+				}
+				else
+				{
+					conn->close();
+					host.count--;
+				}
+
+				this->purge(host, std::chrono::steady_clock::now());
+
+				this->notify(host);
+			});
+		}
+
+		/**
+		 * @brief Close all the idle connections which were not used for the idle timeout.
+		 */
+		inline void purge()
+		{
+			asio::dispatch(executor, [this]() mutable
+			{
+				auto now = std::chrono::steady_clock::now();
+
+				for (auto it = hosts.begin(); it != hosts.end();)
+				{
+					this->purge(it->second, now);
+					this->notify(it->second);
+
+					if (it->second.count == 0 && it->second.waiters.empty())
+						it = hosts.erase(it);
+					else
+						++it;
+				}
+			});
+		}
+
+		/**
+		 * @brief Close all the idle connections.
+		 */
+		inline void clear()
+		{
+			asio::dispatch(executor, [this]() mutable
+			{
+				for (auto& [key, host] : hosts)
+				{
+					host.count -= host.idle.size();
+					host.idle.clear();
+					this->notify(host);
+				}
+			});
+		}
+
+		/**
+		 * @brief Get the executor associated with the object.
+		 */
+		inline const executor_type& get_executor() noexcept
+		{
+			return executor;
+		}
+
+	protected:
+		inline void purge(host_entry& host, std::chrono::steady_clock::time_point now)
+		{
+			while (!host.idle.empty())
+			{
+				client_connection_ptr& conn = host.idle.front();
+
+				if (conn->is_open() && now - conn->idle_time < option.idle_timeout)
+					break;
+
+				host.idle.pop_front();
+				host.count--;
+			}
+		}
+
+		inline void notify(host_entry& host)
+		{
+			std::size_t max_count = (std::max)(option.max_per_host, std::size_t(1));
+
+			if (!host.waiters.empty() && (!host.idle.empty() || host.count < max_count))
+			{
+				std::shared_ptr<waiter_type> waiter = std::move(host.waiters.front());
+				host.waiters.pop_front();
+				waiter->try_send(asio::error_code{});
+			}
+		}
+
+	public:
+		executor_type executor;
+
+		client_pool_option option;
+
+		std::unordered_map<std::string, host_entry> hosts;
+	};
+}
+
+#include <asio3/core/detail/pop_options.hpp>
@@ -29,6 +29,7 @@
 #include <asio3/http/url.hpp>
 #include <asio3/http/read.hpp>
 #include <asio3/http/write.hpp>
+#include <asio3/http/client_pool.hpp>
 
 #include <asio3/proxy/handshake.hpp>
 
@@ -42,6 +43,9 @@ namespace boost::beast::http
 	{
 	#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
 		std::optional<std::reference_wrapper<asio::ssl::context>> sslctx;
+		/// the ssl context which is shared with the pooled connections, it must be used instead
+		/// of the sslctx when the pool is set, because the connections may outlive the request.
+		std::shared_ptr<asio::ssl::context> shared_sslctx;
 	#endif
 		std::string url;
 		std::string data;
@@ -52,6 +56,7 @@ namespace boost::beast::http
 		std::optional<asio::stream_file> saved_file;
 		std::optional<std::filesystem::path> saved_filepath;
 		std::optional<socks5::option> socks5_option;
+		std::optional<std::reference_wrapper<http::client_pool>> pool;
 	};
 }
 
@@ -81,67 +86,6 @@ namespace boost::beast::http::detail
 			if (ec)
 				co_return{ ec };
 
-			asio::ip::tcp::socket sock{ ex };
-
-			std::defer close_sock = [&sock]() mutable
-			{
-				asio::error_code ec{};
-				sock.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
-				sock.close(ec);
-				asio::reset_lock(sock);
-			};
-
-			asio::ip::tcp::resolver resolver(ex);
-
-			std::string addr{ url.get_host() };
-			std::string port{ url.get_port() };
-
-			if (opt.socks5_option.has_value())
-			{
-				socks5::option& s5opt = opt.socks5_option.value();
-				addr = s5opt.proxy_address;
-				port = std::to_string(s5opt.proxy_port);
-			}
-
-			// A successful resolve operation is guaranteed to pass a non-empty range to the handler.
-			auto [e1, eps] = co_await asio::async_resolve(
-				resolver, std::move(addr), std::move(port),
-				asio::ip::resolver_base::flags(), asio::use_deferred_executor(resolver));
-			if (e1)
-				co_return{ e1 };
-
-			if (!!state.cancelled())
-				co_return{ asio::error::operation_aborted };
-
-			auto [e2, ep] = co_await asio::async_connect(
-				sock, eps, asio::default_tcp_connect_condition{}, asio::use_deferred_executor(sock));
-			if (e2)
-				co_return{ e2 };
-
-			if (!!state.cancelled())
-				co_return{ asio::error::operation_aborted };
-
-			if (opt.socks5_option.has_value())
-			{
-				socks5::option& s5opt = opt.socks5_option.value();
-
-				if (s5opt.method.empty())
-					s5opt.method.emplace_back(socks5::auth_method::anonymous);
-				if (s5opt.dest_address.empty())
-					s5opt.dest_address = url.get_host();
-				if (s5opt.dest_port == 0)
-					s5opt.dest_port = static_cast<std::uint16_t>(std::stoul(std::string(url.get_port())));
-				if (std::to_underlying(s5opt.cmd) == 0)
-					s5opt.cmd = socks5::command::connect;
-
-				auto [e3] = co_await socks5::async_handshake(sock, s5opt, asio::use_deferred_executor(sock));
-				if (e3)
-					co_return{ e3 };
-			}
-
-			if (!!state.cancelled())
-				co_return{ asio::error::operation_aborted };
-
 			http::request<http::string_body> req{};
 			req.method(opt.method);
 			req.version(11);
@@ -180,6 +124,10 @@ namespace boost::beast::http::detail
 					"Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/105.0.0.0 Safari/537.36");
 			}
 
+			// the pooled connection is kept alive for the next request.
+			if (opt.pool.has_value() && req.find(http::field::connection) == req.end())
+				req.keep_alive(true);
+
 			if (!opt.saved_file.has_value())
 			{
 				try
@@ -204,123 +152,149 @@ namespace boost::beast::http::detail
 			if (!opt.on_chunk)
 				opt.on_chunk = [](std::string_view) { return true; };
 
-			beast::flat_buffer buffer{};
-			http::response_parser<http::string_body> parser;
+			bool is_ssl = asio::iequals(url.get_schema(), "https");
+
+		#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+			std::shared_ptr<asio::ssl::context> sslctx = get_ssl_context(opt, ec);
+			if (ec)
+				co_return{ ec };
+
+			std::string key = client_pool::make_key(url, opt.socks5_option, is_ssl ? sslctx.get() : nullptr);
+		#else
+			std::string key = client_pool::make_key(url, opt.socks5_option);
+		#endif
+
+			// the request is sent again only if it's idempotent.
+			bool idempotent = http::is_idempotent(opt.method);
+
+			client_connection_ptr conn;
 
-			parser.body_limit((std::numeric_limits<std::size_t>::max)());
+			bool reusable = false;
 
-			if (asio::iequals(url.get_schema(), "https"))
+			std::defer release_conn = [this, &conn, &reusable]() mutable
 			{
-			#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
-				// https://en.cppreference.com/w/cpp/memory/unique_ptr
-				std::unique_ptr<asio::ssl::context, void(*)(asio::ssl::context*)> psslctx
-				{
-					nullptr,
-					[](asio::ssl::context*) {}
-				};
-				if (opt.sslctx.has_value())
-				{
-					std::unique_ptr<asio::ssl::context, void(*)(asio::ssl::context*)> psslctx2
-					{
-						std::addressof(opt.sslctx.value().get()),
-						[](asio::ssl::context*) {}
-					};
-					psslctx = std::move(psslctx2);
-				}
-				else
+				if (conn && opt.pool.has_value())
+					opt.pool.value().get().release(std::move(conn), reusable);
+			};
+
+			std::optional<http::response_parser<http::string_body>> parser;
+
+			// if the server closed a reused keep-alive connection before the response header
+			// was received, send the idempotent request again on a new connection, but only once.
+			for (std::size_t attempt = 0; ; ++attempt)
+			{
+				if (opt.pool.has_value())
 				{
-					std::unique_ptr<asio::ssl::context, void(*)(asio::ssl::context*)> psslctx2
-					{
-						new asio::ssl::context(asio::ssl::context::tlsv12_client),
-						[](asio::ssl::context* p) { delete p; }
-					};
-					asio::load_root_certificates(*psslctx2);
-					//psslctx2->set_verify_mode(asio::ssl::verify_peer);
-					psslctx = std::move(psslctx2);
-				}
+					if (conn)
+						opt.pool.value().get().release(std::move(conn), false);
 
-				std::unique_ptr<asio::ssl::stream<asio::ip::tcp::socket&>> stream =
-					std::make_unique<asio::ssl::stream<asio::ip::tcp::socket&>>(sock, *psslctx);
+					auto [e0, c0] = co_await opt.pool.value().get().async_acquire(
+						key, asio::use_deferred_executor(ex));
+					if (e0)
+						co_return{ e0 };
 
-				// Set SNI Hostname (many hosts need this to handshake successfully)
-				// https://github.com/djarek/certify
-				if (auto it = req.find(http::field::host); it != req.end())
+					conn = std::move(c0);
+				}
+				else
 				{
-					std::string hostname(it->value());
-					SSL_set_tlsext_host_name(stream->native_handle(), hostname.data());
+					conn = std::make_shared<client_connection>(ex);
 				}
 
-				auto [e3] = co_await stream->async_handshake(
-					asio::ssl::stream_base::handshake_type::client, asio::use_deferred_executor(sock));
-				if (e3)
-					co_return{ e3 };
+				bool reused = conn->is_open();
 
-				auto [e4, n4] = co_await http::async_write(*stream, req, asio::use_deferred_executor(sock));
-				if (e4)
+				if (!reused)
 				{
-					co_await stream->async_shutdown(asio::use_deferred_executor(sock));
-					co_return{ e4 };
+				#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+					conn->sslctx = sslctx;
+				#endif
+
+					auto [e2] = co_await http::async_connect(*conn,
+						std::string(url.get_host()), std::string(url.get_port()), is_ssl, opt.socks5_option,
+						asio::use_deferred_executor(conn->sock));
+					if (e2)
+						co_return{ e2 };
 				}
 
 				if (!!state.cancelled())
-				{
-					co_await stream->async_shutdown(asio::use_deferred_executor(sock));
 					co_return{ asio::error::operation_aborted };
-				}
 
-				auto [e5, n5] = co_await http::async_read_header(
-					*stream, buffer, parser, asio::use_deferred_executor(sock));
-				if (e5)
-				{
-					co_await stream->async_shutdown(asio::use_deferred_executor(sock));
-					co_return{ e5 };
-				}
+				parser.emplace();
+				parser->body_limit((std::numeric_limits<std::size_t>::max)());
 
-				if (!opt.on_head(parser.get()))
+				if (is_ssl)
 				{
-					co_await stream->async_shutdown(asio::use_deferred_executor(sock));
-					co_return{ asio::error::operation_aborted };
-				}
+				#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+					auto [e4, n4] = co_await http::async_write(
+						*conn->stream, req, asio::use_deferred_executor(conn->sock));
+					ec = e4;
 
-				auto [e6, n6] = co_await http::async_recv_file(
-					*stream, opt.saved_file.value(), buffer, parser.get(), opt.on_chunk,
-					asio::use_deferred_executor(sock));
-				if (e6)
+					if (!ec && !!state.cancelled())
+						ec = asio::error::operation_aborted;
+
+					if (!ec)
+					{
+						auto [e5, n5] = co_await http::async_read_header(
+							*conn->stream, conn->buffer, *parser, asio::use_deferred_executor(conn->sock));
+						ec = e5;
+					}
+				#else
+					co_return{ asio::error::operation_not_supported };
+				#endif
+				}
+				else
 				{
-					co_await stream->async_shutdown(asio::use_deferred_executor(sock));
-					co_return{ e6 };
+					auto [e4, n4] = co_await http::async_write(
+						conn->sock, req, asio::use_deferred_executor(conn->sock));
+					ec = e4;
+
+					if (!ec && !!state.cancelled())
+						ec = asio::error::operation_aborted;
+
+					if (!ec)
+					{
+						auto [e5, n5] = co_await http::async_read_header(
+							conn->sock, conn->buffer, *parser, asio::use_deferred_executor(conn->sock));
+						ec = e5;
+					}
 				}
 
-				co_await stream->async_shutdown(asio::use_deferred_executor(sock));
-			#else
-				co_return{ asio::error::operation_not_supported };
-			#endif
+				if (reused && attempt == 0 && idempotent && is_stale_connection_error(ec))
+					continue;
+
+				break;
 			}
-			else
-			{
-				auto [e4, n4] = co_await http::async_write(sock, req, asio::use_deferred_executor(sock));
-				if (e4)
-					co_return{ e4 };
 
-				if (!!state.cancelled())
-					co_return{ asio::error::operation_aborted };
+			if (!ec && !opt.on_head(parser->get()))
+				ec = asio::error::operation_aborted;
 
-				auto [e5, n5] = co_await http::async_read_header(
-					sock, buffer, parser, asio::use_deferred_executor(sock));
-				if (e5)
-					co_return{ e5 };
+			if (!ec)
+			{
+				if (is_ssl)
+				{
+				#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+					auto [e6, n6] = co_await http::async_recv_file(
+						*conn->stream, opt.saved_file.value(), conn->buffer, parser->get(), opt.on_chunk,
+						asio::use_deferred_executor(conn->sock));
+					ec = e6;
+				#endif
+				}
+				else
+				{
+					auto [e6, n6] = co_await http::async_recv_file(
+						conn->sock, opt.saved_file.value(), conn->buffer, parser->get(), opt.on_chunk,
+						asio::use_deferred_executor(conn->sock));
+					ec = e6;
+				}
+			}
 
-				if (opt.on_head)
-					opt.on_head(parser.get());
+		#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+			if (is_ssl && !opt.pool.has_value())
+				co_await conn->stream->async_shutdown(asio::use_deferred_executor(conn->sock));
+		#endif
 
-				auto [e6, n6] = co_await http::async_recv_file(
-					sock, opt.saved_file.value(), buffer, parser.get(), opt.on_chunk,
-					asio::use_deferred_executor(sock));
-				if (e6)
-					co_return{ e6 };
-			}
+			reusable = !ec && parser->keep_alive();
 
-			co_return{ error_code{} };
+			co_return{ ec };
         }
 	};
 }
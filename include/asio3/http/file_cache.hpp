@@ -0,0 +1,544 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <asio3/core/asio.hpp>
+#include <asio3/core/beast.hpp>
+#include <asio3/http/core.hpp>
+#include <asio3/http/cache.hpp>
+#include <asio3/http/mime_types.hpp>
+
+#ifdef ASIO3_HEADER_ONLY
+namespace bho::beast::http
+#else
+namespace boost::beast::http
+#endif
+{
+	struct file_cache_option
+	{
+		/// the max count of the cached files, the least recently used one is closed when it's exceeded.
+		std::size_t max_entries = 1024;
+
+		/// the files which are not larger than this are loaded into memory, and their responses
+		/// are serialized in advance.
+		std::size_t max_content_size = 64 * 1024;
+
+		/// the memory budget of all the loaded file contents.
+		std::size_t max_content_bytes = 64 * 1024 * 1024;
+
+		/// the size and the modification time of a cached file are checked again when it's used
+		/// after this interval, a modified file is reloaded and a removed file is dropped.
+		std::chrono::steady_clock::duration revalidate_interval = std::chrono::seconds(1);
+	};
+
+	/**
+	 * @brief The cached file, it holds the open descriptor, the metadata and the responses which
+	 * are serialized in advance. The entry is immutable after it's loaded, a modified file is
+	 * loaded into a new entry, and the old one is released when no one is using it.
+	 */
+	struct file_entry
+	{
+		/// the canonical path of the file.
+		std::string                                      path;
+
+		std::uint64_t                                    size = 0;
+
+		std::filesystem::file_time_type                  mtime{};
+
+		std::string                                      etag;
+
+		std::string                                      last_modified;
+
+		std::string_view                                 mimetype;
+
+		/// the "200 OK" response with the whole content, it's null if the file is too large.
+		std::shared_ptr<const http::serialized_response> response;
+
+		/// the "304 Not Modified" response.
+		std::shared_ptr<const http::serialized_response> not_modified;
+
+		/// the open descriptor of the file, it's -1 on windows, the file is opened by the path.
+		int                                              fd = -1;
+
+		// the time point rep of the steady_clock when the metadata was checked last time.
+		mutable std::atomic<std::chrono::steady_clock::rep> checked{ 0 };
+
+		file_entry() = default;
+
+		~file_entry()
+		{
+		#if !defined(_WIN32)
+			if (fd != -1)
+				::close(fd);
+		#endif
+		}
+
+		/// no copy construct function
+		file_entry(const file_entry&) = delete;
+
+		/// no operator equal function
+		file_entry& operator=(const file_entry&) = delete;
+
+		/**
+		 * @brief Check whether the conditional request can be answered by the "304 Not Modified".
+		 * The "If-None-Match" takes precedence over the "If-Modified-Since".
+		 */
+		template<class Fields>
+		[[nodiscard]] inline bool is_not_modified(const http::header<true, Fields>& req) const noexcept
+		{
+			std::string_view inm = req[http::field::if_none_match];
+			if (!inm.empty())
+				return inm == "*" || inm.find(etag) != std::string_view::npos;
+
+			std::string_view ims = req[http::field::if_modified_since];
+			return !ims.empty() && ims == last_modified;
+		}
+
+		/**
+		 * @brief Get the file content which is loaded into memory, it's empty for the large files.
+		 */
+		[[nodiscard]] inline std::string_view content() const noexcept
+		{
+			if (!response)
+				return std::string_view{};
+
+			return std::string_view(response->data).substr(response->header_size);
+		}
+
+		/**
+		 * @brief Open a file stream which reads this file from the beginning. Every stream has
+		 * its own file offset, so the streams of the same file can be read concurrently.
+		 */
+		inline asio::stream_file open(const auto& executor, asio::error_code& ec) const
+		{
+			asio::stream_file file(executor);
+
+		#if !defined(_WIN32)
+			// the dup shares the file offset with the cached descriptor, so a new open file
+			// description is required. On linux the cached descriptor is reopened through the
+			// proc fs, it's the same file even if the path was replaced.
+			int newfd = -1;
+
+		#if defined(__linux__)
+			std::string proc = "/proc/self/fd/" + std::to_string(fd);
+			newfd = ::open(proc.data(), O_RDONLY | O_CLOEXEC);
+		#endif
+
+			if (newfd == -1)
+				newfd = ::open(path.data(), O_RDONLY | O_CLOEXEC);
+
+			if (newfd == -1)
+			{
+				ec = asio::error_code(errno, asio::error::get_system_category());
+				return file;
+			}
+
+			file.assign(newfd, ec);
+			if (ec)
+				::close(newfd);
+		#else
+			file.open(path, asio::file_base::read_only, ec);
+		#endif
+
+			return file;
+		}
+	};
+
+	/**
+	 * @brief A cache of the open files and their metadata which is attached to a execution
+	 * context. The hot small files are served entirely from memory, and the conditional
+	 * requests are answered without touching the disk.
+	 * The files are keyed by the normalized path, the lookup doesn't access the file system,
+	 * and the entry is revalidated by the size and the modification time at most once per
+	 * revalidate interval.
+	 * @code
+	 *    http::file_cache& files = http::attach_file_cache(ctx.get_executor());
+	 *
+	 *    auto entry = files.get(filepath);
+	 *    if (entry && (*entry)->is_not_modified(req))
+	 *        rep = (*entry)->not_modified;
+	 * @endcode
+	 */
+	class file_cache : public asio::detail::execution_context_service_base<file_cache>
+	{
+	public:
+		using entry_type = file_entry;
+		using entry_ptr  = std::shared_ptr<const file_entry>;
+		using clock_type = std::chrono::steady_clock;
+
+	protected:
+		struct node
+		{
+			std::string key;
+
+			entry_ptr   entry;
+		};
+
+		// the front is the most recently used one.
+		using list_type = std::list<node>;
+
+	public:
+		explicit file_cache(asio::execution_context& ctx)
+			: asio::detail::execution_context_service_base<file_cache>(ctx)
+		{
+		}
+
+		~file_cache()
+		{
+		}
+
+		void shutdown() override
+		{
+			this->clear();
+		}
+
+		/**
+		 * @brief Get the cached file, the file is opened and loaded if it's not cached.
+		 * @param filepath - The full file path.
+		 * @return The cached file, or the error if the file can't be opened or it's not a regular file.
+		 */
+		std::expected<entry_ptr, asio::error_code> get(const std::filesystem::path& filepath)
+		{
+			std::string key = filepath.string();
+
+			clock_type::duration interval;
+
+			// the path is usually normalized already, so it's normalized only when it's not found.
+			entry_ptr e = this->find(key, interval);
+			if (!e)
+			{
+				std::string normal = filepath.lexically_normal().string();
+				if (normal != key)
+				{
+					key = std::move(normal);
+					e = this->find(key, interval);
+				}
+			}
+
+			if (e)
+			{
+				if (!need_revalidate(*e, interval))
+					return e;
+
+				std::error_code ec{};
+				auto size = std::filesystem::file_size(e->path, ec);
+				auto mtime = ec ? std::filesystem::file_time_type{} : std::filesystem::last_write_time(e->path, ec);
+
+				if (!ec && size == e->size && mtime == e->mtime)
+					return e;
+
+				this->erase(key, e);
+			}
+
+			std::expected<entry_ptr, asio::error_code> r = this->load(key);
+
+			if (r.has_value())
+				this->insert(std::move(key), r.value());
+
+			return r;
+		}
+
+		/**
+		 * @brief Remove the cached file, it's closed when it's not used by anyone.
+		 */
+		inline bool erase(const std::filesystem::path& filepath)
+		{
+			std::lock_guard g{ mtx_ };
+
+			auto it = map_.find(filepath.lexically_normal().string());
+			if (it == map_.end())
+				return false;
+
+			this->remove(it);
+
+			return true;
+		}
+
+		/**
+		 * @brief Remove all the cached files.
+		 */
+		inline void clear()
+		{
+			std::lock_guard g{ mtx_ };
+			map_.clear();
+			lru_.clear();
+			bytes_ = 0;
+		}
+
+		/**
+		 * @brief Get the count of the cached files.
+		 */
+		inline std::size_t size()
+		{
+			std::lock_guard g{ mtx_ };
+			return map_.size();
+		}
+
+		/**
+		 * @brief Get the bytes of the file contents which are loaded into memory.
+		 */
+		inline std::size_t get_content_bytes()
+		{
+			std::lock_guard g{ mtx_ };
+			return bytes_;
+		}
+
+		inline void set_option(file_cache_option opt)
+		{
+			std::lock_guard g{ mtx_ };
+			option_ = std::move(opt);
+			this->evict();
+		}
+
+		inline file_cache_option get_option()
+		{
+			std::lock_guard g{ mtx_ };
+			return option_;
+		}
+
+	protected:
+		inline entry_ptr find(const std::string& key, clock_type::duration& interval)
+		{
+			std::lock_guard g{ mtx_ };
+
+			interval = option_.revalidate_interval;
+
+			auto it = map_.find(key);
+			if (it == map_.end())
+				return nullptr;
+
+			lru_.splice(lru_.begin(), lru_, it->second);
+
+			return it->second->entry;
+		}
+
+		static bool need_revalidate(const file_entry& e, clock_type::duration interval) noexcept
+		{
+			clock_type::rep now = clock_type::now().time_since_epoch().count();
+			clock_type::rep checked = e.checked.load(std::memory_order_relaxed);
+
+			if (now - checked < interval.count())
+				return false;
+
+			// only one thread checks the file, the others use the entry as it is.
+			return e.checked.compare_exchange_strong(checked, now, std::memory_order_relaxed);
+		}
+
+		static std::string make_http_date(std::filesystem::file_time_type mtime)
+		{
+			// the file_clock can't be converted by clock_cast on all the compilers.
+			auto tp = std::chrono::time_point_cast<std::chrono::seconds>(std::chrono::system_clock::now() +
+				std::chrono::duration_cast<std::chrono::system_clock::duration>(
+					mtime - std::filesystem::file_time_type::clock::now()));
+
+			static constexpr const char* weekdays[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+			static constexpr const char* months[] = {
+				"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+			std::chrono::sys_days days = std::chrono::floor<std::chrono::days>(tp);
+			std::chrono::year_month_day ymd{ days };
+			std::chrono::weekday wd{ days };
+			std::chrono::hh_mm_ss hms{ tp - days };
+
+			char buf[32];
+			int n = std::snprintf(buf, sizeof(buf), "%s, %02u %s %04d %02d:%02d:%02d GMT",
+				weekdays[wd.c_encoding()], unsigned(ymd.day()), months[unsigned(ymd.month()) - 1],
+				int(ymd.year()), int(hms.hours().count()), int(hms.minutes().count()),
+				int(hms.seconds().count()));
+
+			return std::string(buf, n > 0 ? std::size_t(n) : 0);
+		}
+
+		std::expected<entry_ptr, asio::error_code> load(const std::filesystem::path& filepath)
+		{
+			std::error_code ec{};
+
+			std::shared_ptr<file_entry> e = std::make_shared<file_entry>();
+
+			std::filesystem::path canonical = std::filesystem::canonical(filepath, ec);
+			if (ec)
+				return std::unexpected(ec);
+
+			if (!std::filesystem::is_regular_file(canonical, ec))
+				return std::unexpected(ec ? ec : std::make_error_code(std::errc::is_a_directory));
+
+			e->path = canonical.string();
+			e->size = std::filesystem::file_size(canonical, ec);
+			if (ec)
+				return std::unexpected(ec);
+
+			e->mtime = std::filesystem::last_write_time(canonical, ec);
+			if (ec)
+				return std::unexpected(ec);
+
+			e->checked.store(clock_type::now().time_since_epoch().count(), std::memory_order_relaxed);
+
+		#if !defined(_WIN32)
+			e->fd = ::open(e->path.data(), O_RDONLY | O_CLOEXEC);
+			if (e->fd == -1)
+				return std::unexpected(asio::error_code(errno, asio::error::get_system_category()));
+		#endif
+
+			e->etag = make_etag(e->size, e->mtime);
+			e->last_modified = make_http_date(e->mtime);
+			e->mimetype = http::extension_to_mimetype(canonical.extension().string());
+
+			std::size_t max_content_size = this->get_option().max_content_size;
+
+			if (e->size <= max_content_size)
+			{
+				std::string content;
+				content.resize(std::size_t(e->size));
+
+				std::ifstream file(canonical, std::ios::in | std::ios::binary);
+				if (!file.read(content.data(), std::streamsize(content.size())))
+					return std::unexpected(std::make_error_code(std::errc::io_error));
+
+				http::response<http::string_body> res{ http::status::ok, 11 };
+				res.set(http::field::server, BEAST_VERSION_STRING);
+				res.set(http::field::content_type, e->mimetype);
+				res.set(http::field::etag, e->etag);
+				res.set(http::field::last_modified, e->last_modified);
+				res.body() = std::move(content);
+				res.prepare_payload();
+
+				std::shared_ptr<http::serialized_response> sr = std::make_shared<http::serialized_response>();
+				if (http::serialize_response(res, *sr))
+					e->response = std::move(sr);
+			}
+
+			http::response<http::empty_body> res{ http::status::not_modified, 11 };
+			res.set(http::field::server, BEAST_VERSION_STRING);
+			res.set(http::field::etag, e->etag);
+			res.set(http::field::last_modified, e->last_modified);
+
+			std::shared_ptr<http::serialized_response> sr = std::make_shared<http::serialized_response>();
+			if (http::serialize_response(res, *sr))
+				e->not_modified = std::move(sr);
+
+			return e;
+		}
+
+		static std::string make_etag(std::uint64_t size, std::filesystem::file_time_type mtime)
+		{
+			char buf[48];
+			int n = std::snprintf(buf, sizeof(buf), "\"%llx-%llx\"",
+				static_cast<unsigned long long>(size),
+				static_cast<unsigned long long>(mtime.time_since_epoch().count()));
+			return std::string(buf, n > 0 ? std::size_t(n) : 0);
+		}
+
+		inline void insert(std::string key, entry_ptr e)
+		{
+			std::lock_guard g{ mtx_ };
+
+			// the file may be loaded by the other thread at the same time.
+			auto it = map_.find(key);
+			if (it != map_.end())
+				this->remove(it);
+
+			lru_.emplace_front(node{ key, e });
+
+			map_.emplace(std::move(key), lru_.begin());
+
+			bytes_ += e->content().size();
+
+			this->evict();
+		}
+
+		inline void erase(const std::string& key, const entry_ptr& e)
+		{
+			std::lock_guard g{ mtx_ };
+
+			auto it = map_.find(key);
+			if (it != map_.end() && it->second->entry == e)
+				this->remove(it);
+		}
+
+		inline void remove(std::unordered_map<std::string, list_type::iterator>::iterator it)
+		{
+			bytes_ -= it->second->entry->content().size();
+
+			lru_.erase(it->second);
+
+			map_.erase(it);
+		}
+
+		inline void evict()
+		{
+			while (!lru_.empty() && (map_.size() > option_.max_entries || bytes_ > option_.max_content_bytes))
+			{
+				this->remove(map_.find(lru_.back().key));
+			}
+		}
+
+	protected:
+		std::mutex                                                      mtx_;
+
+		file_cache_option                                               option_;
+
+		list_type                                                       lru_;
+
+		std::unordered_map<std::string, list_type::iterator>   map_;
+
+		std::size_t                                                     bytes_ = 0;
+	};
+
+	/**
+	 * @brief Attach the file cache to the execution context of the executor.
+	 * @param executor - The executor or the execution context.
+	 */
+	inline file_cache& attach_file_cache(auto&& executor, file_cache_option opt = {})
+	{
+		asio::execution_context* ctx = nullptr;
+
+		if constexpr (std::derived_from<std::remove_cvref_t<decltype(executor)>, asio::execution_context>)
+			ctx = std::addressof(executor);
+		else
+			ctx = std::addressof(asio::query(executor, asio::execution::context_as<asio::execution_context&>));
+
+		file_cache& cache = asio::use_service<file_cache>(*ctx);
+		cache.set_option(std::move(opt));
+		return cache;
+	}
+
+	/**
+	 * @brief Get the file cache which is attached to the execution context of the executor.
+	 * @return Returns nullptr if the cache is not attached.
+	 */
+	inline file_cache* find_file_cache(const auto& executor)
+	{
+		asio::execution_context& ctx = asio::query(
+			executor, asio::execution::context_as<asio::execution_context&>);
+
+		if (!asio::has_service<file_cache>(ctx))
+			return nullptr;
+
+		return std::addressof(asio::use_service<file_cache>(ctx));
+	}
+}
@@ -160,7 +160,7 @@ namespace boost::asio
 
 		inline void update_alive_time() noexcept
 		{
-			alive_time = std::chrono::system_clock::now();
+			alive_time = asio::coarse_clock::now();
 		}
 
 	public:
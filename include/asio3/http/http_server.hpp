@@ -57,4 +57,6 @@ namespace boost::asio
 	};
 
 	using http_server = basic_http_server<http_session>;
+
+	using http_arena_server = basic_http_server<http_arena_session>;
 }
@@ -12,6 +12,7 @@
 
 #include <asio3/tcp/tcp_session.hpp>
 #include <asio3/http/core.hpp>
+#include <asio3/http/arena.hpp>
 #include <asio3/http/read.hpp>
 #include <asio3/http/write.hpp>
 
@@ -55,5 +56,67 @@ namespace boost::asio
 		}
 	};
 
+	/**
+	 * @brief The http session whose requests and responses allocate from a per-connection arena,
+	 * the fields and the body of the request, and the response generator use the arena, and the
+	 * arena is reset after each response, so the steady state of a keep-alive connection needn't
+	 * allocate from the heap. The arena's statistics can be used to confirm it.
+	 */
+	template<typename SocketT = tcp_socket>
+	class basic_http_arena_session : public basic_http_session<SocketT>
+	{
+	public:
+		using super = basic_http_session<SocketT>;
+		using socket_type = SocketT;
+		using request_type = http::arena_request;
+		using response_type = http::web_response;
+
+		/**
+		 * @brief constructor
+		 */
+		explicit basic_http_arena_session(socket_type sock) : super(std::move(sock))
+		{
+		}
+
+		basic_http_arena_session(basic_http_arena_session&&) noexcept = default;
+		basic_http_arena_session& operator=(basic_http_arena_session&&) noexcept = default;
+
+		/**
+		 * @brief destructor
+		 */
+		~basic_http_arena_session()
+		{
+			this->close();
+		}
+
+		inline super& base() noexcept
+		{
+			return static_cast<super&>(*this);
+		}
+
+		/**
+		 * @brief Create an empty request which allocates from the arena.
+		 */
+		inline request_type make_request()
+		{
+			return http::make_arena_request(arena);
+		}
+
+		/**
+		 * @brief Create an empty response whose message is allocated from the arena.
+		 */
+		inline response_type make_response()
+		{
+			return response_type{ std::addressof(arena) };
+		}
+
+	public:
+		/// it must be reset after the request and the response of each round were destroyed,
+		/// so the response should be written by the http::advanced_message_generator_ref.
+		http::arena arena;
+	};
+
 	using http_session = basic_http_session<asio::tcp_socket>;
+
+	using http_arena_session = basic_http_arena_session<asio::tcp_socket>;
 }
@@ -32,6 +32,8 @@ namespace boost::asio
 			: super(ex)
 			, ssl_context(std::move(sslctx))
 		{
+			// the ticket key callback of the user is kept, call the asio::ssl_ticket_keys::attach
+			// to issue the session tickets with the rotated keys.
 		}
 
 		basic_https_server(basic_https_server&&) noexcept = default;
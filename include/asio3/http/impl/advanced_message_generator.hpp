@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <stdexcept>
+
 #include <asio3/http/advanced_message_generator.hpp>
 
 #ifdef ASIO3_HEADER_ONLY
@@ -85,12 +87,37 @@ void reinit_response(http::response<BodyT, FieldsT>& m)
     }
 }
 
+// Copy the header of a response into the header which uses the default fields, the fields
+// of the source may use another allocator, such as the arena of a connection.
+template <class FieldsT>
+void copy_response_header(http::response_header<>& dst, const http::header<false, FieldsT>& src)
+{
+    if constexpr (std::same_as<FieldsT, http::fields>)
+    {
+        dst = src;
+    }
+    else
+    {
+        dst = {};
+        dst.version(src.version());
+        dst.result(src.result_int());
+        dst.reason(src.reason());
+        for (const auto& f : src)
+        {
+            if (f.name() == http::field::unknown)
+                dst.insert(f.name_string(), f.value());
+            else
+                dst.insert(f.name(), f.value());
+        }
+    }
+}
+
 template <class BodyT, class FieldsT>
 std::expected<http::response<http::string_body>, error_code> to_string_body_response_impl(
     http::response<BodyT, FieldsT>& m)
 {
     http::response<http::string_body> res{};
-    static_cast<http::response<http::string_body>::header_type&>(res) = m;
+    detail::copy_response_header(res, m);
 	http::response_serializer<BodyT, FieldsT> sr{ m };
 
     // This lambda is used as the "visit" function
@@ -129,9 +156,22 @@ std::expected<http::response<http::string_body>, error_code> to_string_body_resp
 }
 
 template <class BodyT, class FieldsT>
-http::response_header<>& get_response_header_impl(http::response<BodyT, FieldsT>& m) noexcept
+http::response_header<>& get_response_header_impl(http::response<BodyT, FieldsT>& m)
 {
-    return static_cast<http::response_header<>&>(m);
+    if constexpr (std::same_as<FieldsT, http::fields>)
+    {
+        return static_cast<http::response_header<>&>(m);
+    }
+    else
+    {
+        // the fields use another allocator, a copy of the header can't reflect the changes
+        // in both directions, so it's refused.
+        asio::detail::throw_exception(std::logic_error(
+            "the header of the message which uses the fields with another allocator can't be "
+            "referenced, use the result() and keep_alive() of the generator instead"));
+        static http::response_header<> s{};
+        return s;
+    }
 }
 
 template <class BodyT, class FieldsT>
@@ -141,15 +181,56 @@ http::response_header<>& get_response_header_impl(http::request<BodyT, FieldsT>&
     return s;
 }
 
+template <bool isRequest, class BodyT, class FieldsT>
+http::status result_impl(const http::message<isRequest, BodyT, FieldsT>& m) noexcept
+{
+    if constexpr (isRequest)
+        return http::status::unknown;
+    else
+        return m.result();
+}
+
 } // detail
 
+template<class Impl, class... Args>
+void
+advanced_message_generator::emplace(Args&&... args)
+{
+    if (!resource_)
+    {
+        impl_ = std::unique_ptr<impl_base, detail::generator_impl_deleter>(
+            new Impl(std::forward<Args>(args)...));
+        return;
+    }
+
+    void* p = resource_->allocate(sizeof(Impl), alignof(Impl));
+    try
+    {
+        impl_ = std::unique_ptr<impl_base, detail::generator_impl_deleter>(
+            ::new (p) Impl(std::forward<Args>(args)...),
+            detail::generator_impl_deleter{ resource_, sizeof(Impl), alignof(Impl) });
+    }
+    catch (...)
+    {
+        resource_->deallocate(p, sizeof(Impl), alignof(Impl));
+        throw;
+    }
+}
+
 template <bool isRequest, class Body, class Fields>
 advanced_message_generator::advanced_message_generator(
     http::message<isRequest, Body, Fields>&& m)
-    : impl_(std::make_unique<
-            generator_impl<isRequest, Body, Fields>>(
-          std::move(m)))
 {
+    emplace<generator_impl<isRequest, Body, Fields>>(std::move(m));
+}
+
+template <bool isRequest, class Body, class Fields>
+advanced_message_generator&
+advanced_message_generator::operator=(
+    http::message<isRequest, Body, Fields>&& m)
+{
+    emplace<generator_impl<isRequest, Body, Fields>>(std::move(m));
+    return *this;
 }
 
 template <bool isRequest, class Body, class Fields>
@@ -188,8 +269,14 @@ struct advanced_message_generator::generator_impl final
         return m_.keep_alive();
     }
 
+    http::status
+    result() const noexcept override
+    {
+        return detail::result_impl(m_);
+    }
+
     http::response_header<>&
-    get_response_header() noexcept override
+    get_response_header() override
     {
         return detail::get_response_header_impl(m_);
     }
@@ -269,8 +356,14 @@ struct advanced_message_generator::ref_generator_impl final
         return m_.keep_alive();
     }
 
+    http::status
+    result() const noexcept override
+    {
+        return detail::result_impl(m_);
+    }
+
     http::response_header<>&
-    get_response_header() noexcept override
+    get_response_header() override
     {
         return detail::get_response_header_impl(m_);
     }
@@ -316,19 +409,108 @@ private:
 
 template<typename>
 advanced_message_generator::advanced_message_generator()
-    : impl_(std::make_unique<
-            generator_impl<false, http::string_body, http::fields>>(
-          http::message<false, http::string_body, http::fields>(http::status::unknown, 11)))
 {
+    emplace<generator_impl<false, http::string_body, http::fields>>(
+        http::message<false, http::string_body, http::fields>(http::status::unknown, 11));
+}
+
+template<typename>
+advanced_message_generator::advanced_message_generator(std::pmr::memory_resource* mr)
+    : resource_(mr)
+{
+    emplace<generator_impl<false, http::string_body, http::fields>>(
+        http::message<false, http::string_body, http::fields>(http::status::unknown, 11));
 }
 
 template <bool isRequest, class Body, class Fields>
 advanced_message_generator::advanced_message_generator(
     std::reference_wrapper<http::message<isRequest, Body, Fields>> m)
-    : impl_(std::make_unique<
-            ref_generator_impl<isRequest, Body, Fields>>(
-          m.get()))
 {
+    emplace<ref_generator_impl<isRequest, Body, Fields>>(m.get());
+}
+
+struct advanced_message_generator::shared_generator_impl final
+    : advanced_message_generator::impl_base
+{
+    explicit shared_generator_impl(
+        std::shared_ptr<const serialized_response> r)
+        : r_(std::move(r))
+    {
+    }
+
+    bool
+    is_done() override
+    {
+        return pos_ >= r_->data.size();
+    }
+
+    const_buffers_type
+    prepare(error_code& ec) override
+    {
+        ec = {};
+        buf_ = net::const_buffer(r_->data.data() + pos_, r_->data.size() - pos_);
+        return { &buf_, 1 };
+    }
+
+    void
+    consume(std::size_t n) override
+    {
+        pos_ += (std::min)(n, r_->data.size() - pos_);
+    }
+
+    bool
+    keep_alive() const noexcept override
+    {
+        return r_->keep_alive;
+    }
+
+    http::status
+    result() const noexcept override
+    {
+        return r_->header.result();
+    }
+
+    http::response_header<>&
+    get_response_header() override
+    {
+        // the shared header can't be modified, so return a copy of it.
+        if (!header_)
+            header_.emplace(r_->header);
+        return *header_;
+    }
+
+    std::expected<http::response<http::string_body>, error_code> to_string_body_response() override
+    {
+        http::response<http::string_body> res{};
+        static_cast<http::response<http::string_body>::header_type&>(res) = r_->header;
+        res.body().assign(r_->data, r_->header_size);
+        return res;
+    }
+
+private:
+    std::shared_ptr<const serialized_response> r_;
+
+    std::optional<http::response_header<>> header_;
+
+    net::const_buffer buf_;
+
+    std::size_t pos_ = 0;
+};
+
+template<typename>
+advanced_message_generator::advanced_message_generator(
+    std::shared_ptr<const serialized_response> r)
+{
+    emplace<shared_generator_impl>(std::move(r));
+}
+
+template<typename>
+advanced_message_generator&
+advanced_message_generator::operator=(
+    std::shared_ptr<const serialized_response> r)
+{
+    emplace<shared_generator_impl>(std::move(r));
+    return *this;
 }
 
 } // namespace http
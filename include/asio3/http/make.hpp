@@ -82,6 +82,45 @@ namespace boost::beast::http
 		return rep;
 	}
 
+	/**
+	 * @brief Respond to http request with plain text content, the fields and the body of the
+	 * response allocate from the allocator, such as the allocator of a per-connection arena.
+	 */
+	template<typename Allocator>
+	inline http::response<http::basic_string_body<char, std::char_traits<char>, Allocator>,
+		http::basic_fields<Allocator>> make_text_response(
+		std::allocator_arg_t, const Allocator& alloc,
+		asio::is_string auto&& content, http::status result = http::status::ok,
+		std::string_view mimetype = "text/plain", unsigned version = 11)
+	{
+		http::response<http::basic_string_body<char, std::char_traits<char>, Allocator>,
+			http::basic_fields<Allocator>> rep{
+			std::piecewise_construct, std::make_tuple(alloc), std::make_tuple(alloc) };
+
+		rep.set(http::field::server, BEAST_VERSION_STRING);
+		rep.set(http::field::content_type, mimetype.empty() ? "text/plain" : mimetype);
+
+		rep.result(result);
+		rep.version(version < 10 ? 11 : version);
+
+		std::string_view body = asio::to_string_view(content);
+
+		rep.body().assign(body.data(), body.size());
+
+		try
+		{
+			rep.prepare_payload();
+		}
+		catch (const std::exception&)
+		{
+			// The response body MUST be empty for this case
+			rep.body().clear();
+			rep.prepare_payload();
+		}
+
+		return rep;
+	}
+
 	/**
 	 * @brief Respond to http request with json content
 	 */
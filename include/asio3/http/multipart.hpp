@@ -21,6 +21,8 @@
 #include <stdarg.h>
 #include <string.h>
 
+#include <cstdint>
+#include <cstring>
 #include <list>
 #include <map>
 #include <string>
@@ -428,31 +430,15 @@ inline std::ostream& operator<<(std::ostream& os, const basic_multipart_fields<S
 
 namespace multipart_parser
 {
+	/*
+	 * Parse the header rows of a part into the field, the rows are separated by "\r\n" and
+	 * the last row has no "\r\n". The unknown header rows are ignored.
+	 */
 	template<class String>
-	inline bool parse_field(basic_multipart_field<String>& field, std::string_view content)
+	inline bool parse_header(basic_multipart_field<String>& field, std::string_view header)
 	{
-		// 8 == "\r\n" "\r\n\r\n" "\r\n"
-		if (content.size() < 8)
-			return false;
-
-		// first 2 bytes must be "\r\n"
-		if (content.substr(0, 2) != CRLF)
-			return false;
-
-		// last 2 bytes must be "\r\n"
-		if (content.substr(content.size() - 2) != CRLF)
-			return false;
-
-		// remove the first "\r\n" and the last "\r\n"
-		content = content.substr(2, content.size() - 4);
-
-		// find the split of header and value
-		auto split = content.find("\r\n\r\n");
-		if (split == std::string_view::npos)
-			return false;
-
-		std::string_view header = content.substr(0, split);
-		std::string_view value  = content.substr(split + 4);
+		if (header.empty())
+			return true;
 
 		std::string_view::size_type pos_row_1 = static_cast<std::string_view::size_type>( 0);
 		std::string_view::size_type pos_row_2 = static_cast<std::string_view::size_type>(-2);
@@ -521,25 +507,90 @@ namespace multipart_parser
 			}
 			else if (beast::iequals(type, "Content-Type"))
 			{
-				field.content_type(header_row.substr(pos1 + 1));
+				std::string_view v = header_row.substr(pos1);
+				asio::trim_both(v);
+				field.content_type(v);
 			}
 			else if (beast::iequals(type, "Content-Transfer-Encoding"))
 			{
-				field.content_transfer_encoding(header_row.substr(pos1 + 1));
-			}
-			else
-			{
-				assert(false);
+				std::string_view v = header_row.substr(pos1);
+				asio::trim_both(v);
+				field.content_transfer_encoding(v);
 			}
 
 			if (pos_row_2 == std::string_view::npos)
 				break;
 		}
 
+		return true;
+	}
+
+	template<class String>
+	inline bool parse_field(basic_multipart_field<String>& field, std::string_view content)
+	{
+		// 8 == "\r\n" "\r\n\r\n" "\r\n"
+		if (content.size() < 8)
+			return false;
+
+		// first 2 bytes must be "\r\n"
+		if (content.substr(0, 2) != CRLF)
+			return false;
+
+		// last 2 bytes must be "\r\n"
+		if (content.substr(content.size() - 2) != CRLF)
+			return false;
+
+		// remove the first "\r\n" and the last "\r\n"
+		content = content.substr(2, content.size() - 4);
+
+		// find the split of header and value
+		auto split = content.find("\r\n\r\n");
+		if (split == std::string_view::npos)
+			return false;
+
+		std::string_view header = content.substr(0, split);
+		std::string_view value  = content.substr(split + 4);
+
+		if (!parse_header(field, header))
+			return false;
+
 		field.value(value);
 
 		return true;
 	}
+
+	/*
+	 * Get the boundary from the value of the Content-Type, returns empty if it's not a
+	 * "multipart/form-data" or it has no boundary.
+	 */
+	inline std::string_view get_boundary(std::string_view type) noexcept
+	{
+		std::size_t pos1 = asio::ifind(type, "multipart/form-data");
+		if (pos1 == std::string_view::npos)
+			return {};
+		pos1 += 19; // std::strlen("multipart/form-data");
+
+		pos1 = asio::ifind(type, "boundary", pos1);
+		if (pos1 == std::string_view::npos)
+			return {};
+		pos1 += 8; // std::strlen("boundary");
+
+		pos1 = type.find('=', pos1);
+		if (pos1 == std::string_view::npos)
+			return {};
+		pos1 += 1;
+
+		std::size_t pos2 = type.find_first_of("\r;", pos1);
+
+		std::string_view boundary = type.substr(pos1, pos2 == std::string_view::npos ? pos2 : pos2 - pos1);
+
+		asio::trim_both(boundary);
+
+		if (boundary.size() >= 2 && boundary.front() == '\"' && boundary.back() == '\"')
+			boundary = boundary.substr(1, boundary.size() - 2);
+
+		return boundary;
+	}
 }
 
 template<class String = std::string>
@@ -608,29 +659,398 @@ basic_multipart_fields<String> multipart_parser_execute(std::string_view body, s
 template<bool isRequest, class Body, class Fields, class String = std::string>
 basic_multipart_fields<String> multipart_parser_execute(const http::message<isRequest, Body, Fields>& msg)
 {
-	std::string_view type = msg[http::field::content_type];
-
-	std::size_t pos1 = asio::ifind(type, "multipart/form-data");
-	if (pos1 == std::string_view::npos)
+	std::string_view boundary = multipart_parser::get_boundary(msg[http::field::content_type]);
+	if (boundary.empty())
 		return {};
-	pos1 += 19; // std::strlen("multipart/form-data");
 
-	pos1 = asio::ifind(type, "boundary", pos1);
-	if (pos1 == std::string_view::npos)
-		return {};
-	pos1 += 8; // std::strlen("boundary");
+	return multipart_parser_execute<String>(msg.body(), boundary);
+}
 
-	pos1 = type.find('=', pos1);
-	if (pos1 == std::string_view::npos)
-		return {};
-	pos1 += 1;
+/*
+ * The events of the multipart_stream_parser.
+ */
+enum class multipart_event : std::uint8_t
+{
+	/// all the input is consumed, more data is required.
+	need_more,
 
-	std::size_t pos2 = type.find_first_of("\r;", pos1);
+	/// the header of a new part is parsed, get it by part().
+	part_header,
 
-	std::string_view boundary = type.substr(pos1, pos2 == std::string_view::npos ? pos2 : pos2 - pos1);
+	/// a piece of the content of the current part, get it by data().
+	part_data,
 
-	return multipart_parser_execute<String>(msg.body(), boundary);
-}
+	/// the content of the current part is finished.
+	part_end,
+
+	/// the close delimiter is parsed, the remaining data is the epilogue and can be ignored.
+	done,
+};
+
+/*
+ * Incremental "multipart/form-data" parser, the body can be passed in by any size of pieces
+ * as they arrive, so the memory used is constant whatever the body size is.
+ * The part headers and the part content are views into the input or into the parser, nothing
+ * of the content is copied, and the views are only valid until the next call of next().
+ * The header bytes are copied only when the header of a part is split by two inputs.
+ * This class is not thread safety.
+ */
+class multipart_stream_parser
+{
+public:
+	/**
+	 * @brief Constructor
+	 * @param boundary - The boundary in the Content-Type of the message, without the leading "--".
+	 * @param header_limit - The max bytes of the header of each part.
+	 */
+	explicit multipart_stream_parser(std::string_view boundary, std::size_t header_limit = 8 * 1024)
+		: header_limit_(header_limit)
+	{
+		delimiter_.reserve(boundary.size() + 4);
+		delimiter_ += CRLF;
+		delimiter_ += "--";
+		delimiter_ += boundary;
+
+		// the first delimiter may be at the beginning of the body, it has no leading "\r\n",
+		// so treat the body as it's preceded by the "\r\n".
+		matched_ = 2;
+	}
+
+	/**
+	 * @brief Parse the input until an event occurs, the parsed bytes are removed from the input.
+	 * The input must be passed again with the remaining bytes until need_more is returned.
+	 */
+	multipart_event next(std::string_view& input, error_code& ec)
+	{
+		ec = {};
+
+		if (release_header_)
+		{
+			release_header_ = false;
+			header_.clear();
+		}
+
+		data_ = {};
+
+		for (;;)
+		{
+			switch (state_)
+			{
+			case state::preamble:
+			case state::body:
+			{
+				// the bytes at the end of the last input may be the beginning of a delimiter.
+				if (matched_ > 0)
+				{
+					std::size_t n = (std::min)(delimiter_.size() - matched_, input.size());
+
+					if (std::memcmp(input.data(), delimiter_.data() + matched_, n) == 0)
+					{
+						matched_ += n;
+						input.remove_prefix(n);
+
+						if (matched_ < delimiter_.size())
+							return multipart_event::need_more;
+
+						matched_ = 0;
+
+						bool in_part = (state_ == state::body);
+
+						state_ = state::boundary_tail;
+
+						if (in_part)
+							return multipart_event::part_end;
+
+						break;
+					}
+
+					// they are not a delimiter, so they are content. there is no "\r" in the
+					// delimiter except the first byte, so no delimiter starts in the middle.
+					std::string_view held = std::string_view(delimiter_).substr(0, matched_);
+
+					matched_ = 0;
+
+					if (state_ == state::body)
+					{
+						data_ = held;
+						return multipart_event::part_data;
+					}
+
+					break;
+				}
+
+				if (input.empty())
+					return multipart_event::need_more;
+
+				std::size_t pos = find_delimiter(input);
+
+				if (pos != std::string_view::npos)
+				{
+					// emit the content before the delimiter first, the delimiter is parsed by
+					// the next call.
+					if (pos > 0)
+					{
+						std::string_view content = input.substr(0, pos);
+						input.remove_prefix(pos);
+						if (state_ == state::body)
+						{
+							data_ = content;
+							return multipart_event::part_data;
+						}
+					}
+
+					// the delimiter is consumed by the matching above.
+					matched_ = 1;
+					input.remove_prefix(1);
+					break;
+				}
+
+				// hold the tail which may be the beginning of a delimiter.
+				std::size_t tail = partial_delimiter(input);
+
+				std::string_view content = input.substr(0, input.size() - tail);
+
+				matched_ = tail;
+				input = {};
+
+				if (state_ == state::body && !content.empty())
+				{
+					data_ = content;
+					return multipart_event::part_data;
+				}
+
+				return multipart_event::need_more;
+			}
+
+			case state::boundary_tail:
+			{
+				if (input.empty())
+					return multipart_event::need_more;
+
+				char c = input.front();
+				input.remove_prefix(1);
+
+				if /**/ (c == '-')
+					state_ = state::close_dash;
+				else if (c == CR)
+					state_ = state::boundary_lf;
+				else if (c != ' ' && c != '\t') // transport padding
+					return fail(ec, http::error::bad_line_ending);
+
+				break;
+			}
+
+			case state::close_dash:
+			{
+				if (input.empty())
+					return multipart_event::need_more;
+
+				if (input.front() != '-')
+					return fail(ec, http::error::bad_line_ending);
+
+				state_ = state::done;
+				input = {};
+
+				return multipart_event::done;
+			}
+
+			case state::boundary_lf:
+			{
+				if (input.empty())
+					return multipart_event::need_more;
+
+				if (input.front() != LF)
+					return fail(ec, http::error::bad_line_ending);
+
+				input.remove_prefix(1);
+				state_ = state::header;
+				break;
+			}
+
+			case state::header:
+			{
+				if (input.empty())
+					return multipart_event::need_more;
+
+				std::string_view block;
+
+				if (header_.empty())
+				{
+					// the part has no header.
+					if (input.starts_with(CRLF))
+					{
+						input.remove_prefix(2);
+						return on_header(ec, block);
+					}
+
+					if (std::size_t pos = input.find("\r\n\r\n"); pos != std::string_view::npos)
+					{
+						if (pos > header_limit_)
+							return fail(ec, http::error::header_limit);
+
+						block = input.substr(0, pos);
+						input.remove_prefix(pos + 4);
+						return on_header(ec, block);
+					}
+				}
+
+				// the header is split by two inputs, collect it.
+				std::size_t old_size = header_.size();
+				std::size_t n = (std::min)(input.size(), header_limit_ + 4 - (std::min)(old_size, header_limit_ + 4));
+
+				header_.append(input.data(), n);
+
+				std::string_view collected = header_;
+
+				if (collected.starts_with(CRLF))
+				{
+					input.remove_prefix(2 - old_size);
+					release_header_ = true;
+					return on_header(ec, block);
+				}
+
+				std::size_t pos = collected.find("\r\n\r\n", old_size < 3 ? 0 : old_size - 3);
+
+				if (pos == std::string_view::npos)
+				{
+					if (header_.size() >= header_limit_ + 4)
+						return fail(ec, http::error::header_limit);
+
+					input.remove_prefix(n);
+					return multipart_event::need_more;
+				}
+
+				if (pos > header_limit_)
+					return fail(ec, http::error::header_limit);
+
+				input.remove_prefix(pos + 4 - old_size);
+				release_header_ = true;
+				return on_header(ec, collected.substr(0, pos));
+			}
+
+			case state::done:
+			{
+				// ignore the epilogue.
+				input = {};
+				return multipart_event::done;
+			}
+
+			case state::failed:
+			default:
+				return fail(ec, http::error::bad_value);
+			}
+		}
+	}
+
+	/**
+	 * @brief Get the header of the current part, it's valid after the part_header event.
+	 */
+	inline const basic_multipart_field<std::string_view>& part() const noexcept
+	{
+		return part_;
+	}
+
+	/**
+	 * @brief Get the content piece of the current part, it's valid after the part_data event.
+	 */
+	inline std::string_view data() const noexcept
+	{
+		return data_;
+	}
+
+	/**
+	 * @brief Returns true if the close delimiter is parsed.
+	 */
+	inline bool is_done() const noexcept
+	{
+		return state_ == state::done;
+	}
+
+protected:
+	enum class state : std::uint8_t
+	{
+		preamble, boundary_tail, close_dash, boundary_lf, header, body, done, failed
+	};
+
+	inline multipart_event fail(error_code& ec, http::error e) noexcept
+	{
+		state_ = state::failed;
+		ec = e;
+		return multipart_event::need_more;
+	}
+
+	inline multipart_event on_header(error_code& ec, std::string_view block)
+	{
+		part_ = {};
+
+		if (!multipart_parser::parse_header(part_, block))
+			return fail(ec, http::error::bad_field);
+
+		state_ = state::body;
+
+		return multipart_event::part_header;
+	}
+
+	/**
+	 * @brief Find the delimiter, the first byte is found by memchr which is vectorized by
+	 * the c runtime libraries, and the "\r" is rare in the most content.
+	 */
+	inline std::size_t find_delimiter(std::string_view s) const noexcept
+	{
+		const char* p   = s.data();
+		const char* end = s.data() + s.size();
+
+		while (static_cast<std::size_t>(end - p) >= delimiter_.size())
+		{
+			p = static_cast<const char*>(std::memchr(p, CR, static_cast<std::size_t>(end - p) - delimiter_.size() + 1));
+			if (!p)
+				break;
+
+			if (std::memcmp(p + 1, delimiter_.data() + 1, delimiter_.size() - 1) == 0)
+				return static_cast<std::size_t>(p - s.data());
+
+			++p;
+		}
+
+		return std::string_view::npos;
+	}
+
+	/**
+	 * @brief Get the length of the tail of s which is the beginning of the delimiter.
+	 */
+	inline std::size_t partial_delimiter(std::string_view s) const noexcept
+	{
+		std::size_t n = (std::min)(s.size(), delimiter_.size() - 1);
+
+		for (std::size_t i = s.size() - n; i < s.size(); ++i)
+		{
+			if (s[i] == CR)
+			{
+				if (std::memcmp(s.data() + i, delimiter_.data(), s.size() - i) == 0)
+					return s.size() - i;
+			}
+		}
+
+		return 0;
+	}
+
+protected:
+	std::string                              delimiter_;
+
+	std::string                              header_;
+
+	basic_multipart_field<std::string_view>  part_;
+
+	std::string_view                         data_;
+
+	std::size_t                              header_limit_ = 8 * 1024;
+
+	std::size_t                              matched_ = 0;
+
+	state                                    state_ = state::preamble;
+
+	bool                                     release_header_ = false;
+};
 
 #undef CRLF
 #undef LF
@@ -17,6 +17,7 @@
 #include <asio3/core/asio_buffer_specialization.hpp>
 #include <asio3/core/data_persist.hpp>
 #include <asio3/core/file.hpp>
+#include <asio3/http/multipart.hpp>
 
 #ifdef ASIO3_HEADER_ONLY
 namespace bho::beast::http::detail
@@ -24,28 +25,43 @@ namespace bho::beast::http::detail
 namespace boost::beast::http::detail
 #endif
 {
-	template<bool isRequest, typename Body, typename Fields>
-	struct async_recv_file_op
+	/**
+	 * @brief Put the header which was already readed from the stream into the parser, then the
+	 * parser can read the body. The serializer is split after the header, otherwise the chunk
+	 * size of a chunked message is serialized too, and the header is copied before the consume,
+	 * because the consume may free the serialized buffers.
+	 */
+	template<bool isRequest, typename Body, typename Fields, typename Parser>
+	inline void put_header(Parser& parser, http::message<isRequest, Body, Fields>& header, error_code& ec)
 	{
-		http::message<isRequest, Body, Fields>& header;
+		std::string data;
+		std::size_t bytes = 0;
 
-		struct visit
-		{
-			std::vector<asio::const_buffer>& buffers_;
-			std::size_t& buffers_bytes;
+		http::serializer<isRequest, Body, Fields> sr{ header };
 
-			template<class ConstBufferSequence>
-			void operator()(error_code&, ConstBufferSequence const& buffers)
+		sr.split(true);
+
+		while (!ec && !sr.is_header_done())
+		{
+			sr.next(ec, [&data, &bytes](error_code&, const auto& buffers) mutable
 			{
-				buffers_bytes = 0;
+				data += beast::buffers_to_string(buffers);
+				bytes = beast::buffer_bytes(buffers);
+			});
 
-				for (auto buffer : buffers)
-				{
-					buffers_bytes += buffer.size();
-					buffers_.emplace_back(buffer);
-				}
-			}
-		};
+			sr.consume(bytes);
+		}
+
+		if (ec)
+			return;
+
+		parser.put(asio::buffer(data), ec);
+	}
+
+	template<bool isRequest, typename Body, typename Fields>
+	struct async_recv_file_op
+	{
+		http::message<isRequest, Body, Fields>& header;
 
 		// /boost_1_80_0/libs/beast/example/doc/http_examples.hpp
 
@@ -70,16 +86,7 @@ namespace boost::beast::http::detail
 
 			parser.body_limit((std::numeric_limits<std::size_t>::max)());
 
-			std::vector<asio::const_buffer> buffers;
-			std::size_t buffers_bytes = 0;
-			http::serializer<isRequest, Body, Fields> sr{ header };
-			while (!sr.is_header_done())
-			{
-				sr.next(ec, visit{ buffers, buffers_bytes });
-				sr.consume(buffers_bytes);
-			}
-
-			parser.put(buffers, ec);
+			detail::put_header(parser, header, ec);
 			if (ec)
 			{
 				co_return{ ec, recvd_bytes };
@@ -225,6 +232,139 @@ namespace boost::beast::http::detail
 			co_return{ error_code{}, recvd_bytes };
 		}
 	};
+
+	/// the max bytes of the contents which are kept in memory by async_recv_multipart.
+	constexpr std::size_t multipart_value_limit = 1024 * 1024;
+
+	/// the buffer size of each read of async_recv_multipart.
+	constexpr std::size_t multipart_read_size = 64 * 1024;
+
+	template<bool isRequest, typename Body, typename Fields>
+	struct async_recv_multipart_op
+	{
+		http::message<isRequest, Body, Fields>& header;
+
+		auto operator()(auto state, auto sock_ref, auto buffer_ref, auto&& part_callback_) -> void
+		{
+			auto& sock = sock_ref.get();
+			auto& buffer = buffer_ref.get();
+
+			auto part_callback = std::forward_like<decltype(part_callback_)>(part_callback_);
+
+			using file_pointer = std::invoke_result_t<
+				decltype(part_callback)&, const http::basic_multipart_field<std::string_view>&>;
+
+			co_await asio::dispatch(asio::use_deferred_executor(sock));
+
+			state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+			asio::error_code ec{};
+			http::multipart_fields fields{};
+
+			std::string_view boundary = http::multipart_parser::get_boundary(header[http::field::content_type]);
+			if (boundary.empty())
+				co_return{ http::error::bad_value, std::move(fields) };
+
+			fields.boundary(boundary);
+
+			http::multipart_stream_parser mp(boundary);
+
+			http::parser<isRequest, http::buffer_body> parser;
+
+			parser.body_limit((std::numeric_limits<std::size_t>::max)());
+
+			detail::put_header(parser, header, ec);
+			if (ec)
+				co_return{ ec, std::move(fields) };
+
+			std::unique_ptr<char[]> buf = std::make_unique_for_overwrite<char[]>(multipart_read_size);
+
+			http::multipart_field field{};
+			std::string value;
+			std::size_t value_bytes = 0;
+			file_pointer file{};
+
+			while (!parser.is_done())
+			{
+				if (!!state.cancelled())
+					co_return{ asio::error::operation_aborted, std::move(fields) };
+
+				parser.get().body().data = buf.get();
+				parser.get().body().size = multipart_read_size;
+
+				auto [e1, n1] = co_await http::async_read(
+					sock, buffer, parser, asio::use_deferred_executor(sock));
+				if (e1 == http::error::need_buffer)
+				{
+					e1 = {};
+				}
+				else if (e1)
+				{
+					co_return{ e1, std::move(fields) };
+				}
+
+				std::string_view input{ buf.get(), multipart_read_size - parser.get().body().size };
+
+				while (!mp.is_done())
+				{
+					http::multipart_event ev = mp.next(input, ec);
+					if (ec)
+						co_return{ ec, std::move(fields) };
+
+					if (ev == http::multipart_event::need_more)
+						break;
+
+					if /**/ (ev == http::multipart_event::part_header)
+					{
+						const http::basic_multipart_field<std::string_view>& part = mp.part();
+
+						field = {};
+						field.content_disposition(part.content_disposition());
+						field.name(part.name());
+						field.filename(part.filename());
+						field.content_type(part.content_type());
+						field.content_transfer_encoding(part.content_transfer_encoding());
+
+						file = part_callback(part);
+					}
+					else if (ev == http::multipart_event::part_data)
+					{
+						std::string_view data = mp.data();
+
+						if (file)
+						{
+							auto [e2, n2] = co_await asio::async_write(
+								*file, asio::buffer(data), asio::use_deferred_executor(*file));
+							if (e2)
+								co_return{ e2, std::move(fields) };
+						}
+						else
+						{
+							value_bytes += data.size();
+
+							if (value_bytes > multipart_value_limit)
+								co_return{ http::error::body_limit, std::move(fields) };
+
+							value += data;
+						}
+					}
+					else if (ev == http::multipart_event::part_end)
+					{
+						field.value(std::move(value));
+						fields.insert(std::move(field));
+
+						value = {};
+						file = {};
+					}
+				}
+			}
+
+			if (!mp.is_done())
+				co_return{ http::error::partial_message, std::move(fields) };
+
+			co_return{ error_code{}, std::move(fields) };
+		}
+	};
 }
 
 #ifdef ASIO3_HEADER_ONLY
@@ -314,4 +454,50 @@ inline auto async_recv_file(
 		[](auto) { return true; });
 }
 
+/**
+ * @brief Start an asynchronous operation to read the "multipart/form-data" body of the stream,
+ * the body is parsed as it arrives, so the memory used is constant whatever the body size is.
+ * @param stream - The socket stream to which the data is to be read.
+ * @param buffer - The buffer which was used to read the header from the stream.
+ * @param header - The http message header which was already readed from the stream.
+ * @param part_callback - The function which is called at the beginning of each part. The
+ *    content of the part is written to the returned file stream, or kept in the value of
+ *    the field if the returned pointer is null. The function will be called with this signature:
+    @code
+        // the views of the header are only valid in this function.
+        asio::stream_file* on_part(const http::basic_multipart_field<std::string_view>& part){};
+    @endcode
+ * @param token - The completion handler to invoke when the operation completes.
+ *	  The equivalent function signature of the handler must be:
+ *    @code
+ *    void handler(const asio::error_code& ec, http::multipart_fields fields);
+ *    // the fields contain all the parts, the value of the parts which are written to the
+ *    // file streams is empty.
+ */
+template<
+	bool isRequest,
+	typename SockStream,
+	typename DynamicBuffer,
+	typename Body, typename Fields,
+	typename PartCallback,
+	typename RecvToken = asio::default_token_type<SockStream>>
+requires (
+	std::invocable<PartCallback&, const http::basic_multipart_field<std::string_view>&>
+)
+inline auto async_recv_multipart(
+	SockStream& stream,
+	DynamicBuffer& buffer,
+	http::message<isRequest, Body, Fields>& header,
+	PartCallback&& part_callback,
+	RecvToken&& token = asio::default_token_type<SockStream>())
+{
+	return asio::async_initiate<RecvToken, void(asio::error_code, http::multipart_fields)>(
+		asio::experimental::co_composed<void(asio::error_code, http::multipart_fields)>(
+			detail::async_recv_multipart_op<isRequest, Body, Fields>{ header }, stream),
+		token,
+		std::ref(stream),
+		std::ref(buffer),
+		std::forward<PartCallback>(part_callback));
+}
+
 }
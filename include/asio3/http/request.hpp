@@ -29,6 +29,7 @@
 #include <asio3/http/url.hpp>
 #include <asio3/http/read.hpp>
 #include <asio3/http/write.hpp>
+#include <asio3/http/client_pool.hpp>
 
 #include <asio3/proxy/handshake.hpp>
 
@@ -43,17 +44,23 @@ namespace boost::beast::http
 	{
 	#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
 		std::optional<std::reference_wrapper<asio::ssl::context>> sslctx;
+		/// the ssl context which is shared with the pooled connections, it must be used instead
+		/// of the sslctx when the pool is set, because the connections may outlive the request.
+		std::shared_ptr<asio::ssl::context> shared_sslctx;
 	#endif
 		std::string url;
 		std::string data;
 		std::map<std::string, std::string> headers;
 		http::verb method = http::verb::get;
 		std::chrono::steady_clock::duration timeout = asio::http_request_timeout;
+		/// the delay between the connection attempts to the resolved addresses, see RFC 8305.
+		std::chrono::steady_clock::duration connect_attempt_delay = asio::tcp_connection_attempt_delay;
 		std::optional<socks5::option> socks5_option;
 		std::optional<std::reference_wrapper<asio::ip::tcp::socket>> socket;
 	#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
 		std::optional<std::reference_wrapper<asio::ssl::stream<asio::ip::tcp::socket&>>> stream;
 	#endif
+		std::optional<std::reference_wrapper<http::client_pool>> pool;
 	};
 
 	template<typename = void>
@@ -146,8 +153,9 @@ namespace boost::beast::http
 			if (e1)
 				co_return std::tuple{ e1, std::move(resp) };
 
-			auto [e2, ep] = co_await asio::async_connect(
-				sock, eps, asio::default_tcp_connect_condition{}, asio::use_deferred_executor(sock));
+			auto [e2, ep] = co_await asio::async_race_connect(
+				sock, eps, opt.timeout, opt.connect_attempt_delay,
+				asio::default_tcp_socket_option_setter{}, asio::use_deferred_executor(sock));
 			if (e2)
 			{
 				sock.close(ec);
@@ -225,7 +233,16 @@ namespace boost::beast::http
 				nullptr,
 				[](asio::ssl::context*) {}
 			};
-			if (opt.sslctx.has_value())
+			if (opt.shared_sslctx)
+			{
+				std::unique_ptr<asio::ssl::context, void(*)(asio::ssl::context*)> psslctx2
+				{
+					opt.shared_sslctx.get(),
+					[](asio::ssl::context*) {}
+				};
+				psslctx = std::move(psslctx2);
+			}
+			else if (opt.sslctx.has_value())
 			{
 				std::unique_ptr<asio::ssl::context, void(*)(asio::ssl::context*)> psslctx2
 				{
@@ -242,6 +259,7 @@ namespace boost::beast::http
 					[](asio::ssl::context* p) { delete p; }
 				};
 				asio::load_root_certificates(*psslctx2);
+				asio::ssl_session_cache::attach(*psslctx2, asio::default_ssl_session_cache());
 				//psslctx2->set_verify_mode(asio::ssl::verify_peer);
 				psslctx = std::move(psslctx2);
 			}
@@ -282,7 +300,7 @@ namespace boost::beast::http
 				SSL_set_tlsext_host_name(stream.native_handle(), hostname.data());
 			}
 
-			auto [e3] = co_await stream.async_handshake(
+			auto [e3] = co_await asio::async_handshake(stream,
 				asio::ssl::stream_base::handshake_type::client, asio::use_deferred_executor(sock));
 			if (e3)
 			{
@@ -337,16 +355,73 @@ namespace boost::beast::http
     }
 }
 
+
 #ifdef ASIO3_HEADER_ONLY
 namespace bho::beast::http::detail
 #else
 namespace boost::beast::http::detail
 #endif
 {
+	inline http::request<http::string_body> make_request_message(const request_option& opt, const http::url& url)
+	{
+		http::request<http::string_body> req{};
+		req.method(opt.method);
+		req.version(11);
+		req.target(url.get_target());
+		for (auto& [field_name, field_value] : opt.headers)
+		{
+			req.set(field_name, field_value);
+		}
+
+		req.body() = opt.data;
+		try
+		{
+			req.prepare_payload();
+		}
+		catch (const std::exception&)
+		{
+			assert(false);
+		}
+
+		// Some sites must set the http::field::host
+		if (req.find(http::field::host) == req.end())
+		{
+			std::string strhost{ url.get_host() };
+			std::string strport{ url.get_port() };
+			if (strport != "80" && strport != "443")
+			{
+				strhost += ":";
+				strhost += strport;
+			}
+			req.set(http::field::host, strhost);
+		}
+		// Some sites must set the http::field::user_agent
+		if (req.find(http::field::user_agent) == req.end())
+		{
+			req.set(http::field::user_agent,
+				"Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/105.0.0.0 Safari/537.36");
+		}
+
+		// the pooled connection is kept alive for the next request.
+		if (opt.pool.has_value() && req.find(http::field::connection) == req.end())
+			req.keep_alive(true);
+
+		return req;
+	}
+
 	struct async_request_op
 	{
 		request_option opt;
 
+		/**
+		 * @brief Check whether the request should be sent again on a new connection, the server
+		 * may close a reused keep-alive connection at any time.
+		 */
+		inline bool can_retry(bool reused, std::size_t attempt, const asio::error_code& ec) const noexcept
+		{
+			return reused && attempt == 0 && http::is_idempotent(opt.method) && is_stale_connection_error(ec);
+		}
+
 		auto operator()(auto state, auto ex) -> void
 		{
 			co_await asio::dispatch(asio::use_deferred_executor(ex));
@@ -361,201 +436,334 @@ namespace boost::beast::http::detail
 			if (ec)
 				co_return{ ec, std::move(resp) };
 
-			asio::ip::tcp::socket sock{ ex };
+			http::request<http::string_body> req = make_request_message(opt, url);
+
+			bool is_ssl = asio::iequals(url.get_schema(), "https");
 
-			std::defer close_sock = [&sock]() mutable
+		#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+			std::shared_ptr<asio::ssl::context> sslctx = get_ssl_context(opt, ec);
+			if (ec)
+				co_return{ ec, std::move(resp) };
+
+			std::string key = client_pool::make_key(url, opt.socks5_option, is_ssl ? sslctx.get() : nullptr);
+		#else
+			std::string key = client_pool::make_key(url, opt.socks5_option);
+		#endif
+
+			client_connection_ptr conn;
+
+			bool reusable = false;
+
+			std::defer release_conn = [this, &conn, &reusable]() mutable
 			{
-				asio::error_code ec{};
-				sock.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
-				sock.close(ec);
-				asio::reset_lock(sock);
+				if (conn && opt.pool.has_value())
+					opt.pool.value().get().release(std::move(conn), reusable);
 			};
 
-			asio::detail::call_func_when_timeout wt(ex, opt.timeout, [&sock]() mutable
-			{
-				asio::error_code ec{};
-				sock.close(ec);
-				asio::reset_lock(sock);
-			});
+			// the timeout covers the waiting for a pool slot and all the attempts.
+			auto deadline = make_deadline(opt.timeout);
 
-			asio::ip::tcp::resolver resolver(ex);
+			// if the server closed a reused keep-alive connection, send the idempotent request
+			// again on a new connection, but only once.
+			for (std::size_t attempt = 0; ; ++attempt)
+			{
+				if (opt.pool.has_value())
+				{
+					if (conn)
+						opt.pool.value().get().release(std::move(conn), false);
 
-			std::string addr{ url.get_host() };
-			std::string port{ url.get_port() };
+					auto [e0, c0] = co_await opt.pool.value().get().async_acquire(
+						key, remaining_time(deadline), asio::use_deferred_executor(ex));
+					if (e0)
+						co_return{ e0, std::move(resp) };
 
-			if (opt.socks5_option.has_value())
-			{
-				socks5::option& s5opt = opt.socks5_option.value();
-				addr = s5opt.proxy_address;
-				port = std::to_string(s5opt.proxy_port);
-			}
+					conn = std::move(c0);
+				}
+				else
+				{
+					conn = std::make_shared<client_connection>(ex);
+				}
 
-			// A successful resolve operation is guaranteed to pass a non-empty range to the handler.
-			auto [e1, eps] = co_await asio::async_resolve(
-				resolver, std::move(addr), std::move(port),
-				asio::ip::resolver_base::flags(), asio::use_deferred_executor(resolver));
-			if (e1)
-				co_return{ e1, std::move(resp) };
+				auto timeout = remaining_time(deadline);
+				if (timeout == std::chrono::steady_clock::duration::zero())
+					co_return{ asio::error::timed_out, std::move(resp) };
 
-			if (!!state.cancelled())
-				co_return{ asio::error::operation_aborted, std::move(resp) };
+				asio::detail::call_func_when_timeout wt(ex, timeout, make_timeout_closer(conn));
 
-			auto [e2, ep] = co_await asio::async_connect(
-				sock, eps, asio::default_tcp_connect_condition{}, asio::use_deferred_executor(sock));
-			if (e2)
-				co_return{ e2, std::move(resp) };
+				bool reused = conn->is_open();
 
-			if (!!state.cancelled())
-				co_return{ asio::error::operation_aborted, std::move(resp) };
+				if (!reused)
+				{
+				#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+					conn->sslctx = sslctx;
+				#endif
+
+					auto [e2] = co_await http::async_connect(*conn,
+						std::string(url.get_host()), std::string(url.get_port()), is_ssl, opt.socks5_option,
+						timeout, opt.connect_attempt_delay, asio::use_deferred_executor(conn->sock));
+					if (e2)
+						co_return{ e2, std::move(resp) };
+				}
 
-			if (opt.socks5_option.has_value())
-			{
-				socks5::option& s5opt = opt.socks5_option.value();
+				if (!!state.cancelled())
+					co_return{ asio::error::operation_aborted, std::move(resp) };
 
-				if (s5opt.method.empty())
-					s5opt.method.emplace_back(socks5::auth_method::anonymous);
-				if (s5opt.dest_address.empty())
-					s5opt.dest_address = url.get_host();
-				if (s5opt.dest_port == 0)
-					s5opt.dest_port = static_cast<std::uint16_t>(std::stoul(std::string(url.get_port())));
-				if (std::to_underlying(s5opt.cmd) == 0)
-					s5opt.cmd = socks5::command::connect;
+				if (is_ssl)
+				{
+				#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+					auto [e4, n4] = co_await http::async_write(
+						*conn->stream, req, asio::use_deferred_executor(conn->sock));
+					ec = e4;
 
-				auto [e3] = co_await socks5::async_handshake(sock, s5opt, asio::use_deferred_executor(sock));
-				if (e3)
-					co_return{ e3, std::move(resp) };
-			}
+					if (!ec && !!state.cancelled())
+						ec = asio::error::operation_aborted;
 
-			if (!!state.cancelled())
-				co_return{ asio::error::operation_aborted, std::move(resp) };
+					if (!ec)
+					{
+						auto [e6, n6] = co_await http::async_read(
+							*conn->stream, conn->buffer, resp, asio::use_deferred_executor(conn->sock));
+						ec = e6;
+					}
+
+					if (!opt.pool.has_value() && !can_retry(reused, attempt, ec))
+						co_await conn->stream->async_shutdown(asio::use_deferred_executor(conn->sock));
+				#else
+					co_return{ asio::error::operation_not_supported, std::move(resp) };
+				#endif
+				}
+				else
+				{
+					auto [e4, n4] = co_await http::async_write(
+						conn->sock, req, asio::use_deferred_executor(conn->sock));
+					ec = e4;
 
-			http::request<http::string_body> req{};
-			req.method(opt.method);
-			req.version(11);
-			req.target(url.get_target());
-			for (auto& [field_name, field_value] : opt.headers)
-			{
-				req.set(field_name, field_value);
-			}
+					if (!ec && !!state.cancelled())
+						ec = asio::error::operation_aborted;
 
-			req.body() = opt.data;
-			try
-			{
-				req.prepare_payload();
-			}
-			catch (const std::exception&)
-			{
-				assert(false);
-			}
+					if (!ec)
+					{
+						auto [e6, n6] = co_await http::async_read(
+							conn->sock, conn->buffer, resp, asio::use_deferred_executor(conn->sock));
+						ec = e6;
+					}
+				}
 
-			// Some sites must set the http::field::host
-			if (req.find(http::field::host) == req.end())
-			{
-				std::string strhost{ url.get_host() };
-				std::string strport{ url.get_port() };
-				if (strport != "80" && strport != "443")
+				if (can_retry(reused, attempt, ec))
 				{
-					strhost += ":";
-					strhost += strport;
+					resp = http::response<http::string_body>{ http::status::unknown, 11 };
+					continue;
 				}
-				req.set(http::field::host, strhost);
-			}
-			// Some sites must set the http::field::user_agent
-			if (req.find(http::field::user_agent) == req.end())
-			{
-				req.set(http::field::user_agent,
-					"Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/105.0.0.0 Safari/537.36");
+
+				break;
 			}
 
-			if (asio::iequals(url.get_schema(), "https"))
+			reusable = !ec && resp.keep_alive();
+
+			co_return{ ec, std::move(resp) };
+        }
+	};
+
+	struct async_pipeline_op
+	{
+		std::vector<request_option> opts;
+
+		auto operator()(auto state, auto pool_ref) -> void
+		{
+			http::client_pool& pool = pool_ref.get();
+
+			const auto& ex = pool.get_executor();
+
+			co_await asio::dispatch(asio::use_deferred_executor(ex));
+
+			state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+			asio::error_code ec{};
+			std::vector<http::response<http::string_body>> resps;
+
+			if (opts.empty())
+				co_return{ asio::error::invalid_argument, std::move(resps) };
+
+			std::vector<http::request<http::string_body>> reqs;
+			reqs.reserve(opts.size());
+
+			http::url url;
+			std::string key;
+			std::chrono::steady_clock::duration timeout{};
+
+			// the requests are sent again only if all of them are idempotent.
+			bool idempotent = true;
+
+		#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+			std::shared_ptr<asio::ssl::context> sslctx;
+		#endif
+
+			for (request_option& opt : opts)
 			{
+				opt.pool = pool;
+
+				http::url u;
+				ec = u.reset(http::url_encode(opt.url));
+				if (ec)
+					co_return{ ec, std::move(resps) };
+
 			#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
-				// https://en.cppreference.com/w/cpp/memory/unique_ptr
-				std::unique_ptr<asio::ssl::context, void(*)(asio::ssl::context*)> psslctx
-				{
-					nullptr,
-					[](asio::ssl::context*) {}
-				};
-				if (opt.sslctx.has_value())
+				std::shared_ptr<asio::ssl::context> ctx = get_ssl_context(opt, ec);
+				if (ec)
+					co_return{ ec, std::move(resps) };
+
+				bool is_https = asio::iequals(u.get_schema(), "https");
+
+				std::string k = client_pool::make_key(u, opt.socks5_option, is_https ? ctx.get() : nullptr);
+
+				if (key.empty())
+					sslctx = std::move(ctx);
+			#else
+				std::string k = client_pool::make_key(u, opt.socks5_option);
+			#endif
+
+				idempotent = idempotent && http::is_idempotent(opt.method);
+
+				if (key.empty())
 				{
-					std::unique_ptr<asio::ssl::context, void(*)(asio::ssl::context*)> psslctx2
-					{
-						std::addressof(opt.sslctx.value().get()),
-						[](asio::ssl::context*) {}
-					};
-					psslctx = std::move(psslctx2);
+					key = std::move(k);
+					url = u;
 				}
-				else
+				// all the requests must be sent on the same connection.
+				else if (k != key)
 				{
-					std::unique_ptr<asio::ssl::context, void(*)(asio::ssl::context*)> psslctx2
-					{
-						new asio::ssl::context(asio::ssl::context::tlsv12_client),
-						[](asio::ssl::context* p) { delete p; }
-					};
-					asio::load_root_certificates(*psslctx2);
-					//psslctx2->set_verify_mode(asio::ssl::verify_peer);
-					psslctx = std::move(psslctx2);
+					co_return{ asio::error::invalid_argument, std::move(resps) };
 				}
 
-				std::unique_ptr<asio::ssl::stream<asio::ip::tcp::socket&>> stream =
-					std::make_unique<asio::ssl::stream<asio::ip::tcp::socket&>>(sock, *psslctx);
+				timeout = (std::max)(timeout, opt.timeout);
+
+				reqs.emplace_back(make_request_message(opt, u));
+			}
+
+			request_option& opt = opts.front();
+
+			bool is_ssl = asio::iequals(url.get_schema(), "https");
+
+			client_connection_ptr conn;
+
+			bool reusable = false;
+
+			std::defer release_conn = [&pool, &conn, &reusable]() mutable
+			{
+				if (conn)
+					pool.release(std::move(conn), reusable);
+			};
+
+			// the timeout covers the waiting for a pool slot and all the attempts.
+			auto deadline = make_deadline(timeout);
+
+			// if the server closed a reused keep-alive connection before any response
+			// was received, send the idempotent requests again on a new connection, but only once.
+			for (std::size_t attempt = 0; ; ++attempt)
+			{
+				if (conn)
+					pool.release(std::move(conn), false);
+
+				auto [e0, c0] = co_await pool.async_acquire(
+					key, remaining_time(deadline), asio::use_deferred_executor(ex));
+				if (e0)
+					co_return{ e0, std::move(resps) };
+
+				conn = std::move(c0);
+
+				timeout = remaining_time(deadline);
+				if (timeout == std::chrono::steady_clock::duration::zero())
+					co_return{ asio::error::timed_out, std::move(resps) };
+
+				asio::detail::call_func_when_timeout wt(ex, timeout, make_timeout_closer(conn));
 
-				// Set SNI Hostname (many hosts need this to handshake successfully)
-				// https://github.com/djarek/certify
-				if (auto it = req.find(http::field::host); it != req.end())
+				bool reused = conn->is_open();
+
+				if (!reused)
 				{
-					std::string hostname(it->value());
-					SSL_set_tlsext_host_name(stream->native_handle(), hostname.data());
+				#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+					conn->sslctx = sslctx;
+				#endif
+
+					auto [e2] = co_await http::async_connect(*conn,
+						std::string(url.get_host()), std::string(url.get_port()), is_ssl, opt.socks5_option,
+						timeout, opt.connect_attempt_delay, asio::use_deferred_executor(conn->sock));
+					if (e2)
+						co_return{ e2, std::move(resps) };
 				}
 
-				auto [e3] = co_await stream->async_handshake(
-					asio::ssl::stream_base::handshake_type::client, asio::use_deferred_executor(sock));
-				if (e3)
-					co_return{ e3, std::move(resp) };
-
-				auto [e4, n4] = co_await http::async_write(*stream, req, asio::use_deferred_executor(sock));
-				if (e4)
+				// write all the requests first, then read the responses in order.
+				for (http::request<http::string_body>& req : reqs)
 				{
-					co_await stream->async_shutdown(asio::use_deferred_executor(sock));
-					co_return{ e4, std::move(resp) };
+					if (!!state.cancelled())
+						ec = asio::error::operation_aborted;
+
+					if (ec)
+						break;
+
+					if (is_ssl)
+					{
+					#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+						auto [e4, n4] = co_await http::async_write(
+							*conn->stream, req, asio::use_deferred_executor(conn->sock));
+						ec = e4;
+					#else
+						ec = asio::error::operation_not_supported;
+					#endif
+					}
+					else
+					{
+						auto [e4, n4] = co_await http::async_write(
+							conn->sock, req, asio::use_deferred_executor(conn->sock));
+						ec = e4;
+					}
 				}
 
-				if (!!state.cancelled())
+				while (!ec && resps.size() < reqs.size())
 				{
-					co_await stream->async_shutdown(asio::use_deferred_executor(sock));
-					co_return{ asio::error::operation_aborted, std::move(resp) };
+					if (!!state.cancelled())
+					{
+						ec = asio::error::operation_aborted;
+						break;
+					}
+
+					http::response<http::string_body>& resp = resps.emplace_back(http::status::unknown, 11);
+
+					if (is_ssl)
+					{
+					#if defined(ASIO3_ENABLE_SSL) || defined(ASIO3_USE_SSL)
+						auto [e6, n6] = co_await http::async_read(
+							*conn->stream, conn->buffer, resp, asio::use_deferred_executor(conn->sock));
+						ec = e6;
+					#endif
+					}
+					else
+					{
+						auto [e6, n6] = co_await http::async_read(
+							conn->sock, conn->buffer, resp, asio::use_deferred_executor(conn->sock));
+						ec = e6;
+					}
+
+					if (ec)
+						resps.pop_back();
+					// the server will close the connection after this response,
+					// the remaining requests can't be answered.
+					else if (!resp.keep_alive() && resps.size() < reqs.size())
+						ec = http::error::end_of_stream;
 				}
 
-				beast::flat_buffer buffer{};
-				auto [e6, n6] = co_await http::async_read(*stream, buffer, resp, asio::use_deferred_executor(sock));
-				if (e6)
+				if (reused && attempt == 0 && idempotent && resps.empty() && is_stale_connection_error(ec))
 				{
-					co_await stream->async_shutdown(asio::use_deferred_executor(sock));
-					co_return{ e6, std::move(resp) };
+					ec.clear();
+					continue;
 				}
 
-				co_await stream->async_shutdown(asio::use_deferred_executor(sock));
-			#else
-				co_return{ asio::error::operation_not_supported, std::move(resp) };
-			#endif
+				break;
 			}
-			else
-			{
-				auto [e4, n4] = co_await http::async_write(sock, req, asio::use_deferred_executor(sock));
-				if (e4)
-					co_return{ e4, std::move(resp) };
-
-				if (!!state.cancelled())
-					co_return{ asio::error::operation_aborted, std::move(resp) };
 
-				beast::flat_buffer buffer{};
-				auto [e6, n6] = co_await http::async_read(sock, buffer, resp, asio::use_deferred_executor(sock));
-				if (e6)
-					co_return{ e6, std::move(resp) };
-			}
+			reusable = !ec && !resps.empty() && resps.back().keep_alive();
 
-			co_return{ error_code{}, std::move(resp) };
-        }
+			co_return{ ec, std::move(resps) };
+		}
 	};
 }
 
@@ -567,6 +775,8 @@ namespace boost::beast::http
 {
 /**
  * @brief Start an asynchronous http request.
+ * If the opt.pool is set, the connection is borrowed from the pool and returned to the
+ * pool after the response is received, so it can be reused by the next request.
  * @param opt - The request options.
  * @param token - The completion handler to invoke when the operation completes.
  *	  The equivalent function signature of the handler must be:
@@ -586,6 +796,34 @@ inline auto async_request(
 		executor);
 }
 
+/**
+ * @brief Start an asynchronous http/1.1 pipelining requests.
+ * All the requests are written to one pooled connection at first, and then the responses
+ * are read in order. All the requests must have the same scheme/host/port/proxy, and the
+ * requests should be idempotent, because the server may close the connection at any time, and
+ * the requests are only sent again on a new connection when all of them are idempotent.
+ * @param pool - The connection pool.
+ * @param opts - The request options, the opt.pool is ignored.
+ * @param token - The completion handler to invoke when the operation completes.
+ *	  The equivalent function signature of the handler must be:
+ *    @code
+ *    void handler(const asio::error_code& ec, std::vector<http::response<http::string_body>> resps);
+ *    @endcode
+ *    If an error occurs, the resps contains the responses which were received before the error.
+ */
+template<typename SendToken = asio::default_token_type<asio::tcp_socket>>
+inline auto async_pipeline(
+	http::client_pool& pool,
+	std::vector<request_option> opts,
+	SendToken&& token = asio::default_token_type<asio::tcp_socket>())
+{
+	return asio::async_initiate<SendToken, void(asio::error_code, std::vector<http::response<http::string_body>>)>(
+		asio::experimental::co_composed<void(asio::error_code, std::vector<http::response<http::string_body>>)>(
+			detail::async_pipeline_op{ std::move(opts) }, pool.get_executor()),
+		token,
+		std::ref(pool));
+}
+
 }
 
 #include <asio3/core/detail/pop_options.hpp>
@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef ASIO3_HEADER_ONLY
+namespace bho::beast::http
+#else
+namespace boost::beast::http
+#endif
+{
+	struct route_param
+	{
+		std::string_view name;
+		std::string_view value;
+	};
+
+	/**
+	 * @brief The params which are captured by the route tree when matching a path.
+	 * The values are views into the request target, so they are only valid while the
+	 * request is alive. If the target has percent-encoded chars, the values are views
+	 * into the decoded path which is stored in this object.
+	 */
+	class route_params
+	{
+	public:
+		static constexpr std::size_t max_params = 16;
+
+		/**
+		 * @brief Get the value of the param by name, return a empty view if not found.
+		 * The value of a trailing wildcard "*" or "*name" is stored by the name "*" or "name".
+		 */
+		[[nodiscard]] inline std::string_view get(std::string_view name) const noexcept
+		{
+			for (const route_param& param : *this)
+			{
+				if (param.name == name)
+					return param.value;
+			}
+			return std::string_view{};
+		}
+
+		/**
+		 * @brief Check whether the param exists or not.
+		 */
+		[[nodiscard]] inline bool contains(std::string_view name) const noexcept
+		{
+			for (const route_param& param : *this)
+			{
+				if (param.name == name)
+					return true;
+			}
+			return false;
+		}
+
+		[[nodiscard]] inline const route_param* begin() const noexcept { return params_.data(); }
+		[[nodiscard]] inline const route_param* end  () const noexcept { return params_.data() + size_; }
+
+		[[nodiscard]] inline std::size_t size () const noexcept { return size_; }
+		[[nodiscard]] inline bool        empty() const noexcept { return size_ == 0; }
+		[[nodiscard]] inline bool        full () const noexcept { return size_ == max_params; }
+
+		[[nodiscard]] inline const route_param& operator[](std::size_t i) const noexcept
+		{
+			assert(i < size_);
+			return params_[i];
+		}
+
+		inline void push_back(route_param param) noexcept
+		{
+			assert(size_ < max_params);
+			params_[size_++] = param;
+		}
+
+		inline void resize(std::size_t n) noexcept
+		{
+			assert(n <= size_);
+			size_ = n;
+		}
+
+		/**
+		 * @brief Clear the params and the decoded path.
+		 */
+		inline void reset() noexcept
+		{
+			size_ = 0;
+			decoded_path.clear();
+		}
+
+	public:
+		/// only used when the request target has percent-encoded chars.
+		std::string decoded_path;
+
+	protected:
+		std::array<route_param, max_params> params_{};
+
+		std::size_t                         size_ = 0;
+	};
+
+	/**
+	 * @brief A compressed radix tree for url routing.
+	 * The pattern supports these segments:
+	 *   static segment  : "/user/list"
+	 *   param segment   : "/user/:id"       , the param can be got by params.get("id")
+	 *   trailing wildcard : "/static/*" or "/static/*path", matches all the remaining chars.
+	 * When matching, the static segment has the highest priority, then the param segment,
+	 * and then the wildcard. The lookup doesn't allocate any memory.
+	 */
+	template<typename T>
+	class basic_route_tree
+	{
+	protected:
+		struct node
+		{
+			// the static chars of the edge which leads to this node.
+			std::string                        label;
+
+			// static children, the first char of the labels is different from each other.
+			std::vector<std::unique_ptr<node>> children;
+
+			// the ":name" child.
+			std::unique_ptr<node>              param;
+			std::string                        param_name;
+
+			// the trailing "*" or "*name" wildcard.
+			std::optional<T>                   wildcard;
+			std::string                        wildcard_name;
+
+			std::optional<T>                   value;
+		};
+
+	public:
+		using value_type = T;
+
+		basic_route_tree() = default;
+
+		basic_route_tree(basic_route_tree&&) noexcept = default;
+		basic_route_tree& operator=(basic_route_tree&&) noexcept = default;
+
+		/**
+		 * @brief Insert the pattern, return false if the pattern is already exists, or the param
+		 * name is different from the param name of another pattern at the same position, like
+		 * "/user/:id" and "/user/:name".
+		 */
+		bool insert(std::string_view pattern, T value)
+		{
+			node* n = std::addressof(root_);
+
+			while (!pattern.empty())
+			{
+				std::size_t pos = find_special(pattern);
+
+				n = insert_static(n, pattern.substr(0, pos));
+
+				pattern.remove_prefix((std::min)(pos, pattern.size()));
+
+				if (pattern.empty())
+					break;
+
+				std::size_t end = (std::min)(pattern.find('/'), pattern.size());
+
+				std::string_view name = pattern.substr(1, end - 1);
+
+				if (pattern.front() == '*' && end == pattern.size())
+				{
+					if (n->wildcard.has_value())
+						return false;
+
+					n->wildcard_name = name.empty() ? std::string_view{ "*" } : name;
+					n->wildcard = std::move(value);
+
+					++size_;
+
+					return true;
+				}
+
+				// the wildcard in the middle of the pattern is treated as a anonymous param.
+				if (pattern.front() == '*')
+					name = "*";
+
+				if (!n->param)
+				{
+					n->param = std::make_unique<node>();
+					n->param_name = name;
+				}
+				else if (n->param_name != name)
+				{
+					// the same position must use the same param name.
+					return false;
+				}
+
+				n = n->param.get();
+
+				pattern.remove_prefix(end);
+			}
+
+			if (n->value.has_value())
+				return false;
+
+			n->value = std::move(value);
+
+			++size_;
+
+			return true;
+		}
+
+		/**
+		 * @brief Find the value which matchs the path, the captured params are stored into params.
+		 * @return Returns nullptr if not found.
+		 */
+		[[nodiscard]] T* find(std::string_view path, route_params& params) noexcept
+		{
+			return match(root_, path, params);
+		}
+
+		/**
+		 * @brief Get the count of the patterns.
+		 */
+		[[nodiscard]] inline std::size_t size() const noexcept
+		{
+			return size_;
+		}
+
+		/**
+		 * @brief Check whether the tree is empty or not.
+		 */
+		[[nodiscard]] inline bool empty() const noexcept
+		{
+			return size_ == 0;
+		}
+
+		/**
+		 * @brief Remove all the patterns.
+		 */
+		inline void clear() noexcept
+		{
+			root_ = node{};
+			size_ = 0;
+		}
+
+	protected:
+		static std::size_t find_special(std::string_view pattern) noexcept
+		{
+			for (std::size_t i = 0; i < pattern.size(); ++i)
+			{
+				if (pattern[i] == '*')
+					return i;
+
+				// the param must be at the beginning of a segment.
+				if (pattern[i] == ':' && i > 0 && pattern[i - 1] == '/')
+					return i;
+			}
+
+			return pattern.size();
+		}
+
+		static node* insert_static(node* n, std::string_view text)
+		{
+			while (!text.empty())
+			{
+				std::unique_ptr<node>* slot = nullptr;
+
+				for (std::unique_ptr<node>& child : n->children)
+				{
+					if (child->label.front() == text.front())
+					{
+						slot = std::addressof(child);
+						break;
+					}
+				}
+
+				if (!slot)
+				{
+					std::unique_ptr<node>& child = n->children.emplace_back(std::make_unique<node>());
+					child->label = text;
+					return child.get();
+				}
+
+				std::string& label = (*slot)->label;
+
+				std::size_t common = 0;
+				while (common < label.size() && common < text.size() && label[common] == text[common])
+				{
+					++common;
+				}
+
+				// split the edge, the common prefix becomes the parent of the old node.
+				if (common < label.size())
+				{
+					std::unique_ptr<node> mid = std::make_unique<node>();
+					mid->label = label.substr(0, common);
+					label.erase(0, common);
+					mid->children.emplace_back(std::move(*slot));
+					*slot = std::move(mid);
+				}
+
+				n = slot->get();
+
+				text.remove_prefix(common);
+			}
+
+			return n;
+		}
+
+		static T* match_wildcard(node& n, std::string_view path, route_params& params) noexcept
+		{
+			if (!n.wildcard.has_value() || params.full())
+				return nullptr;
+
+			params.push_back(route_param{ n.wildcard_name, path });
+
+			return std::addressof(*n.wildcard);
+		}
+
+		static T* match(node& n, std::string_view path, route_params& params) noexcept
+		{
+			if (path.empty())
+			{
+				if (n.value.has_value())
+					return std::addressof(*n.value);
+
+				// the pattern "/dir/*" matchs the path "/dir" too.
+				for (std::unique_ptr<node>& child : n.children)
+				{
+					if (child->label == "/")
+					{
+						if (T* p = match_wildcard(*child, path, params))
+							return p;
+						break;
+					}
+				}
+
+				return match_wildcard(n, path, params);
+			}
+
+			for (std::unique_ptr<node>& child : n.children)
+			{
+				const std::string& label = child->label;
+
+				if (label.front() != path.front())
+					continue;
+
+				if (path.starts_with(label))
+				{
+					if (T* p = match(*child, path.substr(label.size()), params))
+						return p;
+				}
+				else if (label.size() == path.size() + 1 && label.back() == '/' && label.starts_with(path))
+				{
+					if (T* p = match_wildcard(*child, std::string_view{}, params))
+						return p;
+				}
+
+				break;
+			}
+
+			if (n.param && !params.full())
+			{
+				std::size_t end = (std::min)(path.find('/'), path.size());
+
+				if (end > 0)
+				{
+					std::size_t mark = params.size();
+
+					params.push_back(route_param{ n.param_name, path.substr(0, end) });
+
+					if (T* p = match(*n.param, path.substr(end), params))
+						return p;
+
+					params.resize(mark);
+				}
+			}
+
+			return match_wildcard(n, path, params);
+		}
+
+	protected:
+		node        root_;
+
+		std::size_t size_ = 0;
+	};
+}
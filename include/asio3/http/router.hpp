@@ -27,6 +27,7 @@
 #include <unordered_map>
 #include <type_traits>
 #include <filesystem>
+#include <stdexcept>
 
 #include <asio3/core/asio.hpp>
 #include <asio3/core/beast.hpp>
@@ -40,6 +41,7 @@
 #include <asio3/http/cache.hpp>
 #include <asio3/http/make.hpp>
 #include <asio3/http/core.hpp>
+#include <asio3/http/route_tree.hpp>
 
 #ifdef ASIO3_HEADER_ONLY
 namespace bho::beast::http
@@ -106,8 +108,9 @@ namespace boost::beast::http
 		using request_type = RequestT;
 		using response_type = ResponseT;
 		using return_type = asio::awaitable<bool>;
-		using function_type = std::function<return_type(RequestT&, ResponseT&, Ts...)>;
+		using function_type = std::function<return_type(RequestT&, ResponseT&, route_params&, Ts...)>;
 		using cache_type = cache;
+		using tree_type = basic_route_tree<std::shared_ptr<function_type>>;
 
 		/**
 		 * @brief constructor
@@ -115,7 +118,7 @@ namespace boost::beast::http
 		basic_router()
 		{
 			this->not_found_router_ = std::make_shared<function_type>(
-			[](RequestT& req, ResponseT& rep, Ts...) mutable -> return_type
+			[](RequestT& req, ResponseT& rep, route_params&, Ts...) mutable -> return_type
 			{
 				std::string desc;
 				desc.reserve(64);
@@ -138,23 +141,6 @@ namespace boost::beast::http
 		~basic_router() = default;
 
 	protected:
-		template<http::verb... M>
-		inline decltype(auto) _make_uris(std::string name)
-		{
-			std::size_t index = 0;
-			std::array<std::string, sizeof...(M)> uris;
-			//while (!name.empty() && name.back() == '*')
-			//	name.erase(std::prev(name.end()));
-			while (name.size() > static_cast<std::string::size_type>(1) && name.back() == '/')
-				name.erase(std::prev(name.end()));
-			assert(!name.empty());
-			if (!name.empty())
-			{
-				((uris[index++] = std::string{ this->_to_char(M) } +name), ...);
-			}
-			return uris;
-		}
-
 		template<http::verb... M, class F, class C, class... AOP>
 		inline void _add_impl(std::string name, F f, C* c, AOP&&... aop)
 		{
@@ -170,7 +156,7 @@ namespace boost::beast::http
 				std::bind_front(&self::template _proxy<CacheFlag, F, C, Tup>, this,
 					std::move(f), c, std::move(tp)));
 
-			this->_bind_uris(name, std::move(op), this->_make_uris<M...>(name));
+			this->_bind_route<M...>(std::move(name), std::move(op));
 		}
 
 		template<http::verb... M, class F, class... AOP>
@@ -196,48 +182,56 @@ namespace boost::beast::http
 				std::move(f), std::addressof(c), std::forward<AOP>(aop)...);
 		}
 
-		template<class URIS>
-		inline void _bind_uris(std::string& name, std::shared_ptr<function_type> op, URIS uris)
+		template<http::verb... M>
+		inline void _bind_route(std::string name, std::shared_ptr<function_type> op)
 		{
-			for (auto& uri : uris)
-			{
-				if (uri.empty())
-					continue;
+			while (name.size() > static_cast<std::string::size_type>(1) && name.back() == '/')
+				name.erase(std::prev(name.end()));
 
-				if (name.back() == '*')
-				{
-					assert(this->wildcard_routers_.find(uri) == this->wildcard_routers_.end());
-					this->wildcard_routers_[std::move(uri)] = op;
-				}
-				else
+			assert(!name.empty());
+
+			if (name.empty())
+				return;
+
+			([&]() mutable
+			{
+				if (!this->routers_[std::to_underlying(M)].insert(name, op))
 				{
-					assert(this->strictly_routers_.find(uri) == this->strictly_routers_.end());
-					this->strictly_routers_[std::move(uri)] = op;
+					asio::detail::throw_exception(std::invalid_argument(
+						"the route \"" + name + "\" is already exists or its param name is conflicted with another route"));
 				}
-			}
+			}(), ...);
 		}
 
 		template<class F, class C, class... TS>
-		inline return_type _call_route_function(F& f, C* c, RequestT& req, ResponseT& rep, TS&&... ts)
+		inline return_type _call_route_function(
+			F& f, C* c, RequestT& req, ResponseT& rep, route_params& params, TS&&... ts)
 		{
 			if constexpr (std::same_as<std::decay_t<C>, dummy>)
 			{
-				co_return co_await f(req, rep, std::forward<TS>(ts)...);
+				if constexpr (std::is_invocable_v<F&, RequestT&, ResponseT&, route_params&, TS...>)
+					co_return co_await f(req, rep, params, std::forward<TS>(ts)...);
+				else
+					co_return co_await f(req, rep, std::forward<TS>(ts)...);
 			}
 			else
 			{
-				co_return c ? (co_await (c->*f)(req, rep, std::forward<TS>(ts)...)) : false;
+				if constexpr (std::is_invocable_v<F&, C*, RequestT&, ResponseT&, route_params&, TS...>)
+					co_return c ? (co_await (c->*f)(req, rep, params, std::forward<TS>(ts)...)) : false;
+				else
+					co_return c ? (co_await (c->*f)(req, rep, std::forward<TS>(ts)...)) : false;
 			}
 		}
 
 		template<bool CacheFlag, class F, class C, class Tup>
 		requires (CacheFlag == false)
-		inline return_type _proxy(F& f, C* c, Tup& aops, RequestT& req, ResponseT& rep, Ts... ts)
+		inline return_type _proxy(F& f, C* c, Tup& aops,
+			RequestT& req, ResponseT& rep, route_params& params, Ts... ts)
 		{
 			if (!(co_await _call_aop_before(aops, req, rep, ts...)))
 				co_return false;
 
-			if (!(co_await _call_route_function(f, c, req, rep, ts...)))
+			if (!(co_await _call_route_function(f, c, req, rep, params, ts...)))
 				co_return false;
 
 			if (!(co_await _call_aop_after(aops, req, rep, ts...)))
@@ -248,34 +242,30 @@ namespace boost::beast::http
 
 		template<bool CacheFlag, class F, class C, class Tup>
 		requires (CacheFlag == true)
-		inline return_type _proxy(F& f, C* c, Tup& aops, RequestT& req, ResponseT& rep, Ts... ts)
+		inline return_type _proxy(F& f, C* c, Tup& aops,
+			RequestT& req, ResponseT& rep, route_params& params, Ts... ts)
 		{
-			using pcache_node = decltype(this->cache_.find(""));
-
 			if (http::is_cache_enabled(req))
 			{
-				pcache_node pcn = this->cache_.find(req.target());
-				if (!pcn)
+				typename cache_type::entry_ptr entry = this->cache_.find(req.target(), req);
+				if (!entry)
 				{
 					if (!(co_await _call_aop_before(aops, req, rep, ts...)))
 						co_return false;
 
-					if (!(co_await _call_route_function(f, c, req, rep, ts...)))
+					if (!(co_await _call_route_function(f, c, req, rep, params, ts...)))
 						co_return false;
 
 					if (!(co_await _call_aop_after(aops, req, rep, ts...)))
 						co_return false;
 
-					if (this->cache_.full())
-					{
-						this->cache_.shrink_to_fit();
-					}
-
-					if (!this->cache_.full() && rep.get_response_header().result() == http::status::ok)
+					if (rep.result() == http::status::ok)
 					{
 						if (auto res = rep.to_string_body_response(); res.has_value())
 						{
-							this->cache_.add(req.target(), std::move(res.value()));
+							// send the serialized response, so it needn't be serialized again.
+							if (entry = this->cache_.add(req.target(), req, res.value()); entry)
+								rep = std::move(entry);
 						}
 					}
 
@@ -289,9 +279,17 @@ namespace boost::beast::http
 					if (!(co_await _call_aop_after(aops, req, rep, ts...)))
 						co_return false;
 
-					pcn->update_alive_time();
-
-					rep = std::ref(pcn->msg);
+					if (entry->is_not_modified(req))
+					{
+						http::response<http::empty_body> res{ http::status::not_modified, req.version() };
+						res.set(http::field::etag, entry->header[http::field::etag]);
+						res.keep_alive(req.keep_alive());
+						rep = std::move(res);
+					}
+					else
+					{
+						rep = std::move(entry);
+					}
 
 					co_return true;
 				}
@@ -301,7 +299,7 @@ namespace boost::beast::http
 				if (!(co_await _call_aop_before(aops, req, rep, ts...)))
 					co_return false;
 
-				if (!(co_await _call_route_function(f, c, req, rep, ts...)))
+				if (!(co_await _call_route_function(f, c, req, rep, params, ts...)))
 					co_return false;
 
 				if (!(co_await _call_aop_after(aops, req, rep, ts...)))
@@ -312,15 +310,16 @@ namespace boost::beast::http
 		}
 
 		template<class F, class... TS>
-		inline return_type _not_found_proxy(F& f, RequestT& req, ResponseT& rep, TS&&... ts)
+		inline return_type _not_found_proxy(F& f, RequestT& req, ResponseT& rep, route_params& params, TS&&... ts)
 		{
-			co_return co_await f(req, rep, std::forward<TS>(ts)...);
+			co_return co_await _call_route_function(
+				f, static_cast<dummy*>(nullptr), req, rep, params, std::forward<TS>(ts)...);
 		}
 
 		template<class F, class C, class... TS>
-		inline return_type _not_found_proxy(F& f, C* c, RequestT& req, ResponseT& rep, TS&&... ts)
+		inline return_type _not_found_member_proxy(F& f, C* c, RequestT& req, ResponseT& rep, route_params& params, TS&&... ts)
 		{
-			co_return c ? (co_await (c->*f)(req, rep, std::forward<TS>(ts)...)) : false;
+			co_return co_await _call_route_function(f, c, req, rep, params, std::forward<TS>(ts)...);
 		}
 
 		template<class F>
@@ -334,7 +333,7 @@ namespace boost::beast::http
 		inline void _add_not_found_impl(F f, C* c)
 		{
 			this->not_found_router_ = std::make_shared<function_type>(
-				std::bind(&self::template _not_found_proxy<F, C>, this, std::move(f), c));
+				std::bind_front(&self::template _not_found_member_proxy<F, C>, this, std::move(f), c));
 		}
 
 		template<class F, class C>
@@ -443,53 +442,36 @@ namespace boost::beast::http
 			}
 		}
 
-		inline std::string _make_uri(std::string_view root, std::string_view path)
+		inline std::string_view _make_path(std::string_view path, route_params& params)
 		{
-			std::string uri;
+			if (auto pos = path.find('?'); pos != std::string_view::npos)
+			{
+				path = path.substr(0, pos);
+			}
 
+			// only the percent-encoded path need to be decoded into the params' buffer.
 			if (http::has_undecode_char(path, 1))
 			{
-				std::string decoded = http::url_decode(path);
+				params.decoded_path = http::url_decode(path);
 
-				path = decoded;
-
-				while (path.size() > static_cast<std::string_view::size_type>(1) && path.back() == '/')
-				{
-					path.remove_suffix(1);
-				}
-
-				uri.reserve(root.size() + path.size());
-				uri += root;
-				uri += path;
+				path = params.decoded_path;
 			}
-			else
-			{
-				while (path.size() > static_cast<std::string_view::size_type>(1) && path.back() == '/')
-				{
-					path.remove_suffix(1);
-				}
 
-				uri.reserve(root.size() + path.size());
-				uri += root;
-				uri += path;
+			while (path.size() > static_cast<std::string_view::size_type>(1) && path.back() == '/')
+			{
+				path.remove_suffix(1);
 			}
 
-			return uri;
-		}
-
-		inline constexpr std::string_view _to_char(http::verb method) noexcept
-		{
-			using namespace std::literals;
-			// Use a special name to avoid conflicts with global variable names
-			constexpr std::string_view _hrmchars =
-				"0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"sv;
-			return _hrmchars.substr(std::to_underlying(method), 1);
+			return path;
 		}
 
 	public:
 		/**
 		 * @brief bind a function for http router
-		 * @param name - uri name in string format.
+		 * @param name - uri name in string format, such as "/user/list", "/user/:id", "/static/*".
+		 *   the captured params can be got by the "http::route_params&" param of the function.
+		 *   throws std::invalid_argument if the route is already exists, or a param at the same
+		 *   position of another route has a different name, like "/user/:id" and "/user/:name".
 		 * @param fun - Function object.
 		 * @param aops - A pointer or reference to a aop object list.
 		 * if fun is member function, the first aops param must the class object's pointer or reference.
@@ -542,56 +524,49 @@ namespace boost::beast::http
 			return (*this);
 		}
 
-		inline std::shared_ptr<function_type>& find(RequestT& req)
+		/**
+		 * @brief Find the router function which matchs the request, the captured path params
+		 * are stored into the params.
+		 */
+		inline std::shared_ptr<function_type>& find(RequestT& req, route_params& params)
 		{
-			std::string_view path = req.target();
+			params.reset();
 
-			if (auto pos = path.find('?'); pos != std::string_view::npos)
-			{
-				path = path.substr(0, pos);
-			}
+			std::size_t index = std::to_underlying(req.method());
 
-			std::string uri = this->_make_uri(this->_to_char(req.method()), path);
+			if (index >= this->routers_.size())
+				return this->dummy_router_;
 
-			{
-				auto it = this->strictly_routers_.find(uri);
-				if (it != this->strictly_routers_.end())
-				{
-					return (it->second);
-				}
-			}
+			std::string_view path = this->_make_path(req.target(), params);
 
-			// Find the best match url from tail to head
-			if (!wildcard_routers_.empty())
-			{
-				for (auto it = this->wildcard_routers_.rbegin(); it != this->wildcard_routers_.rend(); ++it)
-				{
-					auto& k = it->first;
-					assert(k.size() >= std::size_t(3));
-					if (!uri.empty() && !k.empty() && uri.front() == k.front() && uri.size() >= (k.size() - 2)
-						&& uri[k.size() - 3] == k[k.size() - 3] && http::url_match(k, uri))
-					{
-						return (it->second);
-					}
-				}
-			}
+			if (std::shared_ptr<function_type>* p = this->routers_[index].find(path, params))
+				return (*p);
 
 			return this->dummy_router_;
 		}
 
+		inline std::shared_ptr<function_type>& find(RequestT& req)
+		{
+			route_params params;
+
+			return this->find(req, params);
+		}
+
 		template<class... TS>
 		inline return_type route(RequestT& req, ResponseT& rep, TS&&... ts)
 		{
-			std::shared_ptr<function_type>& router_ptr = this->find(req);
+			route_params params;
+
+			std::shared_ptr<function_type>& router_ptr = this->find(req, params);
 
 			if (router_ptr)
 			{
-				co_return co_await (*router_ptr)(req, rep, std::forward<TS>(ts)...);
+				co_return co_await (*router_ptr)(req, rep, params, std::forward<TS>(ts)...);
 			}
 
 			if (this->not_found_router_ && (*(this->not_found_router_)))
 			{
-				co_return co_await (*(this->not_found_router_))(req, rep, std::forward<TS>(ts)...);
+				co_return co_await (*(this->not_found_router_))(req, rep, params, std::forward<TS>(ts)...);
 			}
 
 			co_return false;
@@ -603,9 +578,8 @@ namespace boost::beast::http
 		}
 
 	protected:
-		std::unordered_map<std::string, std::shared_ptr<function_type>> strictly_routers_;
-
-		std::          map<std::string, std::shared_ptr<function_type>> wildcard_routers_;
+		/// one route tree per http method, indexed by the http::verb value.
+		std::array<tree_type, std::to_underlying(http::verb::unlink) + 1> routers_;
 
 		std::shared_ptr<function_type>                                  not_found_router_;
 
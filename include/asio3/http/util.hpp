@@ -13,6 +13,7 @@
 #include <asio3/core/detail/push_options.hpp>
 
 #include <cctype>
+#include <charconv>
 #include <sstream>
 
 #include <memory>
@@ -497,6 +498,67 @@ namespace boost::beast::http
 		return true;
 	}
 
+	/**
+	 * @brief Parse the single byte range of the "Range" header value, like "bytes=0-499",
+	 * "bytes=500-" or "bytes=-500".
+	 * @param value - The "Range" header value.
+	 * @param content_size - The size of the whole content.
+	 * @return The first and last byte position of the range. If the range is outside of the
+	 *  content, return status::range_not_satisfiable. If the value is empty, malformed or has
+	 *  multiple ranges, return status::ok, which means the whole content should be sent.
+	 */
+	template<typename = void>
+	std::expected<std::pair<std::uint64_t, std::uint64_t>, http::status>
+		parse_range(std::string_view value, std::uint64_t content_size)
+	{
+		auto to_number = [](std::string_view s, std::uint64_t& n) -> bool
+		{
+			auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), n);
+			return (!s.empty() && ec == std::errc{} && ptr == s.data() + s.size());
+		};
+
+		asio::trim_both(value);
+
+		if (value.size() < 6 || !asio::iequals(value.substr(0, 6), "bytes="))
+			return std::unexpected(http::status::ok);
+
+		value.remove_prefix(6);
+
+		std::size_t pos = value.find('-');
+		if (pos == std::string_view::npos || value.find(',') != std::string_view::npos)
+			return std::unexpected(http::status::ok);
+
+		std::string_view first_str = value.substr(0, pos);
+		std::string_view last_str = value.substr(pos + 1);
+
+		std::uint64_t first = 0, last = 0;
+
+		// the suffix range, the last N bytes.
+		if (first_str.empty())
+		{
+			if (!to_number(last_str, last))
+				return std::unexpected(http::status::ok);
+
+			if (last == 0 || content_size == 0)
+				return std::unexpected(http::status::range_not_satisfiable);
+
+			return std::pair{ content_size - (std::min)(last, content_size), content_size - 1 };
+		}
+
+		if (!to_number(first_str, first))
+			return std::unexpected(http::status::ok);
+
+		if (last_str.empty())
+			last = content_size - 1;
+		else if (!to_number(last_str, last) || last < first)
+			return std::unexpected(http::status::ok);
+
+		if (first >= content_size)
+			return std::unexpected(http::status::range_not_satisfiable);
+
+		return std::pair{ first, (std::min)(last, content_size - 1) };
+	}
+
 	/**
 	 * @brief Returns `true` if the HTTP message's Content-Type is "multipart/form-data";
 	 */
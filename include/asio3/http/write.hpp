@@ -10,6 +10,13 @@
 
 #pragma once
 
+#include <charconv>
+#include <optional>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
 #include <asio3/core/asio.hpp>
 #include <asio3/core/beast.hpp>
 #include <asio3/core/stdutil.hpp>
@@ -18,7 +25,9 @@
 #include <asio3/core/asio_buffer_specialization.hpp>
 #include <asio3/core/data_persist.hpp>
 #include <asio3/core/file.hpp>
+#include <asio3/core/netconcepts.hpp>
 #include <asio3/http/mime_types.hpp>
+#include <asio3/http/ws_prepared_message.hpp>
 
 #ifdef ASIO_STANDALONE
 namespace asio::detail
@@ -42,10 +51,49 @@ namespace boost::asio::detail
 
 			[[maybe_unused]] asio::defer_unlock defered_unlock{ ws_stream };
 
-			auto [e1, n1] = co_await ws_stream.async_write(
-				asio::to_buffer(msg), asio::use_deferred_executor(ws_stream));
+			if constexpr (asio::is_prepared_message<decltype(msg)>)
+			{
+				// write the prepared frame as is if the stream can accept it, otherwise the
+				// stream encodes the payload by itself.
+				if constexpr (requires { ws_stream.async_write_frame(msg.frame_for(ws_stream)); })
+				{
+					asio::const_buffer frame = msg.frame_for(ws_stream);
+
+					if (frame.size() > 0)
+					{
+						auto [e1, n1] = co_await ws_stream.async_write_frame(
+							frame, asio::use_deferred_executor(ws_stream));
+
+						if (e1 != asio::error::operation_not_supported)
+							co_return{ e1, e1 ? 0 : msg.payload().size() };
+					}
+				}
+
+				// the message type is taken by the write when it's initiated, so the option of
+				// the stream is restored before any other operation can see the changed one.
+				auto token = asio::use_deferred_executor(ws_stream);
+
+				auto [e1, n1] = co_await asio::async_initiate<decltype(token), void(asio::error_code, std::size_t)>(
+					[&ws_stream, &msg](auto handler) mutable
+					{
+						bool binary = ws_stream.binary();
+
+						ws_stream.binary(msg.binary());
 
-			co_return{ e1, n1 };
+						ws_stream.async_write(msg.payload(), std::move(handler));
+
+						ws_stream.binary(binary);
+					}, token);
+
+				co_return{ e1, n1 };
+			}
+			else
+			{
+				auto [e1, n1] = co_await ws_stream.async_write(
+					asio::to_buffer(msg), asio::use_deferred_executor(ws_stream));
+
+				co_return{ e1, n1 };
+			}
 		}
 	};
 }
@@ -56,6 +104,58 @@ namespace bho::beast::http::detail
 namespace boost::beast::http::detail
 #endif
 {
+	/// the chunk callback of the async_send_file which doesn't need the file data, the file
+	/// data can be sent by the kernel directly without being copied to the user space.
+	struct send_file_null_callback
+	{
+		constexpr bool operator()(std::string_view) const noexcept { return true; }
+	};
+
+	/// the max bytes of each sendfile call, and the buffer size when the file data is readed
+	/// into the user space.
+	constexpr std::size_t send_file_max_chunk_size = 1024 * 1024;
+	constexpr std::size_t send_file_buffer_size = 64 * 1024;
+
+	/**
+	 * @brief Whether the file can be sent by sendfile, the stream must be a plain tcp socket,
+	 * the file must be a regular file handle, and the file data is not required by the caller.
+	 */
+	template<typename AsyncStream, typename FileStream, typename BodyChunkCallback>
+	concept is_sendfile_capable =
+	#if defined(__linux__)
+		asio::is_basic_stream_socket<AsyncStream> &&
+		asio::is_tcp_socket<AsyncStream> &&
+		std::same_as<std::remove_cvref_t<BodyChunkCallback>, send_file_null_callback> &&
+		requires(FileStream& file, asio::error_code& ec)
+		{
+			{ file.native_handle() } -> std::convertible_to<int>;
+			{ file.seek(0, asio::file_base::seek_cur, ec) } -> std::convertible_to<std::uint64_t>;
+		};
+	#else
+		false;
+	#endif
+
+	/**
+	 * @brief Get the Content-Length value of the message, return empty if it's not setted.
+	 */
+	template<bool isRequest, typename Body, typename Fields>
+	inline std::optional<std::uint64_t> get_content_length(const http::message<isRequest, Body, Fields>& msg)
+	{
+		if (msg.chunked())
+			return std::nullopt;
+
+		auto value = msg[http::field::content_length];
+		if (value.empty())
+			return std::nullopt;
+
+		std::uint64_t length = 0;
+		auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), length);
+		if (ec != std::errc{} || ptr != value.data() + value.size())
+			return std::nullopt;
+
+		return length;
+	}
+
 	template<bool isRequest, typename Body, typename Fields>
 	struct async_send_file_op
 	{
@@ -78,6 +178,11 @@ namespace boost::beast::http::detail
 			asio::error_code ec{};
 			std::size_t sent_bytes = 0;
 
+			// only the Content-Length bytes from the current position of the file are sent, so
+			// the Range request can be served by seeking the file to the first byte of the range.
+			// if the Content-Length is not setted, the file is sent until the end.
+			std::optional<std::uint64_t> remain = detail::get_content_length(header);
+
 			http::message<isRequest, http::buffer_body> msg{ std::move(header) };
 
 			msg.body().data = nullptr;
@@ -97,14 +202,118 @@ namespace boost::beast::http::detail
 
 			sent_bytes += n2;
 
-			std::array<char, 2048> buffer;
+		#if defined(__linux__)
+			// the body of the chunked message must be framed, so only the plain body can be sent
+			// by the kernel directly.
+			if constexpr (detail::is_sendfile_capable<
+				std::remove_cvref_t<decltype(sock)>,
+				std::remove_cvref_t<decltype(file)>,
+				decltype(chunk_callback)>)
+			{
+				if (!msg.chunked())
+				{
+					std::uint64_t offset = file.seek(0, asio::file_base::seek_cur, ec);
+					if (ec)
+					{
+						co_return{ ec, sent_bytes };
+					}
+
+					sock.native_non_blocking(true, ec);
+					if (ec)
+					{
+						co_return{ ec, sent_bytes };
+					}
+
+					while (!remain.has_value() || remain.value() > 0)
+					{
+						if (!!state.cancelled())
+						{
+							ec = asio::error::operation_aborted;
+							break;
+						}
+
+						std::size_t size = remain.has_value() ?
+							std::size_t((std::min)(remain.value(), std::uint64_t(send_file_max_chunk_size))) :
+							send_file_max_chunk_size;
+
+						off_t off = static_cast<off_t>(offset);
+
+						ssize_t n = ::sendfile(sock.native_handle(), file.native_handle(), &off, size);
+						if (n > 0)
+						{
+							offset += std::uint64_t(n);
+							sent_bytes += std::size_t(n);
+
+							if (remain.has_value())
+								remain.value() -= std::uint64_t(n);
+
+							continue;
+						}
+
+						// reached the end of the file.
+						if (n == 0)
+						{
+							// the file is shorter than the Content-Length.
+							if (remain.has_value())
+								ec = asio::error::eof;
+							break;
+						}
+
+						if (errno == EINTR)
+							continue;
+
+						if (errno == EAGAIN || errno == EWOULDBLOCK)
+						{
+							auto [e3] = co_await sock.async_wait(
+								asio::socket_base::wait_write, asio::use_deferred_executor(sock));
+							if (e3)
+							{
+								ec = e3;
+								break;
+							}
+
+							continue;
+						}
+
+						ec = asio::error_code(errno, asio::error::get_system_category());
+						break;
+					}
+
+					// keep the file position as if the data was readed by the file stream.
+					asio::error_code ignored{};
+					file.seek(std::int64_t(offset), asio::file_base::seek_set, ignored);
+
+					co_return{ ec, sent_bytes };
+				}
+			}
+		#endif
+
+			// the buffer is allocated once and reused by all the chunks.
+			std::unique_ptr<char[]> buffer = std::make_unique_for_overwrite<char[]>(send_file_buffer_size);
 			do
 			{
 				if (!!state.cancelled())
 					co_return{ asio::error::operation_aborted, sent_bytes };
 
-				auto [e3, n3] = co_await file.async_read_some(
-					asio::buffer(buffer), asio::use_deferred_executor(file));
+				std::size_t size = remain.has_value() ?
+					std::size_t((std::min)(remain.value(), std::uint64_t(send_file_buffer_size))) :
+					send_file_buffer_size;
+
+				asio::error_code e3{};
+				std::size_t n3 = 0;
+
+				if (size > 0)
+				{
+					auto [e, n] = co_await file.async_read_some(
+						asio::buffer(buffer.get(), size), asio::use_deferred_executor(file));
+					e3 = e;
+					n3 = n;
+				}
+				else
+				{
+					e3 = asio::error::eof;
+				}
+
 				if (e3 == asio::error::eof)
 				{
 					e3 = {};
@@ -124,14 +333,17 @@ namespace boost::beast::http::detail
 						co_return{ e3, sent_bytes };
 					}
 
+					if (remain.has_value())
+						remain.value() -= n3;
+
 					// Point to our buffer with the bytes that
 					// we received, and indicate that there may
 					// be some more data coming
-					msg.body().data = buffer.data();
+					msg.body().data = buffer.get();
 					msg.body().size = n3;
 					msg.body().more = true;
 
-					std::string_view chunk_data{ buffer.data(), n3 };
+					std::string_view chunk_data{ buffer.get(), n3 };
 					if (!chunk_callback(chunk_data))
 					{
 						co_return{ asio::error::operation_aborted, sent_bytes };
@@ -170,7 +382,8 @@ namespace boost::asio
 /**
  * @brief Start an asynchronous operation to write all of the supplied data to a stream.
  * @param stream - The websocket stream to which the data is to be written.
- * @param data - The written data.
+ * @param data - The written data, or a ws_prepared_message which is framed once and written
+ *   to many streams.
  * @param token - The completion handler to invoke when the operation completes.
  *	  The equivalent function signature of the handler must be:
  *    @code
@@ -202,6 +415,8 @@ namespace boost::beast::http
 {
 /**
  * @brief Start an asynchronous operation to write all the data of the supplied file to a stream.
+ * Only the Content-Length bytes from the current position of the file are sent, so a Range
+ * request can be served by seeking the file to the first byte of the range before calling.
  * @param stream - The socket stream to which the data is to be written.
  * @param file - The file stream to which the data is to be readed.
  * @param header - The http message header which will be written to the stream.
@@ -243,6 +458,10 @@ inline auto async_send_file(
 
 /**
  * @brief Start an asynchronous operation to write all the data of the supplied file to a stream.
+ * If the stream is a plain tcp socket and the message is not chunked, the file data is sent
+ * by sendfile without being copied to the user space.
+ * Only the Content-Length bytes from the current position of the file are sent, so a Range
+ * request can be served by seeking the file to the first byte of the range before calling.
  * @param stream - The socket stream to which the data is to be written.
  * @param file - The file stream to which the data is to be readed.
  * @param header - The http message header which will be written to the stream.
@@ -270,7 +489,7 @@ inline auto async_send_file(
 		token,
 		std::ref(stream),
 		std::ref(file),
-		[](auto) { return true; });
+		detail::send_file_null_callback{});
 }
 
 }
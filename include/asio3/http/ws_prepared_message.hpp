@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include <asio3/core/asio.hpp>
+#include <asio3/core/beast.hpp>
+#include <asio3/core/netconcepts.hpp>
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+	/**
+	 * @brief The websocket message which is framed once and sent to many server side sessions.
+	 * The unmasked frame is built when the message is constructed, and the frame compressed by
+	 * the permessage-deflate is built once when it's needed at the first time. The message is a
+	 * cheap copyable handle of the shared immutable frames, so it can be passed to the
+	 * session_map::async_send_all or async_broadcast directly.
+	 * The raw frame is only written to the streams which can accept it, the other streams, like
+	 * the client side streams or the streams whose negotiated deflate options are incompatible,
+	 * fall back to encode the payload by themselves.
+	 * The raw frame is written by the websocket::stream::async_write_frame and the negotiated
+	 * options are got by the websocket::stream::get_negotiated_option, they are only provided
+	 * by the beast which is bundled in asio3 (bho). With the beast of the boost they don't
+	 * exist, the message is still sent correctly, but every stream encodes the payload by itself,
+	 * so the message is framed and compressed once per session.
+	 */
+	class ws_prepared_message
+	{
+	public:
+		using prepared_message_tag = void;
+
+		/**
+		 * @brief constructor
+		 * @param data - the payload of the message.
+		 * @param binary - send the message as a binary message or a text message.
+		 * @param deflate - the compression options, the compressed frame is valid for the
+		 *   streams which negotiated the server_no_context_takeover, and whose negotiated
+		 *   server_max_window_bits is not less than the deflate.server_max_window_bits.
+		 */
+		explicit ws_prepared_message(
+			auto&& data,
+			bool binary = false,
+			const beast::websocket::permessage_deflate& deflate = {})
+			requires (!std::same_as<std::remove_cvref_t<decltype(data)>, ws_prepared_message>)
+			: impl_(std::make_shared<impl>())
+		{
+			auto buffer = asio::buffer(data);
+
+			std::string_view payload{
+				reinterpret_cast<std::string_view::const_pointer>(buffer.data()), buffer.size() };
+
+			impl_->binary = binary;
+			impl_->deflate = deflate;
+			impl_->frame = make_frame(payload, false, binary);
+			impl_->header_size = impl_->frame.size() - payload.size();
+		}
+
+		ws_prepared_message(ws_prepared_message&&) noexcept = default;
+		ws_prepared_message(const ws_prepared_message&) = default;
+		ws_prepared_message& operator=(ws_prepared_message&&) noexcept = default;
+		ws_prepared_message& operator=(const ws_prepared_message&) = default;
+
+		/**
+		 * @brief Get the payload of the message.
+		 */
+		[[nodiscard]] inline asio::const_buffer payload() const noexcept
+		{
+			return asio::buffer(impl_->frame.data() + impl_->header_size,
+				impl_->frame.size() - impl_->header_size);
+		}
+
+		/**
+		 * @brief Check whether the message is a binary message.
+		 */
+		[[nodiscard]] inline bool binary() const noexcept
+		{
+			return impl_->binary;
+		}
+
+		/**
+		 * @brief Get the frame which can be written to the stream as is, the returned buffer
+		 * is empty if the stream must encode the payload by itself.
+		 */
+		template<typename AsyncStream>
+		[[nodiscard]] inline asio::const_buffer frame_for(
+			const beast::websocket::stream<AsyncStream>& ws_stream) const
+		{
+			beast::websocket::permessage_deflate o;
+
+			// the beast of the boost can't tell the negotiated options.
+			if constexpr (!requires { ws_stream.get_negotiated_option(o); })
+			{
+				return asio::const_buffer{};
+			}
+			else
+			{
+				// the stream doesn't compress this message, the plain frame is what it would send.
+				if (!ws_stream.get_negotiated_option(o) || !ws_stream.compress() ||
+					payload().size() < o.msg_size_threshold)
+				{
+					return asio::buffer(impl_->frame);
+				}
+
+				// the frame is compressed without the context of the stream, so the stream must
+				// reset its context after every message too, otherwise the peer's window mismatches.
+				if (!o.server_no_context_takeover ||
+					o.server_max_window_bits < impl_->deflate.server_max_window_bits)
+				{
+					return asio::const_buffer{};
+				}
+
+				std::call_once(impl_->deflated_once, [this]()
+				{
+					impl_->deflated = make_deflated_frame();
+				});
+
+				return asio::buffer(impl_->deflated);
+			}
+		}
+
+	protected:
+		static inline std::string make_frame(std::string_view data, bool rsv1, bool binary)
+		{
+			std::string frame;
+
+			std::size_t header_size = 2;
+			if /**/ (data.size() > 0xffff)
+				header_size += 8;
+			else if (data.size() > 125)
+				header_size += 2;
+
+			frame.reserve(header_size + data.size());
+
+			// FIN, RSV1 and the opcode, the frame of the server is never masked.
+			frame.push_back(char(0x80 | (rsv1 ? 0x40 : 0x00) | (binary ? 0x02 : 0x01)));
+
+			if /**/ (data.size() > 0xffff)
+			{
+				frame.push_back(char(127));
+				for (int i = 7; i >= 0; --i)
+					frame.push_back(char((std::uint64_t(data.size()) >> (i * 8)) & 0xff));
+			}
+			else if (data.size() > 125)
+			{
+				frame.push_back(char(126));
+				frame.push_back(char((data.size() >> 8) & 0xff));
+				frame.push_back(char(data.size() & 0xff));
+			}
+			else
+			{
+				frame.push_back(char(data.size()));
+			}
+
+			frame.append(data);
+
+			return frame;
+		}
+
+		inline std::string make_deflated_frame() const
+		{
+			asio::const_buffer data = payload();
+
+			beast::zlib::deflate_stream zo;
+			zo.reset(
+				impl_->deflate.compLevel,
+				impl_->deflate.server_max_window_bits,
+				impl_->deflate.memLevel,
+				beast::zlib::Strategy::normal);
+
+			std::string out(zo.upper_bound(data.size()) + 16, '\0');
+
+			beast::zlib::z_params zs;
+			zs.next_in = data.data();
+			zs.avail_in = data.size();
+			zs.next_out = out.data();
+			zs.avail_out = out.size();
+
+			beast::error_code ec;
+			zo.write(zs, beast::zlib::Flush::sync, ec);
+
+			std::size_t n = zs.total_out;
+
+			// remove the flush marker "00 00 ff ff", the peer appends it again when inflating.
+			if (!ec && zs.avail_in == 0 && n >= 4)
+				n -= 4;
+			else
+				return impl_->frame;
+
+			return make_frame(std::string_view{ out.data(), n }, true, impl_->binary);
+		}
+
+	protected:
+		struct impl
+		{
+			bool                                 binary = false;
+
+			std::size_t                          header_size = 0;
+
+			beast::websocket::permessage_deflate deflate;
+
+			/// the FIN frame of the whole message, the payload follows the header.
+			std::string                          frame;
+
+			/// the frame with the compressed payload and the RSV1 bit.
+			std::string                          deflated;
+
+			std::once_flag                       deflated_once;
+		};
+
+		std::shared_ptr<impl> impl_;
+	};
+}
@@ -21,6 +21,7 @@
 #include <asio3/proxy/core.hpp>
 #include <asio3/proxy/error.hpp>
 
+#include <asio3/tcp/connect.hpp>
 #include <asio3/tcp/read.hpp>
 #include <asio3/tcp/write.hpp>
 
@@ -418,8 +419,9 @@ namespace boost::asio::socks5
 			else
 			{
 				connect_socket_t bnd_socket(asio::detail::get_lowest_executor(sock));
-				auto [ed, ep] = co_await asio::async_connect(
-					bnd_socket, eps, asio::default_tcp_connect_condition{}, asio::use_awaitable_executor(sock));
+				auto [ed, ep] = co_await asio::async_race_connect(
+					bnd_socket, eps, asio::tcp_connect_timeout, auth_cfg.connect_attempt_delay,
+					asio::default_tcp_socket_option_setter{}, asio::use_awaitable_executor(sock));
 
 				if (!ed)
 				{
@@ -116,6 +116,10 @@ namespace boost::asio::socks5
 		auth_method_vector supported_method{};
 
 		std::function<asio::awaitable<bool>(handshake_info&)> on_auth{};
+
+		// the delay between the connection attempts to the resolved addresses of the connect
+		// command, the attempts are raced with the happy eyeballs algorithm, see RFC 8305.
+		std::chrono::steady_clock::duration connect_attempt_delay = asio::tcp_connection_attempt_delay;
 	};
 
 	namespace
@@ -18,9 +18,12 @@
 #include <asio3/core/stdutil.hpp>
 #include <asio3/core/netutil.hpp>
 #include <asio3/core/match_condition.hpp>
+#include <asio3/core/timer.hpp>
 
 #include <asio3/rpc/serialization.hpp>
 #include <asio3/rpc/message.hpp>
+#include <asio3/rpc/detail/pending_table.hpp>
+#include <asio3/rpc/detail/deadline_wheel.hpp>
 
 #ifdef ASIO_STANDALONE
 namespace asio::rpc
@@ -32,6 +35,10 @@ namespace boost::asio::rpc
 	{
 		std::chrono::steady_clock::duration timeout = asio::http_request_timeout;
 		bool requires_response = true;
+
+		/// send the method id instead of the method name, the server which uses the
+		/// rpc::invoker accepts both of them.
+		bool use_method_id = false;
 	};
 
 	template<typename SerializerT, typename DeserializerT>
@@ -40,85 +47,161 @@ namespace boost::asio::rpc
 	public:
 		using serializer_type   = SerializerT;
 		using deserializer_type = DeserializerT;
+		using id_type           = rpc::header::id_type;
 
 	protected:
-		using lock_type = asio::experimental::channel<
-			void(asio::error_code, serializer_type*, deserializer_type*, std::string_view)>;
+		using parse_function = void(*)(deserializer_type&, asio::error_code&, void*);
 
-		template<typename ReturnT, typename Self, typename ...Args>
-		requires (std::is_void_v<ReturnT>)
-		asio::awaitable<std::tuple<asio::error_code>> async_call_impl(
-			this Self&& self, request_option opt, std::string name, Args&&... args)
+		struct pending_call
 		{
-			auto id = opt.requires_response ? self.id_generator.next() : self.id_generator.zero();
-			auto req = rpc::request<Args...>{ id, std::move(name), std::forward<Args>(args)... };
+			// the completion handler of the waiting caller, it's empty while the request is sending.
+			asio::any_completion_handler<void(asio::error_code)> handler;
+
+			// parse the response into the result variable of the waiting caller.
+			parse_function parse = nullptr;
+			void*          result = nullptr;
+
+			// the request id is reused after it wraps around, the deadline of an old call
+			// only times out the call which has the same generation.
+			std::uint64_t  generation = 0;
+
+			asio::error_code ec{};
+			bool             done = false;
+		};
+
+		struct call_deadline
+		{
+			id_type       id;
+			std::uint64_t generation;
+		};
+
+		/// the request data and the length head, the head is written into the front
+		/// reserved bytes, so the whole frame can be sent by one buffer.
+		struct call_frame
+		{
+			std::string data;
+			std::size_t offset = 0;
+
+			inline asio::const_buffer buffer() const noexcept
+			{
+				return asio::buffer(data.data() + offset, data.size() - offset);
+			}
+		};
+
+		template<typename ReturnT>
+		static void parse_response(deserializer_type& dr, asio::error_code& ec, void* result)
+		{
+			// the response is parsed in place from the read buffer which is consumed after
+			// the parsing, so the result can't be a view into it.
+			static_assert(!asio::is_template_instance_of<std::basic_string_view, ReturnT>,
+				"the return type of the rpc call can't be std::string_view, use std::string instead");
+
+			// the views which are nested in the result are rejected when they are loaded.
+			if constexpr (requires { dr.allow_views(false); })
+				dr.allow_views(false);
+
+			std::defer restore_views = [&dr]() mutable
+			{
+				if constexpr (requires { dr.allow_views(true); })
+					dr.allow_views(true);
+			};
+
+		#if !defined(ASIO_NO_EXCEPTIONS) && !defined(BOOST_ASIO_NO_EXCEPTIONS)
+			try
+			{
+		#endif
+				dr >> ec;
+				if constexpr (!std::is_void_v<ReturnT>)
+				{
+					if (!ec)
+						dr >> *static_cast<ReturnT*>(result);
+				}
+		#if !defined(ASIO_NO_EXCEPTIONS) && !defined(BOOST_ASIO_NO_EXCEPTIONS)
+			}
+			catch (cereal::exception const&)
+			{
+				ec = rpc::make_error_code(rpc::error::parse_error);
+			}
+		#endif
+		}
 
+		template<typename Self, typename Request>
+		asio::awaitable<asio::error_code> async_call_core(this Self&& self,
+			request_option opt, Request& req, parse_function parse, void* result)
+		{
 			co_await asio::dispatch(asio::use_awaitable_executor(self));
 
+			// the id maybe wrapped around while a call of the same id is still pending, skip it.
 			if (opt.requires_response)
 			{
-				std::defer auto_remove_from_map = [&self, id]() mutable
-				{
-					self.pending_requests.erase(id);
-				};
+				while (self.pending_requests.find(req.id))
+					req.id = self.id_generator.next();
+			}
 
-				bool notifyed = false;
-				asio::error_code ec{};
-				asio::timer timer(self.get_executor());
+			// the serializer is shared by all the calls, so the data must be moved out of it
+			// before the send, otherwise the next call will overwrite it while it's queued.
+			call_frame frame = self.make_call_frame(self.serializer, req);
 
-				std::function<void()> callback = [&self, &notifyed, &ec, &timer]() mutable
-				{
-					asio::cancel_timer(timer);
-
-					notifyed = true;
-
-				#if !defined(ASIO_NO_EXCEPTIONS) && !defined(BOOST_ASIO_NO_EXCEPTIONS)
-					try
-					{
-				#endif
-						self.deserializer >> ec;
-				#if !defined(ASIO_NO_EXCEPTIONS) && !defined(BOOST_ASIO_NO_EXCEPTIONS)
-					}
-					catch (cereal::exception const&)
-					{
-						ec = rpc::make_error_code(rpc::error::parse_error);
-					}
-				#endif
-				};
-
-				self.pending_requests.emplace(id, std::move(callback));
-
-				auto& data = (self.serializer.reset() << req).str();
-				std::string head = asio::length_payload_match_condition::generate_length(asio::buffer(data));
-				std::array<asio::const_buffer, 2> buffers
-				{
-					asio::buffer(head),
-					asio::buffer(data),
-				};
-				auto [e1, n1] = co_await self.async_send(buffers, asio::use_awaitable_executor(self));
-				if (e1)
-					co_return std::tuple{ e1 };
-
-				timer.expires_after(opt.timeout);
-				auto [e0] = co_await timer.async_wait(asio::use_awaitable_executor(timer));
-
-				if (notifyed)
-					co_return std::tuple{ ec };
-				else
-					co_return std::tuple{ rpc::make_error_code(rpc::error::timed_out) };
+			std::defer auto_recycle_frame = [&self, &frame]() mutable
+			{
+				self.recycle_call_frame(std::move(frame));
+			};
+
+			if (!opt.requires_response)
+			{
+				auto [e1, n1] = co_await self.async_send(frame.buffer(), asio::use_awaitable_executor(self));
+				co_return e1;
 			}
-			else
+
+			id_type id = req.id;
+
+			std::uint64_t generation = ++self.call_generation;
+
+			self.pending_requests.emplace(id, pending_call{ {}, parse, result, generation });
+
+			self.add_call_deadline(call_deadline{ id, generation }, opt.timeout, self.get_executor());
+
+			auto [e1, n1] = co_await self.async_send(frame.buffer(), asio::use_awaitable_executor(self));
+			if (e1)
 			{
-				auto& data = (self.serializer.reset() << req).str();
-				std::string head = asio::length_payload_match_condition::generate_length(asio::buffer(data));
-				std::array<asio::const_buffer, 2> buffers
-				{
-					asio::buffer(head),
-					asio::buffer(data),
-				};
-				auto [e1, n1] = co_await self.async_send(buffers, asio::use_awaitable_executor(self));
-				co_return std::tuple{ e1 };
+				self.pending_requests.erase(id);
+				co_return e1;
 			}
+
+			// the response may be arrived or timed out already while the request is sending.
+			auto token = asio::use_awaitable_executor(self);
+
+			auto [e2] = co_await asio::async_initiate<decltype(token), void(asio::error_code)>(
+				[&self, id](auto handler) mutable
+				{
+					pending_call* call = self.pending_requests.find(id);
+
+					assert(call);
+
+					call->handler = std::move(handler);
+
+					if (call->done)
+						self.complete_call(id, self.get_executor());
+				}, token);
+
+			co_return e2;
+		}
+
+		template<typename ReturnT, typename Self, typename ...Args>
+		requires (std::is_void_v<ReturnT>)
+		asio::awaitable<std::tuple<asio::error_code>> async_call_impl(
+			this Self&& self, request_option opt, std::string name, Args&&... args)
+		{
+			auto id = opt.requires_response ? self.id_generator.next() : self.id_generator.zero();
+			auto req = rpc::request<Args...>{ id, std::move(name), std::forward<Args>(args)... };
+
+			if (opt.use_method_id)
+				req.use_method_id();
+
+			auto ec = co_await self.async_call_core(
+				std::move(opt), req, &basic_async_caller::parse_response<ReturnT>, nullptr);
+
+			co_return std::tuple{ ec };
 		}
 
 		template<typename ReturnT, typename Self, typename ...Args>
@@ -131,74 +214,129 @@ namespace boost::asio::rpc
 			auto id = opt.requires_response ? self.id_generator.next() : self.id_generator.zero();
 			auto req = rpc::request<Args...>{ id, std::move(name), std::forward<Args>(args)... };
 
-			co_await asio::dispatch(asio::use_awaitable_executor(self));
+			if (opt.use_method_id)
+				req.use_method_id();
 
-			if (opt.requires_response)
+			auto ec = co_await self.async_call_core(
+				std::move(opt), req, &basic_async_caller::parse_response<ReturnT>, std::addressof(result));
+
+			co_return std::tuple{ ec, std::move(result) };
+		}
+
+		template<typename Request>
+		inline call_frame make_call_frame(serializer_type& sr, const Request& req)
+		{
+			constexpr std::size_t head_room = asio::length_payload_match_condition::max_length_size;
+
+			call_frame frame{};
+
+			if (!free_frames.empty())
 			{
-				std::defer auto_remove_from_map = [&self, id]() mutable
-				{
-					self.pending_requests.erase(id);
-				};
+				frame.data = std::move(free_frames.back());
+				free_frames.pop_back();
+			}
 
-				bool notifyed = false;
-				asio::error_code ec{};
-				asio::timer timer(self.get_executor());
+			sr.swap(frame.data);
+			sr.reset(head_room) << req;
+			sr.swap(frame.data);
 
-				std::function<void()> callback = [&self, &notifyed, &ec, &timer, &result]() mutable
-				{
-					asio::cancel_timer(timer);
-
-					notifyed = true;
-
-				#if !defined(ASIO_NO_EXCEPTIONS) && !defined(BOOST_ASIO_NO_EXCEPTIONS)
-					try
-					{
-				#endif
-						self.deserializer >> ec;
-						if (!ec)
-							self.deserializer >> result;
-				#if !defined(ASIO_NO_EXCEPTIONS) && !defined(BOOST_ASIO_NO_EXCEPTIONS)
-					}
-					catch (cereal::exception const&)
-					{
-						ec = rpc::make_error_code(rpc::error::parse_error);
-					}
-				#endif
-				};
-
-				self.pending_requests.emplace(id, std::move(callback));
-
-				auto& data = (self.serializer.reset() << req).str();
-				std::string head = asio::length_payload_match_condition::generate_length(asio::buffer(data));
-				std::array<asio::const_buffer, 2> buffers
-				{
-					asio::buffer(head),
-					asio::buffer(data),
-				};
-				auto [e1, n1] = co_await self.async_send(buffers, asio::use_awaitable_executor(self));
-				if (e1)
-					co_return std::tuple{ e1, std::move(result) };
-
-				timer.expires_after(opt.timeout);
-				auto [e0] = co_await timer.async_wait(asio::use_awaitable_executor(timer));
-
-				if (notifyed)
-					co_return std::tuple{ ec, std::move(result) };
-				else
-					co_return std::tuple{ rpc::make_error_code(rpc::error::timed_out), std::move(result) };
+			char head[head_room];
+			std::size_t n = asio::length_payload_match_condition::generate_length(
+				frame.data.size() - head_room, head);
+
+			frame.offset = head_room - n;
+
+			std::memcpy(frame.data.data() + frame.offset, head, n);
+
+			return frame;
+		}
+
+		inline void recycle_call_frame(call_frame&& frame)
+		{
+			// don't keep the large buffers.
+			if (free_frames.size() < 64 && frame.data.capacity() <= 64 * 1024)
+			{
+				frame.data.clear();
+				free_frames.emplace_back(std::move(frame.data));
 			}
-			else
+		}
+
+		inline void complete_call(id_type id, const auto& ex)
+		{
+			pending_call* call = pending_requests.find(id);
+
+			assert(call && call->done && call->handler);
+
+			auto handler = std::move(call->handler);
+			auto ec = call->ec;
+
+			pending_requests.erase(id);
+
+			asio::post(ex, asio::append(std::move(handler), ec));
+		}
+
+		inline void add_call_deadline(call_deadline deadline, std::chrono::steady_clock::duration timeout, const auto& ex)
+		{
+			std::chrono::steady_clock::time_point expiry = call_deadlines.add(deadline, timeout);
+
+			if (!call_timer)
+				call_timer = std::make_shared<asio::timer>(ex);
+
+			if (!call_owner)
+				call_owner = std::make_shared<basic_async_caller*>(this);
+
+			if (!call_timer_running)
 			{
-				auto& data = (self.serializer.reset() << req).str();
-				std::string head = asio::length_payload_match_condition::generate_length(asio::buffer(data));
-				std::array<asio::const_buffer, 2> buffers
-				{
-					asio::buffer(head),
-					asio::buffer(data),
-				};
-				auto [e1, n1] = co_await self.async_send(buffers, asio::use_awaitable_executor(self));
-				co_return std::tuple{ e1, std::move(result) };
+				call_timer_running = true;
+				start_call_timer();
 			}
+			// the timer is waiting for a later deadline, the waiting is aborted by the rearming.
+			else if (expiry < call_timer_expiry)
+			{
+				start_call_timer();
+			}
+		}
+
+		inline void start_call_timer()
+		{
+			// the timer is only waked at the earliest deadline, not at every tick.
+			call_timer_expiry = call_deadlines.next_expiry();
+			call_timer->expires_at(call_timer_expiry);
+			// the caller maybe moved while the timer is waiting, so the handler finds the
+			// caller by the owner pointer which is updated by the move operations.
+			call_timer->async_wait([owner = call_owner, t = call_timer](const asio::error_code& ec) mutable
+			{
+				// the caller maybe destroyed already.
+				if (ec || t->canceled())
+					return;
+
+				basic_async_caller& self = **owner;
+
+				self.call_deadlines.advance([&self, &t](call_deadline deadline) mutable
+				{
+					pending_call* call = self.pending_requests.find(deadline.id);
+					if (!call || call->done || call->generation != deadline.generation)
+						return;
+
+					call->ec = rpc::make_error_code(rpc::error::timed_out);
+					call->done = true;
+
+					if (call->handler)
+						self.complete_call(deadline.id, t->get_executor());
+				});
+
+				// the remaining deadlines are all belongs to the completed calls.
+				if (self.pending_requests.empty())
+					self.call_deadlines.clear();
+
+				if (self.call_deadlines.empty())
+				{
+					self.call_timer_running = false;
+					return;
+				}
+
+				self.start_call_timer();
+			});
 		}
 
 		template<typename derive_t>
@@ -290,17 +428,89 @@ namespace boost::asio::rpc
 		inline asio::awaitable<asio::error_code> async_notify(this Self&& self,
 			serializer_type& sr, deserializer_type& dr, rpc::header head, auto&& data)
 		{
-			if (auto it = self.pending_requests.find(head.id); it != self.pending_requests.end())
-			{
-				std::function<void()>& cb = it->second;
-				cb();
-				co_return rpc::make_error_code(rpc::error::success);
-			}
-			co_return rpc::make_error_code(rpc::error::invalid_request);
+			pending_call* call = self.pending_requests.find(head.id);
+
+			// the call maybe timed out already.
+			if (!call || call->done)
+				co_return rpc::make_error_code(rpc::error::invalid_request);
+
+			call->parse(dr, call->ec, call->result);
+			call->done = true;
+
+			if (call->handler)
+				self.complete_call(head.id, self.get_executor());
+
+			co_return rpc::make_error_code(rpc::error::success);
 		}
 
 	public:
-		std::map<rpc::header::id_type, std::function<void()>> pending_requests;
+		basic_async_caller() = default;
+
+		basic_async_caller(basic_async_caller&& o) noexcept
+			: pending_requests  (std::move(o.pending_requests))
+			, call_deadlines    (std::move(o.call_deadlines))
+			, call_timer        (std::move(o.call_timer))
+			, call_owner        (std::move(o.call_owner))
+			, call_timer_running(std::exchange(o.call_timer_running, false))
+			, call_timer_expiry (o.call_timer_expiry)
+			, call_generation   (o.call_generation)
+			, free_frames       (std::move(o.free_frames))
+		{
+			if (call_owner)
+				*call_owner = this;
+		}
+
+		basic_async_caller& operator=(basic_async_caller&& o) noexcept
+		{
+			if (this == std::addressof(o))
+				return *this;
+
+			if (call_timer)
+				asio::cancel_timer(*call_timer);
+
+			pending_requests   = std::move(o.pending_requests);
+			call_deadlines     = std::move(o.call_deadlines);
+			call_timer         = std::move(o.call_timer);
+			call_owner         = std::move(o.call_owner);
+			call_timer_running = std::exchange(o.call_timer_running, false);
+			call_timer_expiry  = o.call_timer_expiry;
+			call_generation    = o.call_generation;
+			free_frames        = std::move(o.free_frames);
+
+			if (call_owner)
+				*call_owner = this;
+
+			return *this;
+		}
+
+		~basic_async_caller()
+		{
+			if (call_timer)
+				asio::cancel_timer(*call_timer);
+		}
+
+	public:
+		/// the calls which are waiting for the responses, indexed by the request id.
+		rpc::detail::pending_table<id_type, pending_call> pending_requests;
+
+		/// the deadlines of all the pending calls, driven by the call_timer.
+		rpc::detail::deadline_wheel<call_deadline>        call_deadlines;
+
+		std::shared_ptr<asio::timer>                      call_timer;
+
+		/// points to this caller, the timer handler uses it instead of the this pointer.
+		std::shared_ptr<basic_async_caller*>              call_owner;
+
+		bool                                              call_timer_running = false;
+
+		/// the time point which the call_timer is waiting for.
+		std::chrono::steady_clock::time_point             call_timer_expiry{};
+
+		/// increased for every call which requires response.
+		std::uint64_t                                     call_generation = 0;
+
+		/// the recycled buffers of the call frames.
+		std::vector<std::string>                          free_frames;
 	};
 
 	using async_caller = basic_async_caller<rpc::serializer, rpc::deserializer>;
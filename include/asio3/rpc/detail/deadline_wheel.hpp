@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#ifdef ASIO_STANDALONE
+namespace asio::rpc::detail
+#else
+namespace boost::asio::rpc::detail
+#endif
+{
+	/**
+	 * @brief A hashed timing wheel which holds the deadlines of the pending rpc calls of one
+	 * connection, so all the calls share one timer instead of creating a timer for each call.
+	 * The deadline is rounded up to the tick, adding a deadline is O(1), and every tick only
+	 * visits the deadlines of one slot. The deadlines are not removed when the calls are
+	 * completed, they are skipped when they expire. The timer only needs to be waked at the
+	 * next_expiry, the empty ticks before it are skipped by the advance.
+	 * This class is not thread safety.
+	 */
+	template<typename Key>
+	class deadline_wheel
+	{
+	public:
+		using clock_type = std::chrono::steady_clock;
+		using duration   = clock_type::duration;
+
+	protected:
+		struct item
+		{
+			Key           key;
+			std::uint64_t expiry;
+		};
+
+	public:
+		explicit deadline_wheel(
+			duration tick = std::chrono::milliseconds(10), std::size_t slot_count = 512)
+			: tick_(tick > duration::zero() ? tick : std::chrono::milliseconds(10))
+		{
+			std::size_t n = 1;
+			while (n < slot_count)
+				n <<= 1;
+
+			slots_.resize(n);
+			mask_ = n - 1;
+		}
+
+		deadline_wheel(deadline_wheel&&) noexcept = default;
+		deadline_wheel& operator=(deadline_wheel&&) noexcept = default;
+
+		/**
+		 * @brief Add a deadline which is expired after the timeout.
+		 * @return The time point of the tick which the deadline is expired at.
+		 */
+		inline clock_type::time_point add(Key key, duration timeout)
+		{
+			if (size_ == 0)
+			{
+				start_ = clock_type::now();
+				current_ = 0;
+			}
+
+			std::uint64_t elapsed = static_cast<std::uint64_t>((clock_type::now() - start_) / tick_);
+			std::uint64_t ticks   = static_cast<std::uint64_t>((timeout + tick_ - duration(1)) / tick_);
+			std::uint64_t expiry  = (std::max)(elapsed + (std::max)(ticks, std::uint64_t(1)), current_ + 1);
+
+			slots_[expiry & mask_].emplace_back(key, expiry);
+
+			++size_;
+
+			return time_of(expiry);
+		}
+
+		/**
+		 * @brief Advance the wheel to the current time, and call the function for every
+		 * expired deadline.
+		 */
+		template<typename Function>
+		inline void advance(Function&& f)
+		{
+			std::uint64_t target = static_cast<std::uint64_t>((clock_type::now() - start_) / tick_);
+
+			while (current_ < target && size_ > 0)
+			{
+				++current_;
+
+				std::vector<item>& slot = slots_[current_ & mask_];
+
+				for (std::size_t i = 0; i < slot.size();)
+				{
+					if (slot[i].expiry <= current_)
+					{
+						Key key = slot[i].key;
+
+						slot[i] = slot.back();
+						slot.pop_back();
+
+						--size_;
+
+						f(key);
+					}
+					else
+					{
+						++i;
+					}
+				}
+			}
+		}
+
+		/**
+		 * @brief Get the time point of the next tick.
+		 */
+		[[nodiscard]] inline clock_type::time_point next_tick() const noexcept
+		{
+			return time_of(current_ + 1);
+		}
+
+		/**
+		 * @brief Get the time point of the tick which the earliest deadline is expired at,
+		 * return time_point::max() if there is no deadline.
+		 */
+		[[nodiscard]] inline clock_type::time_point next_expiry() const noexcept
+		{
+			if (size_ == 0)
+				return clock_type::time_point::max();
+
+			// the slots of one round are visited in order, the deadlines of the later rounds
+			// are in the same slots, so they are skipped by the expiry.
+			for (std::uint64_t expiry = current_ + 1; expiry <= current_ + slots_.size(); ++expiry)
+			{
+				for (const item& i : slots_[expiry & mask_])
+				{
+					if (i.expiry == expiry)
+						return time_of(expiry);
+				}
+			}
+
+			// all the deadlines are after one round, this is rare.
+			std::uint64_t earliest = (std::numeric_limits<std::uint64_t>::max)();
+
+			for (const std::vector<item>& slot : slots_)
+			{
+				for (const item& i : slot)
+				{
+					earliest = (std::min)(earliest, i.expiry);
+				}
+			}
+
+			return time_of(earliest);
+		}
+
+		[[nodiscard]] inline duration    tick () const noexcept { return tick_; }
+		[[nodiscard]] inline std::size_t size () const noexcept { return size_; }
+		[[nodiscard]] inline bool        empty() const noexcept { return size_ == 0; }
+
+		inline void clear() noexcept
+		{
+			for (std::vector<item>& slot : slots_)
+			{
+				slot.clear();
+			}
+			size_ = 0;
+		}
+
+	protected:
+		inline clock_type::time_point time_of(std::uint64_t expiry) const noexcept
+		{
+			return start_ + tick_ * static_cast<duration::rep>(expiry);
+		}
+
+	protected:
+		std::vector<std::vector<item>> slots_;
+
+		std::size_t                    mask_ = 0;
+
+		duration                       tick_;
+
+		clock_type::time_point         start_{};
+
+		std::uint64_t                  current_ = 0;
+
+		std::size_t                    size_ = 0;
+	};
+}
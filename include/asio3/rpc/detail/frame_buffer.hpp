@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+#include <asio3/core/asio.hpp>
+
+#ifdef ASIO_STANDALONE
+namespace asio::rpc::detail
+#else
+namespace boost::asio::rpc::detail
+#endif
+{
+	/**
+	 * @brief The receive buffer of a rpc connection.
+	 * The consumed frames are skipped by advancing the begin offset, and the offsets are reset
+	 * to zero when all the data is consumed, so the data is never moved in the common case.
+	 * Only when the tail space is exhausted, the remaining bytes of the last incomplete frame
+	 * are moved to the front.
+	 * This class is not thread safety.
+	 */
+	class frame_buffer
+	{
+	public:
+		explicit frame_buffer(std::size_t capacity = 64 * 1024)
+			: data_(std::make_unique_for_overwrite<char[]>((std::max)(capacity, std::size_t(1))))
+			, capacity_((std::max)(capacity, std::size_t(1)))
+		{
+		}
+
+		frame_buffer(frame_buffer&&) noexcept = default;
+		frame_buffer& operator=(frame_buffer&&) noexcept = default;
+
+		/**
+		 * @brief Get the free tail space which has at least min_size bytes.
+		 */
+		inline asio::mutable_buffer prepare(std::size_t min_size)
+		{
+			if (capacity_ - end_ < min_size)
+			{
+				if (begin_ > 0)
+				{
+					std::memmove(data_.get(), data_.get() + begin_, end_ - begin_);
+					end_ -= begin_;
+					begin_ = 0;
+				}
+
+				if (capacity_ - end_ < min_size)
+				{
+					std::size_t capacity = (std::max)(capacity_ * 2, end_ + min_size);
+
+					auto data = std::make_unique_for_overwrite<char[]>(capacity);
+					std::memcpy(data.get(), data_.get(), end_);
+
+					data_ = std::move(data);
+					capacity_ = capacity;
+				}
+			}
+
+			return asio::buffer(data_.get() + end_, capacity_ - end_);
+		}
+
+		/**
+		 * @brief Move the received bytes from the tail space to the readable data.
+		 */
+		inline void commit(std::size_t n) noexcept
+		{
+			end_ += (std::min)(n, capacity_ - end_);
+		}
+
+		/**
+		 * @brief Remove the bytes from the front of the readable data.
+		 */
+		inline void consume(std::size_t n) noexcept
+		{
+			begin_ += (std::min)(n, end_ - begin_);
+
+			if (begin_ == end_)
+			{
+				begin_ = 0;
+				end_ = 0;
+			}
+		}
+
+		/**
+		 * @brief Get the readable data.
+		 */
+		[[nodiscard]] inline std::string_view data() const noexcept
+		{
+			return std::string_view(data_.get() + begin_, end_ - begin_);
+		}
+
+		[[nodiscard]] inline std::size_t size    () const noexcept { return end_ - begin_; }
+		[[nodiscard]] inline std::size_t capacity() const noexcept { return capacity_; }
+
+	protected:
+		std::unique_ptr<char[]> data_;
+
+		std::size_t             capacity_ = 0;
+
+		std::size_t             begin_ = 0;
+
+		std::size_t             end_ = 0;
+	};
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#ifdef ASIO_STANDALONE
+namespace asio::rpc::detail
+#else
+namespace boost::asio::rpc::detail
+#endif
+{
+	/**
+	 * @brief A flat open addressing hash table for the pending rpc calls and the method ids.
+	 * The keys are the increasing request ids or the hashed method names, the fibonacci
+	 * hashing spreads them evenly and the linear probing sequences are very short. The erased slots are
+	 * filled by backward shifting, so there is no tombstone.
+	 * This class is not thread safety.
+	 */
+	template<std::unsigned_integral Key, typename Value>
+	class pending_table
+	{
+	protected:
+		struct slot
+		{
+			Key   key{};
+			bool  used = false;
+			Value value{};
+		};
+
+	public:
+		using key_type   = Key;
+		using value_type = Value;
+
+		explicit pending_table(std::size_t capacity = 64)
+		{
+			std::size_t n = 8;
+			while (n < capacity)
+				n <<= 1;
+			rehash(n);
+		}
+
+		pending_table(pending_table&&) noexcept = default;
+		pending_table& operator=(pending_table&&) noexcept = default;
+
+		/**
+		 * @brief Find the value by key, return nullptr if not found.
+		 */
+		[[nodiscard]] inline Value* find(Key key) noexcept
+		{
+			for (std::size_t i = index_of(key); slots_[i].used; i = (i + 1) & mask_)
+			{
+				if (slots_[i].key == key)
+					return std::addressof(slots_[i].value);
+			}
+			return nullptr;
+		}
+
+		/**
+		 * @brief Insert a value, the key must not exist already, the caller must check it by find.
+		 * @return The reference of the inserted value, it's invalidated by the next
+		 * insertion or erasure.
+		 */
+		inline Value& emplace(Key key, Value value)
+		{
+			assert(find(key) == nullptr);
+
+			// keep the load factor below 1/2.
+			if ((size_ + 1) * 2 > slots_.size())
+				rehash(slots_.size() * 2);
+
+			std::size_t i = index_of(key);
+			while (slots_[i].used)
+				i = (i + 1) & mask_;
+
+			slots_[i].key   = key;
+			slots_[i].used  = true;
+			slots_[i].value = std::move(value);
+
+			++size_;
+
+			return slots_[i].value;
+		}
+
+		/**
+		 * @brief Erase the value by key, return false if not found.
+		 */
+		inline bool erase(Key key) noexcept
+		{
+			std::size_t i = index_of(key);
+
+			for (; slots_[i].used; i = (i + 1) & mask_)
+			{
+				if (slots_[i].key == key)
+					break;
+			}
+
+			if (!slots_[i].used)
+				return false;
+
+			// shift the following entries of the probing sequence backward.
+			for (std::size_t j = (i + 1) & mask_; slots_[j].used; j = (j + 1) & mask_)
+			{
+				std::size_t home = index_of(slots_[j].key);
+
+				// the entry j can be moved to i only if its home isn't in (i, j].
+				if (((j - home) & mask_) >= ((j - i) & mask_))
+				{
+					slots_[i].key   = slots_[j].key;
+					slots_[i].value = std::move(slots_[j].value);
+					i = j;
+				}
+			}
+
+			slots_[i].used  = false;
+			slots_[i].value = Value{};
+
+			--size_;
+
+			return true;
+		}
+
+		/**
+		 * @brief Call the function for each value, the table must not be modified in the function.
+		 */
+		template<typename Function>
+		inline void for_each(Function&& f)
+		{
+			for (slot& s : slots_)
+			{
+				if (s.used)
+					f(s.key, s.value);
+			}
+		}
+
+		[[nodiscard]] inline std::size_t size () const noexcept { return size_; }
+		[[nodiscard]] inline bool        empty() const noexcept { return size_ == 0; }
+
+		inline void clear() noexcept
+		{
+			for (slot& s : slots_)
+			{
+				s.used  = false;
+				s.value = Value{};
+			}
+			size_ = 0;
+		}
+
+	protected:
+		inline std::size_t index_of(Key key) const noexcept
+		{
+			return static_cast<std::size_t>(
+				(static_cast<std::uint64_t>(key) * 11400714819323198485ull) >> shift_) & mask_;
+		}
+
+		void rehash(std::size_t n)
+		{
+			std::vector<slot> old = std::move(slots_);
+
+			slots_.clear();
+			slots_.resize(n);
+			mask_ = n - 1;
+
+			shift_ = 64;
+			for (std::size_t m = n; m > 1; m >>= 1)
+				--shift_;
+
+			size_ = 0;
+
+			for (slot& s : old)
+			{
+				if (s.used)
+					emplace(s.key, std::move(s.value));
+			}
+		}
+
+	protected:
+		std::vector<slot> slots_;
+
+		std::size_t       mask_ = 0;
+
+		unsigned int      shift_ = 64;
+
+		std::size_t       size_ = 0;
+	};
+}
@@ -30,8 +30,10 @@
 
 #include <cereal/cereal.hpp>
 
-#include <sstream>
+#include <cstring>
 #include <limits>
+#include <string>
+#include <string_view>
 
 namespace cereal
 {
@@ -59,17 +61,18 @@ namespace cereal
 
   // ######################################################################
   //! An output archive designed to save data in a compact binary representation portable over different architectures
-  /*! This archive outputs data to a stream in an extremely compact binary
+  /*! This archive appends data to a string in an extremely compact binary
       representation with as little extra metadata as possible.
 
+      The data is written into the string directly instead of through a std::ostream,
+      so no virtual streambuf call is made for each field. The string is provided by
+      the caller, so it can be reused by the next message, and the caller can reserve
+      some bytes at the front of it for the length head before saving.
+
       This archive will record the endianness of the data as well as the desired in/out endianness
       and assuming that the user takes care of ensuring serialized types are the same size
       across machines, is portable over different architectures.
 
-      When using a binary archive and a file stream, you must use the
-      std::ios::binary format flag to avoid having your data altered
-      inadvertently.
-
       \warning This archive has not been thoroughly tested across different architectures.
                Please report any issues, optimizations, or feature requests at
                <a href="www.github.com/USCiLab/cereal">the project github</a>.
@@ -120,13 +123,13 @@ namespace cereal
         return (*this);
       }
 
-      //! Construct, outputting to the provided stream
-      /*! @param stream The stream to output to. Should be opened with std::ios::binary flag.
+      //! Construct, appending to the provided string
+      /*! @param buffer The string to append to, it must outlive the archive.
           @param options The PortableBinary specific options to use.  See the Options struct
                          for the values of default parameters */
-      ReusablePortableBinaryOutputArchive(std::ostream & stream, Options const & options = Options::Default()) :
+      ReusablePortableBinaryOutputArchive(std::string & buffer, Options const & options = Options::Default()) :
         OutputArchive<ReusablePortableBinaryOutputArchive, AllowEmptyClassElision>(this),
-        itsStream(stream),
+        itsBuffer(buffer),
         itsConvertEndianness( reusable_portable_binary_detail::is_little_endian() ^ options.is_little_endian() )
       {
 		options_.itsOutputEndianness = options.itsOutputEndianness;
@@ -140,38 +143,50 @@ namespace cereal
 		return (*this);
       }
 
-      //! Writes size bytes of data to the output stream
+      //! Appends size bytes of data to the output string
       template <std::streamsize DataSize> inline
       void saveBinary( const void * data, std::streamsize size )
       {
-        std::streamsize writtenSize = 0;
+        std::size_t const pos = itsBuffer.size();
+        std::size_t const len = static_cast<std::size_t>( size );
+
+        // the new bytes are overwritten below, so don't fill them with zeros first.
+        // return the wanted size instead of the passed size, some libstdc++ versions pass
+        // the grown capacity to the operation.
+        itsBuffer.resize_and_overwrite( pos + len, [n = pos + len]( char *, std::size_t ) noexcept { return n; } );
+
+        char * dest = itsBuffer.data() + pos;
 
         if( itsConvertEndianness )
         {
-          for( std::streamsize i = 0; i < size; i += DataSize )
-            for( std::streamsize j = 0; j < DataSize; ++j )
-              writtenSize += itsStream.rdbuf()->sputn( reinterpret_cast<const char*>( data ) + DataSize - j - 1 + i, 1 );
+          for( std::size_t i = 0; i < len; i += DataSize )
+            for( std::size_t j = 0; j < DataSize; ++j )
+              dest[i + j] = reinterpret_cast<const char*>( data )[i + DataSize - j - 1];
         }
         else
-          writtenSize = itsStream.rdbuf()->sputn( reinterpret_cast<const char*>( data ), size );
-
-        if(writtenSize != size)
-          throw Exception("Failed to write " + std::to_string(size) + " bytes to output stream! Wrote " + std::to_string(writtenSize));
+          std::memcpy( dest, data, len );
       }
 
-	  inline std::ostream & stream() { return this->itsStream; }
+	  inline std::string & buffer() noexcept { return this->itsBuffer; }
+
+      //! Checks whether the data need to be swapped by the endianness
+      inline bool convert_endianness() const noexcept { return itsConvertEndianness; }
 
     private:
-      std::ostream & itsStream;
+      std::string & itsBuffer;
       const uint8_t itsConvertEndianness; //!< If set to true, we will need to swap bytes upon saving
 	  Options options_;
   };
 
   // ######################################################################
   //! An input archive designed to load data saved using ReusablePortableBinaryOutputArchive
-  /*! This archive outputs data to a stream in an extremely compact binary
+  /*! This archive loads data from a contiguous memory in an extremely compact binary
       representation with as little extra metadata as possible.
 
+      The data is read from the memory directly instead of through a std::istream, and
+      std::string_view can be loaded as a view into the memory without copying, so the
+      memory must be kept until the loaded string_view is no longer used.
+
       This archive will load the endianness of the serialized data and
       if necessary transform it to match that of the local machine.  This comes
       at a significant performance cost compared to non portable archives if
@@ -184,10 +199,6 @@ namespace cereal
       The archive will do nothing to ensure types are the same size - that is
       the responsibility of the user.
 
-      When using a binary archive and a file stream, you must use the
-      std::ios::binary format flag to avoid having your data altered
-      inadvertently.
-
       \warning This archive has not been thoroughly tested across different architectures.
                Please report any issues, optimizations, or feature requests at
                <a href="www.github.com/USCiLab/cereal">the project github</a>.
@@ -238,13 +249,13 @@ namespace cereal
         return (*this);
       }
 
-      //! Construct, loading from the provided stream
-      /*! @param stream The stream to read from. Should be opened with std::ios::binary flag.
+      //! Construct, loading from the provided memory
+      /*! @param data The memory to read from, it can be changed by reset later.
           @param options The PortableBinary specific options to use.  See the Options struct
                          for the values of default parameters */
-      ReusablePortableBinaryInputArchive(std::istream & stream, Options const & options = Options::Default()) :
+      ReusablePortableBinaryInputArchive(std::string_view data = {}, Options const & options = Options::Default()) :
         InputArchive<ReusablePortableBinaryInputArchive, AllowEmptyClassElision>(this),
-        itsStream(stream),
+        itsData(data),
         itsConvertEndianness( false )
       {
 		options_.itsInputEndianness = options.itsInputEndianness;
@@ -252,6 +263,13 @@ namespace cereal
 
       ~ReusablePortableBinaryInputArchive() CEREAL_NOEXCEPT = default;
 
+      //! Starts loading from another memory
+      ReusablePortableBinaryInputArchive& reset( std::string_view data ) noexcept
+      {
+        itsData = data;
+        return (*this);
+      }
+
       ReusablePortableBinaryInputArchive& load_endian()
       {
         uint8_t streamLittleEndian;
@@ -262,7 +280,7 @@ namespace cereal
 		return (*this);
       }
 
-      //! Reads size bytes of data from the input stream
+      //! Reads size bytes of data from the input data
       /*! @param data The data to save
           @param size The number of bytes in the data
           @tparam DataSize T The size of the actual type of the data elements being loaded */
@@ -270,10 +288,7 @@ namespace cereal
       void loadBinary( void * const data, std::streamsize size )
       {
         // load data
-        auto const readSize = itsStream.rdbuf()->sgetn( reinterpret_cast<char*>( data ), size );
-
-        if(readSize != size)
-          throw Exception("Failed to read " + std::to_string(size) + " bytes from input stream! Read " + std::to_string(readSize));
+        std::memcpy( data, loadView( size ).data(), static_cast<std::size_t>( size ) );
 
         // flip bits if needed
         if( itsConvertEndianness )
@@ -284,11 +299,36 @@ namespace cereal
         }
       }
 
-	  inline std::istream & stream() { return this->itsStream; }
+      //! Gets the view of the next size bytes and skips them
+      inline std::string_view loadView( std::streamsize size )
+      {
+        std::size_t const len = static_cast<std::size_t>( size );
+
+        if( size < 0 || len > itsData.size() )
+          throw Exception("Failed to read " + std::to_string(size) + " bytes from input data! Remaining " + std::to_string(itsData.size()));
+
+        std::string_view view = itsData.substr( 0, len );
+        itsData.remove_prefix( len );
+        return view;
+      }
+
+      //! Gets the bytes which are not loaded yet
+      inline std::size_t remaining() const noexcept { return itsData.size(); }
+
+      //! Sets whether std::string_view can be loaded, it must be false if the memory is
+      //! released before the loaded values are used.
+      inline void allow_views( bool allow ) noexcept { itsAllowViews = allow; }
+
+      //! Checks whether std::string_view can be loaded
+      inline bool allow_views() const noexcept { return itsAllowViews; }
+
+      //! Checks whether the data need to be swapped by the endianness
+      inline bool convert_endianness() const noexcept { return itsConvertEndianness; }
 
     private:
-      std::istream & itsStream;
+      std::string_view itsData;
       uint8_t itsConvertEndianness; //!< If set to true, we will need to swap bytes upon loading
+      bool itsAllowViews = true; //!< If set to false, loading std::string_view throws
 	  Options options_;
   };
 
@@ -357,6 +397,27 @@ namespace cereal
     ar.template loadBinary<sizeof(TT)>( bd.data, static_cast<std::streamsize>( bd.size ) );
   }
 
+  //! Saving std::basic_string_view to portable binary, it's compatible with std::basic_string
+  template <class CharT, class Traits> inline
+  void CEREAL_SAVE_FUNCTION_NAME(ReusablePortableBinaryOutputArchive & ar, std::basic_string_view<CharT, Traits> const & str)
+  {
+    ar( make_size_tag( static_cast<size_type>( str.size() ) ) );
+    ar( binary_data( str.data(), str.size() * sizeof(CharT) ) );
+  }
+
+  //! Loading std::string_view from portable binary, it's a view into the loaded data
+  template <class Traits> inline
+  void CEREAL_LOAD_FUNCTION_NAME(ReusablePortableBinaryInputArchive & ar, std::basic_string_view<char, Traits> & str)
+  {
+    if( !ar.allow_views() )
+      throw Exception("Failed to load std::string_view, the input data is not retained");
+
+    size_type size;
+    ar( make_size_tag( size ) );
+    std::string_view view = ar.loadView( static_cast<std::streamsize>( size ) );
+    str = std::basic_string_view<char, Traits>( view.data(), view.size() );
+  }
+
   // ######################################################################
   //! Epilogue for SizeTags for ReusablePortableBinary archives
   template <class T> inline
@@ -370,10 +431,7 @@ namespace cereal
   template <class T> inline
   void epilogue( ReusablePortableBinaryInputArchive & ar, SizeTag<T> const & sz)
   {
-	  std::streambuf* buff = ar.stream().rdbuf();
-	  std::streamsize need = std::streamsize(sz.size);
-	  std::streamsize have = buff ? buff->in_avail() : std::streamsize(0);
-	  if (need < 0 || need > have)
+	  if (sz.size > ar.remaining())
 		  throw Exception("Illegal data");
   }
 
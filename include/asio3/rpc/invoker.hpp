@@ -12,9 +12,11 @@
 
 #include <cstdint>
 #include <functional>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 
 #include <asio3/core/function_traits.hpp>
 #include <asio3/core/strutil.hpp>
@@ -23,6 +25,7 @@
 
 #include <asio3/rpc/serialization.hpp>
 #include <asio3/rpc/message.hpp>
+#include <asio3/rpc/detail/pending_table.hpp>
 
 #ifdef ASIO_STANDALONE
 namespace asio::rpc
@@ -54,25 +57,74 @@ namespace boost::asio::rpc
 		~basic_invoker() = default;
 
 	protected:
+		struct entry
+		{
+			std::string                    name;
+			rpc::method_id_type            id = 0;
+			std::shared_ptr<function_type> fn;
+		};
+
 		template<typename F>
 		inline void _bind(std::string name, F f)
 		{
-			this->invokers_[std::move(name)] = std::make_shared<function_type>(
-				std::bind_front(&self::template _proxy<F, dummy>, std::move(f), nullptr));
+			this->_add(std::move(name), std::make_shared<function_type>(
+				std::bind_front(&self::template _proxy<F, dummy>, std::move(f), nullptr)));
 		}
 
 		template<typename F, typename C>
 		inline void _bind(std::string name, F f, C& c)
 		{
-			this->invokers_[std::move(name)] = std::make_shared<function_type>(
-				std::bind_front(&self::template _proxy<F, C>, std::move(f), std::addressof(c)));
+			this->_add(std::move(name), std::make_shared<function_type>(
+				std::bind_front(&self::template _proxy<F, C>, std::move(f), std::addressof(c))));
 		}
 
 		template<typename F, typename C>
 		inline void _bind(std::string name, F f, C* c)
 		{
-			this->invokers_[std::move(name)] = std::make_shared<function_type>(
-				std::bind_front(&self::template _proxy<F, C>, std::move(f), c));
+			this->_add(std::move(name), std::make_shared<function_type>(
+				std::bind_front(&self::template _proxy<F, C>, std::move(f), c)));
+		}
+
+		inline void _add(std::string name, std::shared_ptr<function_type> fn)
+		{
+			if (auto it = this->names_.find(name); it != this->names_.end())
+			{
+				this->handlers_[it->second].fn = std::move(fn);
+				return;
+			}
+
+			rpc::method_id_type id = rpc::make_method_id(name);
+
+			// the caller which uses the method id can't tell the two methods apart,
+			// so the conflicted name is rejected in all builds.
+			if (this->ids_.find(id) != nullptr)
+			{
+				asio::detail::throw_exception(std::invalid_argument(
+					"the method id of \"" + name + "\" is conflicted with another method, rename the method"));
+				return;
+			}
+
+			std::size_t index = this->handlers_.size();
+
+			this->ids_.emplace(id, index);
+			this->names_.emplace(name, index);
+			this->handlers_.emplace_back(std::move(name), id, std::move(fn));
+		}
+
+		inline function_type* _find(const rpc::header& head) noexcept
+		{
+			if (head.has_method_id())
+			{
+				if (std::size_t* index = this->ids_.find(head.method_id))
+					return this->handlers_[*index].fn.get();
+			}
+			else
+			{
+				if (auto it = this->names_.find(head.method); it != this->names_.end())
+					return this->handlers_[it->second].fn.get();
+			}
+
+			return nullptr;
 		}
 
 		template<typename F, typename C, class... TS>
@@ -144,6 +196,8 @@ namespace boost::asio::rpc
 		 * @param obj - A pointer or reference to a class object, this parameter can be none.
 		 * if fun is nonmember function, the obj param must be none, otherwise the obj must be the
 		 * the class object's pointer or reference.
+		 * Throws std::invalid_argument if the method id of the name is conflicted with
+		 * the id of another binded function.
 		 */
 		template<typename F, typename ...C>
 		inline self& bind(std::string name, F&& fun, C&&... obj)
@@ -155,7 +209,7 @@ namespace boost::asio::rpc
 				return (*this);
 
 		#if !defined(NDEBUG)
-			assert(this->invokers_.find(name) == this->invokers_.end());
+			assert(this->names_.find(name) == this->names_.end());
 		#endif
 
 			this->_bind(std::move(name), std::forward<F>(fun), std::forward<C>(obj)...);
@@ -168,7 +222,29 @@ namespace boost::asio::rpc
 		 */
 		inline self& unbind(std::string const& name)
 		{
-			this->invokers_.erase(name);
+			auto it = this->names_.find(name);
+			if (it == this->names_.end())
+				return (*this);
+
+			std::size_t index = it->second;
+
+			this->names_.erase(it);
+
+			if (std::size_t* p = this->ids_.find(this->handlers_[index].id); p && *p == index)
+				this->ids_.erase(this->handlers_[index].id);
+
+			// move the last handler to the hole, so the handlers are always dense.
+			if (std::size_t last = this->handlers_.size() - 1; index != last)
+			{
+				this->handlers_[index] = std::move(this->handlers_[last]);
+
+				this->names_[this->handlers_[index].name] = index;
+
+				if (std::size_t* p = this->ids_.find(this->handlers_[index].id); p && *p == last)
+					*p = index;
+			}
+
+			this->handlers_.pop_back();
 
 			return (*this);
 		}
@@ -178,8 +254,19 @@ namespace boost::asio::rpc
 		 */
 		inline std::shared_ptr<function_type> find(std::string const& name)
 		{
-			if (auto it = this->invokers_.find(name); it != this->invokers_.end())
-				return it->second;
+			if (auto it = this->names_.find(name); it != this->names_.end())
+				return this->handlers_[it->second].fn;
+
+			return nullptr;
+		}
+
+		/**
+		 * @brief find binded rpc function by method id
+		 */
+		inline std::shared_ptr<function_type> find(rpc::method_id_type id)
+		{
+			if (std::size_t* index = this->ids_.find(id))
+				return this->handlers_[*index].fn;
 
 			return nullptr;
 		}
@@ -191,14 +278,14 @@ namespace boost::asio::rpc
 		inline asio::awaitable<std::tuple<asio::error_code, std::string>> invoke(
 			auto&& sr, auto&& dr, rpc::header head, auto&& data, TS&&... ts)
 		{
-			head.type = rpc::response_mark;
+			head.make_response();
 		#if !defined(ASIO_NO_EXCEPTIONS) && !defined(BOOST_ASIO_NO_EXCEPTIONS)
 			try
 			{
 		#endif
-				if (auto it = this->invokers_.find(head.method); it != this->invokers_.end())
+				if (function_type* fn = this->_find(head); fn)
 				{
-					std::string resp = co_await(*(it->second))(sr, dr, std::move(head), std::forward<TS>(ts)...);
+					std::string resp = co_await(*fn)(sr, dr, std::move(head), std::forward<TS>(ts)...);
 
 					co_return std::tuple{ asio::error_code{}, std::move(resp) };
 				}
@@ -232,7 +319,12 @@ namespace boost::asio::rpc
 		}
 
 	protected:
-		std::unordered_map<std::string, std::shared_ptr<function_type>> invokers_;
+		/// the binded functions, the name and the method id are both indexed into it.
+		std::vector<entry>                                         handlers_;
+
+		std::unordered_map<std::string, std::size_t>               names_;
+
+		rpc::detail::pending_table<rpc::method_id_type, std::size_t> ids_;
 	};
 
 	using invoker = basic_invoker<rpc::serializer, rpc::deserializer>;
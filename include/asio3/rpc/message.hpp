@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <tuple>
@@ -25,30 +26,18 @@ namespace boost::asio::rpc
 		template<class T>
 		struct parameter_traits_t
 		{
-			template<class T>
-			struct value_t
-			{
-				using type = T;
-			};
-			template<class... Ts>
-			struct value_t<std::basic_string_view<Ts...>>
-			{
-				using type = typename std::basic_string_view<Ts...>::value_type;
-			};
-
-			// if the parameters of rpc calling is raw pointer like char* , must convert it to std::string
-			// if the parameters of rpc calling is std::string_view , must convert it to std::string
+			// if the parameters of rpc calling is raw pointer like char* , must convert it to std::string_view
 			// if the parameters of rpc calling is reference like std::string& , must remove it's 
 			//   reference to std::string
+			// the std::string_view is kept as is, the request is serialized before the call is
+			//   returned, so the viewed string needn't be copied.
 			using ncvr_type = std::remove_cvref_t<T>;
 			using char_type = std::remove_cvref_t<
 				std::remove_all_extents_t<std::remove_pointer_t<ncvr_type>>>;
 			using type = std::conditional_t<
 				asio::is_char_pointer<ncvr_type> || asio::is_char_array<ncvr_type>
-				, std::basic_string<char_type>
-				, std::conditional_t<asio::is_template_instance_of<std::basic_string_view, ncvr_type>
-				, std::basic_string<typename value_t<ncvr_type>::type>
-				, ncvr_type>>;
+				, std::basic_string_view<char_type>
+				, ncvr_type>;
 		};
 	}
 
@@ -58,12 +47,39 @@ namespace boost::asio::rpc
 	 *
 	 * message type : q - request, p - response
 	 *
+	 * when the method id is used, the method name is replaced by the method id:
+	 *
+	 * request  : message type + request id + method id + parameters value...
+	 * response : message type + request id + method id + error code + result value
+	 *
+	 * message type : Q - request, P - response
+	 *
 	 * if result type is void, then result type will wrapped to std::int8_t
 	 */
 
 	static constexpr char request_mark  = 'q';
 	static constexpr char response_mark = 'p';
 
+	static constexpr char request_id_mark  = 'Q';
+	static constexpr char response_id_mark = 'P';
+
+	using method_id_type = std::uint32_t;
+
+	/**
+	 * @brief Get the method id of the method name, the id is the 32 bits FNV-1a hash of the
+	 * name, so the client and the server get the same id without negotiation.
+	 */
+	inline constexpr method_id_type make_method_id(std::string_view name) noexcept
+	{
+		method_id_type hash = 2166136261u;
+		for (char c : name)
+		{
+			hash ^= static_cast<method_id_type>(static_cast<unsigned char>(c));
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
 	struct header
 	{
 		using id_type = std::uint64_t;
@@ -73,25 +89,69 @@ namespace boost::asio::rpc
 			: type(type), id(id), method(std::move(method))
 		{
 		}
+		header(char type, id_type id, method_id_type method_id)
+			: type(type), id(id), method_id(method_id)
+		{
+		}
 
 		template <class Archive>
 		void save(Archive& ar) const
 		{
-			ar(type, id, method);
+			if (has_method_id())
+				ar(type, id, method_id);
+			else
+				ar(type, id, method);
 		}
 
 		template <class Archive>
 		void load(Archive& ar)
 		{
-			ar(type, id, method);
+			ar(type, id);
+
+			if (has_method_id())
+				ar(method_id);
+			else
+				ar(method);
+		}
+
+		inline constexpr bool is_request()  const noexcept
+		{
+			return type == request_mark || type == request_id_mark;
+		}
+		inline constexpr bool is_response() const noexcept
+		{
+			return type == response_mark || type == response_id_mark;
 		}
 
-		inline constexpr bool is_request()  const noexcept { return type == request_mark; }
-		inline constexpr bool is_response() const noexcept { return type == response_mark; }
+		/**
+		 * @brief Check whether the method is carried by the method id instead of the name.
+		 */
+		inline constexpr bool has_method_id() const noexcept
+		{
+			return type == request_id_mark || type == response_id_mark;
+		}
+
+		/**
+		 * @brief Change this header to a response header, the method form is kept.
+		 */
+		inline constexpr void make_response() noexcept
+		{
+			type = has_method_id() ? response_id_mark : response_mark;
+		}
+
+		/**
+		 * @brief Send the method id instead of the method name.
+		 */
+		inline constexpr void use_method_id() noexcept
+		{
+			method_id = rpc::make_method_id(method);
+			type = is_response() ? response_id_mark : request_id_mark;
+		}
 
 		char           type = '\0';
 		id_type        id = 0;
 		std::string    method;
+		method_id_type method_id = 0;
 	};
 
 	template<bool isRequest, typename ...Args>
@@ -18,6 +18,7 @@
 #include <asio3/rpc/invoker.hpp>
 #include <asio3/rpc/caller.hpp>
 #include <asio3/rpc/id_generator.hpp>
+#include <asio3/rpc/serve.hpp>
 
 #ifdef ASIO_STANDALONE
 namespace asio
@@ -37,6 +38,8 @@ namespace boost::asio
 		 */
 		explicit basic_rpc_client(const auto& ex) : super(ex)
 		{
+			// the concurrent calls are coalesced into one write.
+			this->send_queue.enabled = true;
 		}
 
 		basic_rpc_client(basic_rpc_client&&) noexcept = default;
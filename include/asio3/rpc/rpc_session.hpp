@@ -16,6 +16,7 @@
 #include <asio3/rpc/invoker.hpp>
 #include <asio3/rpc/caller.hpp>
 #include <asio3/rpc/id_generator.hpp>
+#include <asio3/rpc/serve.hpp>
 
 #ifdef ASIO_STANDALONE
 namespace asio
@@ -36,6 +37,9 @@ namespace boost::asio
 		explicit basic_rpc_session(socket_type sock) : super(std::move(sock))
 		{
 			this->disconnect_timeout = asio::http_disconnect_timeout;
+
+			// the concurrent calls and responses are coalesced into one write.
+			this->send_queue.enabled = true;
 		}
 
 		basic_rpc_session(basic_rpc_session&&) noexcept = default;
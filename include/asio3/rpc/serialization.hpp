@@ -10,11 +10,10 @@
 
 #pragma once
 
-#include <istream>
-#include <ostream>
-#include <streambuf>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <type_traits>
 
 #include <asio3/core/asio.hpp>
 #include <asio3/core/cereal.hpp>
@@ -28,74 +27,18 @@ namespace asio::rpc
 namespace boost::asio::rpc
 #endif
 {
-	class ostrbuf : public std::streambuf
-	{
-	public:
-		using string_type = std::basic_string<char_type, traits_type>;
-		using size_type = typename string_type::size_type;
-
-		ostrbuf() {}
-		virtual ~ostrbuf() noexcept {}
-
-		inline string_type& str() noexcept
-		{
-			return this->str_;
-		}
-
-		inline void clear() noexcept
-		{
-			this->str_.clear();
-
-			this->setp(this->str_.data(), this->str_.data() + this->str_.size());
-		}
-
-	protected:
-		virtual std::streamsize xsputn(const char_type* s, std::streamsize count) override
-		{
-			this->str_.append(s, size_type(count));
-
-			this->setp(this->str_.data(), this->str_.data() + this->str_.size());
-
-			return count;
-		}
-
-	protected:
-		string_type str_;
-	};
-
-	class istrbuf : public std::streambuf
-	{
-	public:
-		using string_type = std::basic_string<char_type, traits_type>;
-		using size_type = typename string_type::size_type;
-
-		istrbuf() {}
-		virtual ~istrbuf() noexcept {}
-
-		inline void setbuf(std::string_view s) noexcept
-		{
-			this->setbuf(const_cast<char_type*>(s.data()), std::streamsize(s.size()));
-		}
-
-		virtual std::streambuf* setbuf(char_type* s, std::streamsize n) override
-		{
-			this->setg(s, s, s + n);
-			return this;
-		}
-
-	protected:
-		virtual std::streamsize xsgetn(char_type* s, std::streamsize count) override
-		{
-			if (this->in_avail() < count)
-				return std::streamsize(0);
-
-			std::memcpy((void*)s, (const void*)(this->gptr()), size_type(count));
-
-			this->setg(this->eback(), this->gptr() + count, this->egptr());
-
-			return count;
-		}
-	};
+	/**
+	 * @brief Specialize it as std::true_type to serialize a type by one memcpy of the whole object
+	 * instead of field by field, then the type doesn't need the serialize function. The type must
+	 * be trivially copyable and standard layout, and the padding bytes are copied too. The object
+	 * is copied as is, so the peer must have the same layout and the same endianness, otherwise
+	 * the loading fails with exception.
+	 */
+	template<class T>
+	struct is_trivially_serializable : std::false_type {};
+
+	template<class T>
+	inline constexpr bool is_trivially_serializable_v = is_trivially_serializable<T>::value;
 
 	class serializer
 	{
@@ -104,8 +47,7 @@ namespace boost::asio::rpc
 
 		serializer()
 			: obuffer_()
-			, ostream_(std::addressof(obuffer_))
-			, oarchive_(ostream_)
+			, oarchive_(obuffer_)
 		{}
 		~serializer() = default;
 
@@ -136,16 +78,34 @@ namespace boost::asio::rpc
 			return (*this);
 		}
 
-		inline auto& str() noexcept
+		/**
+		 * @brief Reset the serializer and reserve some bytes at the front of the
+		 * buffer, the reserved bytes can be used to write the length head later.
+		 */
+		inline serializer& reset(std::size_t reserved)
 		{
-			return this->obuffer_.str();
+			this->obuffer_.assign(reserved, '\0');
+			this->oarchive_.save_endian();
+			return (*this);
 		}
 
-		inline ostrbuf& buffer() noexcept { return this->obuffer_; }
+		inline std::string& str() noexcept
+		{
+			return this->obuffer_;
+		}
+
+		/**
+		 * @brief Exchange the serialized data with s, so the data can be owned by a
+		 * pending send while the serializer is reused by the next message.
+		 */
+		inline serializer& swap(std::string& s) noexcept
+		{
+			this->obuffer_.swap(s);
+			return (*this);
+		}
 
 	protected:
-		ostrbuf         obuffer_;
-		std::ostream    ostream_;
+		std::string     obuffer_;
 		oarchive        oarchive_;
 	};
 
@@ -155,9 +115,7 @@ namespace boost::asio::rpc
 		using iarchive = cereal::ReusablePortableBinaryInputArchive;
 
 		deserializer()
-			: ibuffer_()
-			, istream_(std::addressof(ibuffer_))
-			, iarchive_(istream_)
+			: iarchive_()
 		{}
 		~deserializer() = default;
 
@@ -183,22 +141,72 @@ namespace boost::asio::rpc
 			return (*this);
 		}
 
+		/**
+		 * @brief Reset the deserializer to load from s, the data is not copied, so s must be
+		 * kept until the loading is finished, and the loaded std::string_view are views into s.
+		 */
 		inline deserializer& reset(std::string_view s)
 		{
-			this->ibuffer_.setbuf(s);
+			this->iarchive_.reset(s);
 			this->iarchive_.load_endian();
 			return (*this);
 		}
 
-		inline istrbuf& buffer() noexcept { return this->ibuffer_; }
+		/**
+		 * @brief Get the bytes which are not loaded yet.
+		 */
+		inline std::size_t remaining() const noexcept
+		{
+			return this->iarchive_.remaining();
+		}
+
+		/**
+		 * @brief Set whether std::string_view can be loaded, loading a std::string_view
+		 * throws if it's false. Set it to false if s of reset is released before the
+		 * loaded values are no longer used.
+		 */
+		inline deserializer& allow_views(bool allow) noexcept
+		{
+			this->iarchive_.allow_views(allow);
+			return (*this);
+		}
 
 	protected:
-		istrbuf         ibuffer_;
-		std::istream    istream_;
 		iarchive        iarchive_;
 	};
 }
 
+namespace cereal
+{
+	//! Saving the trivially serializable types to portable binary by one memcpy
+	template<class T>
+	requires ::rpc::is_trivially_serializable_v<T>
+	inline void CEREAL_SAVE_FUNCTION_NAME(ReusablePortableBinaryOutputArchive& ar, T const& t)
+	{
+		static_assert(std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T>,
+			"The trivially serializable type must be trivially copyable and standard layout");
+
+		if (ar.convert_endianness())
+			throw Exception("Failed to save a trivially serializable type with another endianness");
+
+		ar.template saveBinary<1>(std::addressof(t), sizeof(T));
+	}
+
+	//! Loading the trivially serializable types from portable binary by one memcpy
+	template<class T>
+	requires ::rpc::is_trivially_serializable_v<T>
+	inline void CEREAL_LOAD_FUNCTION_NAME(ReusablePortableBinaryInputArchive& ar, T& t)
+	{
+		static_assert(std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T>,
+			"The trivially serializable type must be trivially copyable and standard layout");
+
+		if (ar.convert_endianness())
+			throw Exception("Failed to load a trivially serializable type with another endianness");
+
+		ar.template loadBinary<1>(std::addressof(t), sizeof(T));
+	}
+}
+
 #ifdef ASIO_STANDALONE
 namespace asio::rpc
 #else
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <array>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <asio3/core/asio.hpp>
+#include <asio3/core/defer.hpp>
+#include <asio3/core/match_condition.hpp>
+
+#include <asio3/rpc/error.hpp>
+#include <asio3/rpc/serialization.hpp>
+#include <asio3/rpc/message.hpp>
+#include <asio3/rpc/detail/frame_buffer.hpp>
+
+#ifdef ASIO_STANDALONE
+namespace asio::rpc
+#else
+namespace boost::asio::rpc
+#endif
+{
+	struct serve_option
+	{
+		/// the max count of the requests which are executing at the same time on one connection.
+		/// When it's reached, the later requests are queued, and the responses are still read.
+		std::size_t max_in_flight = 128;
+
+		/// the max count of the requests which are queued when max_in_flight is reached,
+		/// the connection stops reading when it's reached too.
+		std::size_t max_pending = 1024;
+
+		/// the initial capacity of the receive buffer, it grows when a frame is larger than it.
+		std::size_t buffer_size = 64 * 1024;
+
+		/// the min free space for each read.
+		std::size_t read_size = 16 * 1024;
+	};
+
+	/**
+	 * @brief Read and dispatch the rpc frames of the connection until it's closed.
+	 * The requests are executed concurrently in the executor of the connection, so a slow
+	 * function doesn't block the other requests on the same connection. The responses are
+	 * sent out of order as soon as they are completed, they are matched by the request id
+	 * on the peer side, and the responses which are completed at the same time are
+	 * coalesced into one write by the send queue of the connection.
+	 * The responses of the calls from this side are passed to conn.async_notify, they are
+	 * read even if the requests are back-pressured, so the functions can call the peer on
+	 * the same connection, unless max_in_flight + max_pending requests are outstanding.
+	 * Every request frame is copied out of the receive buffer, because the function may
+	 * be completed after the buffer is reused.
+	 * @param conn - The rpc_session or rpc_client.
+	 * @param invoker - The invoker which the rpc functions are binded to, it must not be
+	 *    modified while the connection is serving.
+	 * @return The error which stops the reading.
+	 */
+	template<typename Connection, typename Invoker>
+	asio::awaitable<asio::error_code> async_serve(Connection& conn, Invoker& invoker, serve_option opt = {})
+	{
+		using serializer_type   = typename Invoker::serializer_type;
+		using deserializer_type = typename Invoker::deserializer_type;
+		using iterator          = asio::buffers_iterator<asio::const_buffer>;
+		using notify_type       = experimental::channel<void(asio::error_code)>;
+
+		// the request data must be kept until the function is completed, and the serializer
+		// and deserializer can't be shared by the concurrent functions.
+		struct request_context
+		{
+			serializer_type   sr;
+			deserializer_type dr;
+			std::string       frame;
+			char              head[asio::length_payload_match_condition::max_length_size];
+		};
+
+		struct pending_request
+		{
+			rpc::header                      head;
+			std::unique_ptr<request_context> ctx;
+		};
+
+		co_await asio::dispatch(asio::use_awaitable_executor(conn));
+
+		auto ex = conn.get_executor();
+
+		opt.max_in_flight = (std::max)(opt.max_in_flight, std::size_t(1));
+
+		rpc::detail::frame_buffer buffer(opt.buffer_size);
+
+		std::vector<std::unique_ptr<request_context>> free_contexts;
+
+		// the requests which are waiting for a free slot of the executing requests.
+		std::deque<pending_request> pending;
+
+		std::size_t in_flight = 0;
+
+		bool waiting = false;
+
+		notify_type notify(ex, 1);
+
+		asio::error_code ec{};
+
+		auto make_context = [&free_contexts](std::string_view data) mutable
+		{
+			std::unique_ptr<request_context> ctx;
+
+			if (free_contexts.empty())
+			{
+				ctx = std::make_unique<request_context>();
+			}
+			else
+			{
+				ctx = std::move(free_contexts.back());
+				free_contexts.pop_back();
+			}
+
+			ctx->frame.assign(data);
+
+			return ctx;
+		};
+
+		// the finished request starts the next queued request, so it's passed to itself.
+		auto start_request = [&conn, &invoker, &ex, &free_contexts, &pending, &in_flight, &waiting, &notify, &opt]
+		(auto& self, rpc::header head, std::unique_ptr<request_context> ctx) mutable -> void
+		{
+			++in_flight;
+
+			asio::co_spawn(ex, [&self, &conn, &invoker, &free_contexts, &pending, &in_flight, &waiting, &notify, &opt,
+				ctx = std::move(ctx), head = std::move(head)]() mutable -> asio::awaitable<void>
+			{
+				std::defer auto_release = [&]() mutable
+				{
+					if (free_contexts.size() < opt.max_in_flight)
+						free_contexts.emplace_back(std::move(ctx));
+
+					--in_flight;
+
+					if (!pending.empty())
+					{
+						pending_request req = std::move(pending.front());
+						pending.pop_front();
+						self(self, std::move(req.head), std::move(req.ctx));
+					}
+
+					if (waiting)
+					{
+						waiting = false;
+						notify.try_send(asio::error_code{});
+					}
+				};
+
+			#if !defined(ASIO_NO_EXCEPTIONS) && !defined(BOOST_ASIO_NO_EXCEPTIONS)
+				try
+				{
+			#endif
+					// skip the header, the invoker reads the parameters after it.
+					rpc::header h{};
+					ctx->dr.reset(ctx->frame);
+					ctx->dr >> h;
+			#if !defined(ASIO_NO_EXCEPTIONS) && !defined(BOOST_ASIO_NO_EXCEPTIONS)
+				}
+				catch (const cereal::exception&)
+				{
+					co_return;
+				}
+			#endif
+
+				auto [e1, resp] = co_await invoker.invoke(ctx->sr, ctx->dr, std::move(head), ctx->frame);
+
+				if (!resp.empty())
+				{
+					std::size_t n = asio::length_payload_match_condition::generate_length(resp.size(), ctx->head);
+
+					std::array<asio::const_buffer, 2> buffers
+					{
+						asio::buffer(ctx->head, n),
+						asio::buffer(resp),
+					};
+
+					co_await conn.async_send(buffers, asio::use_awaitable_executor(conn));
+				}
+			}, asio::detached);
+		};
+
+		for (bool stopped = false; !stopped;)
+		{
+			auto [e1, n1] = co_await conn.get_stream().async_read_some(
+				buffer.prepare(opt.read_size), asio::use_awaitable_executor(conn));
+			if (e1)
+			{
+				ec = e1;
+				break;
+			}
+
+			buffer.commit(n1);
+
+			if constexpr (requires { conn.update_alive_time(); })
+			{
+				conn.update_alive_time();
+			}
+
+			// dispatch all the complete frames in the buffer.
+			while (!stopped)
+			{
+				asio::const_buffer b = asio::buffer(buffer.data());
+
+				auto [end, matched] = asio::length_payload_match_condition{}(
+					iterator::begin(b), iterator::end(b));
+				if (!matched)
+					break;
+
+				std::size_t n = static_cast<std::size_t>(end - iterator::begin(b));
+
+				// illegal length head.
+				if (n == 0)
+				{
+					ec = rpc::make_error_code(rpc::error::parse_error);
+					stopped = true;
+					break;
+				}
+
+				std::string_view data = asio::length_payload_match_condition::get_payload(buffer.data().data(), n);
+
+				rpc::header head{};
+
+			#if !defined(ASIO_NO_EXCEPTIONS) && !defined(BOOST_ASIO_NO_EXCEPTIONS)
+				try
+				{
+			#endif
+					conn.deserializer.reset(data);
+					conn.deserializer >> head;
+			#if !defined(ASIO_NO_EXCEPTIONS) && !defined(BOOST_ASIO_NO_EXCEPTIONS)
+				}
+				catch (const cereal::exception&)
+				{
+					ec = rpc::make_error_code(rpc::error::parse_error);
+					stopped = true;
+					break;
+				}
+			#endif
+
+				if (head.is_request())
+				{
+					// the responses are still read while the requests are back-pressured, only
+					// stop reading when the queue is full too.
+					while (in_flight >= opt.max_in_flight && pending.size() >= opt.max_pending)
+					{
+						waiting = true;
+						co_await notify.async_receive(asio::use_nothrow_awaitable);
+					}
+
+					if (in_flight < opt.max_in_flight)
+						start_request(start_request, std::move(head), make_context(data));
+					else
+						pending.emplace_back(std::move(head), make_context(data));
+				}
+				else if (head.is_response())
+				{
+					co_await conn.async_notify(conn.serializer, conn.deserializer, std::move(head), data);
+				}
+				else
+				{
+					ec = rpc::make_error_code(rpc::error::invalid_request);
+					stopped = true;
+					break;
+				}
+
+				buffer.consume(n);
+			}
+		}
+
+		// the queued requests are not executed after the connection is closed.
+		pending.clear();
+
+		// the executing requests hold the references of the local variables.
+		while (in_flight > 0)
+		{
+			waiting = true;
+			co_await notify.async_receive(asio::use_nothrow_awaitable);
+		}
+
+		co_return ec;
+	}
+}
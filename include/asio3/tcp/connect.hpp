@@ -18,6 +18,323 @@
 #include <asio3/core/with_lock.hpp>
 #include <asio3/tcp/core.hpp>
 
+#ifdef ASIO_STANDALONE
+namespace asio::detail
+#else
+namespace boost::asio::detail
+#endif
+{
+	/**
+	 * @brief Sort the endpoints for the happy eyeballs connect, see RFC 8305 section 4.
+	 * The order of the resolver is kept, but the address families are interleaved, and the
+	 * family of the first endpoint goes first.
+	 */
+	template<typename Endpoint>
+	std::vector<Endpoint> interleave_address_families(std::vector<Endpoint> eps)
+	{
+		if (eps.size() < 3)
+			return eps;
+
+		auto family = eps.front().protocol().family();
+
+		std::vector<Endpoint> primary, secondary, result;
+		result.reserve(eps.size());
+
+		for (auto& ep : eps)
+		{
+			if (ep.protocol().family() == family)
+				primary.emplace_back(std::move(ep));
+			else
+				secondary.emplace_back(std::move(ep));
+		}
+
+		for (std::size_t i = 0; i < primary.size() || i < secondary.size(); ++i)
+		{
+			if (i < primary.size())
+				result.emplace_back(std::move(primary[i]));
+			if (i < secondary.size())
+				result.emplace_back(std::move(secondary[i]));
+		}
+
+		return result;
+	}
+
+	template<typename SocketT>
+	struct tcp_race_connect_state
+	{
+		static constexpr std::size_t npos = std::size_t(-1);
+
+		template<typename Executor>
+		tcp_race_connect_state(const Executor& ex, std::size_t count) : timer(ex)
+		{
+			// the sockets which have pending connect operations must not be moved.
+			socks.reserve(count);
+		}
+
+		inline void on_connect(std::size_t i, const asio::error_code& ec) noexcept
+		{
+			--pending;
+
+			if (!ec)
+			{
+				if (winner == npos)
+					winner = i;
+			}
+			else
+			{
+				last_error = ec;
+				failed = true;
+			}
+
+			// wake up the connect op to start the next attempt or finish.
+			timer.cancel();
+		}
+
+		inline void close_all() noexcept
+		{
+			asio::error_code ec{};
+			for (std::size_t i = 0; i < socks.size(); ++i)
+			{
+				if (i != winner)
+					socks[i].close(ec);
+			}
+		}
+
+		std::vector<SocketT> socks;
+
+		asio::steady_timer   timer;
+
+		std::size_t          pending = 0;
+		std::size_t          winner  = npos;
+
+		bool                 failed  = false;
+		bool                 timeout = false;
+
+		asio::error_code     last_error = asio::error::connection_refused;
+	};
+
+	struct tcp_async_race_connect_op
+	{
+		auto operator()(
+			auto state, auto sock_ref, auto endpoints,
+			std::chrono::steady_clock::duration connect_timeout,
+			std::chrono::steady_clock::duration attempt_delay, auto&& cb_set_option) -> void
+		{
+			auto& sock = sock_ref.get();
+
+			auto fn_set_option = std::forward_like<decltype(cb_set_option)>(cb_set_option);
+
+			using sock_type = std::remove_cvref_t<decltype(sock)>;
+			using endpoint_type = typename sock_type::protocol_type::endpoint;
+			using state_type = tcp_race_connect_state<sock_type>;
+
+			co_await asio::dispatch(asio::use_deferred_executor(sock));
+
+			state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+			if (endpoints.empty())
+				co_return{ asio::error::not_found, endpoint_type{} };
+
+			// a opened socket can't be raced, so the endpoints are tried one by one.
+			if (sock.is_open())
+			{
+				detail::call_func_when_timeout wt(
+					asio::detail::get_lowest_executor(sock), connect_timeout, [&sock]() mutable
+					{
+						error_code ec{};
+						sock.close(ec);
+						asio::reset_lock(sock);
+					});
+
+				asio::error_code ec = asio::error::connection_refused;
+
+				for (const auto& ep : endpoints)
+				{
+					auto [e1] = co_await sock.async_connect(ep, asio::use_deferred_executor(sock));
+					if (!e1)
+						co_return{ e1, ep };
+
+					if (!!state.cancelled())
+						co_return{ asio::error::operation_aborted, endpoint_type{} };
+
+					ec = e1;
+				}
+
+				co_return{ ec, endpoint_type{} };
+			}
+
+			endpoints = detail::interleave_address_families(std::move(endpoints));
+
+			// the attempts hold the state, it will be destroyed after the last attempt finished.
+			auto s = std::make_shared<state_type>(asio::detail::get_lowest_executor(sock), endpoints.size());
+
+			detail::call_func_when_timeout wt(
+				asio::detail::get_lowest_executor(sock), connect_timeout, [s]() mutable
+				{
+					s->timeout = true;
+					s->close_all();
+					s->timer.cancel();
+				});
+
+			std::size_t next = 0;
+			bool delay_elapsed = false;
+
+			while (s->winner == state_type::npos && !s->timeout)
+			{
+				// start the next attempt when the delay elapsed, or when no attempt is in
+				// progress, or when a attempt failed, see RFC 8305 section 5.
+				if (next < endpoints.size() && (s->pending == 0 || s->failed || delay_elapsed))
+				{
+					s->failed = false;
+					delay_elapsed = false;
+
+					const endpoint_type& ep = endpoints[next++];
+
+					sock_type& tmp = s->socks.emplace_back(sock.get_executor());
+
+					asio::error_code ec{};
+					tmp.open(ep.protocol(), ec);
+					if (ec)
+					{
+						s->last_error = ec;
+						continue;
+					}
+
+					// you can use the option callback to set the bind address and port
+					fn_set_option(tmp);
+
+					++s->pending;
+
+					tmp.async_connect(ep, [s, i = s->socks.size() - 1](const asio::error_code& ec) mutable
+					{
+						s->on_connect(i, ec);
+					});
+				}
+
+				if (s->pending == 0)
+					break;
+
+				// a zero delay disables the racing, the next endpoint is tried after the previous failed.
+				if (next < endpoints.size() && attempt_delay > std::chrono::steady_clock::duration::zero())
+					s->timer.expires_after(attempt_delay);
+				else
+					s->timer.expires_at(std::chrono::steady_clock::time_point::max());
+
+				auto [e1] = co_await s->timer.async_wait(asio::use_deferred_executor(s->timer));
+
+				if (!!state.cancelled())
+				{
+					s->close_all();
+					co_return{ asio::error::operation_aborted, endpoint_type{} };
+				}
+
+				if (!e1)
+					delay_elapsed = true;
+			}
+
+			if (s->winner != state_type::npos)
+			{
+				std::size_t i = s->winner;
+
+				s->close_all();
+
+				asio::error_code ec{};
+				endpoint_type ep = s->socks[i].remote_endpoint(ec);
+
+				sock = std::move(s->socks[i]);
+
+				co_return{ asio::error_code{}, ep };
+			}
+
+			s->close_all();
+
+			co_return{ s->timeout ? asio::error::timed_out : s->last_error, endpoint_type{} };
+		}
+	};
+}
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+	/**
+	 * @brief Asynchronously establishes a socket connection with the happy eyeballs algorithm.
+	 * The connection attempts are started one after another with a delay, and the address
+	 * families are interleaved, the first connected attempt wins and the others are closed,
+	 * see RFC 8305. If the socket is already open, the endpoints are tried one by one.
+	 * @param sock - The socket reference to be connected.
+	 * @param endpoints - The endpoints sequence, such as the results of the resolver.
+	 * @param token - The completion handler to invoke when the operation completes. 
+	 *	  The equivalent function signature of the handler must be:
+     *    @code
+     *    void handler(const asio::error_code& ec, asio::ip::tcp::endpoint ep);
+	 */
+	template<
+		typename AsyncStream,
+		typename EndpointSequence,
+		typename ConnectToken = asio::default_token_type<AsyncStream>>
+	requires is_tcp_socket<AsyncStream>
+	inline auto async_race_connect(
+		AsyncStream& sock,
+		const EndpointSequence& endpoints,
+		ConnectToken&& token = asio::default_token_type<AsyncStream>())
+	{
+		using endpoint_type = typename std::remove_cvref_t<AsyncStream>::protocol_type::endpoint;
+
+		return asio::async_initiate<ConnectToken, void(asio::error_code, asio::ip::tcp::endpoint)>(
+			asio::experimental::co_composed<void(asio::error_code, asio::ip::tcp::endpoint)>(
+				detail::tcp_async_race_connect_op{}, sock),
+			token, std::ref(sock),
+			std::vector<endpoint_type>(std::begin(endpoints), std::end(endpoints)),
+			asio::tcp_connect_timeout,
+			asio::tcp_connection_attempt_delay,
+			asio::default_tcp_socket_option_setter{});
+	}
+
+	/**
+	 * @brief Asynchronously establishes a socket connection with the happy eyeballs algorithm.
+	 * The connection attempts are started one after another with a delay, and the address
+	 * families are interleaved, the first connected attempt wins and the others are closed,
+	 * see RFC 8305. If the socket is already open, the endpoints are tried one by one.
+	 * @param sock - The socket reference to be connected.
+	 * @param endpoints - The endpoints sequence, such as the results of the resolver.
+	 * @param connect_timeout - The connect timeout.
+	 * @param attempt_delay - The delay between two attempts, zero means try the endpoints one by one.
+	 * @param cb_set_option - The callback to set the socket options. [](auto& sock){...}
+	 * @param token - The completion handler to invoke when the operation completes. 
+	 *	  The equivalent function signature of the handler must be:
+     *    @code
+     *    void handler(const asio::error_code& ec, asio::ip::tcp::endpoint ep);
+	 */
+	template<
+		typename AsyncStream,
+		typename EndpointSequence,
+		typename SetOptionFn,
+		typename ConnectToken = asio::default_token_type<AsyncStream>>
+	requires (is_tcp_socket<AsyncStream> && std::invocable<SetOptionFn, AsyncStream&>)
+	inline auto async_race_connect(
+		AsyncStream& sock,
+		const EndpointSequence& endpoints,
+		std::chrono::steady_clock::duration connect_timeout,
+		std::chrono::steady_clock::duration attempt_delay,
+		SetOptionFn&& cb_set_option,
+		ConnectToken&& token = asio::default_token_type<AsyncStream>())
+	{
+		using endpoint_type = typename std::remove_cvref_t<AsyncStream>::protocol_type::endpoint;
+
+		return asio::async_initiate<ConnectToken, void(asio::error_code, asio::ip::tcp::endpoint)>(
+			asio::experimental::co_composed<void(asio::error_code, asio::ip::tcp::endpoint)>(
+				detail::tcp_async_race_connect_op{}, sock),
+			token, std::ref(sock),
+			std::vector<endpoint_type>(std::begin(endpoints), std::end(endpoints)),
+			connect_timeout,
+			attempt_delay,
+			std::forward<SetOptionFn>(cb_set_option));
+	}
+}
+
 #ifdef ASIO_STANDALONE
 namespace asio
 #else
@@ -25,7 +342,7 @@ namespace boost::asio
 #endif
 {
 	/**
-	 * @brief Asynchronously establishes a socket connection by trying each endpoint in a sequence.
+	 * @brief Asynchronously establishes a socket connection with the happy eyeballs algorithm.
 	 * @param sock - The socket reference to be connected.
 	 * @param server_address - The target server address. 
 	 * @param server_port - The target server port. 
@@ -47,43 +364,17 @@ namespace boost::asio
 
 		resolver_type resolver(asio::detail::get_lowest_executor(sock));
 
+		typename resolver_type::results_type eps{};
+
 		// A successful resolve operation is guaranteed to pass a non-empty range to the handler.
-		auto [e1, eps] = co_await resolver.async_resolve(
-			addr, port, asio::ip::resolver_base::flags(), asio::use_awaitable_executor(resolver));
+		auto e1 = co_await asio::resolve(
+			resolver, std::move(addr), std::move(port), eps, asio::ip::resolver_base::flags());
 		if (e1)
 			co_return e1;
 
-		if (sock.is_open())
-		{
-			for (const auto& ep : eps)
-			{
-				auto [e2] = co_await sock.async_connect(ep, asio::use_awaitable_executor(sock));
-				if (!e2)
-					co_return e2;
-			}
-		}
-		else
-		{
-			asio::error_code ec{};
-
-			for (const auto& ep : eps)
-			{
-				sock_type tmp(sock.get_executor());
-
-				tmp.open(ep.endpoint().protocol(), ec);
-				if (ec)
-					continue;
+		auto [e2, ep] = co_await asio::async_race_connect(sock, eps, asio::use_awaitable_executor(sock));
 
-				auto [e2] = co_await tmp.async_connect(ep, asio::use_awaitable_executor(tmp));
-				if (!e2)
-				{
-					sock = std::move(tmp);
-					co_return e2;
-				}
-			}
-		}
-
-		co_return asio::error::connection_refused;
+		co_return e2;
 	}
 }
 
@@ -97,7 +388,8 @@ namespace boost::asio::detail
 	{
 		auto operator()(
 			auto state, auto sock_ref, auto&& server_address, auto&& server_port,
-			std::chrono::steady_clock::duration connect_timeout, auto&& cb_set_option) -> void
+			std::chrono::steady_clock::duration connect_timeout,
+			std::chrono::steady_clock::duration attempt_delay, auto&& cb_set_option) -> void
 		{
 			auto& sock = sock_ref.get();
 
@@ -114,6 +406,8 @@ namespace boost::asio::detail
 
 			state.reset_cancellation_state(asio::enable_terminal_cancellation());
 
+			auto start_time = std::chrono::steady_clock::now();
+
 			detail::call_func_when_timeout wt(
 				asio::detail::get_lowest_executor(sock), connect_timeout, [&sock]() mutable
 				{
@@ -148,26 +442,14 @@ namespace boost::asio::detail
 			}
 			else
 			{
-				asio::error_code ec{};
-
-				for (const auto& ep : eps)
-				{
-					sock_type tmp(sock.get_executor());
-
-					tmp.open(ep.endpoint().protocol(), ec);
-					if (ec)
-						continue;
+				auto elapsed = std::chrono::steady_clock::now() - start_time;
 
-					// you can use the option callback to set the bind address and port
-					fn_set_option(tmp);
+				// the racing sockets are not closed by the timeout above, so pass the rest time.
+				auto [e2, ep] = co_await asio::async_race_connect(sock, eps,
+					(std::max)(connect_timeout - elapsed, std::chrono::steady_clock::duration::zero()),
+					attempt_delay, std::move(fn_set_option), asio::use_deferred_executor(sock));
 
-					auto [e2] = co_await tmp.async_connect(ep, asio::use_deferred_executor(tmp));
-					if (!e2)
-					{
-						sock = std::move(tmp);
-						co_return{ e2, ep.endpoint() };
-					}
-				}
+				co_return{ e2, ep };
 			}
 
 			co_return{ asio::error::connection_refused, endpoint_type{} };
@@ -182,7 +464,7 @@ namespace boost::asio
 #endif
 {
 	/**
-	 * @brief Asynchronously establishes a socket connection by trying each endpoint in a sequence.
+	 * @brief Asynchronously establishes a socket connection with the happy eyeballs algorithm.
 	 * @param sock - The socket reference to be connected.
 	 * @param server_address - The target server address. 
 	 * @param server_port - The target server port. 
@@ -207,15 +489,52 @@ namespace boost::asio
 			std::forward_like<decltype(server_address)>(server_address),
 			std::forward_like<decltype(server_port)>(server_port),
 			asio::tcp_connect_timeout,
+			asio::tcp_connection_attempt_delay,
 			asio::default_tcp_socket_option_setter{});
 	}
 
 	/**
-	 * @brief Asynchronously establishes a socket connection by trying each endpoint in a sequence.
+	 * @brief Asynchronously establishes a socket connection with the happy eyeballs algorithm.
+	 * @param sock - The socket reference to be connected.
+	 * @param server_address - The target server address. 
+	 * @param server_port - The target server port. 
+	 * @param connect_timeout - The connect timeout.
+	 * @param cb_set_option - The callback to set the socket options. [](auto& sock){...}
+	 * @param token - The completion handler to invoke when the operation completes. 
+	 *	  The equivalent function signature of the handler must be:
+     *    @code
+     *    void handler(const asio::error_code& ec, asio::ip::tcp::endpoint ep);
+	 */
+	template<
+		typename AsyncStream,
+		typename SetOptionFn,
+		typename ConnectToken = asio::default_token_type<AsyncStream>>
+	requires (is_tcp_socket<AsyncStream> && std::invocable<SetOptionFn, AsyncStream&>)
+	inline auto async_connectex(
+		AsyncStream& sock,
+		is_string auto&& server_address, is_string_or_integral auto&& server_port,
+		std::chrono::steady_clock::duration connect_timeout,
+		SetOptionFn&& cb_set_option,
+		ConnectToken&& token = asio::default_token_type<AsyncStream>())
+	{
+		return asio::async_initiate<ConnectToken, void(asio::error_code, asio::ip::tcp::endpoint)>(
+			asio::experimental::co_composed<void(asio::error_code, asio::ip::tcp::endpoint)>(
+				detail::tcp_async_connect_op{}, sock),
+			token, std::ref(sock),
+			std::forward_like<decltype(server_address)>(server_address),
+			std::forward_like<decltype(server_port)>(server_port),
+			connect_timeout,
+			asio::tcp_connection_attempt_delay,
+			std::forward<SetOptionFn>(cb_set_option));
+	}
+
+	/**
+	 * @brief Asynchronously establishes a socket connection with the happy eyeballs algorithm.
 	 * @param sock - The socket reference to be connected.
 	 * @param server_address - The target server address. 
 	 * @param server_port - The target server port. 
 	 * @param connect_timeout - The connect timeout.
+	 * @param attempt_delay - The delay between two attempts, zero means try the endpoints one by one.
 	 * @param cb_set_option - The callback to set the socket options. [](auto& sock){...}
 	 * @param token - The completion handler to invoke when the operation completes. 
 	 *	  The equivalent function signature of the handler must be:
@@ -231,6 +550,7 @@ namespace boost::asio
 		AsyncStream& sock,
 		is_string auto&& server_address, is_string_or_integral auto&& server_port,
 		std::chrono::steady_clock::duration connect_timeout,
+		std::chrono::steady_clock::duration attempt_delay,
 		SetOptionFn&& cb_set_option,
 		ConnectToken&& token = asio::default_token_type<AsyncStream>())
 	{
@@ -241,6 +561,7 @@ namespace boost::asio
 			std::forward_like<decltype(server_address)>(server_address),
 			std::forward_like<decltype(server_port)>(server_port),
 			connect_timeout,
+			attempt_delay,
 			std::forward<SetOptionFn>(cb_set_option));
 	}
 }
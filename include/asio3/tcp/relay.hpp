@@ -0,0 +1,551 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <asio3/core/asio.hpp>
+#include <asio3/core/defer.hpp>
+#include <asio3/core/netconcepts.hpp>
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+	struct relay_option
+	{
+		/// the max bytes per second of each direction, 0 means unlimited.
+		std::size_t rate_limit = 0;
+
+		/// the max bytes which can be sent at once after idle, 0 means the same as the rate_limit.
+		std::size_t burst_size = 0;
+
+		/// the buffer size of the buffered relay starts from the min size, and it's doubled when
+		/// a read fills the whole buffer, until the max size.
+		std::size_t min_buffer_size = 4 * 1024;
+		std::size_t max_buffer_size = 64 * 1024;
+
+		/// the capacity of the pipe which is used by splice, it's also the max bytes of each splice.
+		std::size_t pipe_size = 64 * 1024;
+
+		/// called with the bytes after each piece of data is relayed in any direction, it can
+		/// be used to update the alive time of the session.
+		std::function<void(std::size_t)> transfer_callback;
+	};
+}
+
+#ifdef ASIO_STANDALONE
+namespace asio::detail
+#else
+namespace boost::asio::detail
+#endif
+{
+	/**
+	 * @brief The buffers of the buffered relay are cached per thread by the power of 2 size,
+	 * so the connections which come and go don't allocate them from the heap every time.
+	 */
+	class relay_buffer
+	{
+	public:
+		relay_buffer() = default;
+
+		explicit relay_buffer(std::size_t size)
+		{
+			this->resize(size);
+		}
+
+		~relay_buffer()
+		{
+			this->release();
+		}
+
+		relay_buffer(relay_buffer&& other) noexcept
+			: data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0))
+		{
+		}
+
+		relay_buffer& operator=(relay_buffer&& other) noexcept
+		{
+			if (this != std::addressof(other))
+			{
+				this->release();
+				data_ = std::exchange(other.data_, nullptr);
+				size_ = std::exchange(other.size_, 0);
+			}
+			return *this;
+		}
+
+		inline void resize(std::size_t size)
+		{
+			size = std::bit_ceil((std::max)(size, std::size_t(1024)));
+
+			if (size == size_)
+				return;
+
+			this->release();
+
+			std::vector<std::unique_ptr<char[]>>* cache = cache_of(size);
+
+			if (cache && !cache->empty())
+			{
+				data_ = cache->back().release();
+				cache->pop_back();
+			}
+			else
+			{
+				data_ = new char[size];
+			}
+
+			size_ = size;
+		}
+
+		[[nodiscard]] inline char*       data() const noexcept { return data_; }
+		[[nodiscard]] inline std::size_t size() const noexcept { return size_; }
+
+	protected:
+		inline void release() noexcept
+		{
+			if (!data_)
+				return;
+
+			std::vector<std::unique_ptr<char[]>>* cache = cache_of(size_);
+
+			if (cache && cache->size() < max_cached)
+			{
+			#if !defined(ASIO_NO_EXCEPTIONS) && !defined(BOOST_ASIO_NO_EXCEPTIONS)
+				try
+				{
+			#endif
+					cache->emplace_back(data_);
+					data_ = nullptr;
+			#if !defined(ASIO_NO_EXCEPTIONS) && !defined(BOOST_ASIO_NO_EXCEPTIONS)
+				}
+				catch (...)
+				{
+				}
+			#endif
+			}
+
+			delete[] data_;
+
+			data_ = nullptr;
+			size_ = 0;
+		}
+
+		static std::vector<std::unique_ptr<char[]>>* cache_of(std::size_t size) noexcept
+		{
+			// 1KB ~ 1MB
+			thread_local std::array<std::vector<std::unique_ptr<char[]>>, 11> caches;
+
+			std::size_t index = static_cast<std::size_t>(std::countr_zero(size)) - 10;
+
+			return index < caches.size() ? std::addressof(caches[index]) : nullptr;
+		}
+
+		static constexpr std::size_t max_cached = 16;
+
+		char*       data_ = nullptr;
+
+		std::size_t size_ = 0;
+	};
+
+	/**
+	 * @brief The token bucket of the rate limit of one direction.
+	 */
+	class relay_token_bucket
+	{
+	public:
+		using clock_type = std::chrono::steady_clock;
+
+		relay_token_bucket(std::size_t rate, std::size_t burst) noexcept
+			: rate_(double(rate))
+			, burst_(double(burst == 0 ? rate : burst))
+			, tokens_(burst_)
+			, last_(clock_type::now())
+		{
+		}
+
+		[[nodiscard]] inline bool enabled() const noexcept
+		{
+			return rate_ > 0;
+		}
+
+		/**
+		 * @brief Get how many bytes can be relayed now, it's at most the max.
+		 */
+		inline std::size_t available(std::size_t max) noexcept
+		{
+			if (!enabled())
+				return max;
+
+			auto now = clock_type::now();
+
+			tokens_ = (std::min)(burst_, tokens_ + std::chrono::duration<double>(now - last_).count() * rate_);
+
+			last_ = now;
+
+			return tokens_ < double(min_grant(max)) ? 0 : (std::min)(max, std::size_t(tokens_));
+		}
+
+		inline void consume(std::size_t n) noexcept
+		{
+			if (enabled())
+				tokens_ -= double(n);
+		}
+
+		/**
+		 * @brief Get how long to wait until the bucket has enough tokens to relay at most max bytes.
+		 */
+		inline clock_type::duration wait_time(std::size_t max) const noexcept
+		{
+			double need = double(min_grant(max)) - tokens_;
+
+			return std::chrono::duration_cast<clock_type::duration>(
+				std::chrono::duration<double>((std::max)(need, 1.0) / rate_));
+		}
+
+	protected:
+		// wait for a few KB at least, otherwise the tokens are granted byte by byte when limited.
+		inline std::size_t min_grant(std::size_t max) const noexcept
+		{
+			return (std::max)(std::size_t(1), (std::min)({ max, std::size_t(burst_), std::size_t(4096) }));
+		}
+
+		double                 rate_;
+
+		double                 burst_;
+
+		double                 tokens_;
+
+		clock_type::time_point last_;
+	};
+
+	template<typename Stream>
+	inline void relay_shutdown_send(Stream& s) noexcept
+	{
+		if constexpr (requires(asio::error_code& ec) { s.shutdown(asio::socket_base::shutdown_send, ec); })
+		{
+			asio::error_code ec{};
+			s.shutdown(asio::socket_base::shutdown_send, ec);
+		}
+	}
+
+	/**
+	 * @brief Whether the direction can be relayed by splice, the both ends must be plain tcp socket.
+	 */
+	template<typename From, typename To>
+	concept is_splice_capable =
+	#if defined(__linux__)
+		asio::is_basic_stream_socket<From> && asio::is_tcp_socket<From> &&
+		asio::is_basic_stream_socket<To> && asio::is_tcp_socket<To>;
+	#else
+		false;
+	#endif
+
+	struct async_relay_one_way_op
+	{
+		relay_option& opt;
+
+		auto operator()(auto state, auto from_ref, auto to_ref) -> void
+		{
+			auto& from = from_ref.get();
+			auto& to = to_ref.get();
+
+			co_await asio::dispatch(asio::use_deferred_executor(from));
+
+			state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+			asio::error_code ec{};
+
+			std::size_t total = 0;
+
+			relay_token_bucket bucket(opt.rate_limit, opt.burst_size);
+
+			std::optional<asio::steady_timer> timer;
+
+		#if defined(__linux__)
+			if constexpr (is_splice_capable<std::remove_cvref_t<decltype(from)>, std::remove_cvref_t<decltype(to)>>)
+			{
+				int pipes[2] = { -1, -1 };
+
+				// fall back to the buffered relay if the pipe can't be created.
+				if (::pipe2(pipes, O_NONBLOCK | O_CLOEXEC) == 0)
+				{
+					std::defer close_pipes = [&pipes]() mutable
+					{
+						::close(pipes[0]);
+						::close(pipes[1]);
+					};
+
+				#if defined(F_SETPIPE_SZ)
+					::fcntl(pipes[1], F_SETPIPE_SZ, int(opt.pipe_size));
+				#endif
+
+					from.native_non_blocking(true, ec);
+					if (!ec)
+						to.native_non_blocking(true, ec);
+					if (ec)
+						co_return{ ec, total };
+
+					std::size_t chunk = (std::max)(opt.pipe_size, std::size_t(4096));
+
+					for (;;)
+					{
+						if (!!state.cancelled())
+							co_return{ asio::error::operation_aborted, total };
+
+						std::size_t size = bucket.available(chunk);
+						if (size == 0)
+						{
+							if (!timer)
+								timer.emplace(from.get_executor());
+
+							timer->expires_after(bucket.wait_time(chunk));
+
+							auto [e0] = co_await timer->async_wait(asio::use_deferred_executor(from));
+							if (e0)
+								co_return{ e0, total };
+
+							continue;
+						}
+
+						// the pipe is always empty here, so EAGAIN means the socket has no data.
+						ssize_t n = ::splice(from.native_handle(), nullptr, pipes[1], nullptr, size,
+							SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+						if (n == 0)
+							break;
+
+						if (n < 0)
+						{
+							if (errno == EINTR)
+								continue;
+
+							if (errno == EAGAIN || errno == EWOULDBLOCK)
+							{
+								auto [e1] = co_await from.async_wait(
+									asio::socket_base::wait_read, asio::use_deferred_executor(from));
+								if (e1)
+									co_return{ e1, total };
+
+								continue;
+							}
+
+							co_return{ asio::error_code(errno, asio::error::get_system_category()), total };
+						}
+
+						bucket.consume(std::size_t(n));
+
+						// drain the pipe into the other end.
+						for (std::size_t pending = std::size_t(n); pending > 0;)
+						{
+							ssize_t m = ::splice(pipes[0], nullptr, to.native_handle(), nullptr, pending,
+								SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+							if (m > 0)
+							{
+								pending -= std::size_t(m);
+								total += std::size_t(m);
+								continue;
+							}
+
+							if (m < 0 && errno == EINTR)
+								continue;
+
+							if (m < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+							{
+								auto [e2] = co_await to.async_wait(
+									asio::socket_base::wait_write, asio::use_deferred_executor(to));
+								if (e2)
+									co_return{ e2, total };
+
+								continue;
+							}
+
+							co_return{ m < 0 ? asio::error_code(errno, asio::error::get_system_category()) :
+								asio::error_code(asio::error::connection_reset), total };
+						}
+
+						if (opt.transfer_callback)
+							opt.transfer_callback(std::size_t(n));
+					}
+
+					// propagate the half close to the other end.
+					relay_shutdown_send(to);
+
+					co_return{ asio::error_code{}, total };
+				}
+			}
+		#endif
+
+			relay_buffer buffer((std::max)(opt.min_buffer_size, std::size_t(1)));
+
+			std::size_t max_buffer_size = (std::max)(opt.max_buffer_size, buffer.size());
+
+			for (;;)
+			{
+				if (!!state.cancelled())
+					co_return{ asio::error::operation_aborted, total };
+
+				std::size_t size = bucket.available(buffer.size());
+				if (size == 0)
+				{
+					if (!timer)
+						timer.emplace(from.get_executor());
+
+					timer->expires_after(bucket.wait_time(buffer.size()));
+
+					auto [e0] = co_await timer->async_wait(asio::use_deferred_executor(from));
+					if (e0)
+						co_return{ e0, total };
+
+					continue;
+				}
+
+				auto [e1, n1] = co_await from.async_read_some(
+					asio::buffer(buffer.data(), size), asio::use_deferred_executor(from));
+				if (e1)
+				{
+					if (e1 != asio::error::eof)
+						ec = e1;
+					break;
+				}
+
+				bucket.consume(n1);
+
+				auto [e2, n2] = co_await asio::async_write(
+					to, asio::buffer(buffer.data(), n1), asio::use_deferred_executor(to));
+
+				total += n2;
+
+				if (e2)
+					co_return{ e2, total };
+
+				if (opt.transfer_callback)
+					opt.transfer_callback(n1);
+
+				// the peer sends faster than the buffer can hold, use a larger one next time.
+				if (n1 == buffer.size() && buffer.size() < max_buffer_size)
+					buffer.resize(buffer.size() * 2);
+			}
+
+			if (!ec)
+				relay_shutdown_send(to);
+
+			co_return{ ec, total };
+		}
+	};
+
+	struct async_relay_op
+	{
+		relay_option opt;
+
+		auto operator()(auto state, auto s1_ref, auto s2_ref) -> void
+		{
+			auto& s1 = s1_ref.get();
+			auto& s2 = s2_ref.get();
+
+			co_await asio::dispatch(asio::use_deferred_executor(s1));
+
+			state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+			// when one direction is failed, the other one is cancelled, and a finished direction
+			// (the peer has closed its sending side) doesn't stop the other one.
+			auto [order, e1, n1, e2, n2] = co_await asio::experimental::make_parallel_group(
+				asio::async_initiate<const asio::deferred_t&, void(asio::error_code, std::size_t)>(
+					asio::experimental::co_composed<void(asio::error_code, std::size_t)>(
+						async_relay_one_way_op{ opt }, s1), asio::deferred, std::ref(s1), std::ref(s2)),
+				asio::async_initiate<const asio::deferred_t&, void(asio::error_code, std::size_t)>(
+					asio::experimental::co_composed<void(asio::error_code, std::size_t)>(
+						async_relay_one_way_op{ opt }, s2), asio::deferred, std::ref(s2), std::ref(s1))
+			).async_wait(asio::experimental::wait_for_one_error(), asio::use_deferred_executor(s1));
+
+			asio::error_code ec = e1 ? e1 : e2;
+
+			// the cancelled one is caused by the failed one.
+			if (order[0] == 1 && e2 && e2 != asio::error::operation_aborted)
+				ec = e2;
+
+			co_return{ ec, n1, n2 };
+		}
+	};
+}
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+/**
+ * @brief Start an asynchronous operation to relay the data between two streams in both directions,
+ * until the both directions are finished, or one of them is failed.
+ * If the both streams are plain tcp sockets on linux, the data is moved by splice through a pipe
+ * without being copied to the user space, otherwise it's relayed by the buffers which are reused
+ * by the thread. When one side closes its sending side, the other side's sending side is shutdown
+ * too, and the other direction continues.
+ * @param s1 - The first stream.
+ * @param s2 - The second stream.
+ * @param opt - The rate limit, the buffer size and the transfer callback.
+ * @param token - The completion handler to invoke when the operation completes.
+ *	  The equivalent function signature of the handler must be:
+ *    @code
+ *    void handler(const asio::error_code& ec, std::size_t s1_to_s2_bytes, std::size_t s2_to_s1_bytes);
+ */
+template<
+	typename AsyncStream1,
+	typename AsyncStream2,
+	typename RelayToken = asio::default_token_type<AsyncStream1>>
+inline auto async_relay(
+	AsyncStream1& s1,
+	AsyncStream2& s2,
+	relay_option opt,
+	RelayToken&& token = asio::default_token_type<AsyncStream1>())
+{
+	return async_initiate<RelayToken, void(asio::error_code, std::size_t, std::size_t)>(
+		experimental::co_composed<void(asio::error_code, std::size_t, std::size_t)>(
+			detail::async_relay_op{ std::move(opt) }, s1),
+		token, std::ref(s1), std::ref(s2));
+}
+
+/**
+ * @brief Start an asynchronous operation to relay the data between two streams in both directions.
+ * @param s1 - The first stream.
+ * @param s2 - The second stream.
+ * @param token - The completion handler to invoke when the operation completes.
+ *	  The equivalent function signature of the handler must be:
+ *    @code
+ *    void handler(const asio::error_code& ec, std::size_t s1_to_s2_bytes, std::size_t s2_to_s1_bytes);
+ */
+template<
+	typename AsyncStream1,
+	typename AsyncStream2,
+	typename RelayToken = asio::default_token_type<AsyncStream1>>
+requires (!std::same_as<std::remove_cvref_t<RelayToken>, relay_option>)
+inline auto async_relay(
+	AsyncStream1& s1,
+	AsyncStream2& s2,
+	RelayToken&& token = asio::default_token_type<AsyncStream1>())
+{
+	return asio::async_relay(s1, s2, relay_option{}, std::forward<RelayToken>(token));
+}
+}
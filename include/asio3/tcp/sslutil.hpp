@@ -10,16 +10,886 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <asio3/core/defer.hpp>
 #include <asio3/core/netutil.hpp>
 #include <asio3/core/with_lock.hpp>
 
 #if defined(ASIO3_ENABLE_SSL)
+#include <openssl/rand.h>
+#include <openssl/evp.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#else
+#include <openssl/hmac.h>
+#endif
+
+#ifdef ASIO_STANDALONE
+namespace asio::detail
+#else
+namespace boost::asio::detail
+#endif
+{
+	/**
+	 * @brief Get the SSL_CTX ex data index of the type T, the shared_ptr<T> which is saved in
+	 * the SSL_CTX is released when the SSL_CTX is freed.
+	 */
+	template<typename T>
+	inline int ssl_ctx_ex_index() noexcept
+	{
+		static const int index = ::SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr,
+			[](void*, void* ptr, CRYPTO_EX_DATA*, int, long, void*)
+			{
+				delete static_cast<std::shared_ptr<T>*>(ptr);
+			});
+		return index;
+	}
+
+	template<typename T>
+	inline T* get_ssl_ctx_ex_data(const SSL_CTX* ctx) noexcept
+	{
+		if (!ctx)
+			return nullptr;
+
+		auto* p = static_cast<std::shared_ptr<T>*>(::SSL_CTX_get_ex_data(ctx, ssl_ctx_ex_index<T>()));
+
+		return p ? p->get() : nullptr;
+	}
+
+	template<typename T>
+	inline void set_ssl_ctx_ex_data(SSL_CTX* ctx, std::shared_ptr<T> value)
+	{
+		delete static_cast<std::shared_ptr<T>*>(::SSL_CTX_get_ex_data(ctx, ssl_ctx_ex_index<T>()));
+
+		::SSL_CTX_set_ex_data(ctx, ssl_ctx_ex_index<T>(),
+			value ? new std::shared_ptr<T>(std::move(value)) : nullptr);
+	}
+
+	struct ssl_async_offload_handshake_op;
+
+	template<typename T>
+	inline std::shared_ptr<T> get_ssl_ctx_ex_shared(const SSL_CTX* ctx)
+	{
+		if (!ctx)
+			return nullptr;
+
+		auto* p = static_cast<std::shared_ptr<T>*>(::SSL_CTX_get_ex_data(ctx, ssl_ctx_ex_index<T>()));
+
+		return p ? *p : nullptr;
+	}
+
+	/**
+	 * @brief Get the SSL ex data index of the session cache key, the key is a std::string.
+	 */
+	inline int ssl_session_key_ex_index() noexcept
+	{
+		static const int index = ::SSL_get_ex_new_index(0, nullptr, nullptr, nullptr,
+			[](void*, void* ptr, CRYPTO_EX_DATA*, int, long, void*)
+			{
+				delete static_cast<std::string*>(ptr);
+			});
+		return index;
+	}
+
+	/**
+	 * @brief Make the session cache key of the ssl stream, it's the sni hostname and the remote endpoint.
+	 */
+	template<typename SslStream>
+	inline std::string make_ssl_session_key(SslStream& ssl_stream)
+	{
+		asio::error_code ec{};
+		auto ep = ssl_stream.lowest_layer().remote_endpoint(ec);
+		if (ec)
+			return {};
+
+		std::string key;
+
+		if (const char* name = ::SSL_get_servername(ssl_stream.native_handle(), TLSEXT_NAMETYPE_host_name))
+			key += name;
+
+		key += '@';
+		key += ep.address().to_string();
+		key += ':';
+		key += std::to_string(ep.port());
+
+		return key;
+	}
+}
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+	/**
+	 * @brief The client side tls session cache, the sessions are keyed by the sni hostname and
+	 * the remote endpoint. Both the TLS 1.3 session tickets and the TLS 1.2 session ids are
+	 * cached, so a reconnect to the same endpoint resumes the session with a abbreviated handshake.
+	 * Attach the cache to a client ssl context, then all the client handshakes of the context
+	 * which are performed by asio::async_handshake will use it.
+	 * All the member functions are thread safe.
+	 */
+	class ssl_session_cache
+	{
+	public:
+		struct statistics
+		{
+			std::size_t full_handshakes    = 0;
+			std::size_t resumed_handshakes = 0;
+			std::size_t insertions         = 0;
+			std::size_t evictions          = 0;
+		};
+
+		/**
+		 * @brief constructor
+		 * @param max_sessions - the max count of the cached sessions, the least recently used
+		 * session will be evicted when the count is exceeded.
+		 */
+		explicit ssl_session_cache(std::size_t max_sessions = 1024)
+			: max_sessions_((std::max)(max_sessions, std::size_t(1)))
+		{
+		}
+
+		~ssl_session_cache()
+		{
+			clear();
+		}
+
+		ssl_session_cache(const ssl_session_cache&) = delete;
+		ssl_session_cache& operator=(const ssl_session_cache&) = delete;
+
+		/**
+		 * @brief Attach the session cache to a client ssl context.
+		 * A cache can be attached to many contexts, the context holds a reference of the cache.
+		 * The new session callback and the session cache mode of the context are replaced.
+		 */
+		static inline void attach(asio::ssl::context& ctx, std::shared_ptr<ssl_session_cache> cache)
+		{
+			SSL_CTX* p = ctx.native_handle();
+
+			// the sessions are saved in this cache only, the internal cache of openssl is useless
+			// for the client.
+			::SSL_CTX_set_session_cache_mode(p, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+
+			// this callback is called when a new session is established, for TLS 1.3 it's called
+			// after the handshake when the server sends the NewSessionTicket message.
+			::SSL_CTX_sess_set_new_cb(p, &ssl_session_cache::on_new_session);
+
+			detail::set_ssl_ctx_ex_data(p, std::move(cache));
+		}
+
+		/**
+		 * @brief Get the session cache which was attached to the ssl context, may be nullptr.
+		 */
+		[[nodiscard]] static inline ssl_session_cache* find(const SSL_CTX* ctx) noexcept
+		{
+			return detail::get_ssl_ctx_ex_data<ssl_session_cache>(ctx);
+		}
+
+		/**
+		 * @brief Bind the ssl to the key and set the cached session of the key to the ssl.
+		 * It must be called before the client handshake.
+		 * @return true if a cached session was set.
+		 */
+		inline bool prepare(SSL* ssl, std::string key)
+		{
+			int index = detail::ssl_session_key_ex_index();
+
+			if (auto* p = static_cast<std::string*>(::SSL_get_ex_data(ssl, index)))
+				*p = std::move(key);
+			else
+				::SSL_set_ex_data(ssl, index, new std::string(std::move(key)));
+
+			const std::string& k = *static_cast<std::string*>(::SSL_get_ex_data(ssl, index));
+
+			std::lock_guard guard{ mtx_ };
+
+			if (!k.empty())
+			{
+				if (auto it = map_.find(k); it != map_.end())
+				{
+					// a TLS 1.3 session can't be resumed again after it was used, the server
+					// will send a new ticket in that connection.
+					if (::SSL_SESSION_is_resumable(it->second->session))
+					{
+						lru_.splice(lru_.begin(), lru_, it->second);
+
+						// SSL_set_session increments the reference count of the session.
+						return ::SSL_set_session(ssl, it->second->session) == 1;
+					}
+
+					erase_unlocked(k);
+				}
+			}
+
+			// the ssl may be reused by SSL_clear, don't resume the session of the last connection.
+			::SSL_set_session(ssl, nullptr);
+
+			return false;
+		}
+
+		/**
+		 * @brief Update the statistics after the handshake, and remove the cached session if
+		 * the handshake failed, the session maybe the reason of the failure.
+		 */
+		inline void complete(SSL* ssl, const asio::error_code& ec)
+		{
+			std::lock_guard guard{ mtx_ };
+
+			if (ec)
+			{
+				if (auto* key = static_cast<std::string*>(::SSL_get_ex_data(ssl, detail::ssl_session_key_ex_index())))
+					erase_unlocked(*key);
+			}
+			else if (::SSL_session_reused(ssl))
+			{
+				++stats_.resumed_handshakes;
+
+				// the new session callback isn't called when a TLS 1.2 session is resumed even
+				// if the server renewed the ticket, so save the renewed session here.
+				if (auto* key = static_cast<std::string*>(::SSL_get_ex_data(ssl, detail::ssl_session_key_ex_index())))
+				{
+					SSL_SESSION* session = ::SSL_get0_session(ssl);
+
+					if (auto it = map_.find(*key); it != map_.end() && it->second->session != session)
+					{
+						if (session && ::SSL_SESSION_is_resumable(session))
+						{
+							::SSL_SESSION_up_ref(session);
+							insert_unlocked(*key, session);
+						}
+					}
+				}
+			}
+			else
+			{
+				++stats_.full_handshakes;
+			}
+		}
+
+		/**
+		 * @brief Save the session with the key, the reference count of the session is incremented.
+		 */
+		inline void insert(std::string key, SSL_SESSION* session)
+		{
+			::SSL_SESSION_up_ref(session);
+
+			std::lock_guard guard{ mtx_ };
+
+			insert_unlocked(std::move(key), session);
+		}
+
+		/**
+		 * @brief Remove the session of the key.
+		 */
+		inline void erase(const std::string& key)
+		{
+			std::lock_guard guard{ mtx_ };
+
+			erase_unlocked(key);
+		}
+
+		/**
+		 * @brief Remove all the sessions.
+		 */
+		inline void clear()
+		{
+			std::lock_guard guard{ mtx_ };
+
+			for (auto& e : lru_)
+			{
+				::SSL_SESSION_free(e.session);
+			}
+
+			map_.clear();
+			lru_.clear();
+		}
+
+		/**
+		 * @brief Get the count of the cached sessions.
+		 */
+		[[nodiscard]] inline std::size_t size() const
+		{
+			std::lock_guard guard{ mtx_ };
+
+			return lru_.size();
+		}
+
+		/**
+		 * @brief Get the statistics of the handshakes and the cache.
+		 */
+		[[nodiscard]] inline statistics get_statistics() const
+		{
+			std::lock_guard guard{ mtx_ };
+
+			return stats_;
+		}
+
+	protected:
+		struct entry
+		{
+			std::string  key;
+			SSL_SESSION* session = nullptr;
+		};
+
+		static int on_new_session(SSL* ssl, SSL_SESSION* session)
+		{
+			ssl_session_cache* cache = find(::SSL_get_SSL_CTX(ssl));
+			if (!cache)
+				return 0;
+
+			auto* key = static_cast<std::string*>(::SSL_get_ex_data(ssl, detail::ssl_session_key_ex_index()));
+			if (!key || key->empty() || !::SSL_SESSION_is_resumable(session))
+				return 0;
+
+			std::lock_guard guard{ cache->mtx_ };
+
+			cache->insert_unlocked(*key, session);
+
+			// return 1 to take the reference of the session.
+			return 1;
+		}
+
+		inline void insert_unlocked(std::string key, SSL_SESSION* session)
+		{
+			if (auto it = map_.find(key); it != map_.end())
+			{
+				::SSL_SESSION_free(it->second->session);
+				it->second->session = session;
+				lru_.splice(lru_.begin(), lru_, it->second);
+			}
+			else
+			{
+				lru_.emplace_front(entry{ std::move(key), session });
+				map_.emplace(lru_.front().key, lru_.begin());
+			}
+
+			++stats_.insertions;
+
+			while (lru_.size() > max_sessions_)
+			{
+				map_.erase(lru_.back().key);
+				::SSL_SESSION_free(lru_.back().session);
+				lru_.pop_back();
+
+				++stats_.evictions;
+			}
+		}
+
+		inline void erase_unlocked(const std::string& key)
+		{
+			if (auto it = map_.find(key); it != map_.end())
+			{
+				auto node = it->second;
+				map_.erase(it);
+				::SSL_SESSION_free(node->session);
+				lru_.erase(node);
+			}
+		}
+
+	protected:
+		mutable std::mutex                                               mtx_;
+
+		std::size_t                                                      max_sessions_;
+
+		std::list<entry>                                                 lru_;
+
+		// the key is a view of entry::key.
+		std::unordered_map<std::string_view, std::list<entry>::iterator> map_;
+
+		statistics                                                       stats_;
+	};
+
+	/**
+	 * @brief Get the session cache which is shared by the client ssl contexts created by asio itself.
+	 */
+	inline const std::shared_ptr<ssl_session_cache>& default_ssl_session_cache()
+	{
+		static const std::shared_ptr<ssl_session_cache> cache = std::make_shared<ssl_session_cache>();
+		return cache;
+	}
+
+	/**
+	 * @brief The server side tls session ticket keys. The tickets are encrypted by the current
+	 * key, the key is rotated periodically, the tickets which were encrypted by the previous keys
+	 * can still be decrypted, and they are renewed with the current key.
+	 * Attach the keys to the server ssl context, if the context is shared by many servers, they
+	 * will share the keys too, so a client can resume the session on any of them.
+	 * All the member functions are thread safe.
+	 */
+	class ssl_ticket_keys
+	{
+	public:
+		struct statistics
+		{
+			std::size_t full_handshakes    = 0;
+			std::size_t resumed_handshakes = 0;
+			std::size_t rotations          = 0;
+		};
+
+		/**
+		 * @brief constructor
+		 * @param rotation_interval - the key is rotated when it was used for this time.
+		 * @param max_keys - the count of the keys which can decrypt the tickets, include the
+		 * current key, so a ticket is valid for (max_keys - 1) * rotation_interval at least.
+		 */
+		explicit ssl_ticket_keys(
+			std::chrono::steady_clock::duration rotation_interval = std::chrono::hours(12),
+			std::size_t max_keys = 2)
+			: rotation_interval_(rotation_interval)
+			, max_keys_((std::max)(max_keys, std::size_t(1)))
+		{
+			rotate();
+		}
+
+		ssl_ticket_keys(const ssl_ticket_keys&) = delete;
+		ssl_ticket_keys& operator=(const ssl_ticket_keys&) = delete;
+
+		~ssl_ticket_keys()
+		{
+			std::lock_guard guard{ mtx_ };
+
+			for (auto& k : keys_)
+			{
+				::OPENSSL_cleanse(std::addressof(k), sizeof(k));
+			}
+		}
+
+		/**
+		 * @brief Attach the ticket keys to a server ssl context.
+		 * The ticket key callback of the context is replaced.
+		 * @param configure_session - whether to set the session timeout of the context, which is
+		 * also the ticket lifetime hint, to the rotation interval, and set the session id context
+		 * to "asio3". Pass false to keep the values which were set by the user.
+		 */
+		static inline void attach(
+			asio::ssl::context& ctx, std::shared_ptr<ssl_ticket_keys> keys, bool configure_session = true)
+		{
+			SSL_CTX* p = ctx.native_handle();
+
+			if (configure_session)
+			{
+				auto lifetime = std::chrono::duration_cast<std::chrono::seconds>(keys->rotation_interval_);
+
+				::SSL_CTX_set_timeout(p, static_cast<long>((std::max)(lifetime.count(), decltype(lifetime.count())(1))));
+
+				// the sessions can't be resumed if the peer is verified but the id context is not set.
+				::SSL_CTX_set_session_id_context(p, reinterpret_cast<const unsigned char*>("asio3"), 5);
+			}
+
+		#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+			::SSL_CTX_set_tlsext_ticket_key_evp_cb(p, &ssl_ticket_keys::on_ticket_key);
+		#else
+			::SSL_CTX_set_tlsext_ticket_key_cb(p, &ssl_ticket_keys::on_ticket_key);
+		#endif
+
+			detail::set_ssl_ctx_ex_data(p, std::move(keys));
+		}
+
+		/**
+		 * @brief Get the ticket keys which was attached to the ssl context, may be nullptr.
+		 */
+		[[nodiscard]] static inline ssl_ticket_keys* find(const SSL_CTX* ctx) noexcept
+		{
+			return detail::get_ssl_ctx_ex_data<ssl_ticket_keys>(ctx);
+		}
+
+		/**
+		 * @brief Generate a new current key immediately, the oldest key is dropped if the count
+		 * of the keys exceeds the max_keys.
+		 */
+		inline void rotate()
+		{
+			std::lock_guard guard{ mtx_ };
+
+			rotate_unlocked();
+		}
+
+		/**
+		 * @brief Update the statistics after the handshake.
+		 */
+		inline void complete(SSL* ssl, const asio::error_code& ec)
+		{
+			if (ec)
+				return;
+
+			std::lock_guard guard{ mtx_ };
+
+			if (::SSL_session_reused(ssl))
+				++stats_.resumed_handshakes;
+			else
+				++stats_.full_handshakes;
+		}
+
+		/**
+		 * @brief Get the statistics of the handshakes and the rotations.
+		 */
+		[[nodiscard]] inline statistics get_statistics() const
+		{
+			std::lock_guard guard{ mtx_ };
+
+			return stats_;
+		}
+
+	protected:
+		struct key
+		{
+			unsigned char name[16];
+			unsigned char hmac_key[32];
+			unsigned char aes_key[32];
+		};
+
+		inline void rotate_unlocked()
+		{
+			key k{};
+
+			if (::RAND_bytes(k.name, sizeof(k.name)) != 1 ||
+				::RAND_bytes(k.hmac_key, sizeof(k.hmac_key)) != 1 ||
+				::RAND_bytes(k.aes_key, sizeof(k.aes_key)) != 1)
+			{
+				return;
+			}
+
+			keys_.emplace_front(k);
+
+			::OPENSSL_cleanse(std::addressof(k), sizeof(k));
+
+			while (keys_.size() > max_keys_)
+			{
+				::OPENSSL_cleanse(std::addressof(keys_.back()), sizeof(key));
+				keys_.pop_back();
+			}
+
+			rotated_time_ = std::chrono::steady_clock::now();
+
+			++stats_.rotations;
+		}
+
+	#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+		static inline bool init_hmac(EVP_MAC_CTX* hctx, unsigned char* hmac_key)
+		{
+			OSSL_PARAM params[3];
+			params[0] = ::OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, hmac_key, 32);
+			params[1] = ::OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char*>("sha256"), 0);
+			params[2] = ::OSSL_PARAM_construct_end();
+			return ::EVP_MAC_CTX_set_params(hctx, params) == 1;
+		}
+	#else
+		static inline bool init_hmac(HMAC_CTX* hctx, unsigned char* hmac_key)
+		{
+			return ::HMAC_Init_ex(hctx, hmac_key, 32, ::EVP_sha256(), nullptr) == 1;
+		}
+	#endif
+
+		// see the example of SSL_CTX_set_tlsext_ticket_key_cb in the openssl document.
+		template<typename HmacCtx>
+		static int on_ticket_key(SSL* ssl, unsigned char* key_name, unsigned char* iv,
+			EVP_CIPHER_CTX* cctx, HmacCtx* hctx, int enc)
+		{
+			ssl_ticket_keys* self = find(::SSL_get_SSL_CTX(ssl));
+			if (!self)
+				return -1;
+
+			std::lock_guard guard{ self->mtx_ };
+
+			if (enc)
+			{
+				if (self->keys_.empty() ||
+					std::chrono::steady_clock::now() - self->rotated_time_ >= self->rotation_interval_)
+				{
+					self->rotate_unlocked();
+				}
+
+				if (self->keys_.empty())
+					return -1;
+
+				key& k = self->keys_.front();
+
+				if (::RAND_bytes(iv, ::EVP_CIPHER_iv_length(::EVP_aes_256_cbc())) != 1)
+					return -1;
+
+				std::memcpy(key_name, k.name, sizeof(k.name));
+
+				if (::EVP_EncryptInit_ex(cctx, ::EVP_aes_256_cbc(), nullptr, k.aes_key, iv) != 1)
+					return -1;
+
+				if (!init_hmac(hctx, k.hmac_key))
+					return -1;
+
+				return 1;
+			}
+			else
+			{
+				for (std::size_t i = 0; i < self->keys_.size(); ++i)
+				{
+					key& k = self->keys_[i];
+
+					if (std::memcmp(key_name, k.name, sizeof(k.name)) != 0)
+						continue;
+
+					if (!init_hmac(hctx, k.hmac_key))
+						return -1;
+
+					if (::EVP_DecryptInit_ex(cctx, ::EVP_aes_256_cbc(), nullptr, k.aes_key, iv) != 1)
+						return -1;
+
+					// return 2 to renew the ticket which was encrypted by a previous key, the
+					// TLS 1.3 tickets are always renewed because the client uses them only once.
+					return (i == 0 && ::SSL_version(ssl) < TLS1_3_VERSION) ? 1 : 2;
+				}
+
+				// the key is expired or unknown, perform a full handshake.
+				return 0;
+			}
+		}
+
+	protected:
+		mutable std::mutex                    mtx_;
+
+		std::chrono::steady_clock::duration   rotation_interval_;
+
+		std::size_t                           max_keys_;
+
+		// the front is the current key.
+		std::deque<key>                       keys_;
+
+		std::chrono::steady_clock::time_point rotated_time_{};
+
+		statistics                            stats_;
+	};
+
+	/**
+	 * @brief The crypto worker pool of the tls handshakes. The handshakes of a ssl context which
+	 * has the pool attached are driven on the pool, so the private key operations of a burst of
+	 * new connections don't stall the established connections of the io_context. The socket
+	 * reads and writes are still performed by the io_context, and asio::async_handshake resumes
+	 * on the executor of the ssl stream when the handshake is finished.
+	 * It's opt-in, a full handshake costs two more thread switches at least, so it's only worth
+	 * for the servers which accept many new connections, or use the expensive rsa keys.
+	 * All the member functions are thread safe.
+	 * @code
+	 *   auto offload = std::make_shared<asio::ssl_handshake_offload>(4);
+	 *   asio::ssl_handshake_offload::attach(server.ssl_context, offload);
+	 * @endcode
+	 */
+	class ssl_handshake_offload
+	{
+	public:
+		struct statistics
+		{
+			// the count of the handshakes which were driven on the pool.
+			std::size_t offloaded_handshakes = 0;
+
+			// the count of the handshakes which are running on the pool now.
+			std::size_t pending_handshakes   = 0;
+		};
+
+		/**
+		 * @brief constructor
+		 * @param thread_count - the thread count of the crypto worker pool.
+		 */
+		explicit ssl_handshake_offload(
+			std::size_t thread_count = (std::max)(std::thread::hardware_concurrency(), 1u))
+			: pool_((std::max)(thread_count, std::size_t(1)))
+		{
+		}
+
+		ssl_handshake_offload(const ssl_handshake_offload&) = delete;
+		ssl_handshake_offload& operator=(const ssl_handshake_offload&) = delete;
+
+		~ssl_handshake_offload()
+		{
+			pool_.join();
+		}
+
+		/**
+		 * @brief Attach the crypto worker pool to a ssl context, the context can be a client
+		 * context or a server context. Pass nullptr to detach the pool.
+		 */
+		static inline void attach(asio::ssl::context& ctx, std::shared_ptr<ssl_handshake_offload> offload)
+		{
+			detail::set_ssl_ctx_ex_data(ctx.native_handle(), std::move(offload));
+		}
+
+		/**
+		 * @brief Get the crypto worker pool which was attached to the ssl context, may be nullptr.
+		 * The pool is returned as a shared_ptr, so it's alive until the handshake is finished
+		 * even if the context is detached.
+		 */
+		[[nodiscard]] static inline std::shared_ptr<ssl_handshake_offload> find(const SSL_CTX* ctx)
+		{
+			return detail::get_ssl_ctx_ex_shared<ssl_handshake_offload>(ctx);
+		}
+
+		/**
+		 * @brief Get the executor of the crypto worker pool.
+		 */
+		[[nodiscard]] inline asio::thread_pool::executor_type get_executor() noexcept
+		{
+			return pool_.get_executor();
+		}
+
+		/**
+		 * @brief Get the statistics of the offloaded handshakes.
+		 */
+		[[nodiscard]] inline statistics get_statistics() const noexcept
+		{
+			statistics stats{};
+			stats.offloaded_handshakes = offloaded_.load(std::memory_order_relaxed);
+			stats.pending_handshakes   = pending_.load(std::memory_order_relaxed);
+			return stats;
+		}
+
+	protected:
+		friend struct detail::ssl_async_offload_handshake_op;
+
+		asio::thread_pool        pool_;
+
+		std::atomic<std::size_t> offloaded_{ 0 };
+
+		std::atomic<std::size_t> pending_{ 0 };
+	};
+}
+
 #ifdef ASIO_STANDALONE
 namespace asio::detail
 #else
 namespace boost::asio::detail
 #endif
 {
+	/**
+	 * @brief Set the cached session before the client handshake.
+	 */
+	template<typename SslStream>
+	inline void prepare_ssl_handshake(SslStream& ssl_stream, ssl::stream_base::handshake_type handsk_type)
+	{
+		SSL* ssl = ssl_stream.native_handle();
+
+		if (handsk_type == ssl::stream_base::handshake_type::client)
+		{
+			if (ssl_session_cache* cache = ssl_session_cache::find(::SSL_get_SSL_CTX(ssl)))
+				cache->prepare(ssl, detail::make_ssl_session_key(ssl_stream));
+		}
+	}
+
+	/**
+	 * @brief Update the handshake statistics of the session cache or the ticket keys.
+	 */
+	template<typename SslStream>
+	inline void complete_ssl_handshake(
+		SslStream& ssl_stream, ssl::stream_base::handshake_type handsk_type, const asio::error_code& ec)
+	{
+		SSL* ssl = ssl_stream.native_handle();
+
+		if (handsk_type == ssl::stream_base::handshake_type::client)
+		{
+			if (ssl_session_cache* cache = ssl_session_cache::find(::SSL_get_SSL_CTX(ssl)))
+				cache->complete(ssl, ec);
+		}
+		else
+		{
+			if (ssl_ticket_keys* keys = ssl_ticket_keys::find(::SSL_get_SSL_CTX(ssl)))
+				keys->complete(ssl, ec);
+		}
+	}
+}
+
+#ifdef ASIO_STANDALONE
+namespace asio::detail
+#else
+namespace boost::asio::detail
+#endif
+{
+	/**
+	 * @brief Drive the handshake on a strand of the crypto worker pool. The openssl engine of
+	 * the ssl stream is called by the intermediate handlers of the handshake, they run on the
+	 * strand because the handler is bound to it, so all the cpu work of the handshake is done
+	 * by the pool, while the socket reads and writes wait in the reactor as usual. The socket
+	 * is only touched by the strand until the handshake is finished.
+	 */
+	struct ssl_async_offload_handshake_op
+	{
+		auto operator()(auto state, auto stream_ref,
+			ssl::stream_base::handshake_type handsk_type,
+			std::chrono::steady_clock::duration handsk_timeout,
+			std::shared_ptr<ssl_handshake_offload> offload) -> void
+		{
+			auto& ssl_stream = stream_ref.get();
+
+			state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+			auto strand = asio::make_strand(offload->get_executor());
+
+			struct handshake_state
+			{
+				bool running   = true;
+				bool timed_out = false;
+			};
+
+			// the socket is only touched by the strand while the handshake is running, so the
+			// timeout just aborts the pending operations on the strand, the socket is closed
+			// and the lock is reset on the executor of the stream after the strand is left.
+			auto hs = std::make_shared<handshake_state>();
+
+			[[maybe_unused]] detail::call_func_when_timeout wt(
+				asio::detail::get_lowest_executor(ssl_stream), handsk_timeout,
+				[&ssl_stream, strand, hs]() mutable
+				{
+					asio::post(strand, [&ssl_stream, hs]() mutable
+					{
+						if (hs->running)
+						{
+							hs->timed_out = true;
+
+							// the shutdown also fails the read which is started after this.
+							error_code ec{};
+							ssl_stream.next_layer().shutdown(asio::socket_base::shutdown_both, ec);
+							ssl_stream.next_layer().cancel(ec);
+						}
+					});
+				});
+
+			offload->offloaded_.fetch_add(1, std::memory_order_relaxed);
+			offload->pending_.fetch_add(1, std::memory_order_relaxed);
+
+			std::defer dec_pending = [&offload]() mutable
+			{
+				offload->pending_.fetch_sub(1, std::memory_order_relaxed);
+			};
+
+			co_await asio::dispatch(asio::bind_executor(strand, asio::use_nothrow_deferred));
+
+			detail::prepare_ssl_handshake(ssl_stream, handsk_type);
+
+			auto [e1] = co_await ssl_stream.async_handshake(handsk_type,
+				asio::bind_executor(strand, asio::use_nothrow_deferred));
+
+			hs->running = false;
+
+			// resume on the executor of the ssl stream.
+			co_await asio::dispatch(asio::use_deferred_executor(ssl_stream));
+
+			if (hs->timed_out)
+			{
+				error_code ec{};
+				ssl_stream.next_layer().close(ec);
+				asio::reset_lock(ssl_stream.next_layer());
+			}
+
+			detail::complete_ssl_handshake(ssl_stream, handsk_type, e1);
+
+			co_return e1;
+		}
+	};
+
 	struct ssl_async_handshake_op
 	{
 		auto operator()(auto state, auto stream_ref,
@@ -32,6 +902,19 @@ namespace boost::asio::detail
 
 			state.reset_cancellation_state(asio::enable_terminal_cancellation());
 
+			if (std::shared_ptr<ssl_handshake_offload> offload =
+				ssl_handshake_offload::find(::SSL_get_SSL_CTX(ssl_stream.native_handle())))
+			{
+				auto token = asio::use_deferred_executor(ssl_stream);
+
+				auto [e1] = co_await asio::async_initiate<decltype(token), void(asio::error_code)>(
+					experimental::co_composed<void(asio::error_code)>(
+						detail::ssl_async_offload_handshake_op{}, ssl_stream),
+					token, stream_ref, handsk_type, handsk_timeout, std::move(offload));
+
+				co_return e1;
+			}
+
 			[[maybe_unused]] detail::call_func_when_timeout wt(
 				asio::detail::get_lowest_executor(ssl_stream), handsk_timeout,
 				[&ssl_stream]() mutable
@@ -41,10 +924,15 @@ namespace boost::asio::detail
 					asio::reset_lock(ssl_stream.next_layer());
 				});
 
+			detail::prepare_ssl_handshake(ssl_stream, handsk_type);
+
 			auto [e1] = co_await ssl_stream.async_handshake(handsk_type, asio::use_deferred_executor(ssl_stream));
 
+			detail::complete_ssl_handshake(ssl_stream, handsk_type, e1);
+
 			co_return e1;
 		}
+
 	};
 
 	struct ssl_async_shutdown_op
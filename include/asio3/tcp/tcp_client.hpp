@@ -81,7 +81,7 @@ namespace boost::asio
 			auto&& data,
 			WriteToken&& token = asio::default_token_type<socket_type>())
 		{
-			return asio::async_send(socket,
+			return asio::async_send_queued(socket, send_queue,
 				std::forward_like<decltype(data)>(data), std::forward<WriteToken>(token));
 		}
 
@@ -178,6 +178,9 @@ namespace boost::asio
 		socket_type       socket;
 
 		std::atomic_flag  aborted{};
+
+		/// set send_queue.enabled to true to coalesce the concurrent sends into one write.
+		asio::send_queue  send_queue;
 	};
 
 	using tcp_client = basic_tcp_client<asio::tcp_socket>;
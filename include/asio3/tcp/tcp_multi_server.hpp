@@ -0,0 +1,409 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <span>
+
+#include <asio3/core/io_context_thread.hpp>
+#include <asio3/core/sharded_session_map.hpp>
+#include <asio3/tcp/listen.hpp>
+#include <asio3/tcp/tcp_session.hpp>
+
+#ifdef ASIO_STANDALONE
+namespace asio::detail
+#else
+namespace boost::asio::detail
+#endif
+{
+	struct tcp_async_multi_listen_op
+	{
+		auto operator()(
+			auto state, auto server_ref,
+			auto&& listen_address, auto&& listen_port) -> void
+		{
+			auto& server = server_ref.get();
+
+			using endpoint_type = asio::ip::tcp::endpoint;
+
+			std::string addr = asio::to_string(std::forward_like<decltype(listen_address)>(listen_address));
+			std::string port = asio::to_string(std::forward_like<decltype(listen_port)>(listen_port));
+
+			asio::tcp_acceptor& front = server.acceptors.front();
+
+			co_await asio::dispatch(asio::use_deferred_executor(front));
+
+			state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+			asio::tcp_resolver resolver(front.get_executor());
+
+			auto [e1, eps] = co_await asio::async_resolve(
+				resolver, std::move(addr), std::move(port),
+				asio::ip::resolver_base::passive, asio::use_deferred_executor(resolver));
+			if (e1)
+				co_return{ e1, endpoint_type{} };
+
+			if (!!state.cancelled())
+				co_return{ asio::error::operation_aborted, endpoint_type{} };
+
+			endpoint_type bnd_endpoint = eps.begin()->endpoint();
+
+			error_code ec{};
+
+			for (asio::tcp_acceptor& acceptor : server.acceptors)
+			{
+				acceptor.open(bnd_endpoint.protocol(), ec);
+				if (ec)
+					break;
+
+				acceptor.set_option(asio::socket_base::reuse_address(true), ec);
+
+			#if defined(SO_REUSEPORT)
+				acceptor.set_option(asio::reuse_port(true), ec);
+				if (ec)
+					break;
+			#endif
+
+				acceptor.bind(bnd_endpoint, ec);
+				if (ec)
+					break;
+
+				acceptor.listen(asio::socket_base::max_listen_connections, ec);
+				if (ec)
+					break;
+
+				// if the listen port is 0, all the other acceptors must use the port which
+				// was chosen by the system for the first acceptor.
+				bnd_endpoint = acceptor.local_endpoint(ec);
+
+			#if !defined(SO_REUSEPORT)
+				// without SO_REUSEPORT only one acceptor can be bound, the accepted sockets
+				// will be distributed to the reactors in round robin mode.
+				break;
+			#endif
+			}
+
+			if (ec)
+			{
+				for (asio::tcp_acceptor& acceptor : server.acceptors)
+				{
+					error_code ec_ignore{};
+					acceptor.close(ec_ignore);
+				}
+
+				server.reuse_port = false;
+
+				co_return{ ec, endpoint_type{} };
+			}
+
+		#if defined(SO_REUSEPORT)
+			server.reuse_port = true;
+		#else
+			server.reuse_port = false;
+		#endif
+
+			co_return{ ec, bnd_endpoint };
+		}
+	};
+}
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+	/**
+	 * @brief A tcp server which runs on multi reactors (io_context_thread).
+	 * When SO_REUSEPORT is supported, one acceptor is opened per reactor and the kernel
+	 * balances the incoming connections between them, otherwise only the first acceptor
+	 * is opened and the accepted sockets are distributed to the reactors in round robin.
+	 * The sessions are stored in a sharded session map which has one shard per reactor, every
+	 * session is stored in the shard of the reactor which its socket is bound to.
+	 */
+	template<typename SessionT = tcp_session, typename SessionMapT = asio::sharded_session_map<SessionT>>
+	class basic_tcp_multi_server
+	{
+	public:
+		using session_type = SessionT;
+		using session_map_type = SessionMapT;
+		using socket_type = typename SessionT::socket_type;
+
+		/**
+		 * @brief Create the server on the reactors, the reactors must outlive the server.
+		 */
+		explicit basic_tcp_multi_server(std::span<asio::io_context_thread> reactors)
+			: basic_tcp_multi_server(make_executors(reactors))
+		{
+		}
+
+		/**
+		 * @brief Create the server with one acceptor per executor.
+		 */
+		template<typename Executor>
+		requires (asio::execution::is_executor<Executor>::value || asio::is_executor<Executor>::value)
+		explicit basic_tcp_multi_server(const std::vector<Executor>& executors)
+			: acceptors(make_acceptors(executors))
+			, session_map(executors)
+		{
+		}
+
+		// the atomics can't be moved, and the accept loops reference the server.
+		basic_tcp_multi_server(basic_tcp_multi_server&&) = delete;
+		basic_tcp_multi_server& operator=(basic_tcp_multi_server&&) = delete;
+
+		~basic_tcp_multi_server()
+		{
+		}
+
+		/**
+		 * @brief Asynchronously start all the acceptors for listen at the address and port.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, asio::ip::tcp::endpoint ep);
+		 */
+		template<typename ListenToken = asio::default_token_type<asio::tcp_acceptor>>
+		inline auto async_listen(
+			is_string auto&& listen_address,
+			is_string_or_integral auto&& listen_port,
+			ListenToken&& token = asio::default_token_type<asio::tcp_acceptor>())
+		{
+			return asio::async_initiate<ListenToken, void(asio::error_code, asio::ip::tcp::endpoint)>(
+				experimental::co_composed<void(asio::error_code, asio::ip::tcp::endpoint)>(
+					detail::tcp_async_multi_listen_op{}, acceptors.front()),
+				token,
+				std::ref(*this),
+				std::forward_like<decltype(listen_address)>(listen_address),
+				std::forward_like<decltype(listen_port)>(listen_port));
+		}
+
+		/**
+		 * @brief Asynchronously accept a new connection from the acceptor of the reactor.
+		 * The accepted socket is bound to the executor of the reactor which it belongs to,
+		 * you should start an accept loop for each index that is_listening(index) returns true.
+		 * @param index - The reactor index.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, asio::ip::tcp::socket sock);
+		 */
+		template<typename AcceptToken = asio::default_token_type<asio::tcp_acceptor>>
+		inline auto async_accept(
+			std::size_t index,
+			AcceptToken&& token = asio::default_token_type<asio::tcp_acceptor>())
+		{
+			// with SO_REUSEPORT every reactor has its own acceptor, the flag is used instead of
+			// the acceptors, because they maybe closed by async_stop in other reactors.
+			if (reuse_port)
+			{
+				asio::tcp_acceptor& acceptor = acceptors.at(index);
+
+				return acceptor.async_accept(acceptor.get_executor(), std::forward<AcceptToken>(token));
+			}
+
+			// only the first acceptor is opened, so choose the reactor in round robin mode.
+			std::size_t n = next_reactor.fetch_add(1, std::memory_order_relaxed) % acceptors.size();
+
+			return acceptors.front().async_accept(acceptors[n].get_executor(), std::forward<AcceptToken>(token));
+		}
+
+		/**
+		 * @brief Asynchronously stop the server.
+		 * All the acceptors are closed in their own reactor, then all the sessions are disconnected.
+		 */
+		template<typename StopToken = asio::default_token_type<asio::tcp_acceptor>>
+		inline auto async_stop(
+			StopToken&& token = asio::default_token_type<asio::tcp_acceptor>())
+		{
+			return asio::async_initiate<StopToken, void(error_code)>(
+				experimental::co_composed<void(error_code)>(
+					[](auto state, auto self_ref) -> void
+					{
+						auto& self = self_ref.get();
+
+						state.reset_cancellation_state(asio::disable_cancellation());
+
+						self.aborted.test_and_set();
+
+						error_code ec{};
+
+						for (asio::tcp_acceptor& acceptor : self.acceptors)
+						{
+							co_await asio::dispatch(asio::use_deferred_executor(acceptor));
+
+							error_code ec_close{};
+							acceptor.close(ec_close);
+							asio::reset_lock(acceptor);
+
+							if (!ec)
+								ec = ec_close;
+						}
+
+						co_await self.session_map.async_disconnect_all(
+							asio::use_deferred_executor(self.acceptors.front()));
+
+						co_return ec;
+					}, acceptors.front()), token, std::ref(*this));
+		}
+
+		/**
+		 * @brief Safety start an asynchronous operation to write all of the supplied data to all clients.
+		 * @param data - The written data.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, std::size_t sent_bytes);
+		 */
+		template<typename WriteToken = asio::default_token_type<socket_type>>
+		inline auto async_send(
+			auto&& data,
+			WriteToken&& token = asio::default_token_type<socket_type>())
+		{
+			return session_map.async_send_all(
+				std::forward_like<decltype(data)>(data),
+				std::forward<WriteToken>(token));
+		}
+
+		/**
+		 * @brief Start an asynchronous operation to write the data to all clients concurrently.
+		 * @param data - The written data.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, std::size_t sent_bytes,
+		 *        std::vector<std::pair<std::shared_ptr<session_type>, asio::error_code>> failures);
+		 */
+		template<typename BroadcastToken = asio::default_token_type<socket_type>>
+		inline auto async_broadcast(
+			auto&& data,
+			BroadcastToken&& token = asio::default_token_type<socket_type>())
+		{
+			return session_map.async_broadcast(
+				std::forward_like<decltype(data)>(data),
+				std::forward<BroadcastToken>(token));
+		}
+
+		/**
+		 * @brief Check whether the acceptor of the reactor is listening or not.
+		 */
+		[[nodiscard]] inline bool is_listening(std::size_t index) noexcept
+		{
+			return index < acceptors.size() && acceptors[index].is_open();
+		}
+
+		/**
+		 * @brief Check whether the server is stopped or not.
+		 */
+		[[nodiscard]] inline bool is_aborted() noexcept
+		{
+			return aborted.test();
+		}
+
+		/**
+		 * @brief Get the reactor count.
+		 */
+		[[nodiscard]] inline std::size_t reactor_count() const noexcept
+		{
+			return acceptors.size();
+		}
+
+		/**
+		 * @brief Get the executor associated with the reactor.
+		 */
+		inline auto get_executor(std::size_t index = 0) noexcept
+		{
+			return acceptors.at(index).get_executor();
+		}
+
+		/**
+		 * @brief Get the listen address.
+		 */
+		[[nodiscard]] inline std::string get_listen_address() noexcept
+		{
+			return asio::get_local_address(acceptors.front());
+		}
+
+		/**
+		 * @brief Get the listen port number.
+		 */
+		[[nodiscard]] inline ip::port_type get_listen_port() noexcept
+		{
+			return asio::get_local_port(acceptors.front());
+		}
+
+		/**
+		 * @brief Get the acceptor of the reactor.
+		 * https://devblogs.microsoft.com/cppblog/cpp23-deducing-this/
+		 */
+		constexpr inline auto&& get_acceptor(this auto&& self, std::size_t index = 0)
+		{
+			return std::forward_like<decltype(self)>(self).acceptors.at(index);
+		}
+
+		/**
+		 * @brief Get the session map.
+		 */
+		constexpr inline auto&& get_session_map(this auto&& self)
+		{
+			return std::forward_like<decltype(self)>(self).session_map;
+		}
+
+	protected:
+		static std::vector<asio::any_io_executor> make_executors(std::span<asio::io_context_thread> reactors)
+		{
+			std::vector<asio::any_io_executor> executors;
+
+			executors.reserve(reactors.size());
+
+			for (asio::io_context_thread& reactor : reactors)
+			{
+				executors.emplace_back(reactor.get_executor());
+			}
+
+			return executors;
+		}
+
+		template<typename Executor>
+		static std::vector<asio::tcp_acceptor> make_acceptors(const std::vector<Executor>& executors)
+		{
+			if (executors.empty())
+				asio::detail::throw_exception(std::invalid_argument("the executors can't be empty"));
+
+			std::vector<asio::tcp_acceptor> result;
+
+			result.reserve(executors.size());
+
+			for (const Executor& ex : executors)
+			{
+				result.emplace_back(ex);
+			}
+
+			return result;
+		}
+
+	public:
+		/// one acceptor per reactor, the acceptor is created with the executor of the reactor.
+		std::vector<asio::tcp_acceptor> acceptors;
+
+		session_map_type session_map;
+
+		/// the next reactor index which is used when SO_REUSEPORT is not supported.
+		std::atomic<std::size_t> next_reactor{ 0 };
+
+		/// whether every reactor has its own acceptor or not, it's set by async_listen.
+		bool reuse_port = false;
+
+		std::atomic_flag aborted{};
+	};
+
+	using tcp_multi_server = basic_tcp_multi_server<tcp_session>;
+}
@@ -12,6 +12,7 @@
 
 #include <asio3/core/io_context_thread.hpp>
 #include <asio3/core/session_map.hpp>
+#include <asio3/core/sharded_session_map.hpp>
 #include <asio3/tcp/listen.hpp>
 #include <asio3/tcp/tcp_session.hpp>
 
@@ -21,11 +22,12 @@ namespace asio
 namespace boost::asio
 #endif
 {
-	template<typename SessionT = tcp_session>
+	template<typename SessionT = tcp_session, typename SessionMapT = asio::session_map<SessionT>>
 	class basic_tcp_server
 	{
 	public:
 		using session_type = SessionT;
+		using session_map_type = SessionMapT;
 		using socket_type = typename SessionT::socket_type;
 
 		explicit basic_tcp_server(const auto& ex) : acceptor(ex), session_map(ex)
@@ -98,6 +100,25 @@ namespace boost::asio
 				std::forward<WriteToken>(token));
 		}
 
+		/**
+		 * @brief Start an asynchronous operation to write the data to all clients concurrently.
+		 * @param data - The written data.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, std::size_t sent_bytes,
+		 *        std::vector<std::pair<std::shared_ptr<session_type>, asio::error_code>> failures);
+		 */
+		template<typename BroadcastToken = asio::default_token_type<socket_type>>
+		inline auto async_broadcast(
+			auto&& data,
+			BroadcastToken&& token = asio::default_token_type<socket_type>())
+		{
+			return session_map.async_broadcast(
+				std::forward_like<decltype(data)>(data),
+				std::forward<BroadcastToken>(token));
+		}
+
 		/**
 		 * @brief Check whether the acceptor is stopped or not.
 		 */
@@ -150,7 +171,7 @@ namespace boost::asio
 	public:
 		asio::tcp_acceptor  acceptor;
 
-		session_map<session_type> session_map;
+		session_map_type session_map;
 	};
 
 	using tcp_server = basic_tcp_server<tcp_session>;
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <asio3/core/netutil.hpp>
+#include <asio3/core/timer_wheel.hpp>
 #include <asio3/tcp/read.hpp>
 #include <asio3/tcp/write.hpp>
 #include <asio3/tcp/disconnect.hpp>
@@ -65,7 +66,7 @@ namespace boost::asio
 			auto&& data,
 			WriteToken&& token = asio::default_token_type<socket_type>())
 		{
-			return asio::async_send(socket,
+			return asio::async_send_queued(socket, send_queue,
 				std::forward_like<decltype(data)>(data), std::forward<WriteToken>(token));
 		}
 
@@ -152,7 +153,7 @@ namespace boost::asio
 
 		inline void update_alive_time() noexcept
 		{
-			alive_time = std::chrono::system_clock::now();
+			alive_time = asio::coarse_clock::now();
 		}
 
 	public:
@@ -161,6 +162,9 @@ namespace boost::asio
 		std::chrono::system_clock::time_point alive_time{ std::chrono::system_clock::now() };
 
 		std::chrono::steady_clock::duration   disconnect_timeout{ asio::tcp_disconnect_timeout };
+
+		/// set send_queue.enabled to true to coalesce the concurrent sends into one write.
+		asio::send_queue                      send_queue;
 	};
 
 	using tcp_session = basic_tcp_session<asio::tcp_socket>;
@@ -32,6 +32,8 @@ namespace boost::asio
 			, ssl_context(std::move(sslctx))
 			, ssl_stream(super::socket, ssl_context)
 		{
+			// the new session callback and the session cache mode of the user are kept, call the
+			// asio::ssl_session_cache::attach to resume the last session when reconnecting.
 		}
 
 		basic_tcps_client(basic_tcps_client&&) noexcept = default;
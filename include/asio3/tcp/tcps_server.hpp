@@ -30,6 +30,8 @@ namespace boost::asio
 			: super(ex)
 			, ssl_context(std::move(sslctx))
 		{
+			// the ticket key callback of the user is kept, call the asio::ssl_ticket_keys::attach
+			// to issue the session tickets with the rotated keys.
 		}
 
 		basic_tcps_server(basic_tcps_server&&) noexcept = default;
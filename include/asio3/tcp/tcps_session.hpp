@@ -82,7 +82,7 @@ namespace boost::asio
 			auto&& data,
 			WriteToken&& token = asio::default_token_type<socket_type>())
 		{
-			return asio::async_send(ssl_stream,
+			return asio::async_send_queued(ssl_stream, this->send_queue,
 				std::forward_like<decltype(data)>(data), std::forward<WriteToken>(token));
 		}
 
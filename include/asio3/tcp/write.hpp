@@ -15,6 +15,7 @@
 #include <asio3/core/with_lock.hpp>
 #include <asio3/core/asio_buffer_specialization.hpp>
 #include <asio3/core/data_persist.hpp>
+#include <asio3/core/send_queue.hpp>
 #include <asio3/tcp/core.hpp>
 
 #ifdef ASIO_STANDALONE
@@ -45,6 +46,99 @@ namespace boost::asio::detail
 			co_return{ e1, n1 };
 		}
 	};
+
+	struct tcp_async_send_queued_op
+	{
+		auto operator()(auto state, auto sock_ref, auto queue_ref, auto&& data) -> void
+		{
+			auto& sock = sock_ref.get();
+			auto& queue = queue_ref.get();
+
+			auto msg = std::forward_like<decltype(data)>(data);
+
+			co_await asio::dispatch(asio::use_deferred_executor(sock));
+
+			if (!queue.enabled)
+			{
+				state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+				co_await asio::async_lock(sock, asio::use_deferred_executor(sock));
+
+				[[maybe_unused]] asio::defer_unlock defered_unlock{ sock };
+
+				auto [e1, n1] = co_await asio::async_write(
+					sock, asio::to_buffer(msg), asio::use_deferred_executor(sock));
+
+				co_return{ e1, n1 };
+			}
+
+			// the queue holds the pointer of the notify channel and the buffer of the msg,
+			// so this operation can't be cancelled after the msg is queued.
+			state.reset_cancellation_state(asio::disable_cancellation());
+
+			send_queue::notify_type notify(asio::detail::get_lowest_executor(sock), 1);
+
+			auto buffers = asio::to_buffer(msg);
+
+			if (queue.is_full(asio::buffer_size(buffers)))
+			{
+				queue.space_waiters.emplace_back(std::addressof(notify));
+
+				auto [e0, n0] = co_await notify.async_receive(asio::use_deferred_executor(notify));
+				if (e0)
+					co_return{ e0, 0 };
+			}
+
+			queue.push(buffers, std::addressof(notify));
+
+			// if no sender is draining the queue now, this sender becomes the writer,
+			// otherwise just wait for the result which will be notified by the writer.
+			bool is_writer = !queue.writing;
+
+			queue.writing = true;
+
+			for (;;)
+			{
+				// the writer only sends one batch which contains its own msg, then hands the
+				// queue over to the next sender, so the writer is never delayed by the senders
+				// which keep queueing msgs.
+				if (is_writer)
+				{
+					std::deque<send_queue::entry> batch;
+					std::vector<asio::const_buffer> gather;
+
+					queue.take(batch, gather);
+
+					auto [e1] = co_await asio::async_lock(sock, asio::use_deferred_executor(sock));
+					if (e1)
+					{
+						queue.complete(batch, e1, 0);
+					}
+					else
+					{
+						auto [e2, n2] = co_await asio::async_write(
+							sock, gather, asio::use_deferred_executor(sock));
+
+						asio::detail::unlock_channel(sock);
+
+						queue.complete(batch, e2, n2);
+					}
+
+					queue.handoff();
+				}
+
+				auto [e3, n3] = co_await notify.async_receive(asio::use_deferred_executor(notify));
+
+				if (queue.next_writer != std::addressof(notify))
+					co_return{ e3, n3 };
+
+				// this sender was chosen as the next writer, its msg is at the front of the queue.
+				queue.next_writer = nullptr;
+
+				is_writer = true;
+			}
+		}
+	};
 }
 
 #ifdef ASIO_STANDALONE
@@ -121,4 +215,35 @@ inline auto async_send(
 		detail::data_persist(std::forward_like<decltype(data)>(data)));
 }
 
+/**
+ * @brief Start an asynchronous operation to write all of the supplied data to a stream by the send queue.
+ *    If the send queue is enabled, all the messages queued while a write is in progress will be
+ *    coalesced into one scatter/gather write, otherwise it's same as the async_send.
+ * @param sock - The stream to which the data is to be written.
+ * @param queue - The send queue of the stream.
+ * @param data - The written data.
+ * @param token - The completion handler to invoke when the operation completes.
+ *	  The equivalent function signature of the handler must be:
+ *    @code
+ *    void handler(const asio::error_code& ec, std::size_t sent_bytes);
+ */
+template<
+	typename AsyncStream,
+	typename SendToken = asio::default_token_type<AsyncStream>>
+requires is_tcp_socket<AsyncStream>
+inline auto async_send_queued(
+	AsyncStream& sock,
+	send_queue& queue,
+	auto&& data,
+	SendToken&& token = asio::default_token_type<AsyncStream>())
+{
+	return async_initiate<SendToken, void(asio::error_code, std::size_t)>(
+		experimental::co_composed<void(asio::error_code, std::size_t)>(
+			detail::tcp_async_send_queued_op{}, sock),
+		token,
+		std::ref(sock),
+		std::ref(queue),
+		detail::data_persist(std::forward_like<decltype(data)>(data)));
+}
+
 }
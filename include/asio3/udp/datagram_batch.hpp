@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <asio3/core/asio.hpp>
+
+#if defined(__linux__)
+	#include <sys/socket.h>
+	#include <netinet/in.h>
+	#include <netinet/udp.h>
+#endif
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+#if defined(UDP_GRO)
+	/// let the kernel coalesce the datagrams of the same flow, the datagram_batch splits them
+	/// back when they are received. The coalesced datagram can be up to 64KiB, so the slot
+	/// size of the datagram_batch should be datagram_batch::gro_slot_size.
+	using udp_gro = asio::detail::socket_option::boolean<SOL_UDP, UDP_GRO>;
+#endif
+
+	/// the datagram which will be sent by asio::async_send_batch, the memory of the buffer
+	/// is retained by the caller.
+	using outgoing_datagram = std::pair<asio::const_buffer, asio::ip::udp::endpoint>;
+
+	struct udp_batch_option
+	{
+		/// merge the consecutive datagrams with the same size and destination into one
+		/// send with UDP_SEGMENT, only used on linux, and turned off automatically when
+		/// the kernel or the nic doesn't support it.
+		bool segmentation_offload = false;
+	};
+
+	/**
+	 * @brief A pre-allocated ring of receive buffers and source endpoints, it's filled by
+	 * asio::async_receive_batch. On linux all the buffers are filled by one recvmmsg call,
+	 * on other platforms the buffers are filled by the queued datagrams one by one.
+	 * The received datagrams are valid until the next receive.
+	 */
+	class datagram_batch
+	{
+	public:
+		using endpoint_type = asio::ip::udp::endpoint;
+
+		/// the slot size which can hold the largest coalesced datagram when the udp_gro is enabled.
+		static constexpr std::size_t gro_slot_size = 64 * 1024;
+
+		struct datagram
+		{
+			std::string_view     data;
+			const endpoint_type& endpoint;
+
+			/// the datagram is larger than the slot size, the tail of it is lost.
+			bool                 truncated = false;
+		};
+
+	protected:
+		struct entry
+		{
+			std::size_t offset;
+			std::size_t size;
+			std::size_t source;
+			bool        truncated = false;
+		};
+
+	public:
+		/**
+		 * @param capacity - The max count of the datagrams which are received by once.
+		 * @param slot_size - The buffer size of each datagram, the bigger datagrams are
+		 * truncated and marked by datagram::truncated. When the udp_gro is enabled, it
+		 * should be gro_slot_size.
+		 */
+		explicit datagram_batch(std::size_t capacity = 64, std::size_t slot_size = 2048)
+			: capacity_((std::max)(capacity, std::size_t(1)))
+			, slot_size_((std::max)(slot_size, std::size_t(1)))
+		{
+			storage_.resize(capacity_ * slot_size_);
+			endpoints_.resize(capacity_);
+			entries_.reserve(capacity_);
+
+		#if defined(__linux__)
+			msgs_.resize(capacity_);
+			iovs_.resize(capacity_);
+			controls_.resize(capacity_ * control_size);
+		#endif
+		}
+
+		datagram_batch(datagram_batch&&) noexcept = default;
+		datagram_batch& operator=(datagram_batch&&) noexcept = default;
+
+		/**
+		 * @brief Get the count of the received datagrams.
+		 */
+		[[nodiscard]] inline std::size_t size() const noexcept { return entries_.size(); }
+
+		[[nodiscard]] inline bool empty() const noexcept { return entries_.empty(); }
+
+		[[nodiscard]] inline std::size_t capacity() const noexcept { return capacity_; }
+
+		[[nodiscard]] inline std::size_t slot_size() const noexcept { return slot_size_; }
+
+		/**
+		 * @brief Get the received datagram by index.
+		 */
+		[[nodiscard]] inline datagram operator[](std::size_t i) const noexcept
+		{
+			const entry& e = entries_[i];
+			return datagram{ std::string_view(storage_.data() + e.offset, e.size), endpoints_[e.source], e.truncated };
+		}
+
+		/**
+		 * @brief Get the count of the truncated datagrams of the last receive.
+		 */
+		[[nodiscard]] inline std::size_t truncated() const noexcept { return truncated_; }
+
+		inline void clear() noexcept
+		{
+			entries_.clear();
+			truncated_ = 0;
+		}
+
+		/**
+		 * @brief Receive the queued datagrams without blocking.
+		 * @return The count of the received datagrams, the ec is would_block if there
+		 * is no queued datagram.
+		 */
+		template<typename Socket>
+		std::size_t receive_some(Socket& sock, asio::error_code& ec)
+		{
+			clear();
+
+		#if defined(__linux__)
+			for (std::size_t i = 0; i < capacity_; ++i)
+			{
+				iovs_[i].iov_base = storage_.data() + i * slot_size_;
+				iovs_[i].iov_len  = slot_size_;
+
+				::msghdr& hdr = msgs_[i].msg_hdr;
+				hdr.msg_name       = endpoints_[i].data();
+				hdr.msg_namelen    = static_cast<::socklen_t>(endpoints_[i].capacity());
+				hdr.msg_iov        = std::addressof(iovs_[i]);
+				hdr.msg_iovlen     = 1;
+				hdr.msg_control    = controls_.data() + i * control_size;
+				hdr.msg_controllen = control_size;
+				hdr.msg_flags      = 0;
+
+				msgs_[i].msg_len = 0;
+			}
+
+			int r = ::recvmmsg(sock.native_handle(), msgs_.data(),
+				static_cast<unsigned int>(capacity_), MSG_DONTWAIT, nullptr);
+			if (r < 0)
+			{
+				ec = asio::error_code(errno, asio::error::get_system_category());
+				return 0;
+			}
+
+			for (std::size_t i = 0; i < static_cast<std::size_t>(r); ++i)
+			{
+				::msghdr& hdr = msgs_[i].msg_hdr;
+
+				endpoints_[i].resize(hdr.msg_namelen);
+
+				std::size_t total = (std::min)(static_cast<std::size_t>(msgs_[i].msg_len), slot_size_);
+				std::size_t segment = total;
+
+			#if defined(UDP_GRO)
+				for (::cmsghdr* c = CMSG_FIRSTHDR(&hdr); c; c = CMSG_NXTHDR(&hdr, c))
+				{
+					if (c->cmsg_level == SOL_UDP && c->cmsg_type == UDP_GRO)
+					{
+						int gso_size = 0;
+						std::memcpy(std::addressof(gso_size), CMSG_DATA(c), sizeof(gso_size));
+						if (gso_size > 0)
+							segment = static_cast<std::size_t>(gso_size);
+					}
+				}
+			#endif
+
+				// a coalesced datagram is split into the original datagrams.
+				std::size_t offset = i * slot_size_;
+				do
+				{
+					std::size_t n = (std::min)(segment, total);
+					entries_.emplace_back(offset, n, i);
+					offset += n;
+					total -= n;
+				} while (total > 0);
+
+				// the bytes which exceed the slot are dropped by the kernel, so the last
+				// received segment is incomplete or the segments after it are lost.
+				if (hdr.msg_flags & MSG_TRUNC)
+				{
+					entries_.back().truncated = true;
+					++truncated_;
+				}
+			}
+
+			ec.clear();
+
+			return entries_.size();
+		#else
+			while (entries_.size() < capacity_)
+			{
+				// the datagram which is queued can be received without blocking.
+				std::size_t avail = sock.available(ec);
+				if (ec)
+					break;
+
+				if (avail == 0)
+				{
+					if (entries_.empty())
+						ec = asio::error::would_block;
+					break;
+				}
+
+				std::size_t i = entries_.size();
+
+				std::size_t n = sock.receive_from(
+					asio::buffer(storage_.data() + i * slot_size_, slot_size_), endpoints_[i], 0, ec);
+				if (ec)
+					break;
+
+				entries_.emplace_back(i * slot_size_, n, i);
+			}
+
+			if (!entries_.empty())
+				ec.clear();
+
+			return entries_.size();
+		#endif
+		}
+
+	protected:
+	#if defined(__linux__)
+		static constexpr std::size_t control_size = CMSG_SPACE(sizeof(int));
+	#endif
+
+		std::size_t                capacity_;
+
+		std::size_t                slot_size_;
+
+		std::vector<char>          storage_;
+
+		std::vector<endpoint_type> endpoints_;
+
+		std::vector<entry>         entries_;
+
+		std::size_t                truncated_ = 0;
+
+	#if defined(__linux__)
+		std::vector<::mmsghdr>     msgs_;
+
+		std::vector<::iovec>       iovs_;
+
+		std::vector<char>          controls_;
+	#endif
+	};
+}
+
+#ifdef ASIO_STANDALONE
+namespace asio::detail
+#else
+namespace boost::asio::detail
+#endif
+{
+#if defined(__linux__)
+	/**
+	 * @brief Send the datagrams by one sendmmsg call without blocking.
+	 * @return The count of the sent datagrams.
+	 */
+	template<typename Socket>
+	std::size_t send_datagrams(
+		Socket& sock, std::span<const asio::outgoing_datagram> datagrams,
+		asio::udp_batch_option& opt, asio::error_code& ec)
+	{
+		static constexpr std::size_t max_datagrams = 64;
+		static constexpr std::size_t max_gso_bytes = 65507;
+
+		::mmsghdr msgs[max_datagrams];
+		::iovec   iovs[max_datagrams];
+		std::size_t counts[max_datagrams];
+
+	#if defined(UDP_SEGMENT)
+		alignas(::cmsghdr) char controls[max_datagrams][CMSG_SPACE(sizeof(std::uint16_t))];
+	#endif
+
+		std::size_t nmsg = 0, ndgram = 0;
+
+		while (ndgram < datagrams.size() && ndgram < max_datagrams)
+		{
+			const asio::outgoing_datagram& first = datagrams[ndgram];
+
+			std::size_t count = 1;
+
+		#if defined(UDP_SEGMENT)
+			// the segments must have the same size, except the last one which can be smaller.
+			if (opt.segmentation_offload && first.first.size() > 0)
+			{
+				std::size_t total = first.first.size();
+
+				while (ndgram + count < datagrams.size() && ndgram + count < max_datagrams)
+				{
+					const asio::outgoing_datagram& next = datagrams[ndgram + count];
+
+					if (next.second != first.second || next.first.size() == 0 ||
+						next.first.size() > first.first.size() || total + next.first.size() > max_gso_bytes)
+						break;
+
+					total += next.first.size();
+					++count;
+
+					if (next.first.size() < first.first.size())
+						break;
+				}
+			}
+		#endif
+
+			::mmsghdr& m = msgs[nmsg];
+			std::memset(std::addressof(m), 0, sizeof(m));
+
+			m.msg_hdr.msg_name    = const_cast<void*>(static_cast<const void*>(first.second.data()));
+			m.msg_hdr.msg_namelen = static_cast<::socklen_t>(first.second.size());
+			m.msg_hdr.msg_iov     = std::addressof(iovs[ndgram]);
+			m.msg_hdr.msg_iovlen  = count;
+
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				const asio::const_buffer& b = datagrams[ndgram + i].first;
+				iovs[ndgram + i].iov_base = const_cast<void*>(b.data());
+				iovs[ndgram + i].iov_len  = b.size();
+			}
+
+		#if defined(UDP_SEGMENT)
+			if (count > 1)
+			{
+				m.msg_hdr.msg_control    = controls[nmsg];
+				m.msg_hdr.msg_controllen = sizeof(controls[nmsg]);
+
+				::cmsghdr* c = CMSG_FIRSTHDR(&m.msg_hdr);
+				c->cmsg_level = SOL_UDP;
+				c->cmsg_type  = UDP_SEGMENT;
+				c->cmsg_len   = CMSG_LEN(sizeof(std::uint16_t));
+
+				std::uint16_t segment = static_cast<std::uint16_t>(first.first.size());
+				std::memcpy(CMSG_DATA(c), std::addressof(segment), sizeof(segment));
+			}
+		#endif
+
+			counts[nmsg] = count;
+
+			++nmsg;
+			ndgram += count;
+		}
+
+		int r = ::sendmmsg(sock.native_handle(), msgs, static_cast<unsigned int>(nmsg), MSG_DONTWAIT);
+		if (r < 0)
+		{
+			int err = errno;
+
+			// the segmentation offload is not supported, send the datagrams one by one.
+			if (opt.segmentation_offload && (err == EIO || err == EINVAL || err == ENOPROTOOPT))
+			{
+				opt.segmentation_offload = false;
+				return send_datagrams(sock, datagrams, opt, ec);
+			}
+
+			ec = asio::error_code(err, asio::error::get_system_category());
+			return 0;
+		}
+
+		ec.clear();
+
+		std::size_t sent = 0;
+		for (std::size_t i = 0; i < static_cast<std::size_t>(r); ++i)
+		{
+			sent += counts[i];
+		}
+		return sent;
+	}
+#endif
+}
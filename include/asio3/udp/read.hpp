@@ -12,8 +12,46 @@
 
 #include <asio3/core/asio.hpp>
 #include <asio3/udp/core.hpp>
+#include <asio3/udp/datagram_batch.hpp>
 #include <asio3/proxy/parser.hpp>
 
+#ifdef ASIO_STANDALONE
+namespace asio::detail
+#else
+namespace boost::asio::detail
+#endif
+{
+	struct udp_async_receive_batch_op
+	{
+		auto operator()(auto state, auto sock_ref, auto batch_ref) -> void
+		{
+			auto& sock = sock_ref.get();
+			auto& batch = batch_ref.get();
+
+			co_await asio::dispatch(asio::use_deferred_executor(sock));
+
+			state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+			for (;;)
+			{
+				asio::error_code ec{};
+
+				std::size_t n = batch.receive_some(sock, ec);
+				if (n > 0)
+					co_return{ asio::error_code{}, n };
+
+				if (ec && ec != asio::error::would_block && ec != asio::error::try_again)
+					co_return{ ec, 0 };
+
+				auto [e1] = co_await sock.async_wait(
+					asio::socket_base::wait_read, asio::use_deferred_executor(sock));
+				if (e1)
+					co_return{ e1, 0 };
+			}
+		}
+	};
+}
+
 #ifdef ASIO_STANDALONE
 namespace asio
 #else
@@ -75,4 +113,29 @@ inline auto async_receive(
 {
 	return s.async_receive(buffers, std::forward<ReadToken>(token));
 }
+
+/**
+ * @brief Start an asynchronous operation to receive a batch of datagrams.
+ * The operation completes when at least one datagram is received, all the datagrams
+ * which are queued at that time are received together, up to the capacity of the batch.
+ * @param s - The udp socket.
+ * @param batch - The batch which the datagrams are received into, it's retained by the
+ *    caller, which must guarantee that it remains valid until the completion handler is called.
+ * @param token - The completion handler to invoke when the operation completes.
+ *	  The equivalent function signature of the handler must be:
+ *    @code
+ *    void handler(const asio::error_code& ec, std::size_t count);
+ */
+template <
+	typename AsyncReadStream,
+	typename ReadToken = asio::default_token_type<AsyncReadStream>>
+inline auto async_receive_batch(
+	AsyncReadStream& s, datagram_batch& batch,
+	ReadToken&& token = asio::default_token_type<AsyncReadStream>())
+{
+	return asio::async_initiate<ReadToken, void(asio::error_code, std::size_t)>(
+		asio::experimental::co_composed<void(asio::error_code, std::size_t)>(
+			detail::udp_async_receive_batch_op{}, s),
+		token, std::ref(s), std::ref(batch));
+}
 }
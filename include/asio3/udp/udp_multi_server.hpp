@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2017-2023 zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+#include <span>
+
+#include <asio3/core/io_context_thread.hpp>
+#include <asio3/core/session_map.hpp>
+#include <asio3/udp/open.hpp>
+#include <asio3/udp/udp_session.hpp>
+
+#ifdef ASIO_STANDALONE
+namespace asio::detail
+#else
+namespace boost::asio::detail
+#endif
+{
+	struct udp_async_multi_open_op
+	{
+		auto operator()(
+			auto state, auto server_ref,
+			auto&& listen_address, auto&& listen_port) -> void
+		{
+			auto& server = server_ref.get();
+
+			using endpoint_type = asio::ip::udp::endpoint;
+
+			std::string addr = asio::to_string(std::forward_like<decltype(listen_address)>(listen_address));
+			std::string port = asio::to_string(std::forward_like<decltype(listen_port)>(listen_port));
+
+			auto& front = server.sockets.front();
+
+			co_await asio::dispatch(asio::use_deferred_executor(front));
+
+			state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+			asio::ip::udp::resolver resolver(asio::detail::get_lowest_executor(front));
+
+			auto [e1, eps] = co_await asio::async_resolve(
+				resolver, std::move(addr), std::move(port),
+				asio::ip::resolver_base::passive, asio::use_deferred_executor(resolver));
+			if (e1)
+				co_return{ e1, endpoint_type{} };
+
+			if (!!state.cancelled())
+				co_return{ asio::error::operation_aborted, endpoint_type{} };
+
+			endpoint_type bnd_endpoint = eps.begin()->endpoint();
+
+			error_code ec{};
+
+			for (auto& sock : server.sockets)
+			{
+				sock.open(bnd_endpoint.protocol(), ec);
+				if (ec)
+					break;
+
+				asio::default_udp_socket_option_setter{}(sock);
+
+			#if defined(SO_REUSEPORT)
+				sock.set_option(asio::reuse_port(true), ec);
+				if (ec)
+					break;
+			#endif
+
+				sock.bind(bnd_endpoint, ec);
+				if (ec)
+					break;
+
+				// if the listen port is 0, all the other sockets must use the port which
+				// was chosen by the system for the first socket.
+				bnd_endpoint = sock.local_endpoint(ec);
+
+			#if !defined(SO_REUSEPORT)
+				// without SO_REUSEPORT only one socket can be bound, all the datagrams
+				// are received by the first reactor.
+				break;
+			#endif
+			}
+
+			if (ec)
+			{
+				for (auto& sock : server.sockets)
+				{
+					error_code ec_ignore{};
+					sock.close(ec_ignore);
+				}
+
+				co_return{ ec, endpoint_type{} };
+			}
+
+			co_return{ ec, bnd_endpoint };
+		}
+	};
+
+	struct udp_multi_server_async_send_op
+	{
+		auto operator()(auto state, auto server_ref, auto&& data) -> void
+		{
+			auto& server = server_ref.get();
+
+			auto msg = std::forward_like<decltype(data)>(data);
+
+			co_await asio::dispatch(asio::use_deferred_executor(server.sockets.front()));
+
+			state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+			error_code ec{};
+			std::size_t total = 0;
+
+			for (auto& map : server.session_maps)
+			{
+				auto [e1, n1] = co_await map.async_send_all(
+					asio::to_buffer(msg), asio::use_deferred_executor(map));
+				if (e1 && !ec)
+					ec = e1;
+
+				total += n1;
+			}
+
+			co_return{ ec, total };
+		}
+	};
+
+	struct udp_multi_server_async_broadcast_op
+	{
+		auto operator()(auto state, auto server_ref, auto&& data) -> void
+		{
+			auto& server = server_ref.get();
+
+			auto msg = std::forward_like<decltype(data)>(data);
+
+			using failures_type = typename std::remove_cvref_t<decltype(server)>::failures_type;
+
+			co_await asio::dispatch(asio::use_deferred_executor(server.sockets.front()));
+
+			state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+			error_code ec{};
+			std::size_t total = 0;
+			failures_type failures;
+
+			for (auto& map : server.session_maps)
+			{
+				auto [e1, n1, f1] = co_await map.async_broadcast(
+					asio::to_buffer(msg), asio::use_deferred_executor(map));
+				if (e1 && !ec)
+					ec = e1;
+
+				total += n1;
+
+				failures.insert(failures.end(),
+					std::make_move_iterator(f1.begin()), std::make_move_iterator(f1.end()));
+			}
+
+			co_return{ ec, total, std::move(failures) };
+		}
+	};
+}
+
+#ifdef ASIO_STANDALONE
+namespace asio
+#else
+namespace boost::asio
+#endif
+{
+	/**
+	 * @brief A udp server which runs on multi reactors (io_context_thread).
+	 * When SO_REUSEPORT is supported, one socket is bound to the same port per reactor, the
+	 * kernel selects the socket by the hash of the source and destination address, so the
+	 * datagrams of a remote endpoint always land on the same reactor. Every reactor has its
+	 * own session map, the sessions are found without crossing the threads.
+	 * When SO_REUSEPORT is not supported, only the first socket is opened.
+	 */
+	template<typename SessionT = udp_session, typename SessionMapT = asio::session_map<SessionT>>
+	class basic_udp_multi_server
+	{
+	public:
+		using session_type = SessionT;
+		using session_map_type = SessionMapT;
+		using socket_type = typename SessionT::socket_type;
+		using failures_type = typename SessionMapT::failures_type;
+
+		/**
+		 * @brief Create the server on the reactors, the reactors must outlive the server.
+		 */
+		explicit basic_udp_multi_server(std::span<asio::io_context_thread> reactors)
+			: basic_udp_multi_server(make_executors(reactors))
+		{
+		}
+
+		/**
+		 * @brief Create the server with one socket and one session map per executor.
+		 */
+		template<typename Executor>
+		requires (asio::execution::is_executor<Executor>::value || asio::is_executor<Executor>::value)
+		explicit basic_udp_multi_server(const std::vector<Executor>& executors)
+		{
+			if (executors.empty())
+				asio::detail::throw_exception(std::invalid_argument("the executors can't be empty"));
+
+			sockets.reserve(executors.size());
+			session_maps.reserve(executors.size());
+
+			for (const Executor& ex : executors)
+			{
+				sockets.emplace_back(ex);
+				session_maps.emplace_back(ex);
+			}
+		}
+
+		basic_udp_multi_server(basic_udp_multi_server&&) noexcept = default;
+		basic_udp_multi_server& operator=(basic_udp_multi_server&&) noexcept = default;
+
+		~basic_udp_multi_server()
+		{
+		}
+
+		/**
+		 * @brief Asynchronously open all the sockets at the address and port.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, asio::ip::udp::endpoint ep);
+		 */
+		template<typename OpenToken = asio::default_token_type<socket_type>>
+		inline auto async_open(
+			is_string auto&& listen_address,
+			is_string_or_integral auto&& listen_port,
+			OpenToken&& token = asio::default_token_type<socket_type>())
+		{
+			return asio::async_initiate<OpenToken, void(asio::error_code, asio::ip::udp::endpoint)>(
+				experimental::co_composed<void(asio::error_code, asio::ip::udp::endpoint)>(
+					detail::udp_async_multi_open_op{}, sockets.front()),
+				token,
+				std::ref(*this),
+				std::forward_like<decltype(listen_address)>(listen_address),
+				std::forward_like<decltype(listen_port)>(listen_port));
+		}
+
+		/**
+		 * @brief Asynchronously stop the server.
+		 * All the sockets are closed in their own reactor, then all the sessions are disconnected.
+		 */
+		template<typename StopToken = asio::default_token_type<socket_type>>
+		inline auto async_stop(
+			StopToken&& token = asio::default_token_type<socket_type>())
+		{
+			return asio::async_initiate<StopToken, void(error_code)>(
+				experimental::co_composed<void(error_code)>(
+					[](auto state, auto self_ref) -> void
+					{
+						auto& self = self_ref.get();
+
+						state.reset_cancellation_state(asio::disable_cancellation());
+
+						error_code ec{};
+
+						for (auto& sock : self.sockets)
+						{
+							co_await asio::dispatch(asio::use_deferred_executor(sock));
+
+							error_code ec_close{};
+							sock.shutdown(asio::socket_base::shutdown_both, ec_close);
+							sock.close(ec_close);
+							asio::reset_lock(sock);
+
+							if (!ec)
+								ec = ec_close;
+						}
+
+						for (auto& map : self.session_maps)
+						{
+							co_await map.async_disconnect_all(asio::use_deferred_executor(map));
+						}
+
+						co_return ec;
+					}, sockets.front()), token, std::ref(*this));
+		}
+
+		/**
+		 * @brief Start an asynchronous operation to receive a batch of datagrams by the socket
+		 * of the reactor, you should start a receive loop for each index that is_listening(index)
+		 * returns true.
+		 * @param index - The reactor index.
+		 * @param batch - The batch which the datagrams are received into.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, std::size_t count);
+		 */
+		template<typename ReadToken = asio::default_token_type<socket_type>>
+		inline auto async_receive_batch(
+			std::size_t index,
+			datagram_batch& batch,
+			ReadToken&& token = asio::default_token_type<socket_type>())
+		{
+			return asio::async_receive_batch(sockets.at(index), batch, std::forward<ReadToken>(token));
+		}
+
+		/**
+		 * @brief Safety start an asynchronous operation to write all of the supplied data to all clients.
+		 * @param data - The written data.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, std::size_t sent_bytes);
+		 */
+		template<typename WriteToken = asio::default_token_type<socket_type>>
+		inline auto async_send(
+			auto&& data,
+			WriteToken&& token = asio::default_token_type<socket_type>())
+		{
+			return asio::async_initiate<WriteToken, void(error_code, std::size_t)>(
+				experimental::co_composed<void(error_code, std::size_t)>(
+					detail::udp_multi_server_async_send_op{}, sockets.front()),
+				token, std::ref(*this),
+				detail::data_persist(std::forward_like<decltype(data)>(data)));
+		}
+
+		/**
+		 * @brief Start an asynchronous operation to write the data to all clients concurrently.
+		 * @param data - The written data.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, std::size_t sent_bytes,
+		 *        std::vector<std::pair<std::shared_ptr<session_type>, asio::error_code>> failures);
+		 */
+		template<typename BroadcastToken = asio::default_token_type<socket_type>>
+		inline auto async_broadcast(
+			auto&& data,
+			BroadcastToken&& token = asio::default_token_type<socket_type>())
+		{
+			return asio::async_initiate<BroadcastToken, void(error_code, std::size_t, failures_type)>(
+				experimental::co_composed<void(error_code, std::size_t, failures_type)>(
+					detail::udp_multi_server_async_broadcast_op{}, sockets.front()),
+				token, std::ref(*this),
+				detail::data_persist(std::forward_like<decltype(data)>(data)));
+		}
+
+		/**
+		 * @brief Check whether the socket of the reactor is opened or not.
+		 */
+		[[nodiscard]] inline bool is_listening(std::size_t index) noexcept
+		{
+			return index < sockets.size() && sockets[index].is_open();
+		}
+
+		/**
+		 * @brief Check whether the server is stopped or not.
+		 */
+		[[nodiscard]] inline bool is_aborted() noexcept
+		{
+			return !sockets.front().is_open();
+		}
+
+		/**
+		 * @brief Get the reactor count.
+		 */
+		[[nodiscard]] inline std::size_t reactor_count() const noexcept
+		{
+			return sockets.size();
+		}
+
+		/**
+		 * @brief Get the executor associated with the reactor.
+		 */
+		inline auto get_executor(std::size_t index = 0) noexcept
+		{
+			return asio::detail::get_lowest_executor(sockets.at(index));
+		}
+
+		/**
+		 * @brief Get the listen address.
+		 */
+		[[nodiscard]] inline std::string get_listen_address() noexcept
+		{
+			return asio::get_local_address(sockets.front());
+		}
+
+		/**
+		 * @brief Get the listen port number.
+		 */
+		[[nodiscard]] inline ip::port_type get_listen_port() noexcept
+		{
+			return asio::get_local_port(sockets.front());
+		}
+
+		/**
+		 * @brief Get the socket of the reactor.
+		 * https://devblogs.microsoft.com/cppblog/cpp23-deducing-this/
+		 */
+		constexpr inline auto&& get_socket(this auto&& self, std::size_t index = 0)
+		{
+			return std::forward_like<decltype(self)>(self).sockets.at(index);
+		}
+
+		/**
+		 * @brief Get the session map of the reactor.
+		 */
+		constexpr inline auto&& get_session_map(this auto&& self, std::size_t index = 0)
+		{
+			return std::forward_like<decltype(self)>(self).session_maps.at(index);
+		}
+
+	protected:
+		static std::vector<asio::any_io_executor> make_executors(std::span<asio::io_context_thread> reactors)
+		{
+			std::vector<asio::any_io_executor> executors;
+
+			executors.reserve(reactors.size());
+
+			for (asio::io_context_thread& reactor : reactors)
+			{
+				executors.emplace_back(reactor.get_executor());
+			}
+
+			return executors;
+		}
+
+	public:
+		/// one socket per reactor, the sessions of the reactor hold the reference of it,
+		/// so the vector must not be resized after the construction.
+		std::vector<socket_type>      sockets;
+
+		/// one session map per reactor, the sessions of a reactor are only in its own map.
+		std::vector<session_map_type> session_maps;
+	};
+
+	using udp_multi_server = basic_udp_multi_server<udp_session>;
+}
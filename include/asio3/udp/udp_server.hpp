@@ -12,6 +12,7 @@
 
 #include <asio3/core/io_context_thread.hpp>
 #include <asio3/core/session_map.hpp>
+#include <asio3/core/sharded_session_map.hpp>
 #include <asio3/udp/open.hpp>
 #include <asio3/udp/udp_session.hpp>
 
@@ -21,11 +22,12 @@ namespace asio
 namespace boost::asio
 #endif
 {
-	template<typename SessionT = udp_session>
+	template<typename SessionT = udp_session, typename SessionMapT = asio::session_map<SessionT>>
 	class basic_udp_server
 	{
 	public:
 		using session_type = SessionT;
+		using session_map_type = SessionMapT;
 		using socket_type = typename SessionT::socket_type;
 
 		explicit basic_udp_server(const auto& ex)
@@ -100,6 +102,59 @@ namespace boost::asio
 				std::forward<WriteToken>(token));
 		}
 
+		/**
+		 * @brief Start an asynchronous operation to write the data to all clients concurrently.
+		 * @param data - The written data.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, std::size_t sent_bytes,
+		 *        std::vector<std::pair<std::shared_ptr<session_type>, asio::error_code>> failures);
+		 */
+		template<typename BroadcastToken = asio::default_token_type<socket_type>>
+		inline auto async_broadcast(
+			auto&& data,
+			BroadcastToken&& token = asio::default_token_type<socket_type>())
+		{
+			return session_map.async_broadcast(
+				std::forward_like<decltype(data)>(data),
+				std::forward<BroadcastToken>(token));
+		}
+
+		/**
+		 * @brief Start an asynchronous operation to receive a batch of datagrams.
+		 * @param batch - The batch which the datagrams are received into.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, std::size_t count);
+		 */
+		template<typename ReadToken = asio::default_token_type<socket_type>>
+		inline auto async_receive_batch(
+			datagram_batch& batch,
+			ReadToken&& token = asio::default_token_type<socket_type>())
+		{
+			return asio::async_receive_batch(socket, batch, std::forward<ReadToken>(token));
+		}
+
+		/**
+		 * @brief Start an asynchronous operation to send a batch of datagrams.
+		 * @param datagrams - The buffers and destinations, they must remain valid until the
+		 *    completion handler is called.
+		 * @param token - The completion handler to invoke when the operation completes.
+		 *	  The equivalent function signature of the handler must be:
+		 *    @code
+		 *    void handler(const asio::error_code& ec, std::size_t sent_count);
+		 */
+		template<typename WriteToken = asio::default_token_type<socket_type>>
+		inline auto async_send_batch(
+			std::span<const asio::outgoing_datagram> datagrams,
+			udp_batch_option opt = {},
+			WriteToken&& token = asio::default_token_type<socket_type>())
+		{
+			return asio::async_send_batch(socket, datagrams, std::move(opt), std::forward<WriteToken>(token));
+		}
+
 		/**
 		 * @brief Check whether the socket is stopped or not.
 		 */
@@ -152,7 +207,7 @@ namespace boost::asio
 	public:
 		socket_type    socket;
 
-		session_map<session_type> session_map;
+		session_map_type session_map;
 	};
 
 	using udp_server = basic_udp_server<udp_session>;
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <asio3/core/netutil.hpp>
+#include <asio3/core/timer_wheel.hpp>
 #include <asio3/udp/read.hpp>
 #include <asio3/udp/write.hpp>
 #include <asio3/udp/disconnect.hpp>
@@ -156,7 +157,7 @@ namespace boost::asio
 
 		inline void update_alive_time() noexcept
 		{
-			alive_time = std::chrono::system_clock::now();
+			alive_time = asio::coarse_clock::now();
 		}
 
 		[[nodiscard]] static auto create(socket_type& sock, ip::udp::endpoint& remote_endpoint)
@@ -171,7 +172,7 @@ namespace boost::asio
 
 		std::chrono::system_clock::time_point alive_time{ std::chrono::system_clock::now() };
 
-		asio::timer           watchdog_timer{ asio::detail::get_lowest_executor(socket) };
+		asio::wheel_timer     watchdog_timer{ asio::detail::get_lowest_executor(socket) };
 	};
 
 	using udp_session = basic_udp_session<asio::udp_socket>;
@@ -17,6 +17,7 @@
 #include <asio3/core/asio_buffer_specialization.hpp>
 #include <asio3/core/data_persist.hpp>
 #include <asio3/udp/core.hpp>
+#include <asio3/udp/datagram_batch.hpp>
 
 #ifdef ASIO_STANDALONE
 namespace asio::detail
@@ -103,6 +104,61 @@ namespace boost::asio::detail
 			co_return{ e1, n1 };
 		}
 	};
+
+	struct udp_async_send_batch_op
+	{
+		auto operator()(
+			auto state, auto sock_ref,
+			std::span<const asio::outgoing_datagram> datagrams, asio::udp_batch_option opt) -> void
+		{
+			auto& sock = sock_ref.get();
+
+			co_await asio::dispatch(asio::use_deferred_executor(sock));
+
+			state.reset_cancellation_state(asio::enable_terminal_cancellation());
+
+			co_await asio::async_lock(sock, asio::use_deferred_executor(sock));
+
+			[[maybe_unused]] asio::defer_unlock defered_unlock{ sock };
+
+			std::size_t sent = 0;
+
+		#if defined(__linux__)
+			while (sent < datagrams.size())
+			{
+				asio::error_code ec{};
+
+				sent += detail::send_datagrams(sock, datagrams.subspan(sent), opt, ec);
+
+				if (ec == asio::error::would_block || ec == asio::error::try_again)
+				{
+					auto [e1] = co_await sock.async_wait(
+						asio::socket_base::wait_write, asio::use_deferred_executor(sock));
+					if (e1)
+						co_return{ e1, sent };
+				}
+				else if (ec)
+				{
+					co_return{ ec, sent };
+				}
+			}
+		#else
+			asio::ignore_unused(opt);
+
+			for (const asio::outgoing_datagram& dgram : datagrams)
+			{
+				auto [e1, n1] = co_await sock.async_send_to(
+					dgram.first, dgram.second, asio::use_deferred_executor(sock));
+				if (e1)
+					co_return{ e1, sent };
+
+				++sent;
+			}
+		#endif
+
+			co_return{ asio::error_code{}, sent };
+		}
+	};
 }
 
 #ifdef ASIO_STANDALONE
@@ -251,4 +307,56 @@ inline auto async_send(
 		token, std::ref(s),
 		detail::data_persist(std::forward_like<decltype(data)>(data)));
 }
+
+/**
+ * @brief Start an asynchronous operation to send a batch of datagrams.
+ * On linux the datagrams are sent by sendmmsg, up to 64 datagrams per system call.
+ * @param s - The udp socket.
+ * @param datagrams - The buffers and destinations, the memory of the buffers is retained
+ *    by the caller, which must guarantee that they remain valid until the completion
+ *    handler is called.
+ * @param opt - The batch option.
+ * @param token - The completion handler to invoke when the operation completes.
+ *	  The equivalent function signature of the handler must be:
+ *    @code
+ *    void handler(const asio::error_code& ec, std::size_t sent_count);
+ */
+template<
+	typename AsyncWriteStream,
+	typename WriteToken = asio::default_token_type<AsyncWriteStream>>
+requires is_udp_socket<AsyncWriteStream>
+inline auto async_send_batch(
+	AsyncWriteStream& s,
+	std::span<const asio::outgoing_datagram> datagrams,
+	udp_batch_option opt,
+	WriteToken&& token = asio::default_token_type<AsyncWriteStream>())
+{
+	return async_initiate<WriteToken, void(asio::error_code, std::size_t)>(
+		experimental::co_composed<void(asio::error_code, std::size_t)>(
+			detail::udp_async_send_batch_op{}, s),
+		token, std::ref(s), datagrams, std::move(opt));
+}
+
+/**
+ * @brief Start an asynchronous operation to send a batch of datagrams.
+ * @param s - The udp socket.
+ * @param datagrams - The buffers and destinations, the memory of the buffers is retained
+ *    by the caller, which must guarantee that they remain valid until the completion
+ *    handler is called.
+ * @param token - The completion handler to invoke when the operation completes.
+ *	  The equivalent function signature of the handler must be:
+ *    @code
+ *    void handler(const asio::error_code& ec, std::size_t sent_count);
+ */
+template<
+	typename AsyncWriteStream,
+	typename WriteToken = asio::default_token_type<AsyncWriteStream>>
+requires is_udp_socket<AsyncWriteStream>
+inline auto async_send_batch(
+	AsyncWriteStream& s,
+	std::span<const asio::outgoing_datagram> datagrams,
+	WriteToken&& token = asio::default_token_type<AsyncWriteStream>())
+{
+	return asio::async_send_batch(s, datagrams, udp_batch_option{}, std::forward<WriteToken>(token));
+}
 }